@@ -0,0 +1,83 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// CoreDefs.h
+//==============================================================================
+// This file contains the definitions used by the FAST core library (see
+// fastcore.h). Nothing here may depend on GTK+, so that the library can be
+// built without it. Definitions used only by the user interface belong in
+// TypeDefs.h, which includes this file.
+//
+#ifndef FAST_COREDEFS
+#define FAST_COREDEFS
+
+#include <string>
+
+// The current version of FAST is named here. This is printed on startup and in
+// the FAST help->about window.
+#define FAST_VERSION "0.7.0"
+
+// Define an FTS file version. This is stored in the FTS file and can be used
+// for backward compatibility at a later date should a new file version be
+// created.
+#define FTS_FILE_VERSION 4
+#define FTS_FILE_VERSION_UP_TO_0_6_5   2
+#define FTS_FILE_VERSION_SECTIONS      4  // First version with a section table
+
+// Any line starting with IO_COMMENT will be ignored in text I/O routines
+#define IO_COMMENT '#'
+
+// Comment character used in XGremlin line lists and ASCII spectra
+#define XGREMLIN_COMMENT '!'
+
+// A line is plotted, profiled and fitted over +/- PLOT_WIDTH_RANGE times its
+// width in mK
+#define PLOT_WIDTH_RANGE 0.004
+
+// Occasionally, a user may want to fit a line near the target line if it is partially blended.
+// To prevent FAST using this line in its calculations, that line may be designed a FAKE LINE
+// by giving it the following tag on loading.
+#define FAKE_LINE_TAG "*Fake Line*                     "
+
+// Fields to include in the outputwindow
+#define NUM_BF_OUTPUT_FIELDS 15
+#define NUM_TARGET_OUTPUT_FIELDS 9
+#define NUM_FITTED_OUTPUT_FIELDS 9
+const std::string FAST_BF_FIELD_NAMES [NUM_BF_OUTPUT_FIELDS] =  {"Spectrum Tag",
+  "Line Index", "Wavenumber", "Intensity", "U (S/N) / %", "U (Cal.) / %", "U (Trans.) / %",
+  "U (Total) / %", "U (Int.)", "Branching Fraction", "U (Br. Frac.) / %",
+  "Transition Probability x 10^{6}", "U (Tr. Prob.) / %", "log (gf)", "U (log(gf)) / dex" };
+const std::string FAST_TARGET_FIELD_NAMES [NUM_TARGET_OUTPUT_FIELDS] = {
+  "Wavelength", "Est. log(gf)", "Est. Branching Fraction",
+  "E Lower", "J Lower", "Config Lower", "E Upper", "J Upper", "Config Upper" };
+const std::string FAST_FITTED_FIELD_NAMES [NUM_FITTED_OUTPUT_FIELDS] = {
+  "Line", "Label", "Peak", "Width", "Damping",
+  "U (Total)", "U (Even)", "U (Odd)", "U (Rand)" };
+
+//------------------------------------------------------------------------------
+// Type definitions
+//
+typedef struct td_coord {
+  double x;
+  double y;
+
+  td_coord () { x = 0.0; y = 0.0; }
+  td_coord (double nx, double ny) { x = nx; y = ny; }
+
+} Coord;
+
+#endif // FAST_COREDEFS
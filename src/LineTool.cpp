@@ -17,26 +17,55 @@
 //==============================================================================
 // Main function
 //==============================================================================
-// Loads the main FAST GTK+ window and waits for it to be closed.
+// Loads the main FAST GTK+ window and waits for it to be closed, or runs a batch
+// analysis without starting GTK+ if --batch is given (see batch.h).
 //
 #include <gtkmm/main.h>
 #include <iostream>
 #include <fstream>
 #include "analyserwindow.h"
+#include "batch.h"
+#include "trace.h"
 #include <string>
 
 using namespace::std;
 
 #define NUM_CMD_LINE_ARGS 2
 #define ERROR_INVALID_ARGS    1
+#define ERROR_BATCH_FAILED    2
 #define NO_ERROR              0
 
 void showHelp () {
 	cout << "fast : The FTS Atomic Spectrum Tool, for analysis of atomic line spectra" << endl;
 	cout << "------------------------------------------------------------------------" << endl;
-	cout << "Syntax : fast [<fast file> | -h]" << endl << endl;
+	cout << "Syntax : fast [<fast file> | -h]" << endl;
+	cout << "         fast --batch <fast file | job file> [-o <output file>]" << endl;
+	cout << "              [-f csv | latex | aastex] [-t <threads>]" << endl << endl;
 	cout << "<fast file>  : A previously saved FAST project to be opened." << endl;
-	cout << "-h | --help  : Displays this help message." << endl << endl;;
+	cout << "--batch      : Calculates the branching fractions of a project, or of" << endl;
+	cout << "               the project named in a job file, without opening a" << endl;
+	cout << "               window, and writes them to <output file>." << endl;
+	cout << "-f           : The output format. Text/CSV is used by default." << endl;
+	cout << "-t           : The number of threads used to profile the lines." << endl;
+	cout << "-h | --help  : Displays this help message." << endl;
+	cout << "--trace <file> : Records the time spent in each stage of the analysis" << endl;
+	cout << "               and writes it to <file> as a Chrome trace. The file" << endl;
+	cout << "               may also be named in the " << TRACE_ENV << " environment variable." << endl << endl;
+}
+
+
+//------------------------------------------------------------------------------
+// stopTrace () : Writes the trace file if tracing was started by Trace::parse
+// (). A trace that cannot be written is reported but is not treated as a
+// failure of FAST itself.
+//
+void stopTrace () {
+	try {
+		Trace::stop ();
+	} catch (Error Err) {
+		cout << "Error: " << Err.message << endl;
+		if (Err.subtext != "") cout << Err.subtext << endl;
+	}
 }
 
 
@@ -47,10 +76,32 @@ void showHelp () {
 //
 int main(int argc, char *argv[])
 {
-    string CurrentDir = getenv ("PWD");
+	string CurrentDir;
 	string FileName;
 	string Argument;
 
+	// Strip --trace from the command line before it is looked at by anything
+	// else. Tracing uses threads, so they are initialised first.
+	if (!Glib::thread_supported ()) Glib::thread_init ();
+	Trace::parse (argc, argv);
+
+	// A batch run never starts GTK+, so handle it before anything else.
+	if (BatchRun::requested (argc, argv)) {
+		cout << "The FTS Atomic Spectrum Tool (FAST) v" << FAST_VERSION << " (built " << __DATE__ << ")" << endl;
+		try {
+			BatchRun Batch;
+			Batch.parse (argc, argv);
+			Batch.run ();
+		} catch (Error Err) {
+			cout << "Error: " << Err.message << endl;
+			if (Err.subtext != "") cout << Err.subtext << endl;
+			stopTrace ();
+			return Err.code == FLT_SYNTAX_ERROR ? ERROR_INVALID_ARGS : ERROR_BATCH_FAILED;
+		}
+		stopTrace ();
+		return NO_ERROR;
+	}
+
 	// First check to see if too many arguments have been specified. If so,
 	// display an error and showHelp (). Also check to see if the user
 	// has explicitly requested help.
@@ -68,7 +119,13 @@ int main(int argc, char *argv[])
 	}
 
 	// The command line arguments are OK, so start FAST. If a file has been
-	// specified at argv[1], try and open it on startup.
+	// specified at argv[1], try and open it on startup. PWD is not set when
+	// FAST is started without a shell, so fall back to the working directory.
+	if (getenv ("PWD") != NULL) {
+		CurrentDir = getenv ("PWD");
+	} else {
+		CurrentDir = ".";
+	}
 	cout << "The FTS Atomic Spectrum Tool (FAST) v" << FAST_VERSION << " (built " << __DATE__ << ")" << endl;
 	Gtk::Main kit(argc, argv);
 	AnalyserWindow win;
@@ -98,5 +155,6 @@ int main(int argc, char *argv[])
 
   // Show the main FAST project window
   Gtk::Main::run(win);
+  stopTrace ();
   return NO_ERROR;
 }
@@ -17,26 +17,19 @@
 //==============================================================================
 // TypeDefs.h
 //==============================================================================
-// This file contains definitions that are used throughout FAST.
+// This file contains definitions that are used throughout the FAST user
+// interface. Those also needed by the core library are in CoreDefs.h.
 #ifndef FAST_TYPEDEFS
 #define FAST_TYPEDEFS
 
 #include <string>
 #include <gdkmm/color.h>
 
+#include "CoreDefs.h"
 #include "xgline.h"
 #include "kzline.h"
 #include "linedata.h"
-
-// The current version of FAST is named here. This is printed on startup and in
-// the FAST help->about window.
-#define FAST_VERSION "0.7.0"
-
-// Define an FTS file version. This is stored in the FTS file and can be used
-// for backward compatibility at a later date should a new file version be
-// created.
-#define FTS_FILE_VERSION 3
-#define FTS_FILE_VERSION_UP_TO_0_6_5   2
+#include "bfengine.h"
 
 // The number of data points contained in the synthetic Voigt profiles.
 #define NUM_VOIGT_POINTS 200
@@ -58,36 +51,30 @@
 #define AW_CHILD_EQWIDTH_NO_NORM_COLOUR "#DDADAD"
 #define AW_CHILD_EQWIDTH_SOME_NORM_COLOUR "#DDDD8D"
 
+// How often the edits in a project's journal are saved to the project file
+#define AW_JOURNAL_COMPACT_SECONDS 120
+
+// Parts of the displayed level that are out of date and will be refreshed the
+// next time the GUI is idle. See AnalyserWindow::markDirty ().
+#define AW_DIRTY_PLOTS      0x01  // The line profile grid and its "C=" notes
+#define AW_DIRTY_COMPARISON 0x02  // The spectrum scaling factors
+#define AW_DIRTY_XGREMLIN   0x04  // The list of XGremlin lines
+#define AW_DIRTY_BF         0x08  // The branching fraction list
+#define AW_DIRTY_TARGETS    0x10  // The list of Kurucz lines
+#define AW_DIRTY_ALL        0x1F
+
 // FAST configuration file in the user's home directory
 #define FAST_CONFIG_FILE ".fastrc"
 #define NUM_RECENT_FILES 4
 
+// Directory in the user's home directory holding the parsed input cache, and
+// its default size limit in megabytes
+#define FAST_CACHE_DIR ".fastcache"
+#define AW_INPUT_CACHE_DEFAULT_MB 256
+
 // Default file save names for project exports
 #define AW_DEF_TARGETS_NAME "targets.txt"
 
-// Any line starting with IO_COMMENT will be ignored in text I/O routines
-#define IO_COMMENT '#'
-
-// Occasionally, a user may want to fit a line near the target line if it is partially blended.
-// To prevent FAST using this line in its calculations, that line may be designed a FAKE LINE
-// by giving it the following tag on loading.
-#define FAKE_LINE_TAG "*Fake Line*                     "
-
-// Fields to include in the outputwindow
-#define NUM_BF_OUTPUT_FIELDS 15
-#define NUM_TARGET_OUTPUT_FIELDS 9
-#define NUM_FITTED_OUTPUT_FIELDS 9
-const std::string FAST_BF_FIELD_NAMES [NUM_BF_OUTPUT_FIELDS] =  {"Spectrum Tag", 
-  "Line Index", "Wavenumber", "Intensity", "U (S/N) / %", "U (Cal.) / %", "U (Trans.) / %",
-  "U (Total) / %", "U (Int.)", "Branching Fraction", "U (Br. Frac.) / %",
-  "Transition Probability x 10^{6}", "U (Tr. Prob.) / %", "log (gf)", "U (log(gf)) / dex" };
-const std::string FAST_TARGET_FIELD_NAMES [NUM_TARGET_OUTPUT_FIELDS] = {
-  "Wavelength", "Est. log(gf)", "Est. Branching Fraction", 
-  "E Lower", "J Lower", "Config Lower", "E Upper", "J Upper", "Config Upper" };
-const std::string FAST_FITTED_FIELD_NAMES [NUM_FITTED_OUTPUT_FIELDS] = {
-  "Line", "Label", "Peak", "Width", "Damping",
-  "U (Total)", "U (Even)", "U (Odd)", "U (Rand)" };
-
 // Define a LinePair structure that permits target lines to be linked to their
 // observed profiles. Include a plot of the observed line.
 typedef struct line_pair {
@@ -97,19 +84,16 @@ typedef struct line_pair {
   int xgLineListIndex, xgLineLineIndex;
 } LinePair;
 
-// RatioAndError typedef, used for calculating the transfer ratios and errors
-// needed to link a given intensity calibration across multiple spectra.
-typedef struct ratio_and_error {
-  unsigned int a, b;
-  double Ratio;
-  double Error;
-} RatioAndError;
+// Define a PlotPosition structure that records where the line shown in a plot
+// is stored: its spectrum, its line list in that spectrum, and its index in the
+// list.
+typedef struct plot_position {
+  unsigned int Spectrum, List, Line;
+} PlotPosition;
 
-typedef struct type_data_bf {
-  int index;
-  double wavenumber, eqwidth, err_line, err_cal, err_trans, err_total, 
-    err_eqwidth, br_frac, err_br_frac, a, err_a, loggf, dex;
-  std::string spectrum;
+// The branching fraction data of a line calculated by BfEngine, together with
+// the plot of the line and the colours used to display the data.
+typedef struct type_data_bf : public bf_result {
   LineData *profile;
   Gdk::Color bg_colour, eq_width_colour, err_cal_colour;
 } DataBF;
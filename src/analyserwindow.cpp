@@ -22,7 +22,7 @@
 
 #include "analyserwindow.h"
 #include "plotFns.cpp"
-#include "lineio.cpp"
+#include "lineio.h"
 
 #include "analyserwindow_construct.cpp" // Constructor / destruction functions
 #include "analyserwindow_signal.cpp"    // General signal handlers
@@ -34,26 +34,88 @@
 #include "analyserwindow_refresh.cpp"   // Functions to refresh window widgets
 #include "analyserwindow_errors.cpp"    // Error handlers for AnalyserWindow
 #include "analyserwindow_config.cpp"	// I/O routines for the FAST config file
+#include "analyserwindow_jobs.cpp"      // Background jobs for loading data
 
 using namespace::std;
 
+//------------------------------------------------------------------------------
+// projectHasChanged (bool) : Marks the project as changed or saved. An edit that
+// is not described to the journal is recorded there as a barrier, past which
+// the journal cannot be replayed.
+//
 void AnalyserWindow::projectHasChanged (bool ProjectHasChanged) {
   if (ProjectHasChanged) {
-    ProjectChangedSinceSave = true;
-    m_refActionGroup->get_action("FileSave")->set_sensitive(true);
+    projectHasChanged (JournalRecord (JOURNAL_BARRIER));
   } else {
     ProjectChangedSinceSave = false;
     m_refActionGroup->get_action("FileSave")->set_sensitive(false);
   }
 }
 
+
+//------------------------------------------------------------------------------
+// projectHasChanged (JournalRecord) : Marks the project as changed by Edit, and
+// appends Edit to the journal of the project file.
+//
+void AnalyserWindow::projectHasChanged (JournalRecord Edit) {
+  ProjectChangedSinceSave = true;
+  ProjectChanges ++;
+  Edit.Change = ProjectChanges;
+  Journal.append (Edit);
+  m_refActionGroup->get_action("FileSave")->set_sensitive(true);
+}
+
+
+//------------------------------------------------------------------------------
+// lineHasChanged (LineData *) : Marks the project as changed after the user has
+// selected, disabled or hidden the line plotted in Plot. The position of the
+// line is looked up in PlotPositions, which addNewLines () fills in.
+//
+void AnalyserWindow::lineHasChanged (LineData *Plot) {
+  map <LineData *, PlotPosition>::iterator Position = PlotPositions.find (Plot);
+  if (Position != PlotPositions.end ()) {
+    lineHasChanged (Plot, Position -> second.Spectrum, Position -> second.List,
+      Position -> second.Line);
+  } else {
+    projectHasChanged (true);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// lineHasChanged (LineData *, unsigned int, unsigned int, unsigned int) : Marks
+// the project as changed after the user has selected, disabled or hidden the
+// line plotted in Plot, and journals the new state of the line, which is line
+// Line of list List in spectrum Spectrum.
+//
+void AnalyserWindow::lineHasChanged (LineData *Plot, unsigned int Spectrum, 
+  unsigned int List, unsigned int Line) {
+  unsigned int Flags = 0;
+  bool Hidden = Plot -> hidden ();
+
+  // A hidden plot reports itself as unselected and disabled, so it must be
+  // shown briefly to read its real state (as in saveInterface ()).
+  if (Hidden) Plot -> hidden (false);
+  if (Plot -> selected ()) Flags |= JOURNAL_SELECTED;
+  if (Plot -> disabled ()) Flags |= JOURNAL_DISABLED;
+  if (Hidden) {
+    Plot -> hidden (true);
+    Flags |= JOURNAL_HIDDEN;
+  }
+  projectHasChanged (JournalRecord (JOURNAL_LINE_STATE, Spectrum, List, Line, 
+    Flags));
+}
+
 //------------------------------------------------------------------------------
 // on_delete_event (GdkEventAny*) : Overrides the default on_delete_event in
 // order to check whether or not the current project has been saved. If it
-// hasn't, tell the user and ask them if they still want to quit.
+// hasn't, tell the user and ask them if they still want to quit. Background
+// jobs are cancelled, so a save that was still running counts as unsaved.
 //
 bool AnalyserWindow::on_delete_event (GdkEventAny* event) {
-  if (ProjectChangedSinceSave) {
+  bool SaveCancelled = PendingSave != NULL;
+  if (Jobs.busy ()) Jobs.cancelAll ();
+  if (ProjectChangedSinceSave || SaveCancelled) {
     Gtk::MessageDialog quit(*this, "Would you like to save the project before quitting?",
       false, Gtk::MESSAGE_QUESTION, Gtk::BUTTONS_NONE);
     quit.set_secondary_text(" Click cancel to return to the project.");
@@ -75,6 +137,7 @@ bool AnalyserWindow::on_delete_event (GdkEventAny* event) {
         // aborted due to a file save error.
       }
     } else if (Result == Gtk::RESPONSE_NO) {
+      Journal.discard ();
       this -> hide ();
     }
   } else {
@@ -84,260 +147,286 @@ bool AnalyserWindow::on_delete_event (GdkEventAny* event) {
 }
 
 //------------------------------------------------------------------------------
-// scaleGraphs () : Puts all the line profile plots on the same Y scale. This 
-// makes it easier to see relative peak intensities, which is useful for 
-// branching fraction work. This method is called when the Scale button is 
-// clicked on the toolbar. 
+// scaleGraphs () : Puts all the line profile plots on the same Y scale, or
+// returns them to their own scales if they already share one. This makes it
+// easier to see relative peak intensities, which is useful for branching
+// fraction work. The shared scale stays in use for any level shown later.
 //
 void AnalyserWindow::scaleGraphs () {
-  if (LineBoxes.size () == 0) return;
-  if (!LineBoxes[0][0] -> autoLimits ()) {
-    for (unsigned int i = 0; i < LineBoxes.size (); i ++) {
-      for (unsigned int j = 0; j < LineBoxes[i].size (); j ++) {
-        LineBoxes[i][j] -> setAutoLimits ();
-        LineBoxes[i][j] -> queue_draw ();
-      }
-    }
-  } else {
-    double MinY = LineBoxes[0][0] -> plotLimits().min.y;
-    double MaxY = LineBoxes[0][0] -> plotLimits().max.y;
-    GraphLimits lim;
-    for (unsigned int i = 0; i < LineBoxes.size (); i ++) {
-      for (unsigned int j = 0; j < LineBoxes[i].size (); j ++) {
-        if (LineBoxes[i][j] -> plotLimits().min.y < MinY) MinY = LineBoxes[i][j] -> plotLimits().min.y;
-        if (LineBoxes[i][j] -> plotLimits().max.y > MaxY) MaxY = LineBoxes[i][j] -> plotLimits().max.y;
-      }
-    }
-    for (unsigned int i = 0; i < LineBoxes.size (); i ++) {
-      for (unsigned int j = 0; j < LineBoxes[i].size (); j ++) {
-        lim = LineBoxes[i][j] -> plotLimits();
-        lim.min.y = MinY; lim.max.y = MaxY;
-        LineBoxes[i][j] -> plotLimits (lim);
-        LineBoxes[i][j] -> queue_draw ();
-      }
-    }
+  SharedScale = !SharedScale;
+  applyScale ();
+}
+
+
+//------------------------------------------------------------------------------
+// updateSharedScale (LineData *) : Records the Y range of a plot in LineBoxes
+// that has just been added, filled or hidden. Hidden and empty plots are left
+// out of the shared scale, which is taken from the ranges of the other plots,
+// so it shrinks again once the plot that set it has gone. applyScale () then
+// gives Plot its new scale. clearDisplayedPlots () forgets every plot.
+//
+void AnalyserWindow::updateSharedScale (LineData *Plot) {
+  GraphLimits Limits;
+  map <LineData *, GraphLimits>::iterator Scale = PlotScales.find (Plot);
+  if (Scale != PlotScales.end ()) {
+    ScaleMins.erase (ScaleMins.find (Scale -> second.min.y));
+    ScaleMaxes.erase (ScaleMaxes.find (Scale -> second.max.y));
+    PlotScales.erase (Scale);
   }
+  if (!Plot -> hidden () && Plot -> naturalLimits (Limits)) {
+    PlotScales[Plot] = Limits;
+    ScaleMins.insert (Limits.min.y);
+    ScaleMaxes.insert (Limits.max.y);
+  }
+  ScaleChanged.push_back (Plot);
 }
 
 
 //------------------------------------------------------------------------------
-// Generate a Voigt profile for the current line. w[0] contains the Gaussian 
-// component of the Voigt profile width, and w[1] the Lorentzian component.
-// These are extracted from the XGremlin writelines data by using the "width"
-// and "dmp" column, where the latter is the fraction of the Voigt profile
-// width that arises from the Lorentzian. Don't forget that the writelines
-// widths are in mK.
-//
-vector <Coord> AnalyserWindow::voigtProfile (XgLine LineIn, vector <Coord> Points) {
-  vector <Coord> RtnPlot (Points.size (), Coord ());
-  double x[Points.size ()], y[Points.size ()];
-  double xc = LineIn.wavenumber ();
-  for (unsigned int i = 0; i < Points.size (); i ++) {
-    x[i] = Points[i].x;
-    y[i] = 0.0;
-  }
-
-  VoigtLsqfit voigtGen;
-  voigtGen.voigt(Points.size (), x, y, 
-    0.0005 * LineIn.width() / (x[1] - x[0]), LineIn.peak(), LineIn.dmp(), xc);
-  
-  // Create a synthetic Voigt profile using the input line parameters
-  for (unsigned int i = 0; i < Points.size (); i ++) {
-    RtnPlot[i].y = y[i];
-    RtnPlot[i].x = x[i] /* * (1.0 + WaveCorr)*/;
+// applyScale () : Gives the plots in LineBoxes either the shared Y scale or
+// their own, depending on SharedScale. Every plot is rescaled if the shared
+// limits have moved or SharedScale has been toggled. Otherwise only the plots
+// passed to updateSharedScale () since the last call are. Only the plots whose
+// limits change are redrawn, and only if they are on screen.
+//
+void AnalyserWindow::applyScale () {
+  TRACE_SCOPE ("applyScale");
+  bool Shared = SharedScale && PlotScales.size () > 0;
+  GraphLimits Limits;
+  bool Changed;
+
+  if (Shared) {
+    Limits.min.y = *ScaleMins.begin ();
+    Limits.max.y = *ScaleMaxes.rbegin ();
+  }
+  if (Shared != ScaleShared || (Shared && (Limits.min.y != SharedLimits.min.y
+    || Limits.max.y != SharedLimits.max.y))) {
+    ScaleChanged.clear ();
+    for (unsigned int i = 0; i < LineBoxes.size (); i ++) {
+      ScaleChanged.insert (ScaleChanged.end (), LineBoxes[i].begin (),
+        LineBoxes[i].end ());
+    }
   }
-  return RtnPlot;
+  SharedLimits = Limits;
+  ScaleShared = Shared;
+
+  for (unsigned int i = 0; i < ScaleChanged.size (); i ++) {
+    if (Shared) {
+      Changed = ScaleChanged[i] -> scaleY (Limits.min.y, Limits.max.y);
+    } else {
+      Changed = ScaleChanged[i] -> setAutoLimits ();
+    }
+    if (Changed) ScaleChanged[i] -> redraw ();
+  }
+  ScaleChanged.clear ();
 }
 
 
 //------------------------------------------------------------------------------
-// matchedXgLineExists (KzLine, double) : Determines whether or not an XGremlin
-// line exists that matches the KzLine passed in at arg1. To find out exactly
-// which line matches best, getLinePairs() should be used instead.
+// matchedXgLinesExist (vector <KzLine> &, double) : Determines whether or not
+// an XGremlin line exists within Discriminator of each of the Kurucz lines in
+// Lines. The wavenumbers of every XGremlin line are sorted once, so that each
+// Kurucz line only needs a binary search. To find out exactly which line
+// matches best, getLinePairs() should be used instead.
 //
-bool AnalyserWindow::matchedXgLineExists (KzLine LineIn, double Discrimintor) {
+vector <bool> AnalyserWindow::matchedXgLinesExist (vector <KzLine> &Lines,
+  double Discriminator) {
+  vector <double> Wavenumbers;
+  vector <bool> Found (Lines.size (), false);
   for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
     for (unsigned int j = 0; j < ExptSpectra[i].linesPtr2() -> size (); j ++) {
       for (unsigned int k = 0; k < ExptSpectra[i].linesPtr2() -> at(j).size (); k ++) {
-        if (abs(ExptSpectra[i].linesPtr2()->at (j)[k].wavenumber() - LineIn.sigma()) < Discrimintor) {
-          return true;
-        }
+        Wavenumbers.push_back (ExptSpectra[i].linesPtr2()->at (j)[k].wavenumber());
       }
     }
   }
-  return false;
+  sort (Wavenumbers.begin (), Wavenumbers.end ());
+  for (unsigned int i = 0; i < Lines.size (); i ++) {
+    vector <double>::iterator Next = upper_bound (Wavenumbers.begin (),
+      Wavenumbers.end (), Lines[i].sigma () - Discriminator);
+    Found[i] = Next != Wavenumbers.end () 
+      && *Next < Lines[i].sigma () + Discriminator;
+  }
+  return Found;
 }
 
 
 //------------------------------------------------------------------------------
-// getLinePairs (*KzList, int) : Given a list of levels from the Kurucz
-// database in KzLevel, getLinePairs will attempt to match each level with 
-// an XGremlin line attached to spectrum Spec. When a match is found, a new 
-// LinePair object is created to link the Kurucz level and XGremlin line, and 
-// the level is removed from KzLevel.
-//
-vector <LinePair> AnalyserWindow::getLinePairs (vector <KzLine *> KzLevel, int Spec) {
-  vector <LinePair> MatchedLines;
-  vector <LinePair> AllXgLines;
-  vector <LinePair> Candidates;
-  vector <LineData *> CandidatePlots;
-  vector <LineData *> AllPlots;
-  vector <vector <XgLine *> > PtrLines;
-  vector <int> CandidateIndicies;
-  double MinDifference;
-  int MinDiffIndex;
-  LinePair NextPair;
+// engine () : Returns a BfEngine for the current project, which is used for all
+// the line matching, transfer ratio and branching fraction calculations.
+//
+BfEngine AnalyserWindow::engine () {
+  return BfEngine (ExptSpectra, LinkedSpectra, KuruczList.levelPrecision (),
+    Options.correct_snr ());
+}
+
 
-  // Copy all the lines attached to ExptSpectra[Spec] into a single vector
-  PtrLines = ExptSpectra[Spec].linesPtr();
-  for (unsigned int j = 0; j < ExptSpectra[Spec].linesPtr2()->size (); j ++) {
-    for (unsigned int k = 0; k < ExptSpectra[Spec].linesPtr2()->at(j).size (); k ++) {
-      NextPair.xgLine = PtrLines[j][k];
-      NextPair.xgLineListIndex = j;
-      NextPair.xgLineLineIndex = k;
-      AllXgLines.push_back (NextPair);
-      AllPlots.push_back (ExptSpectra[Spec].plots()[j][k]);
+//------------------------------------------------------------------------------
+// lineMatches (vector < vector <LinePair *> > &) : Copies the line pairs of a
+// level into the form used by BfEngine, along with the states of their plots.
+//
+vector < vector <LineMatch> > AnalyserWindow::lineMatches 
+  (vector < vector <LinePair *> > &Pairs) {
+  vector < vector <LineMatch> > Matches (Pairs.size ());
+  LineMatch NextMatch;
+  for (unsigned int i = 0; i < Pairs.size (); i ++) {
+    for (unsigned int j = 0; j < Pairs[i].size (); j ++) {
+      NextMatch.xgLine = Pairs[i][j] -> xgLine;
+      NextMatch.kzLine = Pairs[i][j] -> kzLine;
+      NextMatch.xgLineListIndex = Pairs[i][j] -> xgLineListIndex;
+      NextMatch.xgLineLineIndex = Pairs[i][j] -> xgLineLineIndex;
+      NextMatch.Selected = Pairs[i][j] -> plot -> selected ();
+      NextMatch.Disabled = Pairs[i][j] -> plot -> disabled ();
+      Matches[i].push_back (NextMatch);
     }
   }
+  return Matches;
+}
 
-  // Search through each level in KzLevel and compare the wavenumbers to the
-  // lines in AllXgLines. If a line is found that matches the level wavenumber
-  // to within a tolerance of KzLevel.levelPrecision (), add that line to a
-  // list of candidates for the best match.
-  for (unsigned int i = 0; i < KzLevel.size(); i ++) {
-    for (unsigned int j = 0; j < AllXgLines.size (); j ++) {
-      if (abs(AllXgLines[j].xgLine->wavenumber() - KzLevel[i]->sigma()) < KuruczList.levelPrecision ()) {
-        if (AllXgLines[j].xgLine->id() != FAKE_LINE_TAG) {
-          Candidates.push_back (AllXgLines[j]);
-          CandidatePlots.push_back (AllPlots[j]);
-          CandidateIndicies.push_back (j);
-        }
-      }
-    }
 
-    // Take all the candidate matches identified above and see which XGremlin
-    // line BEST matches the wavenumber of the Kurucz level. When the best match
-    // has been found, create a new LinePair object for it and add it to the
-    // vector to be returned at the end of the method.
-    if (Candidates.size () > 0) {
-      MinDifference = abs (KzLevel[i]->sigma() - Candidates[0].xgLine->wavenumber());
-      MinDiffIndex = 0;
-      for (unsigned int j = 0; j < Candidates.size (); j ++) {
-        if (abs (KzLevel[i]->sigma() - Candidates[j].xgLine->wavenumber()) < MinDifference) {
-          MinDifference = abs(KzLevel[i]->sigma() - Candidates[j].xgLine->wavenumber());
-          MinDiffIndex = j;
-        }
+//------------------------------------------------------------------------------
+// matchLinePairs (vector <KzLine *>) : Matches each Kurucz line in KzLevel with
+// the XGremlin lines of every spectrum using BfEngine::match (), and links each
+// match to the plot of its XGremlin line. Target lines that are not found in a
+// spectrum have NULL xgLine and plot pointers, which installLinePairs () later
+// replaces with blank lines. No widgets are created, so this may be called
+// from a Job.
+//
+vector < vector <LinePair> > AnalyserWindow::matchLinePairs (vector <KzLine *> KzLevel) {
+  vector < vector <LineMatch> > Matches = engine ().match (KzLevel);
+  vector < vector <LinePair> > LinePairs (Matches.size ());
+  LinePair NextPair;
+
+  for (unsigned int i = 0; i < Matches.size (); i ++) {
+    for (unsigned int j = 0; j < Matches[i].size (); j ++) {
+      NextPair.xgLine = Matches[i][j].xgLine;
+      NextPair.kzLine = Matches[i][j].kzLine;
+      NextPair.xgLineListIndex = Matches[i][j].xgLineListIndex;
+      NextPair.xgLineLineIndex = Matches[i][j].xgLineLineIndex;
+      if (NextPair.xgLine != NULL) {
+        NextPair.plot = LinePlots[i][NextPair.xgLineListIndex]
+          [NextPair.xgLineLineIndex];
+      } else {
+        NextPair.plot = NULL;
       }
-      NextPair = Candidates[MinDiffIndex];
-      NextPair.kzLine = KzLevel[i];
-      NextPair.plot = CandidatePlots[MinDiffIndex];
-      MatchedLines.push_back (NextPair);
-
-      // Remove the matched XGremlin line from AllXgLines and the level from
-      // KzLevel so that neither are used again in subsequent matches.
-      AllXgLines.erase (AllXgLines.begin() + CandidateIndicies[MinDiffIndex]);
-      AllPlots.erase (AllPlots.begin() + CandidateIndicies[MinDiffIndex]);
-      Candidates.clear ();
-      CandidatePlots.clear ();
-      CandidateIndicies.clear ();
-    
-    // If no candidate line was found, insert a blank line into the list of
-    // matched lines so that the final vector is of a known size, and is the
-    // same size for all loaded spectra.
-    } else {
-      NextPair.xgLine = new XgLine;
-      NextPair.plot = new LineData (*NextPair.xgLine);
-      NextPair.kzLine = KzLevel[i];
-      NextPair.xgLineListIndex = -1;
-      NextPair.xgLineLineIndex = -1;
-      MatchedLines.push_back (NextPair);
+      LinePairs[i].push_back (NextPair);
     }
   }
-  
-  return MatchedLines;
+  return LinePairs;
 }
 
 
 //------------------------------------------------------------------------------
-// getLinePairs (vector <KzLine *>) : Calls getLinePairs (KzList, int) above to
-// actually obtain the Kurucz/XGremlin line pairs. These are then examined, and
-// lines that have no corresponding experimental data in any of the loaded
-// spectra are removed.
+// matchAllLevels (Job *) : Matches the lines of every loaded upper level with
+// the experimental lines. If Progress is not NULL, the fraction of levels
+// matched is reported to it, and matching stops early if it is cancelled.
 //
-vector < vector <LinePair> > AnalyserWindow::getLinePairs (vector <KzLine *> KzLevel) {
-  vector < vector <LinePair> > LinePairs;
+vector < vector < vector <LinePair> > > AnalyserWindow::matchAllLevels 
+  (Job *Progress) {
+  TRACE_SCOPE ("matchAllLevels");
+  vector < vector < vector <LinePair> > > Pairs;
+  unsigned int NumLevels = KuruczList.numUpperLevels ();
+  for (unsigned int i = 0; i < NumLevels; i ++) {
+    if (Progress != NULL) {
+      if (Progress -> cancelled ()) break;
+      Progress -> progress (double (i) / double (NumLevels));
+    }
+    Pairs.push_back (matchLinePairs (KuruczList.upperLevelLines (i)));
+  }
+  return Pairs;
+}
 
-  // Link the Kurucz list KzLevel to experimental XGremlin data 
-  for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
-    LinePairs.push_back (getLinePairs (KzLevel, i));
-  }
-
-  // Scan through the lines and remove any for which there is no loaded
-  // experimental data in any of the XGremlin spectra
-  if (LinePairs.size () > 0) {
-    bool LineFound;
-    for (int j = LinePairs[0].size () - 1; j >= 0; j --) {
-      LineFound = false;
-      for (unsigned int i = 0; i < LinePairs.size (); i ++) {
-        if (LinePairs[i][j].xgLineLineIndex != -1) {
-          LineFound = true;
-          break;
+
+//------------------------------------------------------------------------------
+// installLinePairs (vector < vector < vector <LinePair> > >) : Stores the output
+// of matchAllLevels () in LevelLines. Blank lines and plots are created in
+// Placeholders for every target line that was not found in a spectrum, after
+// those made for the previous LevelLines have been freed. Must be called on
+// the main loop, since the displayed plots are cleared first.
+//
+void AnalyserWindow::installLinePairs 
+  (vector < vector < vector <LinePair> > > Pairs) {
+  TRACE_SCOPE ("installLinePairs");
+  clearDisplayedPlots ();
+  Placeholders.reset ();
+  for (unsigned int i = 0; i < Pairs.size (); i ++) {
+    for (unsigned int j = 0; j < Pairs[i].size (); j ++) {
+      for (unsigned int k = 0; k < Pairs[i][j].size (); k ++) {
+        if (Pairs[i][j][k].xgLine == NULL) {
+          Pairs[i][j][k].xgLine = Placeholders.newLine ();
+          Pairs[i][j][k].plot = Placeholders.newPlot (*Pairs[i][j][k].xgLine);
         }
       }
-      if (!LineFound) {
-        for (unsigned int i = 0; i < LinePairs.size (); i ++) {
-          delete LinePairs[i][j].plot;
-          delete LinePairs[i][j].xgLine;
-          LinePairs[i].erase (LinePairs[i].begin() + j);
-        }
+    }
+  }
+  LevelLines = Pairs;
+
+  // Record which levels show each plot, so that a change to one line only
+  // refreshes the levels it belongs to.
+  PlotLevels.clear ();
+  for (unsigned int i = 0; i < LevelLines.size (); i ++) {
+    for (unsigned int j = 0; j < LevelLines[i].size (); j ++) {
+      for (unsigned int k = 0; k < LevelLines[i][j].size (); k ++) {
+        vector <unsigned int> &Levels = PlotLevels[LevelLines[i][j][k].plot];
+        if (Levels.size () == 0 || Levels.back () != i) Levels.push_back (i);
       }
     }
   }
-  return LinePairs;
 }
 
 
 //------------------------------------------------------------------------------
-// getLinePairs () : A wrapper function for getLinePairs (vector <KzLine *>),
-// above. This function will get the Kurucz/XGremlin line pairs for all loaded
-// upper levels and store them in LevelLines for later use.
+// getLinePairs () : Gets the Kurucz/XGremlin line pairs for all loaded upper
+// levels and stores them in LevelLines for later use. To do this without
+// blocking the main loop, use queueLineMatching () instead.
 //
 void AnalyserWindow::getLinePairs () {
-  vector < vector <LinePair> > NextPairSet;
-  LevelLines.clear ();
-  for (unsigned int i = 0; i < KuruczList.numUpperLevels (); i ++) {
-    NextPairSet = getLinePairs (KuruczList.upperLevelLines (i));
-    LevelLines.push_back (NextPairSet);
-  }
+  TRACE_SCOPE ("getLinePairs");
+  installLinePairs (matchAllLevels ());
+}
+
+
+//------------------------------------------------------------------------------
+// queueLineMatching (sigc::slot <void>) : Matches the Kurucz and XGremlin lines
+// on a background thread, and calls Then on the main loop once LevelLines has
+// been updated.
+//
+void AnalyserWindow::queueLineMatching (sigc::slot <void> Then) {
+  Jobs.push (new MatchLinesJob (this, Then));
 }
 
 
 //------------------------------------------------------------------------------
 // plotLines (vector < vector <LinePair>) : Plots all the XGremlin lines passed
-// in at arg1. All lines from a given spectrum are attached to the Profiles 
-// table in a single row. A new row created for the next spectrum.
+// in at arg1. All lines from a given spectrum are shown in a single row of the
+// Profiles grid. A new row created for the next spectrum.
 //
 void AnalyserWindow::plotLines (vector < vector <LinePair *> > PlotLines, 
   vector <unsigned int> PlotOrder) {
+  TRACE_SCOPE ("plotLines");
   vector <Coord> LineCoords, VoigtCoords, ResCoords;
   
-  // First clear any plots that are currently displayed in the AnalyserWindow.
+  // First clear any plots that are currently displayed in the AnalyserWindow,
+  // and make sure that the plots about to be shown have been profiled.
   clearDisplayedPlots ();
+  for (unsigned int i = 0; i < PlotLines.size (); i ++) {
+    for (unsigned int j = 0; j < PlotLines[i].size (); j ++) {
+      if (PlotLines[i][j] -> xgLineLineIndex != -1
+        && !PlotLines[i][j] -> plot -> plotted ()) {
+        profileLines (PlotOrder[i], PlotLines[i][j] -> xgLineListIndex);
+      }
+    }
+  }
   // Now create LineData objects for all the remaining lines and add the
   // appropriate plots and line data to them.  
   generatePlots (PlotLines);
+  applyScale ();
+  vector <string> Titles;
   for (unsigned int i = 0; i < LineBoxes.size (); i ++) {
-    frameSpectrumPlots.push_back (new Gtk::Frame);
-    hboxSpectrumPlots.push_back (new Gtk::HBox);
-    frameSpectrumPlots[i] -> set_label ("(" + ExptSpectra[PlotOrder[i]].index() + ") " + ExptSpectra[PlotOrder[i]].name());
-    frameSpectrumPlots[i] -> add ((Gtk::Widget &) *hboxSpectrumPlots [i]);
-    frameSpectrumPlots[i] -> show ();
-    hboxSpectrumPlots[i] -> show ();
-    for (unsigned int j = 0; j < LineBoxes[i].size (); j ++) {
-      hboxSpectrumPlots[i] -> pack_start ((Gtk::Widget &) *LineBoxes[i][j], false, false, 0);
-    }
-    Profiles.pack_start ((Gtk::Widget &) *frameSpectrumPlots [i], false, false, 0);
+    Titles.push_back ("(" + ExptSpectra[PlotOrder[i]].index() + ") "
+      + ExptSpectra[PlotOrder[i]].name());
   }
+  Profiles.set (LineBoxes, Titles);
 }
 
 
@@ -366,7 +455,7 @@ void AnalyserWindow::generatePlots (vector < vector <LinePair *> > PlotLines) {
 	if (PlotSpectrum[i]) {
 		for (unsigned int j = 0; j < PlotLines[i].size (); j ++) {
 		  Plots.push_back (PlotLines[i][j]->plot);
-		  Plots[j] -> show ();
+		  updateSharedScale (PlotLines[i][j]->plot);
 		}
 	}
     LineBoxes.push_back (Plots);
@@ -375,268 +464,457 @@ void AnalyserWindow::generatePlots (vector < vector <LinePair *> > PlotLines) {
 }
 
 
+//------------------------------------------------------------------------------
+// renderModel (XgSpectrum *, vector <XgLine> &, ModelSpectrum &) : Renders the
+// lines in Lines onto the grid of Spectrum, storing the result in Model.
+//
+void AnalyserWindow::renderModel (XgSpectrum *Spectrum, vector <XgLine> &Lines,
+  ModelSpectrum &Model) {
+  if (Spectrum -> numDataPoints () > 0) {
+    Model.grid (Spectrum -> data (0).x, Spectrum -> get_point_spacing (),
+      Spectrum -> numDataPoints ());
+    Model.render (Lines);
+  } else {
+    Model.clear ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// fillLinePlot (LineData *, LineProfile &) : Adds the experimental data, fitted
+// Voigt profile and residual calculated by LineProfiler to Plot.
+//
+void AnalyserWindow::fillLinePlot (LineData *Plot, LineProfile &Profile) {
+  Plot -> addPlot (Profile.Data, true, false);
+  Plot -> addPlot (Profile.Voigt);
+  Plot -> setPlotColour (0, 0.5, 0.5, 0.5);
+  Plot -> setPlotWidth (1, 1.0);
+  Plot -> addResidual (Profile.Residual);
+}
+
+
 //------------------------------------------------------------------------------
 // addNewLines : Once on_data_load_line_list has loaded a new set of XGremlin
 // addNewLines is called to 1) store these lines in the ExptSpectra vector, and
 // 2) more importantly, generate plots for each of the new lines that can be
-// quickly called up when requested by the user.
+// quickly called up when requested by the user. The line profiles are computed
+// in parallel before any of the plots are created.
 //
-void AnalyserWindow::addNewLines (XgSpectrum *Spectrum, vector <XgLine> NewLines){
-  vector <Coord> LineCoords, VoigtCoords, ResCoords;
-  vector <vector <Coord> > Neighbours;
+void AnalyserWindow::addNewLines (XgSpectrum *Spectrum, unsigned int Index,
+  vector <XgLine> NewLines) {
+  LineProfiler Profiler;
+  Profiler.compute (Spectrum, NewLines, Options.num_threads ());
+  addNewLines (Spectrum, Index, NewLines, Profiler.profiles ());
+}
+
+
+//------------------------------------------------------------------------------
+// addNewLines (XgSpectrum *, unsigned int, vector <XgLine> &, 
+// vector <LineProfile> &) : Creates a plot for each line in NewLines from the
+// profiles already calculated for them by LineProfiler, then stores the lines
+// in Spectrum and LinePlots respectively. Spectrum is (or will become)
+// ExptSpectra[Index]. If Profiles is empty, the plots are left empty until
+// profileLines () is called. This must be called on the main loop.
+//
+void AnalyserWindow::addNewLines (XgSpectrum *Spectrum, unsigned int Index, 
+  vector <XgLine> &NewLines, vector <LineProfile> &Profiles) {
   vector <LineData *> Plots;
-  Coord NextPoint;
-  double ResidualRMS;
-  ostringstream oss;
+  PlotPosition Position;
+  Position.Spectrum = Index;
+  Position.List = Spectrum -> lines ().size ();
 
   // Create a plot for each object
   for (unsigned int i = 0; i < NewLines.size (); i ++) {
     Plots.push_back (new LineData (NewLines[i]));
-    Plots[i]->signal_selected().connect (sigc::mem_fun(*this, &AnalyserWindow::on_click_plot));
-    Plots[i]->signal_disabled().connect (sigc::mem_fun(*this, &AnalyserWindow::on_popup_disable_line));
-    Plots[i]->signal_hidden().connect (sigc::mem_fun(*this, &AnalyserWindow::on_popup_hide_line));
+    Plots[i]->signal_selected().connect (sigc::bind (sigc::mem_fun(*this, &AnalyserWindow::on_click_plot), Plots[i]));
+    Plots[i]->signal_disabled().connect (sigc::bind (sigc::mem_fun(*this, &AnalyserWindow::on_popup_disable_line), Plots[i]));
+    Plots[i]->signal_hidden().connect (sigc::bind (sigc::mem_fun(*this, &AnalyserWindow::on_popup_hide_line), Plots[i]));
     
     Plots[i] -> showParams (ViewLineParams);
-    Plots[i] -> addPlot (Spectrum -> data(NewLines[i].wavenumber(),
-      NewLines[i].width() * PLOT_WIDTH_RANGE), true, false);
-    LineCoords = Plots[i] -> getPlotData (0);
-    VoigtCoords = voigtProfile (NewLines[i], LineCoords);
-    Plots[i] -> addPlot (VoigtCoords);
-    
-    // Find neighbouring lines that might be sufficiently close to the current
-    // line to interfere with the residual RMS calculation.
-    Neighbours.clear ();
-    for (unsigned int j = (((int)i - 5 > 0) ? ((int)i - 5) : 0); 
-      j < ((i + 5 < NewLines.size ()) ? (i + 5) : NewLines.size ()); j ++) {
-      if (j != i && abs (NewLines[j].wavenumber () - NewLines[i].wavenumber ()) 
-        < 3 * DEF_PLOT_WIDTH) {
-        Neighbours.push_back (voigtProfile (NewLines[j], LineCoords));
-      }
+    if (i < Profiles.size ()) fillLinePlot (Plots[i], Profiles[i]);
+    Position.Line = i;
+    PlotPositions[Plots[i]] = Position;
+  }
+  
+  // Done generating new plots. Store the new lines in the Spectrum.
+  Spectrum -> lines_push_back (NewLines);
+  if (LinePlots.size () <= Index) LinePlots.resize (Index + 1);
+  LinePlots[Index].push_back (Plots);
+}
+
+
+//------------------------------------------------------------------------------
+// removeLineList (unsigned int, int) : Deletes the plots of every line in list
+// ListIndex of ExptSpectra[Spectrum], then removes the list. The plots are
+// taken out of the Profiles grid first, since it keeps a pointer to every plot
+// it displays. The plots of any later lists in the spectrum move down one list
+// in PlotPositions.
+//
+void AnalyserWindow::removeLineList (unsigned int Spectrum, int ListIndex) {
+  vector < vector <LineData *> > &Plots = LinePlots[Spectrum];
+  clearDisplayedPlots ();
+  if (ListIndex < (int)Plots.size ()) {
+    for (unsigned int i = 0; i < Plots[ListIndex].size (); i ++) {
+      PlotPositions.erase (Plots[ListIndex][i]);
+      delete (Plots[ListIndex][i]);
     }
-    // Calculate the residuals from the difference between the experimental line
-    // data and the Voigt profile generated from the XGremlin fit.
-    ResCoords.clear ();
-    ResidualRMS = 0.0;
-    for (unsigned int k = 0; k < VoigtCoords.size (); k ++) {
-      NextPoint = Coord (LineCoords[k].x, LineCoords[k].y - VoigtCoords[k].y);
-      for (unsigned int j = 0; j < Neighbours.size (); j ++) {
-        NextPoint.y -= Neighbours [j][k].y;
+    for (unsigned int i = ListIndex + 1; i < Plots.size (); i ++) {
+      for (unsigned int j = 0; j < Plots[i].size (); j ++) {
+        PlotPositions[Plots[i][j]].List --;
       }
-      ResCoords.push_back (NextPoint);
-      ResidualRMS += ResCoords[k].y * ResCoords[k].y;
     }
-    ResidualRMS = sqrt (ResidualRMS / VoigtCoords.size ());
-    NewLines[i].noise (ResidualRMS);
-    
-    Plots[i] -> setPlotColour (0, 0.5, 0.5, 0.5);
-    Plots[i] -> setPlotWidth (1, 1.0);
-    Plots[i] -> addResidual (ResCoords);
+    Plots.erase (Plots.begin () + ListIndex);
   }
-  
-  // Done generating new plots. Store the new lines and plots in the Spectrum.
-  Spectrum -> lines_push_back (NewLines);
-  Spectrum -> plots_push_back (Plots);
+  ExptSpectra[Spectrum].remove_linelist (ListIndex);
 }
-  
+
 
 //------------------------------------------------------------------------------
-// plotLines (XgSpectrum, int) : Plots all the XGremlin lines passed in at arg1.
+// removeSpectrum (unsigned int) : Removes ExptSpectra[Index] along with the
+// plots of all its lines and any links to it. The spectra after it move down
+// one place, so the links and plot positions that refer to them are renumbered
+// and the spectra are given new index letters. This is shared by
+// on_data_remove_spectrum () and replayJournal ().
 //
-void AnalyserWindow::plotLines (XgSpectrum XgData, int Index) {
-  vector <Coord> LineCoords, VoigtCoords, ResCoords;
-  Gtk::TreeModel::Row row;
-  
+void AnalyserWindow::removeSpectrum (unsigned int Index) {
+  if (Index >= ExptSpectra.size ()) return;
+  while (ExptSpectra[Index].linesPtr2 () -> size () > 0) {
+    removeLineList (Index, ExptSpectra[Index].linesPtr2 () -> size () - 1);
+  }
   clearDisplayedPlots ();
-  LineBoxes.push_back (XgData.plots()[Index]);
-  
-  modelDataXGr -> clear ();
-  modelDataBF -> clear ();
-  lineDataTreeModel -> clear ();
-  for (unsigned int i = 0; i < XgData.lines()[Index].size (); i ++) {
-    row = *(modelDataXGr -> append ());
+  ExptSpectra.erase (ExptSpectra.begin () + Index);
+  if (Index < LinePlots.size ()) LinePlots.erase (LinePlots.begin () + Index);
 
-    // Add the XGremlin line data to the table
-    row[colsDataXGr.spectrum] = "";
-    row[colsDataXGr.index] = XgData.lines()[Index][i].line ();
-    row[colsDataXGr.wavenumber] = XgData.lines()[Index][i].wavenumber ();
-    row[colsDataXGr.peak] = XgData.lines()[Index][i].peak ();
-    row[colsDataXGr.width] = XgData.lines()[Index][i].width ();
-    row[colsDataXGr.dmp] = XgData.lines()[Index][i].dmp ();
-    row[colsDataXGr.eqwidth] = XgData.lines()[Index][i].eqwidth () 
-      / XgData.response (XgData.lines()[Index][i].wavenumber ());
-    row[colsDataXGr.epstot] = XgData.lines()[Index][i].epstot ();
-    row[colsDataXGr.epsevn] = XgData.lines()[Index][i].epsevn ();
-    row[colsDataXGr.epsodd] = XgData.lines()[Index][i].epsodd ();
-    row[colsDataXGr.epsran] = XgData.lines()[Index][i].epsran ();
-    row[colsDataXGr.id] = XgData.lines()[Index][i].id ();
-    row[colsDataXGr.profile] = LineBoxes[0][i];
-    if (XgData.response (XgData.lines()[Index][i].wavenumber ()) == 1.0) {
-      row[colsDataXGr.eq_width_colour] = Gdk::Color (AW_EQWIDTH_NO_NORM_COLOUR);
-      row[colsDataXGr.bg_colour] = Gdk::Color (AW_PARENT_LINE_COLOUR);
+  for (int i = LinkedSpectra.size () - 1; i >= 0; i --) {
+    if (LinkedSpectra[i].a == Index || LinkedSpectra[i].b == Index) {
+      LinkedSpectra.erase (LinkedSpectra.begin () + i);
     } else {
-      row[colsDataXGr.eq_width_colour] = Gdk::Color (AW_EQWIDTH_NORM_COLOUR);
-      row[colsDataXGr.bg_colour] = Gdk::Color (AW_PARENT_LINE_COLOUR);
+      if (LinkedSpectra[i].a > Index) LinkedSpectra[i].a --;
+      if (LinkedSpectra[i].b > Index) LinkedSpectra[i].b --;
     }
   }
-  
-  for (unsigned int i = 0; i < LineBoxes.size (); i ++) {
-    frameSpectrumPlots.push_back (new Gtk::Frame);
-    hboxSpectrumPlots.push_back (new Gtk::HBox);
-    frameSpectrumPlots[i] -> set_label ("Name");
-    frameSpectrumPlots[i] -> add ((Gtk::Widget &) *hboxSpectrumPlots [i]);
-    frameSpectrumPlots[i] -> show ();
-    hboxSpectrumPlots[i] -> show ();
-    for (unsigned int j = 0; j < LineBoxes[i].size (); j ++) {
-      hboxSpectrumPlots[i] -> pack_start ((Gtk::Widget &) *LineBoxes[i][j], false, false, 0);
-      LineBoxes[i][j] -> show ();
+
+  for (unsigned int i = Index; i < ExptSpectra.size (); i ++) {
+    string Label;
+    Label.push_back (char (i + ASCII_A));
+    ExptSpectra[i].index (Label);
+  }
+  for (unsigned int i = Index; i < LinePlots.size (); i ++) {
+    for (unsigned int j = 0; j < LinePlots[i].size (); j ++) {
+      for (unsigned int k = 0; k < LinePlots[i][j].size (); k ++) {
+        PlotPositions[LinePlots[i][j][k]].Spectrum = i;
+      }
     }
-    Profiles.pack_start ((Gtk::Widget &) *frameSpectrumPlots [i], false, false, 0);
   }
 }
 
 
 //------------------------------------------------------------------------------
-// compareLinkedSpectra (unsigned int, unsigned int, Gtk::TreeModel::Row) : If
-// the user has explicitly linked the two spectra specified at arg1 and arg2, it
-// is assumed that they were measured simultaneously, and have identical 
-// spectrometer response functions (or have been pre-processed to remove 
-// differences in response function). This will typically be the case when
-// linking spectra from FTS channel A and channel B. By definition, this link,
-// assets that the relative intensity of all lines in both spectra should be
-// identical. As a result, ANY line common to both spectra be used to calculate
-// a scaling factor rather than just the lines from the currently selected upper
-// level.
-//
-RatioAndError AnalyserWindow::compareLinkedSpectra (unsigned int a, unsigned int b, 
-  Gtk::TreeModel::Row parentRow) throw (int) {
-  
-  Gtk::TreeModel::Row row;
-  vector <XgLine> List1 = ExptSpectra[a].linesVector ();
-  vector <XgLine> List2 = ExptSpectra[b].linesVector ();
-  double Ratio = 0.0, Error = 0.0, AveRatio = 0.0, AveError = 0.0, RatioDenom = 0.0;
-  double SNR1, SNR2;
-  RatioAndError RtnRatioAndError;
-  ostringstream oss;
-  unsigned int NumLinesCompared = 0;
-  
-  for (unsigned int i = 0; i < List1.size (); i ++) {
-    for (unsigned int j = 0; j < List2.size (); j ++) {
-      if (abs (List1[i].wavenumber () - List2[j].wavenumber ()) < KuruczList.levelPrecision ()) {
-        // Add a new child row for the comparison of individual lines and
-        // fill it with the required information
-        row = *(modelDataComp -> append (parentRow->children()));
-        row[colsDataComp.ref] = ExptSpectra [a].index ();
-        row[colsDataComp.comparison] = ExptSpectra [b].index ();
-        row[colsDataComp.wavenumber] = "";
-
-        Ratio = List1[i].eqwidth () / List2[j].eqwidth ();
-        if (Options.correct_snr ()) {
-          SNR1 = List1[i].snr ();
-          SNR2 = List2[j].snr ();
-        } else {
-          SNR1 = List1[i].snr () / List1[i].noise();
-          SNR2 = List2[j].snr () / List2[j].noise();
-        } 
-        Error = sqrt(pow (SNR1, -2.0) + pow (SNR2, -2.0));
-        AveRatio += Ratio / pow (Error, 2.0);
-        RatioDenom += pow (Error, -2.0);
-        AveError += pow (Error, 2.0);
-        oss.str (""); oss << Ratio << " +/- " << Ratio * Error;
-        row[colsDataComp.ratio] = oss.str ();
-        oss.str (""); oss << List1[i].wavenumber();
-        row[colsDataComp.wavenumber] = oss.str ();
-        NumLinesCompared ++;
+// deleteLinePlots () : Deletes the plots of every line in the project. They are
+// taken out of the Profiles grid first, and any ProfileLinesJob still queued
+// for them is cancelled. Called when the project is replaced, once LevelLines,
+// which also points to the plots, has been cleared.
+//
+void AnalyserWindow::deleteLinePlots () {
+  map <pair <unsigned int, int>, ProfileLinesJob *>::iterator Queued;
+  for (Queued = ProfilingLists.begin (); Queued != ProfilingLists.end ();
+    Queued ++) {
+    Queued -> second -> cancel ();
+  }
+  ProfilingLists.clear ();
+  clearDisplayedPlots ();
+  for (unsigned int i = 0; i < LinePlots.size (); i ++) {
+    for (unsigned int j = 0; j < LinePlots[i].size (); j ++) {
+      for (unsigned int k = 0; k < LinePlots[i][j].size (); k ++) {
+        delete (LinePlots[i][j][k]);
       }
     }
   }
-  
-  if (NumLinesCompared == 0) {
-    throw (NO_COMPARISON_LINES_FOUNDS);
-  }
-  // Update the root node with the overall comparison information
-  AveRatio /= RatioDenom;
-  AveError = pow (AveError, 0.5) / NumLinesCompared;
-  parentRow[colsDataComp.ref] = ExptSpectra [a].index ();
-  parentRow[colsDataComp.comparison] = ExptSpectra [b].index ();
-  parentRow[colsDataComp.wavenumber] = "";
-  oss.str (""); oss << AveRatio << " +/- " << AveError;
-  parentRow[colsDataComp.ratio] = oss.str ();
-  RtnRatioAndError.Ratio = AveRatio;
-  RtnRatioAndError.Error = AveError;
-  RtnRatioAndError.a = a;
-  RtnRatioAndError.b = b;
-  return RtnRatioAndError;
-}    
-
- 
+  LinePlots.clear ();
+  PlotPositions.clear ();
+}
+
+
 //------------------------------------------------------------------------------
-// getBestScalingFactor (unsigned int, unsigned int, vector <RatioAndError>) :
-// Finds the best equivalent width scaling factor to use when overlapping the
-// two spectra specified at arg1 and arg2. If the two spectra do not overlap, or
-// if there are no common lines between them, this function will attempt to
-// calculate a compound scaling factor using intermediate spectra. Be careful:
-// this is a RECURSIVE function.
-//
-RatioAndError AnalyserWindow::getBestScalingFactor (unsigned int Start, 
-  unsigned int End, vector <RatioAndError> ScalingFactors) throw (int) {
-  
-  RatioAndError RtnFactor, NextFactor, Swap;
-  vector <RatioAndError> Subset;
-  RtnFactor.Error = -1;
-  
-  // Search through all available ScalingFactors to find a link from spectrum
-  // 'Start', A, to spectrum 'End', B.  
-  for (unsigned int i = 0; i < ScalingFactors.size (); i ++) {
-    if (ScalingFactors [i].a == Start) {
-      if (ScalingFactors [i].b == End) {
-        // Success: The factor linking A and B has been found. Return it.
-        return ScalingFactors [i];
-      } else {
-        // The current scaling factor starts at spectrum A, but does not link to
-        // B. It instead links to a third spectrum, C.
-        Subset = ScalingFactors;
-        Subset.erase (Subset.begin () + i);
-        try {
-          // Try to find to find another scaling factor that links C to B. This
-          // search is RECURSIVE, and so is capable of finding a suitable link
-          // from A to B with more than one intermediate spectrum.
-          NextFactor = getBestScalingFactor (ScalingFactors [i].b, End, Subset);
-        } catch (int e) {
-          try {
-            // No factor was found linking C to B, but one might exist that
-            // links B to C. If so, this can be inverted.
-            NextFactor = getBestScalingFactor (End, ScalingFactors [i].b, Subset);
-            Swap = NextFactor;
-            NextFactor.a = Swap.b;
-            NextFactor.b = Swap.a;
-            NextFactor.Ratio = 1.0 / Swap.Ratio;
-          } catch (int e) {
-            // No factor was found linking either C to B or B to C.
-            NextFactor.Error = -1;
-          }
+// refreshLinePlots (unsigned int, int) : Regenerates the plots of every line in
+// list ListIndex of ExptSpectra[SpectrumIndex] after the line parameters have
+// been changed. Only the lines whose profiles are not in the list's
+// ProfileStore are recalculated.
+//
+void AnalyserWindow::refreshLinePlots (unsigned int SpectrumIndex, 
+  int ListIndex) {
+  XgSpectrum *Spectrum = &ExptSpectra[SpectrumIndex];
+  LineProfiler Profiler;
+
+  Profiler.compute (Spectrum, Spectrum -> linesPtr2 () -> at (ListIndex),
+    Options.num_threads (), Spectrum -> profiles (ListIndex));
+  applyLineProfiles (SpectrumIndex, ListIndex, Profiler);
+}
+
+
+//------------------------------------------------------------------------------
+// applyLineProfiles (unsigned int, int, LineProfiler &) : Fills the plots of
+// list ListIndex of ExptSpectra[SpectrumIndex] with the profiles calculated by
+// Profiler, and replaces the list's ProfileStore with them. The existing
+// LineData objects are reused so that LevelLines remains valid, and their
+// selected, disabled and hidden states are kept. Must be called on the main
+// loop.
+//
+void AnalyserWindow::applyLineProfiles (unsigned int SpectrumIndex,
+  int ListIndex, LineProfiler &Profiler) {
+  XgSpectrum *Spectrum = &ExptSpectra[SpectrumIndex];
+  vector <XgLine> &Lines = Spectrum -> linesPtr2 () -> at (ListIndex);
+  LineData *Plot;
+
+  Spectrum -> profiles (ListIndex) -> set (Profiler.keys (), Profiler.profiles ());
+  for (unsigned int i = 0; i < Lines.size (); i ++) {
+    Lines[i].noise (Profiler.profiles ()[i].Noise);
+    Plot = LinePlots[SpectrumIndex][ListIndex][i];
+    Plot -> setLine (Lines[i]);
+    Plot -> clearPlots ();
+    fillLinePlot (Plot, Profiler.profiles ()[i]);
+    Plot -> redraw ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// applyRefit (RefittedList &, bool) : Applies the results of refitLines () to
+// the list they belong to. The fitted parameters are written into the lines,
+// the blend clusters are updated, and the plots of the lines whose profiles
+// have changed are regenerated. The other plots in the list are left alone.
+// Blended must match the value passed to refitLines (). Must be called on the
+// main loop.
+//
+void AnalyserWindow::applyRefit (RefittedList &Refitted, bool Blended) {
+  XgSpectrum *Spectrum = &ExptSpectra[Refitted.Spectrum];
+  vector <XgLine> &Lines = Spectrum -> linesPtr2 () -> at (Refitted.List);
+  LineClusters *Clusters = Spectrum -> clusters (Refitted.List);
+  LineData *Plot;
+
+  for (unsigned int i = 0; i < Refitted.Fitted.size (); i ++) {
+    VoigtRefitter::apply (Lines[Refitted.Fitted[i]], Refitted.Fits[i]);
+  }
+  if (Refitted.Fitted.size () > 0) Spectrum -> linesChanged ();
+  if (Clusters != NULL) {
+    for (unsigned int i = 0; i < Refitted.CleanClusters.size (); i ++) {
+      Clusters -> dirty (Refitted.CleanClusters[i], false);
+    }
+    Clusters -> update (Lines, Refitted.Fitted, !Blended);
+  }
+  for (unsigned int i = 0; i < Refitted.Plots.size (); i ++) {
+    Lines[Refitted.Plots[i]].noise (Refitted.Profiles[i].Noise);
+    Plot = LinePlots[Refitted.Spectrum][Refitted.List][Refitted.Plots[i]];
+    Plot -> setLine (Lines[Refitted.Plots[i]]);
+    Plot -> clearPlots ();
+    fillLinePlot (Plot, Refitted.Profiles[i]);
+    Plot -> redraw ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// profileLines (unsigned int, int) : Queues a ProfileLinesJob to calculate the
+// plots of list ListIndex of ExptSpectra[Spectrum] if any of them are still
+// empty, and one is not already queued. The lines of an opened project are only
+// profiled the first time one of them is displayed, since this also needs the
+// spectrum data to be read from the project file. Until the job has finished
+// the plots are shown empty.
+//
+void AnalyserWindow::profileLines (unsigned int Spectrum, int ListIndex) {
+  vector <LineData *> &Plots = LinePlots[Spectrum][ListIndex];
+  pair <unsigned int, int> List (Spectrum, ListIndex);
+  if (ProfilingLists.count (List) > 0) return;
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    if (!Plots[i] -> plotted ()) {
+      ProfilingLists[List] = new ProfileLinesJob (this, Spectrum, ListIndex);
+      Jobs.push (ProfilingLists[List]);
+      return;
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// refitLines (unsigned int, vector < vector <unsigned int> >, bool,
+// vector <RefittedList> &, Job *) : Refits lines in ExptSpectra[Spec] with
+// VoigtRefitter. Targets[j] lists the indices of the lines in list j that are
+// to be fitted. If Blended is false, each line is fitted separately with all
+// the other lines in its list held fixed. If it is true, every blend cluster
+// containing a target line is fitted as a single group. In both cases the fits
+// are shared between worker threads.
+//
+// This is run from RefitLinesJob, so the lines and plots are not changed here.
+// Each list is fitted and profiled as a copy, and the results added to
+// Refitted for applyRefit () to store on the main loop. Only the ProfileStore
+// of the list is updated, since it is a cache looked up by the contents of
+// each profile. The spectrum data, clusters and profile stores must already
+// have been created on the main loop. If Progress is not NULL, refitting stops
+// before the next list once it is cancelled. Returns the number of target
+// lines successfully refitted.
+//
+int AnalyserWindow::refitLines (unsigned int Spec, 
+  vector < vector <unsigned int> > Targets, bool Blended,
+  vector <RefittedList> &Refitted, Job *Progress) throw (Error) {
+  XgSpectrum *Spectrum = &ExptSpectra[Spec];
+  vector < vector <XgLine> > *SpectrumLines = Spectrum -> linesPtr2 ();
+  vector < vector <XgLine *> > Groups;
+  vector < vector <unsigned int> > GroupIndices;
+  vector < vector <VoigtFitResult> > Results;
+  vector <unsigned int> GroupClusters;
+  vector <Coord> Data = Spectrum -> data ();
+  vector <double> Y (Data.size ());
+  vector <XgLine> Lines;
+  VoigtRefitter Refitter;
+  ModelSpectrum Model;
+  LineClusters *Clusters;
+  int NumRefitted = 0;
+
+  if (Data.size () < 2) return 0;
+  for (unsigned int k = 0; k < Data.size (); k ++) Y[k] = Data[k].y;
+  Refitter.spectrum (Y, Data[0].x, Spectrum -> get_point_spacing ());
+
+  for (unsigned int j = 0; j < Targets.size () && j < SpectrumLines -> size ();
+    j ++) {
+    if (Targets[j].size () == 0) continue;
+    if (Progress != NULL && Progress -> cancelled ()) break;
+    Clusters = Spectrum -> clusters (j);
+    if (Clusters == NULL) return NumRefitted;
+    Lines = SpectrumLines -> at (j);
+    renderModel (Spectrum, Lines, Model);
+    vector <bool> IsTarget (Lines.size (), false);
+    for (unsigned int i = 0; i < Targets[j].size (); i ++) {
+      if (Targets[j][i] < IsTarget.size ()) IsTarget[Targets[j][i]] = true;
+    }
+
+    // Divide the target lines into groups to be fitted simultaneously
+    GroupIndices.clear ();
+    GroupClusters.clear ();
+    if (Blended) {
+      vector <bool> Used (Clusters -> size (), false);
+      for (unsigned int i = 0; i < Targets[j].size (); i ++) {
+        int c = Clusters -> clusterOf (Targets[j][i]);
+        if (c >= 0 && !Used[c]) {
+          Used[c] = true;
+          GroupIndices.push_back (Clusters -> cluster (c));
+          GroupClusters.push_back (c);
         }
-        // If a scaling factor was found linking C to B, combine it with the
-        // factor linking A to C to obtain the required link from A to B.
-        if (NextFactor.Error != -1) {
-          NextFactor.Ratio *= ScalingFactors [i].Ratio;
-          NextFactor.Error = 
-            sqrt (pow (NextFactor.Error, 2) + pow (ScalingFactors[i].Error, 2));
-          // Depending on which spectra are loaded in the current project, it
-          // may be possible to link A to B through different intermediary
-          // spectra. If this is the case, keep only the scaling factor that has
-          // the lowest associated uncertainty.
-          if (RtnFactor.Error == -1 || NextFactor.Error < RtnFactor.Error) {
-            RtnFactor = NextFactor;
-          }
+      }
+    } else {
+      for (unsigned int i = 0; i < Targets[j].size (); i ++) {
+        if (Targets[j][i] >= IsTarget.size ()) continue;
+        GroupIndices.push_back (vector <unsigned int> (1, Targets[j][i]));
+      }
+    }
+    Groups.clear ();
+    for (unsigned int g = 0; g < GroupIndices.size (); g ++) {
+      vector <XgLine *> NextGroup;
+      for (unsigned int k = 0; k < GroupIndices[g].size (); k ++) {
+        NextGroup.push_back (&Lines[GroupIndices[g][k]]);
+      }
+      Groups.push_back (NextGroup);
+    }
+
+    // Fit the groups and keep the converged results, writing them into the
+    // copy of the list so that it can be profiled. A blend is only marked as
+    // clean if every line in it was refitted successfully.
+    Refitter.fit (Groups, &Model, Options.num_threads ());
+    Results = Refitter.results ();
+    RefittedList Next;
+    Next.Spectrum = Spec;
+    Next.List = j;
+    for (unsigned int g = 0; g < Groups.size (); g ++) {
+      bool AllApplied = true;
+      for (unsigned int k = 0; k < Groups[g].size (); k ++) {
+        if (VoigtRefitter::apply (*Groups[g][k], Results[g][k])) {
+          Next.Fitted.push_back (GroupIndices[g][k]);
+          Next.Fits.push_back (Results[g][k]);
+          if (IsTarget[GroupIndices[g][k]]) NumRefitted ++;
+        } else {
+          AllApplied = false;
         }
       }
+      if (Blended && AllApplied) Next.CleanClusters.push_back (GroupClusters[g]);
     }
+
+    // Only the profiles whose keys have changed are recalculated. These belong
+    // to the refitted lines and to any neighbours whose residuals they
+    // overlap, so just those plots need to be regenerated.
+    LineProfiler Profiler;
+    Profiler.compute (Spectrum, Lines, Options.num_threads (),
+      Spectrum -> profiles (j));
+    Spectrum -> profiles (j) -> set (Profiler.keys (), Profiler.profiles ());
+    Next.Plots = Profiler.computed ();
+    for (unsigned int i = 0; i < Next.Plots.size (); i ++) {
+      Next.Profiles.push_back (Profiler.profiles ()[Next.Plots[i]]);
+    }
+    Refitted.push_back (Next);
   }
-  // If no suitable link was found from A to B, throw an error
-  if (RtnFactor.Error == -1) throw (NO_SCALING_RATIO_FOUND);
-  return RtnFactor;
+  return NumRefitted;
 }
+
+
+//------------------------------------------------------------------------------
+// queueRefit (vector < vector < vector <unsigned int> > >, bool, string) :
+// Refits the lines listed in Targets on a background thread. Targets[s][j]
+// lists the indices of the lines in list j of spectrum s that are to be
+// fitted. Detail is appended to the message shown once the refit is complete.
+//
+void AnalyserWindow::queueRefit
+  (vector < vector < vector <unsigned int> > > Targets, bool Blended,
+  string Detail) {
+  Jobs.push (new RefitLinesJob (this, Targets, Blended, Detail));
+}
+
+
+//------------------------------------------------------------------------------
+// plotLines (unsigned int, int) : Plots all the XGremlin lines in list Index of
+// ExptSpectra[Spectrum].
+//
+void AnalyserWindow::plotLines (unsigned int Spectrum, int Index) {
+  TRACE_SCOPE ("plotLines");
+  XgSpectrum &XgData = ExptSpectra[Spectrum];
+  vector <XgLine> &Lines = XgData.linesPtr2 () -> at (Index);
+  vector <Coord> LineCoords, VoigtCoords, ResCoords;
+  Gtk::TreeModel::Row row;
   
+  clearDisplayedPlots ();
+  LineBoxes.push_back (LinePlots[Spectrum][Index]);
+  for (unsigned int i = 0; i < LineBoxes[0].size (); i ++) {
+    updateSharedScale (LineBoxes[0][i]);
+  }
+  applyScale ();
   
-  
+  modelDataXGr -> clear ();
+  modelDataBF -> clear ();
+  lineDataTreeModel -> clear ();
+  for (unsigned int i = 0; i < Lines.size (); i ++) {
+    row = *(modelDataXGr -> append ());
 
+    // Add the XGremlin line data to the table
+    row[colsDataXGr.spectrum] = "";
+    row[colsDataXGr.index] = Lines[i].line ();
+    row[colsDataXGr.wavenumber] = Lines[i].wavenumber ();
+    row[colsDataXGr.peak] = Lines[i].peak ();
+    row[colsDataXGr.width] = Lines[i].width ();
+    row[colsDataXGr.dmp] = Lines[i].dmp ();
+    row[colsDataXGr.eqwidth] = Lines[i].eqwidth () 
+      / XgData.response (Lines[i].wavenumber ());
+    row[colsDataXGr.epstot] = Lines[i].epstot ();
+    row[colsDataXGr.epsevn] = Lines[i].epsevn ();
+    row[colsDataXGr.epsodd] = Lines[i].epsodd ();
+    row[colsDataXGr.epsran] = Lines[i].epsran ();
+    row[colsDataXGr.id] = Lines[i].id ();
+    row[colsDataXGr.profile] = LineBoxes[0][i];
+    if (XgData.response (Lines[i].wavenumber ()) == 1.0) {
+      row[colsDataXGr.eq_width_colour] = Gdk::Color (AW_EQWIDTH_NO_NORM_COLOUR);
+      row[colsDataXGr.bg_colour] = Gdk::Color (AW_PARENT_LINE_COLOUR);
+    } else {
+      row[colsDataXGr.eq_width_colour] = Gdk::Color (AW_EQWIDTH_NORM_COLOUR);
+      row[colsDataXGr.bg_colour] = Gdk::Color (AW_PARENT_LINE_COLOUR);
+    }
+  }
+  
+  vector <string> Titles (1, "(" + XgData.index() + ") " + XgData.name());
+  Profiles.set (LineBoxes, Titles);
+}
@@ -34,6 +34,8 @@
 //   analyserwindow_signal_data.cpp  : Signal handlers for the UI Data menu
 //   analyserwindow_signal_click.cpp : Signal handlers for UI click events
 //   analyserwindow_signal_popup.cpp : Signal handlers for UI popup menus
+//   analyserwindow_jobs.cpp         : Background jobs for loading data and
+//                                     matching lines off the GTK main loop
 //
 #ifndef LINE_ANALYSER_WINDOW
 #define LINE_ANALYSER_WINDOW
@@ -56,9 +58,13 @@
 #include <gtkmm/toolbar.h>
 #include <gtkmm/paned.h>
 #include <gtkmm/iconfactory.h>
+#include <gtkmm/progressbar.h>
 #include <sys/stat.h>
 #include <gtkmm/main.h>
 #include <cstdio>
+#include <map>
+#include <set>
+#include <algorithm>
 #if defined (_WIN32)
   #include <direct.h>
 #endif
@@ -71,13 +77,35 @@
 #include "graph.h"
 #include "linedata.h"
 #include "voigtlsqfit.h"
+#include "modelspectrum.h"
+#include "voigtfit.h"
+#include "lineprofile.h"
 #include "xgspectrum.h"
 #include "about.h"
 #include "outputwindow.h"
 #include "optionswindow.h"
+#include "perfwindow.h"
+#include "overviewwindow.h"
+#include "profilegrid.h"
+#include "arraymodel.h"
+#include "jobqueue.h"
+#include "ftsfile.h"
+#include "projectjournal.h"
+#include "projectfile.h"
+#include "bfengine.h"
+#include "inputcache.h"
+#include "trace.h"
 
 using namespace::std;
 
+// The kinds of file written when a project is exported
+#define EXPORT_TARGETS   0  // The Kurucz list
+#define EXPORT_SPECTRUM  1  // DAT and HDR files, or an ASCII spectrum
+#define EXPORT_LINES     2  // A LIN file or writelines list
+#define EXPORT_STD_LAMP  3
+#define EXPORT_RADIANCE  4
+#define EXPORT_RESPONSE  5
+
 // Model for treeLevels, which contains a list of all the target upper
 // levels loaded from a Kurucz line list.
 class LevelColumns : public Gtk::TreeModel::ColumnRecord {
@@ -92,26 +120,72 @@ class LevelColumns : public Gtk::TreeModel::ColumnRecord {
 };
 
 
+// The outcome of refitting some of the lines in one list in the background,
+// which is applied to the list on the main loop by applyRefit (). Fits[i] is
+// the converged fit of line Fitted[i], and CleanClusters lists the blends in
+// which every line was refitted. Profiles[i] is the new profile of line
+// Plots[i], for each line whose profile has changed.
+typedef struct refitted_list {
+  unsigned int Spectrum, List;
+  vector <unsigned int> Fitted;
+  vector <VoigtFitResult> Fits;
+  vector <unsigned int> CleanClusters;
+  vector <unsigned int> Plots;
+  vector <LineProfile> Profiles;
+} RefittedList;
+
+class SaveProjectJob;
+class ProfileLinesJob;
+
 class AnalyserWindow : public Gtk::Window {
 
+  friend class LoadSpectrumJob;
+  friend class LoadLineListJob;
+  friend class MatchLinesJob;
+  friend class RefitLinesJob;
+  friend class ProfileLinesJob;
+  friend class OpenProjectJob;
+  friend class SaveProjectJob;
+  friend class SnapshotProjectJob;
+  friend class ExportProjectJob;
+
   private:
     // Class variables to store all loaded Kurucz and XGremlin data
     KzList KuruczList;
     vector < XgSpectrum > ExptSpectra;
     vector < vector < vector <LinePair> > > LevelLines;
+    LineArena Placeholders;          // Blank lines and plots in LevelLines
+    map <LineData *, vector <unsigned int> > PlotLevels;  // Levels using a plot
+    vector < vector < vector <LineData *> > > LinePlots;  // [spectrum][list][line]
+    map <LineData *, PlotPosition> PlotPositions;  // Lines shown by each plot
+    map <pair <unsigned int, int>, ProfileLinesJob *> ProfilingLists;  // Queued
     vector < vector <LineData *> > LineBoxes; 
-    vector < Gtk::Frame *> frameSpectrumPlots;
-    vector < Gtk::HBox *> hboxSpectrumPlots;
+    bool SharedScale;                // True if LineBoxes share one Y scale
+    bool ScaleShared;                // SharedScale when it was last applied
+    GraphLimits SharedLimits;        // Y range of every plot in LineBoxes
+    map <LineData *, GraphLimits> PlotScales;  // Y range of each shown plot
+    multiset <double> ScaleMins, ScaleMaxes;   // The ranges in PlotScales
+    vector <LineData *> ScaleChanged;  // Plots to be given their Y scale
     vector <RatioAndError> ScalingFactors;
     bool ViewLineParams;
     string CurrentFilename;
     string DefaultFolder;
     bool ProjectChangedSinceSave;
-    typedef struct type_link_spectra { unsigned int a, b; } TypeLinkSpectra;
+    unsigned int ProjectChanges;     // Number of edits since the window opened
+    unsigned int NumSnapshots;       // Number of snapshots taken for saving
+    SaveProjectJob *PendingSave;     // The background save, if one is queued
+    ProjectJournal Journal;          // Edits made since the project was saved
+    InputCache Cache;                // Parsed copies of loaded source files
     vector <TypeLinkSpectra> LinkedSpectra;
+
+    JobQueue Jobs;
     sigc::connection LinkConnection, AbortLinkConnection;
+    sigc::connection RefreshConnection;  // Pending on_refresh_idle () call
+    unsigned int Dirty;                  // AW_DIRTY_* parts awaiting refresh
     OutputWindow Output;
     OptionsWindow Options;
+    PerformanceWindow Performance;
+    OverviewWindow Overview;
 
     // GTKmm VBox to hold all the widgets in the AnalyserWindow
     Gtk::VBox BaseBox;
@@ -134,7 +208,7 @@ class AnalyserWindow : public Gtk::Window {
     Gtk::ScrolledWindow scrollDataXGr; // Contains treeDataXGr
     Gtk::ScrolledWindow scrollDataComp;// Contains treeDataComp
     Gtk::ScrolledWindow scrollDataBF;  // Contains treeDataBF
-    Gtk::ScrolledWindow ProfileScroll; // Contains the Profiles table
+    Gtk::ScrolledWindow ProfileScroll; // Contains the Profiles grid
     Gtk::TreeView treeSpectra;         // Contains all the XGremlin spectra (ASCII) and line lists
     Gtk::TreeView treeLevels;          // Contains all upper levels loaded from a Kurucz list
     Gtk::TreeView treeLevelsBF;        // Contains BF data for loaded upper levels
@@ -142,8 +216,11 @@ class AnalyserWindow : public Gtk::Window {
     Gtk::TreeView treeDataXGr;         // Contains the XGremlin lines for the selected upper level
     Gtk::TreeView treeDataComp;        // Contains information for the comparison of loaded experimental spectra
     Gtk::TreeView treeDataBF;          // Contains BF and log(gf) data for each line in the selected upper level
-    Gtk::VBox Profiles;                // Displays plots for XGremlin lines corresponding to the selected upper level
+    ProfileGrid Profiles;              // Displays plots for XGremlin lines corresponding to the selected upper level
     Gtk::Statusbar Status;
+    Gtk::HBox StatusBox;               // Contains Status and the job progress widgets
+    Gtk::ProgressBar JobProgress;      // Shows the progress of background jobs
+    Gtk::Button JobCancel;             // Cancels all background jobs
 
     // Properties for creating an editable text cell for level lifetimes
     Gtk::CellRendererText textLifetime, textLifetimeError;
@@ -166,10 +243,16 @@ class AnalyserWindow : public Gtk::Window {
     Glib::RefPtr<Gtk::TreeStore> m_refTreeModel;
     Glib::RefPtr<Gtk::TreeStore> levelTreeModel;
     Glib::RefPtr<Gtk::TreeStore> modelLevelsBF;
-    Glib::RefPtr<Gtk::TreeStore> lineDataTreeModel;
+    Glib::RefPtr<ArrayModel> lineDataTreeModel;   // Rows of TargetLines
     Glib::RefPtr<Gtk::TreeStore> modelDataXGr;
     Glib::RefPtr<Gtk::TreeStore> modelDataComp;
-    Glib::RefPtr<Gtk::TreeStore> modelDataBF;
+    Glib::RefPtr<ArrayModel> modelDataBF;         // Rows of BrFracData
+
+    // The data shown in the "Kurucz Data" and "Br. Frac. Data" tabs. TargetFound
+    // is true for each target line that is matched by an XGremlin line.
+    vector <KzLine> TargetLines;
+    vector <bool> TargetFound;
+    vector <DataBF> BrFracData;
 
     // List of recently loaded .FTS files for the File toolbar menu
     vector <string> RecentFiles;
@@ -182,46 +265,90 @@ class AnalyserWindow : public Gtk::Window {
     void add_stock_item(const char *name[], Glib::ustring id, Glib::ustring label);
     void plotLines 
       (vector < vector <LinePair *> > PlotLines, vector <unsigned int> PlotOrder);
-    void plotLines (XgSpectrum XgData, int Index);
+    void plotLines (unsigned int Spectrum, int Index);
     void generatePlots (vector < vector <LinePair *> > PlotLines);
-    vector <Coord> voigtProfile (XgLine LineIn, vector <Coord> Points);
-    vector <LinePair> getLinePairs (vector <KzLine *> KzLevel, int Spec);
-    vector < vector <LinePair> > getLinePairs (vector <KzLine *> KzLevel);
+    BfEngine engine ();
+    vector < vector <LineMatch> > lineMatches (vector < vector <LinePair *> > &Pairs);
+    vector < vector <LinePair> > matchLinePairs (vector <KzLine *> KzLevel);
+    vector < vector < vector <LinePair> > > matchAllLevels (Job *Progress = NULL);
+    void installLinePairs (vector < vector < vector <LinePair> > > Pairs);
     void getLinePairs ();
-    bool matchedXgLineExists (KzLine LineIn, double Discrimintor);
+    void queueLineMatching (sigc::slot <void> Then);
+    vector <bool> matchedXgLinesExist (vector <KzLine> &Lines, 
+      double Discriminator);
     void clearDisplayedPlots ();
-    void updateKuruczCompleteness ();
-    void updateKuruczBF ();
+    void updateKuruczCompleteness (int OnlyLevel = -1);
+    void updateKuruczCompleteness (LineData *Plot);
+    void updateKuruczBF (int OnlyLevel = -1);
     void loadXGremlinData ();
+    int displayedLevel ();
+    void orderLinePairs (int Level, vector < vector <LinePair *> > &OrderedPairs,
+      vector <string> &SpectrumLabels, vector <unsigned int> &SpectrumOrder);
+    void markDirty (unsigned int Parts);
+    void refreshDirty ();
     void updatePlottedData (bool CalcScaleFactors = true);
-    int do_load_expt_spectrum ();
-    void writeFileVersion (ofstream *BinOut);
-    void saveExptSpectra (ofstream *BinOut);
-    void saveKuruczList (ofstream *BinOut);
-    void saveInterface (ofstream *BinOut);
-    int readFileVersion (ifstream *BinIn);
-    void loadExptSpectra (ifstream *BinIn);
-    void loadKuruczList (ifstream *BinIn);
-    void loadInterface (ifstream *BinIn, int FileVersion);
+    int do_load_expt_spectrum (bool LoadLineList = false);
+    void addExptSpectrum (XgSpectrum NewSpectrum, string Filename);
+    void attachLineList (int Index, string Filename, vector <XgLine> &NewLines,
+      vector <char> LinHeader);
+    void lineListMatched ();
+    void saveInterface (ostream *BinOut);
+    void takeSnapshot (ProjectSnapshot &Project);
+    void snapshotInterface (ProjectSnapshot &Project);
+    void exportFile (unsigned int Type, unsigned int Spectrum,
+      unsigned int List, string Path, const vector <Coord> &Points)
+      throw (Error);
+    void readKuruczFile (string Filename) throw (Error);
+    void loadInterface (istream *BinIn, int FileVersion);
+    void installProject (string Filename, ProjectData &Project);
+    void fileOpenComplete (string Filename, int FileVersion, 
+      vector <char> Interface);
+    void fileOpenError (string Filename, Error Err);
     void refreshKuruczList ();
-    void refreshSpectraList ();
+    void refreshSpectraList (bool Rematch = true);
     void projectHasChanged (bool Changed);
+    void projectHasChanged (JournalRecord Edit);
+    void lineHasChanged (LineData *Plot);
+    void lineHasChanged (LineData *Plot, unsigned int Spectrum, 
+      unsigned int List, unsigned int Line);
+    void replayJournal (vector <JournalRecord> &Edits);
     void addToSpectraList (XgSpectrum NewSpectrum, int Index, bool Ref, bool Select);
-    void addNewLines (XgSpectrum *Spectrum, vector <XgLine> NewLines);
+    vector <MemoryUse> memoryUsage ();
+    vector <XgSpectrum> *overviewSpectra ();
+    void addNewLines (XgSpectrum *Spectrum, unsigned int Index, 
+      vector <XgLine> NewLines);
+    void addNewLines (XgSpectrum *Spectrum, unsigned int Index, 
+      vector <XgLine> &NewLines, vector <LineProfile> &Profiles);
+    void removeLineList (unsigned int Spectrum, int ListIndex);
+    void removeSpectrum (unsigned int Index);
+    void deleteLinePlots ();
+    void renderModel (XgSpectrum *Spectrum, vector <XgLine> &Lines, 
+      ModelSpectrum &Model);
+    void fillLinePlot (LineData *Plot, LineProfile &Profile);
+    void refreshLinePlots (unsigned int SpectrumIndex, int ListIndex);
+    void applyLineProfiles (unsigned int SpectrumIndex, int ListIndex,
+      LineProfiler &Profiler);
+    void profileLines (unsigned int Spectrum, int ListIndex);
+    int refitLines (unsigned int Spec, vector < vector <unsigned int> > Targets,
+      bool Blended, vector <RefittedList> &Refitted, Job *Progress = NULL)
+      throw (Error);
+    void applyRefit (RefittedList &Refitted, bool Blended);
+    void queueRefit (vector < vector < vector <unsigned int> > > Targets,
+      bool Blended, string Detail = "");
     void updateKuruczList (KzList LineList);
+    void targetValue (unsigned int Row, int Column, Glib::ValueBase &Value);
     void updateXGremlinList (vector < vector <LinePair *> > OrderedPairs, 
       vector <string> SpectrumLabels, vector <unsigned int> SpectrumOrder);
     vector <DataBF> calculateBranchingFractions (vector < vector <LinePair *> > OrderedPairs, 
       vector <string> SpectrumLabels, vector <unsigned int> SpectrumOrder);
     void updateBranchingFractions (vector < vector <LinePair *> > OrderedPairs, 
       vector <string> SpectrumLabels, vector <unsigned int> SpectrumOrder);
+    void bfValue (unsigned int Row, int Column, Glib::ValueBase &Value);
     vector <RatioAndError> updateComparisonList (vector < vector <LinePair *> > 
       OrderedPairs, vector <string> SpectrumLabels, vector <unsigned int> SpectrumOrder);
-    void saveProject (string Filename) throw (Error);
-    RatioAndError compareLinkedSpectra (unsigned int a, unsigned int b, 
-      Gtk::TreeModel::Row parentRow) throw (int);
-    RatioAndError getBestScalingFactor (unsigned int Start, 
-      unsigned int End, vector <RatioAndError> ScalingFactors) throw (int);
+    void saveProject (string Filename, bool Background = false) throw (Error);
+    void projectSaved (string Filename, unsigned int Changes);
+    void projectSaveError (string Filename, Error Err);
     
     void lifetimeValidatedOnCellData(Gtk::CellRenderer* renderer, const Gtk::TreeModel::iterator& iter);
     void lifetimeErrorValidatedOnCellData(Gtk::CellRenderer* renderer, const Gtk::TreeModel::iterator& iter);
@@ -258,7 +385,7 @@ class AnalyserWindow : public Gtk::Window {
     void on_click_level_list (GdkEventButton* event);
     void on_click_level_list_bf (GdkEventButton* event);
     void on_click_treeDataXGr ();
-    void on_click_plot (bool Selected);
+    void on_click_plot (bool Selected, LineData *Plot);
     void row_callback_treeDataXGr (const Gtk::TreeModel::iterator& iter);
     // Handlers for items in right-click popup menus. These are implemented in analyserwindow_signal_popup.cpp
     void on_popup_remove_linelist ();
@@ -268,18 +395,36 @@ class AnalyserWindow : public Gtk::Window {
     void on_popup_show_hidden_lines ();
     void on_popup_remove_level ();
     void on_popup_export_linelist ();
+    void on_popup_refit_linelist ();
+    void on_popup_refit_dirty_blends ();
+    void on_popup_refit_spectrum ();
+    void on_popup_refit_level ();
     void on_popup_enable_line ();
-    void on_popup_disable_line (bool Disable);
-    void on_popup_hide_line ();
+    void on_popup_disable_line (bool Disable, LineData *Plot);
+    void on_popup_hide_line (LineData *Plot);
     // Miscellaneous signal handlers, which are implemented in analyserwindow_signal.cpp
     void on_tools_options ();
+    void on_tools_purge_cache ();
+    void on_tools_performance ();
+    void on_tools_overview ();
+    void on_overview_line (unsigned int Spectrum, unsigned int List,
+      unsigned int Line);
     void on_help_about ();
     void ref_spectrum_toggled (const Glib::ustring& path);
+    void on_jobs_busy (bool Busy);
+    void on_jobs_locked (bool Locked);
+    void on_job_progress (string Description, double Fraction);
+    void on_job_failed (string Description, string Message);
+    void on_job_cancel ();
     bool on_delete_event (GdkEventAny* event);
+    bool on_compact_journal ();
+    bool on_refresh_idle ();
     void do_link_spectrum (GdkEventButton* event);
     void abort_link_spectrum (GdkEventButton* event);
 
     void scaleGraphs ();
+    void updateSharedScale (LineData *Plot);
+    void applyScale ();
 
     // Model for treeLevelsBF, which contains all the level specific information
     // for branching fraction work. The bg_colour property allows the EW columns
@@ -413,4 +558,195 @@ class AnalyserWindow : public Gtk::Window {
     void fileOpen (string Filename);
 };
 
+
+//==============================================================================
+// Background jobs used by AnalyserWindow. The run () functions only read files
+// and the data held by the window, while anything that changes the window or
+// creates widgets is left to finish (). These are implemented in
+// analyserwindow_jobs.cpp.
+//==============================================================================
+
+// Loads an XGremlin spectrum and adds it to the list of experimental spectra.
+// If LoadLineList is true, the user is then asked for a line list to attach.
+class LoadSpectrumJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    string Filename;
+    bool LoadLineList;
+    XgSpectrum NewSpectrum;
+    Error LoadError;
+    bool Failed;
+
+  public:
+    LoadSpectrumJob (AnalyserWindow *WindowIn, string FilenameIn, 
+      bool LoadLineListIn);
+    void run ();
+    void finish ();
+    void abort ();
+};
+
+// Reads an XGremlin line list and attaches the lines lying between
+// MinWavenumber and MaxWavenumber to spectrum Index.
+class LoadLineListJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    string Filename;
+    int Index;
+    double MinWavenumber, MaxWavenumber;
+    vector <XgLine> NewLines;
+    vector <char> LinHeader;
+    Error LoadError;
+    bool Failed;
+
+  public:
+    LoadLineListJob (AnalyserWindow *WindowIn, string FilenameIn, int IndexIn,
+      double MinWavenumberIn, double MaxWavenumberIn);
+    void run ();
+    void finish ();
+};
+
+// Matches the target lines of every upper level with the experimental lines,
+// replacing LevelLines, and then calls Then.
+class MatchLinesJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    sigc::slot <void> Then;
+    vector < vector < vector <LinePair> > > Pairs;
+
+  public:
+    MatchLinesJob (AnalyserWindow *WindowIn, sigc::slot <void> ThenIn);
+    void run ();
+    void finish ();
+    void abort ();
+};
+
+// Refits the lines listed in Targets, where Targets[s][j] holds the indices of
+// the lines to fit in list j of spectrum s. Only the plots whose profiles have
+// changed are regenerated once the refit is complete.
+class RefitLinesJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    vector < vector < vector <unsigned int> > > Targets;
+    bool Blended;
+    string Detail;
+    unsigned int NumLines;
+    int NumRefitted;
+    vector <RefittedList> Refitted;
+    Error RefitError;
+    bool Failed;
+
+  public:
+    RefitLinesJob (AnalyserWindow *WindowIn,
+      vector < vector < vector <unsigned int> > > TargetsIn, bool BlendedIn,
+      string DetailIn);
+    void run ();
+    void finish ();
+    void abort ();
+};
+
+// Calculates the plots of a line list that has not yet been profiled, such as
+// one from an opened project. The plots are shown empty until the job has
+// finished, and are then filled in and the displayed level refreshed.
+class ProfileLinesJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    unsigned int Spectrum;
+    int List;
+    vector <XgLine> Lines;       // Copy whose noise levels the profiler sets
+    ProfileStore *Stored;
+    unsigned int NumThreads;
+    LineProfiler Profiler;
+    Error ProfileError;
+    bool Failed;
+
+  public:
+    ProfileLinesJob (AnalyserWindow *WindowIn, unsigned int SpectrumIn,
+      int ListIn);
+    void run ();
+    void finish ();
+    void abort ();
+};
+
+// Reads a project from an FTS file and replaces the current project with it.
+class OpenProjectJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    string Filename;
+    ProjectData Project;
+    Error LoadError;
+    bool Failed;
+
+  public:
+    OpenProjectJob (AnalyserWindow *WindowIn, string FilenameIn);
+    void run ();
+    void finish ();
+};
+
+// Writes a snapshot of the project to an FTS file. The file is written under a
+// temporary name and then renamed, so an interrupted save never leaves a
+// partially written project behind. This job does not read the window's data,
+// so the user may carry on working while it runs.
+class SaveProjectJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    string Filename;
+    ProjectSnapshot Project;
+    Error SaveError;
+    bool Failed;
+
+  public:
+    SaveProjectJob (AnalyserWindow *WindowIn, string FilenameIn);
+    ProjectSnapshot &snapshot () { return Project; }
+    void run ();
+    void finish ();
+    void abort ();
+};
+
+// Copies the project into the snapshot of a SaveProjectJob on a worker thread,
+// and then queues that job. This job is exclusive, so the project cannot be
+// edited while it is copied. The SaveProjectJob is deleted with this job if it
+// is never queued.
+class SnapshotProjectJob : public Job {
+  private:
+    AnalyserWindow *Window;
+    SaveProjectJob *Save;
+
+  public:
+    SnapshotProjectJob (AnalyserWindow *WindowIn, SaveProjectJob *SaveIn);
+    ~SnapshotProjectJob () { delete Save; }
+    void run ();
+    void finish ();
+    void abort ();
+};
+
+// Exports the files of the project to a directory. Each file is formatted in
+// memory and written in a single call, and several files are written at once
+// by a pool of threads. A file that cannot be written is reported at the end
+// without stopping the others.
+class ExportProjectJob : public Job {
+  private:
+    typedef struct export_file {
+      unsigned int Type;       // One of the EXPORT_ types
+      unsigned int Spectrum, List;
+      string Path;
+      vector <Coord> Points;   // Copy of the spectrum for EXPORT_SPECTRUM
+    } ExportFile;
+
+    AnalyserWindow *Window;
+    string Directory;
+    vector <ExportFile> Files;
+    vector <string> Failures;  // Names of the files that were not written
+    unsigned int NextFile, NumDone, NumThreads;
+    Glib::Mutex FileMutex;
+
+    void addFile (unsigned int Type, unsigned int Spectrum, unsigned int List,
+      string Name);
+    void worker ();
+
+  public:
+    ExportProjectJob (AnalyserWindow *WindowIn, string DirectoryIn);
+    void run ();
+    void finish ();
+};
+
 #endif // LINE_ANALYSER_WINDOW
@@ -41,6 +41,12 @@ AnalyserWindow::AnalyserWindow () {
   CurrentFilename = "";
   DefaultFolder = "";
   ProjectChangedSinceSave = false;
+  ProjectChanges = 0;
+  NumSnapshots = 0;
+  PendingSave = NULL;
+  Dirty = 0;
+  SharedScale = false;
+  ScaleShared = false;
   readConfigFile ();
 
   // Build the menubar and toolbar and add them to the top of the BaseBox
@@ -87,17 +93,51 @@ AnalyserWindow::AnalyserWindow () {
   
   // Populate the BaseBox (the main VBox) with the primary window Widgets
   BaseBox.pack_start (hpanedDivider, true, true, 0);
-  BaseBox.pack_start (Status, false, false, 0);
+  BaseBox.pack_start (StatusBox, false, false, 0);
+  StatusBox.pack_start (Status, true, true, 0);
+  StatusBox.pack_start (JobProgress, false, false, 2);
+  StatusBox.pack_start (JobCancel, false, false, 2);
   add (BaseBox);
+
+  // Prepare the background job queue and its progress display
+  JobCancel.set_label ("Cancel");
+  JobProgress.set_size_request (200);
+  Jobs.signal_progress ().connect
+    (sigc::mem_fun (*this, &AnalyserWindow::on_job_progress));
+  Jobs.signal_busy ().connect
+    (sigc::mem_fun (*this, &AnalyserWindow::on_jobs_busy));
+  Jobs.signal_locked ().connect
+    (sigc::mem_fun (*this, &AnalyserWindow::on_jobs_locked));
+  Jobs.signal_failed ().connect
+    (sigc::mem_fun (*this, &AnalyserWindow::on_job_failed));
+  JobCancel.signal_clicked ().connect
+    (sigc::mem_fun (*this, &AnalyserWindow::on_job_cancel));
+  Options.set_num_threads (VoigtRefitter::defaultThreads ());
+  Jobs.threads (Options.num_threads ());
+  Options.set_cache_limit (AW_INPUT_CACHE_DEFAULT_MB);
+  if (getenv ("HOME") != NULL) {
+    Cache.directory (string (getenv ("HOME")) + "/" + FAST_CACHE_DIR);
+  }
+  Cache.limit (uint64_t (Options.cache_limit ()) * 1048576);
+  Performance.memory_source (sigc::mem_fun (*this,
+    &AnalyserWindow::memoryUsage));
+  Overview.spectra_source (sigc::mem_fun (*this,
+    &AnalyserWindow::overviewSpectra));
+  Overview.signal_line_clicked ().connect (sigc::mem_fun (*this,
+    &AnalyserWindow::on_overview_line));
+  Glib::signal_timeout ().connect_seconds (sigc::mem_fun (*this,
+    &AnalyserWindow::on_compact_journal), AW_JOURNAL_COMPACT_SECONDS);
   
   // Create the tree models for the treeView objects
   m_refTreeModel = Gtk::TreeStore::create (m_Columns);
   levelTreeModel = Gtk::TreeStore::create (levelCols);
   modelLevelsBF = Gtk::TreeStore::create (levelColsBF);
-  lineDataTreeModel = Gtk::TreeStore::create (targetsCols);
+  lineDataTreeModel = ArrayModel::create (targetsCols,
+    sigc::mem_fun (*this, &AnalyserWindow::targetValue));
   modelDataXGr = Gtk::TreeStore::create (colsDataXGr);
   modelDataComp = Gtk::TreeStore::create (colsDataComp);
-  modelDataBF = Gtk::TreeStore::create (colsDataBF);
+  modelDataBF = ArrayModel::create (colsDataBF,
+    sigc::mem_fun (*this, &AnalyserWindow::bfValue));
 
   // Add columns to the Upper Levels tree
   treeLevels.set_model (levelTreeModel);
@@ -472,6 +512,8 @@ AnalyserWindow::AnalyserWindow () {
       sigc::mem_fun(*this, &AnalyserWindow::on_popup_link_spectrum)));
     menulist.push_back(Gtk::Menu_Helpers::MenuElem("Show Hidden Lines in Current Level",
           sigc::mem_fun(*this, &AnalyserWindow::on_popup_show_hidden_lines)));
+    menulist.push_back(Gtk::Menu_Helpers::MenuElem("Refit All Lines",
+      sigc::mem_fun(*this, &AnalyserWindow::on_popup_refit_spectrum)));
     menulist.push_back(Gtk::Menu_Helpers::MenuElem("Remove Spectrum",
       sigc::mem_fun(*this, &AnalyserWindow::on_data_remove_spectrum)));
   }
@@ -485,6 +527,10 @@ AnalyserWindow::AnalyserWindow () {
       sigc::mem_fun(*this, &AnalyserWindow::on_popup_remove_linelist) ) );
     menulist.push_back( Gtk::Menu_Helpers::MenuElem("Export Line List",
       sigc::mem_fun(*this, &AnalyserWindow::on_popup_export_linelist) ) );
+    menulist.push_back( Gtk::Menu_Helpers::MenuElem("Refit Lines",
+      sigc::mem_fun(*this, &AnalyserWindow::on_popup_refit_linelist) ) );
+    menulist.push_back( Gtk::Menu_Helpers::MenuElem("Refit Changed Blends",
+      sigc::mem_fun(*this, &AnalyserWindow::on_popup_refit_dirty_blends) ) );
   }
   menuLinelistPopup.accelerate(*this);
   
@@ -529,6 +575,8 @@ AnalyserWindow::AnalyserWindow () {
     Gtk::Menu::MenuList& menulist = menuLevelPopup.items();
     menulist.push_back(Gtk::Menu_Helpers::MenuElem("Load Kurucz Line List",
       sigc::mem_fun(*this, &AnalyserWindow::on_data_load_kurucz)));
+    menulist.push_back(Gtk::Menu_Helpers::MenuElem("Refit Level Lines",
+      sigc::mem_fun(*this, &AnalyserWindow::on_popup_refit_level)));
     menulist.push_back(Gtk::Menu_Helpers::MenuElem("Remove Level",
       sigc::mem_fun(*this, &AnalyserWindow::on_popup_remove_level)));
   }
@@ -550,6 +598,8 @@ AnalyserWindow::AnalyserWindow () {
 
   // Show all the widgets then display the window itself
   show_all_children ();
+  JobProgress.hide ();
+  JobCancel.hide ();
   show ();
 }
 
@@ -619,6 +669,15 @@ void AnalyserWindow::buildMenubarAndToolbar (bool PackWidgets) {
   m_refActionGroup->add( Gtk::Action::create("Options", "Options",
     "Allows a number of FAST options to be changed"),
     sigc::mem_fun(this, &AnalyserWindow::on_tools_options) );
+  m_refActionGroup->add( Gtk::Action::create("PurgeCache", "Purge Input Cache",
+    "Removes the parsed copies of previously loaded files"),
+    sigc::mem_fun(this, &AnalyserWindow::on_tools_purge_cache) );
+  m_refActionGroup->add( Gtk::Action::create("Performance", "Performance",
+    "Shows the time taken by each stage of FAST and the memory it uses"),
+    sigc::mem_fun(this, &AnalyserWindow::on_tools_performance) );
+  m_refActionGroup->add( Gtk::Action::create("Overview", "Spectrum Overview",
+    "Shows the whole of each spectrum with markers for its lines"),
+    sigc::mem_fun(this, &AnalyserWindow::on_tools_overview) );
   
   // Create the "Help" menu
   m_refActionGroup->add( Gtk::Action::create("HelpMenu", "_Help") );
@@ -679,6 +738,9 @@ void AnalyserWindow::buildMenubarAndToolbar (bool PackWidgets) {
         "    </menu>"
         "    <menu action='ToolsMenu'>"
         "      <menuitem action='Options'/>"
+        "      <menuitem action='PurgeCache'/>"
+        "      <menuitem action='Performance'/>"
+        "      <menuitem action='Overview'/>"
         "    </menu>"
         "    <menu action='HelpMenu'>"
         "      <menuitem action='About'/>"
@@ -17,375 +17,199 @@
 //==============================================================================
 // AnalyserWindow class (analyserwindow_io.cpp)
 //==============================================================================
-// This file contains I/O functions for saving FAST projects to disk and
-// restoring them later on.
+// This file contains I/O functions for saving FAST projects to disk. The file
+// itself is written and read back by ProjectFile (see projectfile.h).
 
 //==============================================================================
 // ANALYSERWINDOW BINARY I/O FUNCTIONS
 //==============================================================================
 
+
 //------------------------------------------------------------------------------
-// Read/write a file version tag from/to the beginning of the file. This is
-// currently unused, but may be important in the future if the FTS file format
-// changes and backward compatibility is needed.
-// 
-void AnalyserWindow::writeFileVersion (ofstream *BinOut) {
-  unsigned int Version = FTS_FILE_VERSION;
-  BinOut->write ((char*)&Version, sizeof (unsigned int));
+// takeSnapshot (ProjectSnapshot &) : Copies everything that is saved in an FTS
+// file into Project. This must be called on the main loop, but once it returns
+// Project can be written from any thread while the user continues to edit.
+//
+void AnalyserWindow::takeSnapshot (ProjectSnapshot &Project) {
+  ProjectFile::snapshot (KuruczList, ExptSpectra, LinkedSpectra, Project);
+  snapshotInterface (Project);
 }
 
-int AnalyserWindow::readFileVersion (ifstream *BinIn) {
-  unsigned int Version;
-  BinIn->read ((char*)&Version, sizeof (unsigned int));
-  return Version;
+
+//------------------------------------------------------------------------------
+// snapshotInterface (ProjectSnapshot &) : Copies the interface settings into
+// Project, along with the number of edits made so far. Everything else is left
+// for ProjectFile::snapshot (), which a SnapshotProjectJob calls on a worker.
+//
+void AnalyserWindow::snapshotInterface (ProjectSnapshot &Project) {
+  ostringstream InterfaceOut;
+  string Interface;
+
+  // The interface settings are read from the line plots, so they are written
+  // to a buffer here rather than on the thread that saves the file.
+  saveInterface (&InterfaceOut);
+  Interface = InterfaceOut.str ();
+  Project.Interface.assign (Interface.begin (), Interface.end ());
+  Project.Changes = ProjectChanges;
+  Project.Serial = NumSnapshots ++;
 }
 
 
 //------------------------------------------------------------------------------
-// saveExptSpectra (ofstream *) : Sends the loaded experimental spectra to the
-// binary ofstream passed in at arg 1. If this function is changed, care must be
-// taken to ensure that loadExptSpectra (ifstream *) is modified in a similar 
-// way or loading saved data will fail due to binary bit mismatches.
+// writeExportBuffer (string, const string &, bool) : Writes the whole of Buffer
+// to the file Path in a single call, in binary mode if Binary is true.
 //
-void AnalyserWindow::saveExptSpectra (ofstream *BinOut) {
-  unsigned int Size;
-  vector <Coord> PointsToSave;
-  vector <vector <XgLine> > LinesToSave;
-  vector <vector <char> > LinHeaders;
-  float NextPoint, PointSpacing, MinX;
-
-  // Determine how many experimental spectra there are
-  Size = ExptSpectra.size ();
-  BinOut->write ((char*)&Size, sizeof (unsigned int));
-  
-  // Save each experimental spectrum in turn
-  for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
-  
-    // Determine how many data points there are in the spectrum
-    PointsToSave = ExptSpectra[i].data ();
-    PointSpacing = ExptSpectra[i].get_point_spacing ();
-    Size = PointsToSave.size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    MinX = PointsToSave[0].x;
-    BinOut->write ((char*)&MinX, sizeof (float));
-    BinOut->write ((char*)&PointSpacing, sizeof (float));
-    
-    // Write each data point in turn
-    for (unsigned int j = 0; j < PointsToSave.size (); j ++) {
-      NextPoint = (float) PointsToSave [j].y;
-      BinOut->write ((char*) &NextPoint, sizeof (float));
-    }
-    
-    // Save the file header
-    vector <char> HeaderFile = ExptSpectra[i].headerFile ();
-    Size = HeaderFile.size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    for (unsigned int j = 0; j < Size; j ++) {
-      BinOut->write ((char*) &HeaderFile[j], sizeof (char));
-    }
-    
-    // Determine how many line lists are attached to the spectrum
-    LinesToSave = ExptSpectra[i].lines();
-    LinHeaders = ExptSpectra[i].linHeaders ();
-    Size = LinesToSave.size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    
-    // Write each line list in turn
-    for (unsigned int j = 0; j < LinesToSave.size (); j ++) {
-      Size = LinHeaders [j].size ();
-      BinOut->write ((char*)&Size, sizeof (unsigned int));
-      for (unsigned int k = 0; k < LinHeaders [j].size (); k ++) {
-        BinOut->write ((char*)&LinHeaders[j][k], sizeof (char));
-      }
-      Size = LinesToSave[j].size ();
-      BinOut->write ((char*)&Size, sizeof (unsigned int));
-      for (unsigned int k = 0; k < LinesToSave [j].size (); k ++) {
-        LinesToSave [j][k].save (*BinOut);
-      }
-    }
-    
-    
-    // Write the standard lamp spectrum, if one exists.
-    PointsToSave = ExptSpectra[i].standard_lamp_spectrum();
-    Size = PointsToSave.size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    for (unsigned int j = 0; j < PointsToSave.size (); j ++) {
-      BinOut->write ((char*) &PointsToSave [j], sizeof (Coord));
-    }
-    
-    // Write the standard lamp radiance data, if any exists.
-    Size = ExptSpectra[i].radiance().size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    for (unsigned int j = 0; j < ExptSpectra[i].radiance().size (); j ++) {
-      BinOut->write ((char*) &ExptSpectra[i].radiance() [j], sizeof (Coord));
-    }
-    
-    // Write the standard lamp radiance uncertainties, if any exist.
-    Size = ExptSpectra[i].radiance_error_ranges().size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    for (unsigned int j = 0; j < Size; j ++) {
-      BinOut->write ((char*) &ExptSpectra[i].radiance_error_ranges()[j], sizeof (ErrRange));
-    }
-    
-    // Finally, save the name, standard lamp name, index, and reference status 
-    // of the spectrum
-    Size = ExptSpectra[i].name().size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    char NameOut [Size];
-    strcpy (NameOut, ExptSpectra[i].name().c_str());
-    BinOut->write (NameOut, sizeof(char) * Size);
-
-    Size = ExptSpectra[i].standard_lamp_file().size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    char StandardLampFileOut [Size];
-    strcpy (StandardLampFileOut, ExptSpectra[i].standard_lamp_file().c_str());
-    BinOut->write (StandardLampFileOut, sizeof(char) * Size);
-    
-    Size = ExptSpectra[i].radiance_file().size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    char RadianceFileOut [Size];
-    strcpy (RadianceFileOut, ExptSpectra[i].radiance_file().c_str());
-    BinOut->write (RadianceFileOut, sizeof(char) * Size);
-
-    Size = ExptSpectra[i].index().size ();
-    BinOut->write ((char*)&Size, sizeof (unsigned int));
-    char IndexOut [Size];
-    strcpy (IndexOut, ExptSpectra[i].index().c_str());
-    BinOut->write (IndexOut, sizeof(char) * Size);
-
-    bool Ref = ExptSpectra[i].isReference();
-    BinOut->write ((char*)&Ref, sizeof(bool));
+static void writeExportBuffer (string Path, const string &Buffer, bool Binary)
+  throw (Error) {
+  string Name = Path.substr (Path.find_last_of ("/\\") + 1);
+  FILE *Out = fopen (Path.c_str (), Binary ? "wb" : "w");
+  if (Out == NULL) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error opening " + Name,
+      "Check you have write permissions for the specified location."));
   }
-  
-  unsigned int LinkSize = LinkedSpectra.size ();
-  BinOut->write ((char*)&LinkSize, sizeof (unsigned int));
-  for (unsigned int i = 0; i < LinkedSpectra.size (); i ++) {
-    BinOut->write ((char*)&LinkedSpectra [i].a, sizeof (unsigned int));
-    BinOut->write ((char*)&LinkedSpectra [i].b, sizeof (unsigned int));
+  size_t Written = fwrite (Buffer.data (), 1, Buffer.size (), Out);
+  if (fclose (Out) != 0 || Written != Buffer.size ()) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error writing " + Name,
+      "Check there is enough space on the disk."));
   }
 }
 
 
 //------------------------------------------------------------------------------
-// loadExptSpectra (ifstream *) : Reads experimental spectrum information from
-// the ifstream at arg 1 that was previously saved with saveExptSpectra above.
+// appendExportPoints (string &, vector <Coord> &, bool) : Adds a line to Buffer
+// for each point, in the format used by the standard lamp, radiance and
+// response files. The radiance is stored as a logarithm, so Exp is set to
+// write out the exponent of each y value instead.
 //
-void AnalyserWindow::loadExptSpectra (ifstream *BinIn) {
-  unsigned int NumSpectra, DataSize, LinesSize, NumLists, StrSize, StdLampSize,
-    RadianceSize, RadErrSize, HeaderSize, LinHeaderSize;
-  XgLine NextLine;
-  XgSpectrum NextSpectrum;
-  Coord NextCoord;
-  ErrRange NextError;
-  vector <Coord> LoadedPoints;
-  vector <XgLine> NextLineSet;
-  vector <char> NextLinHeader;
-  vector <ErrRange> LoadedErrors;
-  float NextPoint, PointSpacing, MinX;
-  char NextChar;
-  
-  // Determine how many experimental spectra there are and either load each in
-  // turn. If there are no spectra, only the NumSpectra will be loaded.
-  BinIn->read ((char*)&NumSpectra, sizeof(unsigned int));
-//  cout << "NumSpectra: " << NumSpectra << endl;
-  // Load each experimental spectrum in turn
-  for (unsigned int i = 0; i < NumSpectra; i ++) {
-    NextSpectrum.clear ();
-    
-    // Determine how many data points there are in the spectrum
-    BinIn->read ((char*)&DataSize, sizeof (unsigned int));
-    BinIn->read ((char*)&MinX, sizeof (float));
-    BinIn->read ((char*)&PointSpacing, sizeof (float));
-    NextSpectrum.set_point_spacing (PointSpacing);
-    
-    // Read each data point into NextSpectrum
-    LoadedPoints.clear ();
-    for (unsigned int j = 0; j < DataSize; j ++) {
-      BinIn->read ((char*)&NextPoint, sizeof (float));
-      NextCoord.x = (double(j) * PointSpacing) + double(MinX);
-      NextCoord.y = NextPoint;
-      LoadedPoints.push_back (NextCoord);
-    }
-    NextSpectrum.data (LoadedPoints);
-    
-    // Load the file header
-    vector <char> HeaderFile;
-    BinIn->read ((char*)&HeaderSize, sizeof (unsigned int));
-    for (unsigned int j = 0; j < HeaderSize; j ++) {
-      BinIn->read ((char*) &NextChar, sizeof (char));
-      HeaderFile.push_back (NextChar);
-    }
-    NextSpectrum.headerFile (HeaderFile);
-
-    // Determine how many line lists are attached to the spectrum
-    BinIn->read ((char*)&NumLists, sizeof (unsigned int));
-    // Read each line list in turn into NextSpectrum
-    for (unsigned int j = 0; j < NumLists; j ++) {
-      BinIn->read ((char*)&LinHeaderSize, sizeof (unsigned int));
-      NextLinHeader.clear ();
-      for (unsigned int k = 0; k < LinHeaderSize; k ++) {
-        BinIn->read ((char*)&NextChar, sizeof (char));
-        NextLinHeader.push_back (NextChar);
-      }
-      BinIn->read ((char*)&LinesSize, sizeof (unsigned int));
-      NextLineSet.clear ();
-      for (unsigned int k = 0; k < LinesSize; k ++) {
-        NextLine.load (*BinIn);
-        NextLineSet.push_back (NextLine);
-      }
-      addNewLines (&NextSpectrum, NextLineSet);
-      NextSpectrum.lin_headers_push_back (NextLinHeader);
-    }
-    
-    // Read the standard lamp spectrum, if one exists
-    LoadedPoints.clear ();
-    BinIn->read ((char*)&StdLampSize, sizeof (unsigned int));
-    for (unsigned int j = 0; j < StdLampSize; j ++) {
-      BinIn->read ((char*)&NextCoord, sizeof (Coord));
-      LoadedPoints.push_back (NextCoord);
-    }      
-    NextSpectrum.standard_lamp_spectrum (LoadedPoints);
-
-    // Read the standard lamp radiance data, if any exists
-    LoadedPoints.clear ();
-    BinIn->read ((char*)&RadianceSize, sizeof (unsigned int));
-    for (unsigned int j = 0; j < RadianceSize; j ++) {
-      BinIn->read ((char*)&NextCoord, sizeof (Coord));
-      LoadedPoints.push_back (NextCoord);
-    }
-    NextSpectrum.radiance (LoadedPoints);
-    
-    // Read the standard lamp radiance uncertainties, if any exist
-    LoadedErrors.clear ();
-    BinIn->read ((char*)&RadErrSize, sizeof (unsigned int));
-    for (unsigned int j = 0; j < RadErrSize; j ++) {
-      BinIn->read ((char*)&NextError, sizeof (ErrRange));
-      LoadedErrors.push_back (NextError);
-    }
-    NextSpectrum.radiance_errors (LoadedErrors);
-    
-    // Finally, read the name, response file name, index, and reference status 
-    // of the spectrum
-    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
-    char NameIn [StrSize + 1];
-    BinIn->read (NameIn, sizeof(char) * StrSize);
-    NameIn [StrSize] = '\0';
-    NextSpectrum.name (string (NameIn));
-
-    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
-    char StdLampIn [StrSize + 1];
-    BinIn->read (StdLampIn, sizeof(char) * StrSize);
-    StdLampIn [StrSize] = '\0';
-    NextSpectrum.standard_lamp_file (string (StdLampIn));
-
-    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
-    char RadianceIn [StrSize + 1];
-    BinIn->read (RadianceIn, sizeof(char) * StrSize);
-    RadianceIn [StrSize] = '\0';
-    NextSpectrum.radiance_file (string (RadianceIn));
-
-    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
-    char IndexIn [StrSize + 1];
-    BinIn->read (IndexIn, sizeof(char) * StrSize);
-    IndexIn [StrSize] = '\0';
-    NextSpectrum.index (string (IndexIn));
-
-    bool Ref;
-    BinIn->read ((char*)&Ref, sizeof(bool));
-    NextSpectrum.isReference (Ref);
-    ExptSpectra.push_back (NextSpectrum);
-  }
-  
-  unsigned int LinkSize;
-  TypeLinkSpectra NextLink;
-  BinIn->read ((char*)&LinkSize, sizeof (unsigned int));
-  for (unsigned int i = 0; i < LinkSize; i ++) {
-    BinIn->read ((char*)&NextLink.a, sizeof (unsigned int));
-    BinIn->read ((char*)&NextLink.b, sizeof (unsigned int));
-    LinkedSpectra.push_back (NextLink);
+static void appendExportPoints (string &Buffer, vector <Coord> &Points,
+  bool Exp) {
+  char NextPoint [XGSPECTRUM_ASCII_POINT_SIZE];
+  Buffer.reserve (Buffer.size () + Points.size () * 28);
+  for (unsigned int i = 0; i < Points.size (); i ++) {
+    Buffer.append (NextPoint, sprintf (NextPoint, "%13.5f %13.6E\n",
+      Points[i].x, Exp ? exp (Points[i].y) : Points[i].y));
   }
-  
-  // Finally, refresh the list of spectra to display the newly loaded data.
-  refreshSpectraList ();
 }
 
 
 //------------------------------------------------------------------------------
-// saveKuruczList (ofstream *) : Sends the loaded Kurucz spectra to the binary
-// ofstream passed in at arg 1. If this function is changed, care must be taken
-// to ensure that loadKuruczList (ifstream *) is modified in a similar way or
-// loading saved data will fail due to binary bit mismatches.
+// exportFile (unsigned int, unsigned int, unsigned int, string,
+// const vector <Coord> &) : Writes one file of an exported project to Path.
+// Type is one of the EXPORT_ types, and Spectrum and List say which spectrum
+// and line list it belongs to. An EXPORT_SPECTRUM file is written from Points,
+// a copy of the spectrum data taken on the main loop. The file is formatted in
+// memory and then written in one go. Several files may be written at once by
+// ExportProjectJob, so the data must not be changed meanwhile.
 //
-void AnalyserWindow::saveKuruczList (ofstream *BinOut) {
-  unsigned int Size;
-  KzLine NextLine;
-  vector <KzLine> LinesToSave;
-  
-  // Determine how many lines are in the Kurucz list and save each in turn. If
-  // there are no lines, write a zero value for "Size" then return.
-  LinesToSave = KuruczList.lines ();
-  Size = LinesToSave.size ();
-  BinOut->write ((char*)&Size, sizeof (unsigned int));
-  if (Size != 0) {
-    for (unsigned int i = 0; i < Size; i ++) {
-      LinesToSave [i].save (*BinOut);
+void AnalyserWindow::exportFile (unsigned int Type, unsigned int Spectrum,
+  unsigned int List, string Path, const vector <Coord> &Points) throw (Error) {
+  string Buffer;
+  ostringstream Out;
+  char NextRange [2 * XGSPECTRUM_ASCII_POINT_SIZE];
+  bool Binary = false;
+
+  switch (Type) {
+    case EXPORT_TARGETS:
+      KuruczList.save (Out);
+      Buffer = Out.str ();
+      break;
+
+    case EXPORT_SPECTRUM:
+      try {
+        ExptSpectra[Spectrum].save (Path, Points);
+      } catch (int e) {
+        throw (Error (e, "Error writing " + ExptSpectra[Spectrum].name (),
+          "Check you have write permissions for the specified location."));
+      }
+      return;
+
+    case EXPORT_LINES: {
+      vector <XgLine> &Lines = ExptSpectra[Spectrum].linesPtr2 () -> at (List);
+      vector <char> LinHeader = ExptSpectra[Spectrum].linHeaders ()[List];
+      if (LinHeader.size () > 0) {
+        writeLinFile (Out, LinHeader, Lines);
+        Binary = true;
+      } else {
+        writeLines (Lines, Out);
+      }
+      Buffer = Out.str ();
+      break;
+    }
+
+    case EXPORT_STD_LAMP: {
+      vector <Coord> StdLamp = ExptSpectra[Spectrum].standard_lamp_spectrum ();
+      Buffer = "# Standard lamp spectrum created by FAST\n#\n";
+      Buffer += "# this was attached to " + ExptSpectra[Spectrum].name ()
+        + "\n#\n";
+      appendExportPoints (Buffer, StdLamp, false);
+      break;
+    }
+
+    case EXPORT_RADIANCE: {
+      vector <Coord> Radiance = ExptSpectra[Spectrum].radiance ();
+      vector <ErrRange> RadianceErr =
+        ExptSpectra[Spectrum].radiance_error_ranges ();
+      Buffer = "# Standard lamp radiance file created by FAST\n#\n";
+      Buffer += "# this was attached to " + ExptSpectra[Spectrum].name ()
+        + "\n#\n";
+      appendExportPoints (Buffer, Radiance, true);
+      Buffer += "U\n";
+      Buffer += "# Min wavelength   Max wavelength   Uncertainty / %\n";
+      Buffer += "# -------------------------------------------------\n";
+      for (unsigned int i = 0; i < RadianceErr.size (); i ++) {
+        Buffer.append (NextRange, sprintf (NextRange, "  %14.2f   %14.2f   %14.2f\n",
+          RadianceErr[i].min, RadianceErr[i].max, RadianceErr[i].err));
+      }
+      break;
+    }
+
+    case EXPORT_RESPONSE: {
+      vector <Coord> Response = ExptSpectra[Spectrum].response ();
+      Buffer = "# Spectral response function created by FAST\n#\n";
+      Buffer += "# Attached to spectrum : " + ExptSpectra[Spectrum].name ()
+        + "\n";
+      Buffer += "# Std. Lamp Spectrum   : "
+        + ExptSpectra[Spectrum].standard_lamp_file () + " \n";
+      Buffer += "# Std. Lamp Radiance   : "
+        + ExptSpectra[Spectrum].radiance_file () + " \n#\n";
+      appendExportPoints (Buffer, Response, false);
+      break;
     }
-    
-    // Save the name of the KuruczList
-    Size = KuruczList.name ().size ();
-    char NameOut [Size];
-    strcpy (NameOut, KuruczList.name().c_str());
-    BinOut->write ((char*)&Size, sizeof(unsigned int));
-    BinOut->write (NameOut, sizeof(char) * Size);
-    
-    // Save the Kurucz list level precision variable
-    double PrecisionOut = KuruczList.levelPrecision ();
-    BinOut->write ((char*)&PrecisionOut, sizeof(double));
   }
+  writeExportBuffer (Path, Buffer, Binary);
 }
 
 
 //------------------------------------------------------------------------------
-// loadKuruczList (ifstream *) : Reads Kurucz list information from the ifstream
-// at arg 1 that was previously saved with saveKuruczList above.
+// readKuruczFile (string) : Adds the lines in the Kurucz list file Filename to
+// KuruczList. The parsed lines, and their grouping into upper levels, are taken
+// from the input cache if the file has been loaded before.
 //
-void AnalyserWindow::loadKuruczList (ifstream *BinIn) {
-  unsigned int Size, NameSize;
-  KzLine NextLine;
-  double PrecisionIn;
+void AnalyserWindow::readKuruczFile (string Filename) throw (Error) {
   vector <KzLine> Lines;
+  vector < vector <unsigned int> > Levels;
+  double Precision = KuruczList.levelPrecision ();
 
-  // Determine how many lines are in the Kurucz list and either load each in
-  // turn or abort if there are no Kurucz lists available.
-  BinIn->read ((char*)&Size, sizeof (unsigned int));
-  if (Size == 0) return;  
-  for (unsigned int i = 0; i < Size; i ++) {
-    NextLine.load (*BinIn);
-    Lines.push_back (NextLine);
+  if (!Cache.read (Filename, Precision, Lines, Levels)) {
+    KzList Parsed;
+    Parsed.levelPrecision (Precision);
+    Parsed.read (Filename);
+    Lines = Parsed.lines ();
+    Levels = Parsed.upperLevelIndices ();
+    Cache.write (Filename, Precision, Lines, Levels);
+  }
+  if (KuruczList.size () == 0) {
+    KuruczList.assign (Lines, Levels);
+  } else {
+    KuruczList.push_back (Lines);
   }
-  KuruczList.push_back (Lines);
-
-  // Load the name of the KuruczList
-  BinIn->read ((char*)&NameSize, sizeof (unsigned int));
-  char NameIn [NameSize + 1];
-  BinIn->read (NameIn, sizeof(char) * NameSize);
-  NameIn [NameSize + 1] = '\0';
-  KuruczList.name (NameIn);
-
-  // Load the Kurucz list level precision variable
-  BinIn->read ((char*)&PrecisionIn, sizeof(double));
-  KuruczList.levelPrecision (PrecisionIn);
-  
-  // Finally, refresh the list of Kurucz lines to display the newly loaded data
-  getLinePairs ();
-  refreshKuruczList ();
 }
 
 
 //------------------------------------------------------------------------------
-// saveInterface (ofstream) : Saves interface settings to the project file
-// attached to the ofstream at arg1.
-void AnalyserWindow::saveInterface (ofstream *BinOut) {
+// saveInterface (ostream *) : Saves interface settings to the project file
+// attached to the ostream at arg1.
+void AnalyserWindow::saveInterface (ostream *BinOut) {
   bool Selected, Disabled, Hidden, CorrectSignalToNoise;
   for (unsigned int Level = 0; Level < LevelLines.size (); Level ++) {
     for (unsigned int i = 0; i < LevelLines[Level].size (); i ++) {
@@ -414,10 +238,10 @@ void AnalyserWindow::saveInterface (ofstream *BinOut) {
 
 
 //------------------------------------------------------------------------------
-// loadInterface (ifstream) : Loads interface settings from the project file
-// attached to the ifstream at arg1.
+// loadInterface (istream *, int) : Loads interface settings from the project
+// file attached to the istream at arg1.
 //
-void AnalyserWindow::loadInterface (ifstream *BinIn, int FileVersion) {
+void AnalyserWindow::loadInterface (istream *BinIn, int FileVersion) {
   bool Selected, Disabled, Hidden, CorrectSignalToNoise;
 
   // Up to version 0.6.5, the disabled and hidden status of a line was not
@@ -458,3 +282,107 @@ void AnalyserWindow::loadInterface (ifstream *BinIn, int FileVersion) {
   }
   updateKuruczCompleteness ();
 }
+
+
+//------------------------------------------------------------------------------
+// replayJournal (vector <JournalRecord> &) : Applies the edits recovered from a
+// project's journal, which must be done once the project has been opened and
+// its interface settings loaded. Edits that refer to items that no longer
+// exist are skipped. The window is then refreshed to show the edited project.
+//
+void AnalyserWindow::replayJournal (vector <JournalRecord> &Edits) {
+  bool Rematch = false;
+
+  clearDisplayedPlots ();
+  for (unsigned int n = 0; n < Edits.size (); n ++) {
+    JournalRecord &Edit = Edits[n];
+    bool ValidSpectrum = Edit.A < ExptSpectra.size ();
+    switch (Edit.Type) {
+
+      case JOURNAL_LINE_STATE:
+      {
+        if (!ValidSpectrum || Edit.B >= ExptSpectra[Edit.A].linesPtr2 () -> size ()
+          || Edit.C >= ExptSpectra[Edit.A].linesPtr2 () -> at (Edit.B).size ()) {
+          break;
+        }
+        LineData *Plot = LinePlots[Edit.A][Edit.B][Edit.C];
+        Plot -> hidden ((Edit.Flags & JOURNAL_HIDDEN) != 0);
+        Plot -> disabled ((Edit.Flags & JOURNAL_DISABLED) != 0);
+        Plot -> selected ((Edit.Flags & JOURNAL_SELECTED) != 0);
+        break;
+      }
+
+      case JOURNAL_LIFETIME:
+        if (Edit.A < KuruczList.numUpperLevels ()) {
+          KuruczList.set_upper_level_lifetime (Edit.A, Edit.Value);
+          KuruczList.set_upper_level_lifetime_error (Edit.A, Edit.Error);
+        }
+        break;
+
+      case JOURNAL_REFERENCE:
+        if (!ValidSpectrum) break;
+        if (Edit.Flags & JOURNAL_REF) {
+          for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
+            ExptSpectra[i].isReference (false);
+          }
+        }
+        ExptSpectra[Edit.A].isReference ((Edit.Flags & JOURNAL_REF) != 0);
+        break;
+
+      case JOURNAL_LINK:
+      {
+        if (!ValidSpectrum || Edit.B >= ExptSpectra.size () || Edit.A == Edit.B) {
+          break;
+        }
+        bool Linked = false;
+        for (unsigned int i = 0; i < LinkedSpectra.size () && !Linked; i ++) {
+          Linked = LinkedSpectra[i].a == Edit.A && LinkedSpectra[i].b == Edit.B;
+        }
+        if (!Linked) {
+          TypeLinkSpectra NewLink;
+          NewLink.a = Edit.A;
+          NewLink.b = Edit.B;
+          LinkedSpectra.push_back (NewLink);
+        }
+        break;
+      }
+
+      case JOURNAL_REMOVE_SPECTRUM:
+        if (!ValidSpectrum) break;
+        removeSpectrum (Edit.A);
+        Rematch = true;
+        break;
+
+      case JOURNAL_REMOVE_LIST:
+        if (ValidSpectrum && Edit.B < ExptSpectra[Edit.A].linesPtr2 () -> size ()) {
+          removeLineList (Edit.A, Edit.B);
+          Rematch = true;
+        }
+        break;
+
+      case JOURNAL_REMOVE_STD_LAMP:
+        if (ValidSpectrum) ExptSpectra[Edit.A].remove_standard_lamp_spectrum ();
+        break;
+
+      case JOURNAL_REMOVE_RADIANCE:
+        if (ValidSpectrum) ExptSpectra[Edit.A].remove_radiance ();
+        break;
+
+      case JOURNAL_REMOVE_LEVEL:
+        if (Edit.A < KuruczList.numUpperLevels ()) {
+          KuruczList.eraseUpperLevel (Edit.A);
+          if (KuruczList.size () == 0) KuruczList.clear ();
+          Rematch = true;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (Rematch) getLinePairs ();
+  refreshKuruczList ();
+  m_refTreeModel -> clear ();
+  refreshSpectraList (false);
+}
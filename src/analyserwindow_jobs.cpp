@@ -0,0 +1,644 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// AnalyserWindow class (analyserwindow_jobs.cpp)
+//==============================================================================
+// This file contains the background jobs used by AnalyserWindow to load data,
+// match and refit lines, and export projects without blocking the GTK main
+// loop. While any exclusive job is queued the window's actions and panes are
+// made insensitive (see on_jobs_locked ()), so the data read by the run ()
+// functions cannot be changed underneath them. SaveProjectJob works on its own
+// snapshot of the project and so is not exclusive. The snapshot is copied by
+// the exclusive SnapshotProjectJob that queues it.
+
+#include <iterator>
+
+using namespace::std;
+
+//==============================================================================
+// LoadSpectrumJob
+//==============================================================================
+
+LoadSpectrumJob::LoadSpectrumJob (AnalyserWindow *WindowIn, string FilenameIn,
+  bool LoadLineListIn) : Job ("Loading " +
+  FilenameIn.substr (FilenameIn.find_last_of ("/\\") + 1)) {
+  Window = WindowIn;
+  Filename = FilenameIn;
+  LoadLineList = LoadLineListIn;
+  Failed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Reads the spectrum from an XGremlin DAT file, or from an ASCII file
+// if Filename does not have a DAT header. The points of an ASCII spectrum are
+// taken from the input cache if they have been read before.
+//
+void LoadSpectrumJob::run () {
+  vector <Coord> Points;
+  try {
+    try {
+      NewSpectrum.loadDat (Filename);
+    } catch (Error e) {
+      if (e.code != FLT_FILE_HEAD_ERROR) {
+        throw (e);
+      } else if (Window -> Cache.read (Filename, Points)) {
+        NewSpectrum.data (Points);
+      } else {
+        NewSpectrum.loadAscii (Filename);
+        Points = NewSpectrum.data ();
+        Window -> Cache.write (Filename, Points);
+      }
+    }
+  } catch (Error e) {
+    LoadError = e;
+    Failed = true;
+  }
+  progress (1.0);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Adds the spectrum to the window and matches the Kurucz lines to
+// the new set of spectra. The user is then asked for a line list if required.
+//
+void LoadSpectrumJob::finish () {
+  if (Failed) {
+    Window -> display_error (&LoadError);
+    return;
+  }
+  Window -> addExptSpectrum (NewSpectrum, Filename);
+  if (LoadLineList) {
+    Window -> queueLineMatching (sigc::mem_fun (*Window,
+      &AnalyserWindow::on_data_load_line_list));
+  } else {
+    Window -> queueLineMatching (sigc::slot <void> ());
+  }
+}
+
+
+//==============================================================================
+// LoadLineListJob
+//==============================================================================
+
+LoadLineListJob::LoadLineListJob (AnalyserWindow *WindowIn, string FilenameIn,
+  int IndexIn, double MinWavenumberIn, double MaxWavenumberIn) : Job ("Loading "
+  + FilenameIn.substr (FilenameIn.find_last_of ("/\\") + 1)) {
+  Window = WindowIn;
+  Filename = FilenameIn;
+  Index = IndexIn;
+  MinWavenumber = MinWavenumberIn;
+  MaxWavenumber = MaxWavenumberIn;
+  Failed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Reads the lines from an XGremlin LIN file, or from a writelines file
+// if Filename does not end with .lin, and removes those outside the spectrum.
+// The parsed lines are taken from the input cache if the file has been read
+// before. Like those of an opened project, the plot profiles of the lines are
+// only calculated when they are first displayed.
+//
+void LoadLineListJob::run () {
+  try {
+    try {
+      bool Lin = Filename.size () >= 4
+        && Filename.substr(Filename.size() - 4, 4) == ".lin";
+      if (!Window -> Cache.read (Filename, NewLines, LinHeader)) {
+        if (Lin) {
+          NewLines = readLinFile (Filename);
+          LinHeader = readLinFileHeader (Filename);
+        } else {
+          NewLines = readLineList (Filename);
+        }
+        Window -> Cache.write (Filename, NewLines, LinHeader);
+      }
+    } catch (const char* e) {
+      cout << e << endl;
+      throw (Error (FLT_FILE_READ_ERROR, "File read error, check the terminal for details"));
+    }
+  } catch (Error e) {
+    LoadError = e;
+    Failed = true;
+    return;
+  }
+
+  // Remove lines that are outside the spectrum
+  for (int i = NewLines.size () - 1; i >= 0; i --) {
+    if (NewLines[i].wavenumber () < MinWavenumber ||
+      NewLines[i].wavenumber () > MaxWavenumber) {
+      NewLines.erase (NewLines.begin () + i);
+    }
+  }
+  progress (1.0);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Attaches the lines to their spectrum.
+//
+void LoadLineListJob::finish () {
+  if (Failed) {
+    Window -> display_error (&LoadError);
+    return;
+  }
+  Window -> attachLineList (Index, Filename, NewLines, LinHeader);
+}
+
+
+//==============================================================================
+// MatchLinesJob
+//==============================================================================
+
+MatchLinesJob::MatchLinesJob (AnalyserWindow *WindowIn,
+  sigc::slot <void> ThenIn) : Job ("Matching lines") {
+  Window = WindowIn;
+  Then = ThenIn;
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Matches the Kurucz and XGremlin lines.
+//
+void MatchLinesJob::run () {
+  Pairs = Window -> matchAllLevels (this);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Replaces LevelLines with the new line pairs.
+//
+void MatchLinesJob::finish () {
+  Window -> installLinePairs (Pairs);
+  Then ();
+}
+
+
+//------------------------------------------------------------------------------
+// abort () : LevelLines must always match the loaded spectra, so a cancelled
+// match is completed on the main loop rather than being abandoned.
+//
+void MatchLinesJob::abort () {
+  Window -> getLinePairs ();
+  Then ();
+}
+
+
+//==============================================================================
+// RefitLinesJob
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Constructor : Counts the target lines. Any spectrum data still held in a
+// project file is read here, on the main loop, and the blend clusters and
+// profile stores of the target lists are created, so that the job only ever
+// reads them.
+//
+RefitLinesJob::RefitLinesJob (AnalyserWindow *WindowIn,
+  vector < vector < vector <unsigned int> > > TargetsIn, bool BlendedIn,
+  string DetailIn) : Job ("Refitting lines") {
+  Window = WindowIn;
+  Targets = TargetsIn;
+  Blended = BlendedIn;
+  Detail = DetailIn;
+  NumLines = 0;
+  NumRefitted = 0;
+  Failed = false;
+  for (unsigned int s = 0; s < Targets.size (); s ++) {
+    XgSpectrum &Spectrum = Window -> ExptSpectra[s];
+    for (unsigned int j = 0; j < Targets[s].size (); j ++) {
+      if (Targets[s][j].size () == 0) continue;
+      NumLines += Targets[s][j].size ();
+      Spectrum.loadData ();
+      Spectrum.clusters (j);
+      Spectrum.profiles (j);
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Refits the target lines of each spectrum in turn and calculates the
+// profiles that have changed. The lines themselves are left alone until
+// finish ().
+//
+void RefitLinesJob::run () {
+  try {
+    for (unsigned int s = 0; s < Targets.size (); s ++) {
+      if (cancelled ()) return;
+      NumRefitted += Window -> refitLines (s, Targets[s], Blended, Refitted,
+        this);
+      progress (double (s + 1) / double (Targets.size ()));
+    }
+  } catch (Error e) {
+    RefitError = e;
+    Failed = true;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Writes the fitted parameters into the lines and regenerates the
+// plots whose profiles have changed.
+//
+void RefitLinesJob::finish () {
+  for (unsigned int i = 0; i < Refitted.size (); i ++) {
+    Window -> applyRefit (Refitted[i], Blended);
+  }
+  if (Failed) {
+    Window -> display_error (&RefitError);
+  } else {
+    ostringstream oss;
+    oss << "Refitted " << NumRefitted << " of " << NumLines << " lines"
+      << Detail;
+    Window -> Status.push (oss.str ());
+  }
+  if (Refitted.size () > 0) {
+    Window -> updatePlottedData ();
+    Window -> projectHasChanged (true);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// abort () : Applies the lists refitted before the job was cancelled, since
+// their profile stores have already been updated.
+//
+void RefitLinesJob::abort () {
+  finish ();
+}
+
+
+//==============================================================================
+// ProfileLinesJob
+//==============================================================================
+
+ProfileLinesJob::ProfileLinesJob (AnalyserWindow *WindowIn,
+  unsigned int SpectrumIn, int ListIn) : Job ("Profiling lines") {
+  Window = WindowIn;
+  Spectrum = SpectrumIn;
+  List = ListIn;
+  Failed = false;
+  XgSpectrum &XgData = Window -> ExptSpectra[Spectrum];
+  XgData.loadData ();
+  Lines = XgData.linesPtr2 () -> at (List);
+  Stored = XgData.profiles (List);
+  NumThreads = Window -> Options.num_threads ();
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Calculates the profiles of the lines. The plots are left alone until
+// finish ().
+//
+void ProfileLinesJob::run () {
+  try {
+    Profiler.compute (&Window -> ExptSpectra[Spectrum], Lines, NumThreads,
+      Stored);
+  } catch (Error e) {
+    ProfileError = e;
+    Failed = true;
+  }
+  progress (1.0);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Fills the plots of the list with the new profiles. If a level is
+// displayed it is refreshed, since the noise levels of its lines are now set.
+// Otherwise the list itself may be on show, and its plots are added to the
+// shared Y scale. Any error is reported, and the plots left empty.
+//
+void ProfileLinesJob::finish () {
+  Window -> ProfilingLists.erase (make_pair (Spectrum, List));
+  if (Failed) {
+    Window -> display_error (&ProfileError);
+    return;
+  }
+  Window -> applyLineProfiles (Spectrum, List, Profiler);
+  if (Window -> displayedLevel () != -1) {
+    Window -> markDirty (AW_DIRTY_ALL & ~AW_DIRTY_TARGETS);
+  } else {
+    map <LineData *, PlotPosition>::iterator Position;
+    for (unsigned int i = 0; i < Window -> LineBoxes.size (); i ++) {
+      for (unsigned int j = 0; j < Window -> LineBoxes[i].size (); j ++) {
+        Position = Window -> PlotPositions.find (Window -> LineBoxes[i][j]);
+        if (Position != Window -> PlotPositions.end ()
+          && Position -> second.Spectrum == Spectrum
+          && int (Position -> second.List) == List) {
+          Window -> updateSharedScale (Window -> LineBoxes[i][j]);
+        }
+      }
+    }
+    Window -> applyScale ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// abort () : The plots are left empty, to be profiled when next displayed.
+//
+void ProfileLinesJob::abort () {
+  map <pair <unsigned int, int>, ProfileLinesJob *>::iterator Queued =
+    Window -> ProfilingLists.find (make_pair (Spectrum, List));
+  if (Queued != Window -> ProfilingLists.end () && Queued -> second == this) {
+    Window -> ProfilingLists.erase (Queued);
+  }
+}
+
+
+//==============================================================================
+// OpenProjectJob
+//==============================================================================
+
+OpenProjectJob::OpenProjectJob (AnalyserWindow *WindowIn, string FilenameIn)
+  : Job ("Loading " + FilenameIn.substr (FilenameIn.find_last_of ("/\\") + 1)) {
+  Window = WindowIn;
+  Filename = FilenameIn;
+  Failed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Reads the project file into Project. The plot profiles of the lines
+// are not calculated until they are first displayed (see profileLines ()).
+//
+void OpenProjectJob::run () {
+  try {
+    ProjectFile::read (Filename, Project, this);
+    if (cancelled ()) return;
+  } catch (Error e) {
+    LoadError = e;
+    Failed = true;
+    return;
+  }
+  progress (1.0);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Replaces the current project with the one that has been read.
+//
+void OpenProjectJob::finish () {
+  if (Failed) {
+    Window -> fileOpenError (Filename, LoadError);
+    return;
+  }
+  Window -> installProject (Filename, Project);
+}
+
+
+//==============================================================================
+// SaveProjectJob
+//==============================================================================
+
+SaveProjectJob::SaveProjectJob (AnalyserWindow *WindowIn, string FilenameIn)
+  : Job ("Saving " + FilenameIn.substr (FilenameIn.find_last_of ("/\\") + 1),
+  false) {
+  Window = WindowIn;
+  Filename = FilenameIn;
+  Failed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Writes the snapshot to Filename.
+//
+void SaveProjectJob::run () {
+  try {
+    ProjectFile::write (Filename, Project, this);
+  } catch (Error e) {
+    SaveError = e;
+    Failed = true;
+  }
+  progress (1.0);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Tells the window whether or not the project was saved.
+//
+void SaveProjectJob::finish () {
+  if (Window -> PendingSave == this) Window -> PendingSave = NULL;
+  if (Failed) {
+    Window -> projectSaveError (Filename, SaveError);
+  } else {
+    Window -> projectSaved (Filename, Project.Changes);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// abort () : The save was cancelled, so the existing file was left untouched.
+//
+void SaveProjectJob::abort () {
+  if (Window -> PendingSave == this) {
+    Window -> PendingSave = NULL;
+    Window -> Status.push ("Save cancelled");
+  }
+}
+
+
+//==============================================================================
+// SnapshotProjectJob
+//==============================================================================
+
+SnapshotProjectJob::SnapshotProjectJob (AnalyserWindow *WindowIn,
+  SaveProjectJob *SaveIn) : Job (SaveIn -> description ()) {
+  Window = WindowIn;
+  Save = SaveIn;
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Copies the project into the snapshot of Save. The interface settings
+// have already been copied on the main loop.
+//
+void SnapshotProjectJob::run () {
+  if (Save -> cancelled ()) return;
+  ProjectFile::snapshot (Window -> KuruczList, Window -> ExptSpectra,
+    Window -> LinkedSpectra, Save -> snapshot ());
+  progress (1.0);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Queues Save to write the snapshot. If Save has been cancelled in
+// the meantime it is aborted by the queue without being run.
+//
+void SnapshotProjectJob::finish () {
+  Window -> Jobs.push (Save);
+  Save = NULL;
+}
+
+
+//------------------------------------------------------------------------------
+// abort () : The snapshot was cancelled, so Save is deleted with this job.
+//
+void SnapshotProjectJob::abort () {
+  if (Window -> PendingSave == Save) {
+    Window -> PendingSave = NULL;
+    Window -> Status.push ("Save cancelled");
+  }
+}
+
+
+//==============================================================================
+// ExportProjectJob
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Constructor : Lists the files to be written to DirectoryIn. The points of
+// each spectrum are copied here, on the main loop, reading any still held in a
+// project file, so that the workers write from their own copy and never change
+// the spectra.
+//
+ExportProjectJob::ExportProjectJob (AnalyserWindow *WindowIn,
+  string DirectoryIn) : Job ("Exporting " +
+  DirectoryIn.substr (DirectoryIn.find_last_of ("/\\") + 1)) {
+  Window = WindowIn;
+  Directory = DirectoryIn;
+  NextFile = 0;
+  NumDone = 0;
+  NumThreads = Window -> Options.num_threads ();
+
+  addFile (EXPORT_TARGETS, 0, 0, AW_DEF_TARGETS_NAME);
+  for (unsigned int i = 0; i < Window -> ExptSpectra.size (); i ++) {
+    XgSpectrum &Spectrum = Window -> ExptSpectra[i];
+    addFile (EXPORT_SPECTRUM, i, 0, Spectrum.name ());
+    Files.back ().Points = Spectrum.data ();
+    vector < vector <XgLine> > *Lines = Spectrum.linesPtr2 ();
+    for (unsigned int j = 0; j < Lines -> size (); j ++) {
+      if (Lines -> at (j).size () > 0) {
+        addFile (EXPORT_LINES, i, j, Lines -> at (j)[0].name ());
+      }
+    }
+    if (Spectrum.standard_lamp_spectrum ().size () != 0) {
+      addFile (EXPORT_STD_LAMP, i, 0, Spectrum.standard_lamp_file ());
+    }
+    if (Spectrum.radiance ().size () != 0) {
+      addFile (EXPORT_RADIANCE, i, 0, Spectrum.radiance_file ());
+    }
+    if (Spectrum.response ().size () > 0) {
+      addFile (EXPORT_RESPONSE, i, 0, Spectrum.name () + ".response");
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// addFile (unsigned int, unsigned int, unsigned int, string) : Adds a file
+// called Name to the list of those to be exported.
+//
+void ExportProjectJob::addFile (unsigned int Type, unsigned int Spectrum,
+  unsigned int List, string Name) {
+  ExportFile NewFile;
+  NewFile.Type = Type;
+  NewFile.Spectrum = Spectrum;
+  NewFile.List = List;
+  NewFile.Path = Directory + "/" + Name;
+  Files.push_back (NewFile);
+}
+
+
+//------------------------------------------------------------------------------
+// worker () : Repeatedly takes the next file from Files and writes it until
+// none remain or the job is cancelled. Run concurrently by every thread in
+// run (). A file that fails is recorded in Failures and the worker carries on.
+//
+void ExportProjectJob::worker () {
+  unsigned int Next;
+  while (!cancelled ()) {
+    {
+      Glib::Mutex::Lock lock (FileMutex);
+      Next = NextFile ++;
+    }
+    if (Next >= Files.size ()) return;
+    ExportFile &File = Files[Next];
+    try {
+      Window -> exportFile (File.Type, File.Spectrum, File.List, File.Path,
+        File.Points);
+    } catch (Error e) {
+      Glib::Mutex::Lock lock (FileMutex);
+      Failures.push_back (File.Path.substr (File.Path.find_last_of ("/\\")
+        + 1));
+    }
+    Glib::Mutex::Lock lock (FileMutex);
+    progress (double (++ NumDone) / Files.size ());
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Writes the files, sharing them between NumThreads threads (including
+// this one).
+//
+void ExportProjectJob::run () {
+  vector <Glib::Thread *> Workers;
+  if (NumThreads > Files.size ()) NumThreads = Files.size ();
+  for (unsigned int i = 1; i < NumThreads; i ++) {
+    try {
+      Workers.push_back (Glib::Thread::create
+        (sigc::mem_fun (*this, &ExportProjectJob::worker), true));
+    } catch (Glib::ThreadError &e) {
+      break;  // Carry on with however many threads were created
+    }
+  }
+  worker ();
+  for (unsigned int i = 0; i < Workers.size (); i ++) {
+    Workers[i] -> join ();
+  }
+  progress (1.0);
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Reports the outcome of the export, listing any files that could
+// not be written.
+//
+void ExportProjectJob::finish () {
+  ostringstream oss, osssub;
+  if (Failures.size () == 0) {
+    oss << "Project exported to " << Directory;
+    Window -> Status.push (oss.str ());
+    return;
+  }
+  oss << "Error : Unable to export " << Failures.size () << " of "
+    << Files.size () << " files to " << Directory;
+  osssub << "The following files could not be written:\n";
+  for (unsigned int i = 0; i < Failures.size (); i ++) {
+    osssub << "\n  " << Failures[i];
+  }
+  Gtk::MessageDialog dialog (*Window, oss.str (), false, Gtk::MESSAGE_ERROR,
+    Gtk::BUTTONS_OK);
+  dialog.set_secondary_text (osssub.str ());
+  dialog.run ();
+  Window -> Status.push (oss.str ());
+}
+
+
+//------------------------------------------------------------------------------
+// abort () : Reports that the export was cancelled, leaving the files already
+// written in place.
+//
+void ExportProjectJob::abort () {
+  ostringstream oss;
+  oss << "Export to " << Directory << " cancelled after " << NumDone
+    << " of " << Files.size () << " files";
+  Window -> Status.push (oss.str ());
+}
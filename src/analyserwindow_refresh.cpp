@@ -25,17 +25,19 @@
 using namespace::std;
 
 //------------------------------------------------------------------------------
-// updateKuruczCompleteness () : Whenever any of the Kurucz line list parameters
-// change, updateKuruczCompleteness is called to recalculate the fraction of
-// significant Kurucz lines are present in the loaded experimental spectra.
+// updateKuruczCompleteness (int) : Whenever any of the Kurucz line list
+// parameters change, updateKuruczCompleteness is called to recalculate the
+// fraction of significant Kurucz lines are present in the loaded experimental
+// spectra. If OnlyLevel is not -1, only that upper level is recalculated.
 //
-void AnalyserWindow::updateKuruczCompleteness () {
+void AnalyserWindow::updateKuruczCompleteness (int OnlyLevel) {
   typedef Gtk::TreeModel::Children type_children;
   type_children children = levelTreeModel->children();
   double FractionFound;
   int Level;
   for (type_children::iterator iter = children.begin(); iter != children.end(); ++iter) {
     Level = (*iter)[levelCols.index];
+    if (OnlyLevel != -1 && Level != OnlyLevel) continue;
     FractionFound = 0.0;
     for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
       for (unsigned int j = 0; j < LevelLines[Level][i].size (); j ++) {
@@ -48,15 +50,32 @@ void AnalyserWindow::updateKuruczCompleteness () {
     }
     (*iter)[levelCols.fracFound] = FractionFound;
   }
-  updateKuruczBF ();
+  updateKuruczBF (OnlyLevel);
 }
 
 
 //------------------------------------------------------------------------------
-// updateKuruczBF () : Updates the branching fraction tab in the Kurucz Upper
-// Levels section of the window
+// updateKuruczCompleteness (LineData *) : Recalculates the completeness of
+// every upper level that has a line shown in Plot, after that line has been
+// selected, disabled or hidden. A line may belong to several levels, not just
+// the one that is displayed.
 //
-void AnalyserWindow::updateKuruczBF () {
+void AnalyserWindow::updateKuruczCompleteness (LineData *Plot) {
+  map <LineData *, vector <unsigned int> >::iterator Levels = 
+    PlotLevels.find (Plot);
+  if (Levels == PlotLevels.end ()) return;
+  for (unsigned int i = 0; i < Levels -> second.size (); i ++) {
+    updateKuruczCompleteness (int (Levels -> second[i]));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// updateKuruczBF (int) : Updates the branching fraction tab in the Kurucz Upper
+// Levels section of the window. If OnlyLevel is not -1, only the row for that
+// upper level is updated.
+//
+void AnalyserWindow::updateKuruczBF (int OnlyLevel) {
   typedef Gtk::TreeModel::Children type_children;
   type_children children = levelTreeModel->children();
   double FractionFound, Ratio, EwTotal, ATotal, Lifetime;
@@ -85,6 +104,7 @@ void AnalyserWindow::updateKuruczBF () {
   for (type_children::iterator iter = children.begin(); iter != children.end(); ++iter) {
     Level = (*iter)[levelColsBF.index];
     i = i + 1; Lifetime = Lifetimes [i];
+    if (OnlyLevel != -1 && Level != OnlyLevel) continue;
     EwTotal = 0.0;
     FractionFound = 0.0;
 
@@ -128,46 +148,84 @@ void AnalyserWindow::updateKuruczBF () {
   }
 }
 
+//------------------------------------------------------------------------------
+// sameTarget (KzLine &, KzLine &) : Returns true if a and b look the same in
+// the "Kurucz Data" tab.
+//
+static bool sameTarget (KzLine &a, KzLine &b) {
+  return a.sigma () == b.sigma () && a.lambda () == b.lambda ()
+    && a.loggf () == b.loggf () && a.brFrac () == b.brFrac ()
+    && a.eLower () == b.eLower () && a.jLower () == b.jLower ()
+    && a.eUpper () == b.eUpper () && a.jUpper () == b.jUpper ()
+    && a.configLower () == b.configLower ()
+    && a.configUpper () == b.configUpper ();
+}
+
+
 //------------------------------------------------------------------------------
 // updateKuruczList () : Updates the list of Kurucz lines displayed in the 
-// "Kurucz Data" tab at the bottom right of the window.
+// "Kurucz Data" tab at the bottom right of the window. The lines are read
+// from TargetLines by targetValue () as they are drawn, and only the rows that
+// differ from the previous list are redrawn.
 //
 void AnalyserWindow::updateKuruczList (KzList LineList) {
-  Gtk::TreeModel::Row row;
-  
-  lineDataTreeModel->clear ();
-  vector <KzLine> TargetLines = LineList.lines();
-  for (unsigned int i = 0; i < TargetLines.size(); i ++) {
-    row = *(lineDataTreeModel->append());
-    if (TargetLines[i].brFrac () > MIN_SIGNIFICANT_BF) {
-      row[targetsCols.colour] = Gdk::Color ("#000000");
-      if (matchedXgLineExists (TargetLines[i], 
-        KuruczList.levelPrecision ())) {
-        row[targetsCols.bg_colour] = Gdk::Color ("#FFFFFF");
-      } else {
-        row[targetsCols.bg_colour] = Gdk::Color ("#FF9090");
-      }
+  vector <KzLine> NewLines = LineList.lines();
+  vector <bool> NewFound = matchedXgLinesExist (NewLines, 
+    KuruczList.levelPrecision ());
+  vector <bool> Changed (NewLines.size (), true);
+  for (unsigned int i = 0; i < NewLines.size () && i < TargetLines.size (); i ++) {
+    Changed[i] = NewFound[i] != TargetFound[i] 
+      || !sameTarget (NewLines[i], TargetLines[i]);
+  }
+  TargetLines.swap (NewLines);
+  TargetFound.swap (NewFound);
+  lineDataTreeModel -> reset (TargetLines.size (), Changed);
+}
+
+
+//------------------------------------------------------------------------------
+// targetValue (unsigned int, int, Glib::ValueBase &) : Returns the value of
+// column Column of the "Kurucz Data" tab for line Row of TargetLines.
+//
+void AnalyserWindow::targetValue (unsigned int Row, int Column,
+  Glib::ValueBase &Value) {
+  if (Row >= TargetLines.size ()) return;  // Being deleted from the model
+  KzLine &Line = TargetLines[Row];
+  if (Column == targetsCols.colour.index ()) {
+    if (Line.brFrac () > MIN_SIGNIFICANT_BF) {
+      ArrayModel::set (Value, targetsCols.colour, Gdk::Color ("#000000"));
+    } else if (TargetFound[Row]) {
+      ArrayModel::set (Value, targetsCols.colour, Gdk::Color ("#606060"));
     } else {
-      if (matchedXgLineExists (TargetLines[i], 
-        KuruczList.levelPrecision ())) {
-        row[targetsCols.colour] = Gdk::Color ("#606060");
-      } else {
-        row[targetsCols.colour] = Gdk::Color ("#D0D0D0");
-      }
-      row[targetsCols.bg_colour] = Gdk::Color ("#FFFFFF");
+      ArrayModel::set (Value, targetsCols.colour, Gdk::Color ("#D0D0D0"));
+    }
+  } else if (Column == targetsCols.bg_colour.index ()) {
+    if (Line.brFrac () > MIN_SIGNIFICANT_BF && !TargetFound[Row]) {
+      ArrayModel::set (Value, targetsCols.bg_colour, Gdk::Color ("#FF9090"));
+    } else {
+      ArrayModel::set (Value, targetsCols.bg_colour, Gdk::Color ("#FFFFFF"));
     }
-    
-    row[targetsCols.sigma] = TargetLines[i].sigma ();
-    row[targetsCols.wavelength] = TargetLines[i].lambda ();
-    row[targetsCols.loggf] = TargetLines[i].loggf ();
-    row[targetsCols.bf] = TargetLines[i].brFrac ();
-    row[targetsCols.elower] = TargetLines[i].eLower ();
-    row[targetsCols.jlower] = TargetLines[i].jLower ();
-    row[targetsCols.configlower] = TargetLines[i].configLower ();
-    row[targetsCols.eupper] = TargetLines[i].eUpper ();
-    row[targetsCols.jupper] = TargetLines[i].jUpper ();
-    row[targetsCols.configupper] = TargetLines[i].configUpper ();
   }
+  else if (Column == targetsCols.sigma.index ())
+    ArrayModel::set (Value, targetsCols.sigma, Line.sigma ());
+  else if (Column == targetsCols.wavelength.index ())
+    ArrayModel::set (Value, targetsCols.wavelength, Line.lambda ());
+  else if (Column == targetsCols.loggf.index ())
+    ArrayModel::set (Value, targetsCols.loggf, Line.loggf ());
+  else if (Column == targetsCols.bf.index ())
+    ArrayModel::set (Value, targetsCols.bf, Line.brFrac ());
+  else if (Column == targetsCols.elower.index ())
+    ArrayModel::set (Value, targetsCols.elower, Line.eLower ());
+  else if (Column == targetsCols.jlower.index ())
+    ArrayModel::set (Value, targetsCols.jlower, Line.jLower ());
+  else if (Column == targetsCols.configlower.index ())
+    ArrayModel::set (Value, targetsCols.configlower, Line.configLower ());
+  else if (Column == targetsCols.eupper.index ())
+    ArrayModel::set (Value, targetsCols.eupper, Line.eUpper ());
+  else if (Column == targetsCols.jupper.index ())
+    ArrayModel::set (Value, targetsCols.jupper, Line.jUpper ());
+  else if (Column == targetsCols.configupper.index ())
+    ArrayModel::set (Value, targetsCols.configupper, Line.configUpper ());
 }
 
 
@@ -181,7 +239,7 @@ void AnalyserWindow::updateXGremlinList (
 
   Gtk::TreeModel::Row row, parentRow;
   bool LineFound;
-  RatioAndError BestScalingFactor, Swap;
+  RatioAndError BestScalingFactor;
   
   // Cycle through all the lines in the current level with i
   for (unsigned int i = 0; i < OrderedPairs[0].size (); i ++) {
@@ -203,29 +261,9 @@ void AnalyserWindow::updateXGremlinList (
         row[colsDataXGr.width] = OrderedPairs[j][i]->xgLine->width ();
         row[colsDataXGr.dmp] = OrderedPairs[j][i]->xgLine->dmp ();
         
-        // Calculate the branching fraction data that needs to be shown
-        try {
-          BestScalingFactor = getBestScalingFactor (SpectrumOrder[0], SpectrumOrder[j], ScalingFactors);
-        } catch (int e) {
-          if (e == NO_SCALING_RATIO_FOUND) {
-            try {
-              BestScalingFactor = getBestScalingFactor (SpectrumOrder[j], SpectrumOrder[0], ScalingFactors);
-              Swap = BestScalingFactor;
-              BestScalingFactor.a = Swap.b;
-              BestScalingFactor.b = Swap.a;
-              BestScalingFactor.Ratio = 1.0 / Swap.Ratio;
-            } catch (int e2) {
-              if (e2 == NO_SCALING_RATIO_FOUND) {
-                BestScalingFactor.a = 0;
-                BestScalingFactor.b = 0;
-                BestScalingFactor.Ratio = 1.0;
-                BestScalingFactor.Error = 0.0;
-//                cout << "Unable to link " << SpectrumLabels [j] << " and "
-//                  << SpectrumLabels [0] << endl;
-              }
-            }
-          }
-        }        
+        // Put the intensity on the scale of the reference spectrum
+        BestScalingFactor = BfEngine::scalingFactor (SpectrumOrder[0],
+          SpectrumOrder[j], ScalingFactors);
         row[colsDataXGr.eqwidth] = OrderedPairs[j][i]->xgLine->eqwidth () 
           / ExptSpectra[SpectrumOrder[j]].response 
             (OrderedPairs[j][i]->xgLine->wavenumber ())
@@ -253,452 +291,361 @@ void AnalyserWindow::updateXGremlinList (
 //------------------------------------------------------------------------------
 // calculateBranchingFractions (vector < vector <LinePair *> >, vector <string>,
 // vector <unsigned int>) : Calculates all the branching fraction data to be
-// displayed in the "Br. Frac. Data" list. The contents of the list is based on
-// which line plots are selected (highlighted) in the main window.
+// displayed in the "Br. Frac. Data" list with BfEngine. The contents of the
+// list is based on which line plots are selected (highlighted) in the main
+// window.
 //
 vector <DataBF> AnalyserWindow::calculateBranchingFractions (
   vector < vector <LinePair *> > OrderedPairs, vector <string> SpectrumLabels,
   vector <unsigned int> SpectrumOrder) {
-  
-  vector <DataBF> AllBrFracData;
-  DataBF NextBrFracLine;
-  RatioAndError BestScalingFactor;
-  RatioAndError Swap;
-  double gf;
-  double TotalEqWidth = 0.0, TotalKuruczBrFrac = 0.0, TotalErrInEqWidth = 0.0;
-
-  // Cycle through each of the lines in the target upper level
-  for (unsigned int i = 0; i < OrderedPairs[0].size (); i ++) { 
-
-    // Cycle through each of the loaded spectra with j
-    for (unsigned int j = 0; j < OrderedPairs.size (); j ++) { 
-
-      // Only consider a line if it has a valid wavenumber and is selected
-      if (OrderedPairs[j][i] -> xgLine -> wavenumber () > 0.0) {
-        if (OrderedPairs[j][i] -> plot -> selected ()) {
-        
-          // Calculate the branching fraction data that needs to be shown
-          try {
-            BestScalingFactor = getBestScalingFactor (SpectrumOrder[0], SpectrumOrder[j], ScalingFactors);
-          } catch (int e) {
-            if (e == NO_SCALING_RATIO_FOUND) {
-              try {
-                BestScalingFactor = getBestScalingFactor (SpectrumOrder[j], SpectrumOrder[0], ScalingFactors);
-                Swap = BestScalingFactor;
-                BestScalingFactor.a = Swap.b;
-                BestScalingFactor.b = Swap.a;
-                BestScalingFactor.Ratio = 1.0 / Swap.Ratio;
-              } catch (int e2) {
-                if (e2 == NO_SCALING_RATIO_FOUND) {
-                  BestScalingFactor.a = 0;
-                  BestScalingFactor.b = 0;
-                  BestScalingFactor.Ratio = 1.0;
-                  BestScalingFactor.Error = 0.0;
-//                  cout << "Unable to link " << SpectrumLabels [j] << " and "
-//                    << SpectrumLabels [0] << endl;
-                }
-              }
-            }
-          }
-          NextBrFracLine.spectrum = SpectrumLabels[j];
-          NextBrFracLine.index = OrderedPairs[j][i]->xgLine->line ();
-          NextBrFracLine.wavenumber = OrderedPairs[j][i]->xgLine->wavenumber ();
-          NextBrFracLine.eqwidth = OrderedPairs[j][i]->xgLine->eqwidth () 
-            / ExptSpectra[SpectrumOrder[j]].response 
-              (OrderedPairs[j][i]->xgLine->wavenumber ())
-            * BestScalingFactor.Ratio;
-          if (Options.correct_snr ()) {
-            NextBrFracLine.err_line = OrderedPairs[j][i]->xgLine->noise() / OrderedPairs[j][i]->xgLine->snr() * 100;
-          } else {
-            NextBrFracLine.err_line = 1.0 / OrderedPairs[j][i]->xgLine->snr() * 100;
-          }
-          
-          NextBrFracLine.err_cal = ExptSpectra[SpectrumOrder[j]].response_error
-            (OrderedPairs[j][i]->xgLine->wavenumber ());
-          NextBrFracLine.err_trans = BestScalingFactor.Error * 100;
-          NextBrFracLine.err_total = sqrt (pow (NextBrFracLine.err_line, 2)
-            + pow (NextBrFracLine.err_cal / sqrt (2.0), 2) 
-            + pow (NextBrFracLine.err_trans, 2));
-          NextBrFracLine.err_eqwidth = 
-            NextBrFracLine.eqwidth * NextBrFracLine.err_total / 100;
-          NextBrFracLine.profile = LineBoxes[j][i];
-
-          // Keep a running total of the equivalent width and its error, and the
-          // Kurucz branching fraction summed over all selected lines. These are
-          // used for normalisation of parameters later on.
-          TotalEqWidth += NextBrFracLine.eqwidth;
-          TotalErrInEqWidth += 
-            pow (NextBrFracLine.eqwidth * NextBrFracLine.err_total / 100, 2);
-          TotalKuruczBrFrac += OrderedPairs[j][i]->kzLine->brFrac ();
-
-          // The fields that depend upon the above level sum totals cannot be
-          // fully calculated until those sum totals are known. Therefore, the
-          // following fields contain only intermediate calculations, which are
-          // completed when adding the data to the table, below.
-          NextBrFracLine.a = 1.0 / OrderedPairs[j][i]->kzLine->lifetime ();
-          NextBrFracLine.err_a = pow (100 * OrderedPairs[j][i]->kzLine->lifetime_error () 
-              / OrderedPairs[j][i]->kzLine->lifetime (), 2);
-          if (OrderedPairs[j][i]->kzLine->eUpper() > OrderedPairs[j][i]->kzLine->eLower()) {
-            gf =  1.499e-14 * (2 * OrderedPairs[j][i] -> kzLine->jUpper () + 1)
-              * pow (OrderedPairs[j][i] -> xgLine->airWavelength (), 2);
-          } else { 
-            gf =  1.499e-14 * (2 * OrderedPairs[j][i] -> kzLine->jLower () + 1)
-              * pow (OrderedPairs[j][i] -> xgLine->airWavelength (), 2);
-          }
-          NextBrFracLine.loggf = gf;
-
-          // Determine the background colour of fields that require additional
-          // user data.
-          NextBrFracLine.bg_colour = Gdk::Color (AW_PARENT_LINE_COLOUR);
-          if (ExptSpectra[SpectrumOrder[j]].response 
-            (OrderedPairs[j][i]->xgLine->wavenumber ()) == 1.0) {
-            NextBrFracLine.eq_width_colour = Gdk::Color (AW_EQWIDTH_NO_NORM_COLOUR);
-          } else {
-            NextBrFracLine.eq_width_colour = Gdk::Color (AW_EQWIDTH_NORM_COLOUR);
-          }
-          if (ExptSpectra[SpectrumOrder[j]].response_error 
-            (OrderedPairs[j][i]->xgLine->wavenumber ()) == 0.0) {
-            NextBrFracLine.err_cal_colour = Gdk::Color (AW_EQWIDTH_NO_NORM_COLOUR);
-          } else {
-            NextBrFracLine.err_cal_colour = Gdk::Color (AW_EQWIDTH_NORM_COLOUR);
-          }
-          AllBrFracData.push_back (NextBrFracLine);
-          
-          // Only one line of each type can be considered in the branching
-          // fraction calculation, so break out of the spectrum loop. This will
-          // mean that if a given line is selected in more than one spectrum,
-          // only the first selected instance will be used.
-          break;
-        }
-      }
+  TRACE_SCOPE ("calculateBranchingFractions");
+  vector < vector <LineMatch> > Matches = lineMatches (OrderedPairs);
+  vector <BfResult> Results = engine ().branchingFractions (Matches,
+    SpectrumLabels, SpectrumOrder, ScalingFactors);
+  vector <DataBF> AllBrFracData (Results.size ());
+
+  // Add the plot of each line and the colours of the fields that require
+  // additional user data.
+  for (unsigned int j = 0; j < Results.size (); j ++) {
+    DataBF &Data = AllBrFracData[j];
+    (BfResult &) Data = Results[j];
+    Data.profile = NULL;
+    if (Data.order < LineBoxes.size () 
+      && Data.line < LineBoxes[Data.order].size ()) {
+      Data.profile = LineBoxes[Data.order][Data.line];
     }
-  }
-  TotalErrInEqWidth = sqrt (TotalErrInEqWidth);
-  
-  // Add all the branching fraction data to the "Br. Frac. Data" table.
-  for (unsigned int j = 0; j < AllBrFracData.size (); j ++) {   
-    // Now consider the fields that require normalisation to the level's total
-    // eq. width, total error in eq. width, or total Kurucz branching fraction.
-    // These normalisations could not be done above, so perform the calculations
-    // here.
-    AllBrFracData[j].br_frac = 
-      AllBrFracData[j].eqwidth * TotalKuruczBrFrac / TotalEqWidth;
-    
-    // This calculation of err_br_frac is incorrect. Don't use it. It's here
-    // simply because other publications have used it in the past, so it may
-    // be necessary to use it for diagnostics in the future.
-//    AllBrFracData[j].err_br_frac = sqrt(pow (AllBrFracData[j].err_total, 2) +
-//      pow (100.0 * TotalErrInEqWidth / TotalEqWidth, 2));
-  }
-
-  // Calculate U (BF) based on Equation 7 in C.M.Sikstrom et al., JQSRT,
-  // 74 pp. 355 (2002). Note that the coefficient (1- BF_k) should be squared as
-  // it is in Equation 6!
-  for (unsigned int j = 0; j < AllBrFracData.size (); j ++) {   
-    AllBrFracData[j].err_br_frac = (1 - 2.0 * AllBrFracData[j].br_frac) *
-      pow (AllBrFracData[j].err_total, 2);
-    for (unsigned int k = 0; k < AllBrFracData.size (); k ++) {
-      AllBrFracData[j].err_br_frac += pow (AllBrFracData[k].br_frac, 2) * 
-        pow (AllBrFracData[k].err_total, 2);
+    Data.bg_colour = Gdk::Color (AW_PARENT_LINE_COLOUR);
+    if (Data.normalised) {
+      Data.eq_width_colour = Gdk::Color (AW_EQWIDTH_NORM_COLOUR);
+    } else {
+      Data.eq_width_colour = Gdk::Color (AW_EQWIDTH_NO_NORM_COLOUR);
+    }
+    if (Data.calibrated) {
+      Data.err_cal_colour = Gdk::Color (AW_EQWIDTH_NORM_COLOUR);
+    } else {
+      Data.err_cal_colour = Gdk::Color (AW_EQWIDTH_NO_NORM_COLOUR);
     }
-    AllBrFracData[j].err_br_frac = sqrt (AllBrFracData[j].err_br_frac);
   }
+  return AllBrFracData;
+}
 
-  for (unsigned int j = 0; j < AllBrFracData.size (); j ++) {   
-    gf = AllBrFracData[j].loggf;
-    AllBrFracData[j].a = AllBrFracData[j].br_frac * AllBrFracData[j].a;
-    AllBrFracData[j].err_a = 
-      sqrt (pow (AllBrFracData[j].err_br_frac, 2) + AllBrFracData[j].err_a);
-    AllBrFracData[j].loggf = log10 (gf * AllBrFracData[j].a);
-    AllBrFracData[j].dex = log10 (gf * (1 + AllBrFracData[j].err_a / 100))
-      - log10 (gf);
-  }
-  return AllBrFracData;  
+
+//------------------------------------------------------------------------------
+// sameBF (DataBF &, DataBF &) : Returns true if a and b look the same in the
+// branching fraction table. The row colours follow from the values compared.
+//
+static bool sameBF (DataBF &a, DataBF &b) {
+  return a.profile == b.profile && a.index == b.index 
+    && a.wavenumber == b.wavenumber && a.eqwidth == b.eqwidth
+    && a.err_line == b.err_line && a.err_cal == b.err_cal
+    && a.err_trans == b.err_trans && a.err_total == b.err_total
+    && a.err_eqwidth == b.err_eqwidth && a.br_frac == b.br_frac
+    && a.err_br_frac == b.err_br_frac && a.a == b.a && a.err_a == b.err_a
+    && a.loggf == b.loggf && a.dex == b.dex && a.spectrum == b.spectrum
+    && a.line == b.line && a.order == b.order 
+    && a.normalised == b.normalised && a.calibrated == b.calibrated;
 }
 
 
 //------------------------------------------------------------------------------
-// updateBranchingFractions (...) :
+// updateBranchingFractions (...) : Recalculates the branching fraction data
+// shown in the "Br. Frac. Data" tab. The data are read from BrFracData by
+// bfValue () as they are drawn.
 //
 void AnalyserWindow::updateBranchingFractions (
   vector < vector <LinePair *> > OrderedPairs, vector <string> SpectrumLabels,
   vector <unsigned int> SpectrumOrder) {
-  Gtk::TreeModel::Row row;
-  vector <DataBF> AllBrFracData =
+  vector <DataBF> NewData =
     calculateBranchingFractions (OrderedPairs, SpectrumLabels, SpectrumOrder);
-  
-  // Add all the branching fraction data to the "Br. Frac. Data" table.
-  for (unsigned int j = 0; j < AllBrFracData.size (); j ++) { 
-    row = *(modelDataBF -> append ());;
-    
-    // First copy across the fields that were calculated in their entirety above.
-    row[colsDataBF.spectrum] = AllBrFracData[j].spectrum;
-    row[colsDataBF.index] = AllBrFracData[j].index;
-    row[colsDataBF.wavenumber] = AllBrFracData[j].wavenumber;
-    row[colsDataBF.eqwidth] = AllBrFracData[j].eqwidth;
-    row[colsDataBF.err_line] = AllBrFracData[j].err_line;
-    row[colsDataBF.err_cal] = AllBrFracData[j].err_cal;
-    row[colsDataBF.err_trans] = AllBrFracData[j].err_trans;
-    row[colsDataBF.err_total] = AllBrFracData[j].err_total;
-    row[colsDataBF.err_eqwidth] = AllBrFracData[j].err_eqwidth;
-    row[colsDataBF.profile] = AllBrFracData[j].profile;
-    row[colsDataBF.bg_colour] = AllBrFracData[j].bg_colour;
-    row[colsDataBF.eq_width_colour] = AllBrFracData[j].eq_width_colour;
-    row[colsDataBF.err_cal_colour] = AllBrFracData[j].err_cal_colour;
-    row[colsDataBF.br_frac] = AllBrFracData[j].br_frac;
-    row[colsDataBF.err_br_frac] = AllBrFracData[j].err_br_frac;
-    row[colsDataBF.a] = AllBrFracData[j].a;
-    row[colsDataBF.err_a] = AllBrFracData[j].err_a;
-    row[colsDataBF.loggf] = AllBrFracData[j].loggf;
-    row[colsDataBF.dex] = AllBrFracData[j].dex; 
+  vector <bool> Changed (NewData.size (), true);
+  for (unsigned int i = 0; i < NewData.size () && i < BrFracData.size (); i ++) {
+    Changed[i] = !sameBF (NewData[i], BrFracData[i]);
   }
+  BrFracData.swap (NewData);
+  modelDataBF -> reset (BrFracData.size (), Changed);
+}
+
+
+//------------------------------------------------------------------------------
+// bfValue (unsigned int, int, Glib::ValueBase &) : Returns the value of column
+// Column of the "Br. Frac. Data" tab for row Row of BrFracData.
+//
+void AnalyserWindow::bfValue (unsigned int Row, int Column,
+  Glib::ValueBase &Value) {
+  if (Row >= BrFracData.size ()) return;  // Being deleted from the model
+  DataBF &Data = BrFracData[Row];
+  if (Column == colsDataBF.spectrum.index ())
+    ArrayModel::set (Value, colsDataBF.spectrum, Data.spectrum);
+  else if (Column == colsDataBF.index.index ())
+    ArrayModel::set (Value, colsDataBF.index, Data.index);
+  else if (Column == colsDataBF.wavenumber.index ())
+    ArrayModel::set (Value, colsDataBF.wavenumber, Data.wavenumber);
+  else if (Column == colsDataBF.eqwidth.index ())
+    ArrayModel::set (Value, colsDataBF.eqwidth, Data.eqwidth);
+  else if (Column == colsDataBF.err_line.index ())
+    ArrayModel::set (Value, colsDataBF.err_line, Data.err_line);
+  else if (Column == colsDataBF.err_cal.index ())
+    ArrayModel::set (Value, colsDataBF.err_cal, Data.err_cal);
+  else if (Column == colsDataBF.err_trans.index ())
+    ArrayModel::set (Value, colsDataBF.err_trans, Data.err_trans);
+  else if (Column == colsDataBF.err_total.index ())
+    ArrayModel::set (Value, colsDataBF.err_total, Data.err_total);
+  else if (Column == colsDataBF.err_eqwidth.index ())
+    ArrayModel::set (Value, colsDataBF.err_eqwidth, Data.err_eqwidth);
+  else if (Column == colsDataBF.profile.index ())
+    ArrayModel::set (Value, colsDataBF.profile, Data.profile);
+  else if (Column == colsDataBF.bg_colour.index ())
+    ArrayModel::set (Value, colsDataBF.bg_colour, Data.bg_colour);
+  else if (Column == colsDataBF.eq_width_colour.index ())
+    ArrayModel::set (Value, colsDataBF.eq_width_colour, Data.eq_width_colour);
+  else if (Column == colsDataBF.err_cal_colour.index ())
+    ArrayModel::set (Value, colsDataBF.err_cal_colour, Data.err_cal_colour);
+  else if (Column == colsDataBF.br_frac.index ())
+    ArrayModel::set (Value, colsDataBF.br_frac, Data.br_frac);
+  else if (Column == colsDataBF.err_br_frac.index ())
+    ArrayModel::set (Value, colsDataBF.err_br_frac, Data.err_br_frac);
+  else if (Column == colsDataBF.a.index ())
+    ArrayModel::set (Value, colsDataBF.a, Data.a);
+  else if (Column == colsDataBF.err_a.index ())
+    ArrayModel::set (Value, colsDataBF.err_a, Data.err_a);
+  else if (Column == colsDataBF.loggf.index ())
+    ArrayModel::set (Value, colsDataBF.loggf, Data.loggf);
+  else if (Column == colsDataBF.dex.index ())
+    ArrayModel::set (Value, colsDataBF.dex, Data.dex);
 }
 
 
 //------------------------------------------------------------------------------
 // updateComparisonList () : Update the "Compare Spectra" tab at the bottom
 // right of the window. This tab displays information allowing the loaded
-// experimental spectra to be compared against one another.
+// experimental spectra to be compared against one another. The transfer ratios
+// themselves are calculated by BfEngine, and returned.
 //
 vector <RatioAndError> AnalyserWindow::updateComparisonList (vector < vector <LinePair *> > 
   OrderedPairs, vector <string> SpectrumLabels, vector <unsigned int> SpectrumOrder) {
+  TRACE_SCOPE ("updateComparisonList");
   Gtk::TreeModel::Row row, parentRow;
-  double Ratio, Error, AveRatio, AveError, RatioDenom, SNRa, SNRb;
   ostringstream oss;
-  RatioAndError NextRatioAndError;
+  vector <TransferRatio> Details;
   vector <RatioAndError> RtnData;
-  bool LinkFound, NoAppend = false;
-  unsigned int NumLinesCompared = 0;
-
-  // Compare each of the loaded experimental spectra to the others. First add
-  // null scaling for the reference spectrum. Then assess what factors are
-  // needed to put the other spectra on the same scale as the reference spectrum.
-  NextRatioAndError.Ratio = 1.0;
-  NextRatioAndError.Error = 0.0;
-  NextRatioAndError.a = SpectrumOrder[0];
-  NextRatioAndError.b = SpectrumOrder[0];
-  RtnData.push_back (NextRatioAndError);
-  
-  if (OrderedPairs.size () > 1) {
-    for (unsigned int k = 0; k < OrderedPairs.size () - 1; k ++) {
-      for (unsigned int j = 1; j < OrderedPairs.size (); j ++) {
-        if (j > k) {
-        
-          // Add a new row to the comparison list and initialise it
-          if (!NoAppend) {
-            parentRow = *(modelDataComp -> append ());
-          }
-          NoAppend = false;
-          AveRatio = 0.0;
-          AveError = 0.0;
-          RatioDenom = 0.0;
-          LinkFound = false;
-          // First check to see if the spectra have been explicitly linked together by the user.
-          // In such cases ALL lines common to both spectra may be used to calculate the transfer
-          // ratio rather than only the lines belonging to the current upper level.
-          for (unsigned int i = 0; i < LinkedSpectra.size (); i ++) {
-            try {
-              if (LinkedSpectra [i].a == SpectrumOrder[k] &&
-                LinkedSpectra [i].b == SpectrumOrder[j]) {
-                LinkFound = true;
-                NextRatioAndError = 
-                  compareLinkedSpectra (LinkedSpectra [i].a, LinkedSpectra [i].b, parentRow);
-              } else if (LinkedSpectra [i].b == SpectrumOrder[k] &&
-                LinkedSpectra [i].a == SpectrumOrder[j]){
-                LinkFound = true;
-                NextRatioAndError = 
-                  compareLinkedSpectra (LinkedSpectra [i].b, LinkedSpectra [i].a, parentRow);
-              }
-              if (LinkFound) {
-                parentRow[colsDataComp.ref] = SpectrumLabels[k];
-                parentRow[colsDataComp.comparison] = SpectrumLabels[j];
-                parentRow[colsDataComp.wavenumber] = "";
-                oss.str (""); 
-                oss << NextRatioAndError.Ratio << " +/- " << NextRatioAndError.Error;
-                parentRow[colsDataComp.ratio] = oss.str ();
-                RtnData.push_back (NextRatioAndError);
-              }
-              break;
-            } catch (int e) {
-              if (e == NO_COMPARISON_LINES_FOUNDS) {
-                NoAppend = true;
-                break;
-              }
-            }
-          }
-          // If the spectra have not been linked by the user only the common lines belonging to the
-          // current upper level may be used to calculate the transfer ratio.
-          if (!LinkFound) {
-            NumLinesCompared = 0;
-            // Compare matching lines in each of the two spectra
-            for (unsigned int i = 0; i < OrderedPairs[k].size (); i ++) {
-              if (OrderedPairs[k][i]->xgLine->wavenumber () > 0.0 && !OrderedPairs[k][i]->plot->disabled()
-                && OrderedPairs[j][i]->xgLine->wavenumber () > 0.0 && !OrderedPairs[j][i]->plot->disabled()) {
-                
-                // Add a new child row for the comparison of individual lines and
-                // fill it with the required information
-                row = *(modelDataComp -> append (parentRow->children()));
-                row[colsDataComp.ref] = SpectrumLabels[k];
-                row[colsDataComp.comparison] = SpectrumLabels[j];
-                row[colsDataComp.wavenumber] = "";
-
-                Ratio = (OrderedPairs [k][i]->xgLine->eqwidth () 
-                  / ExptSpectra[SpectrumOrder[k]].response (OrderedPairs[k][i]->xgLine->wavenumber ()))
-                  / (OrderedPairs [j][i]->xgLine->eqwidth ()
-                  / ExptSpectra[SpectrumOrder[j]].response (OrderedPairs[j][i]->xgLine->wavenumber ()));
-                
-                if (Options.correct_snr ()) {
-                  SNRa = OrderedPairs [k][i]->xgLine->snr () / OrderedPairs [k][i]->xgLine->noise();
-                  SNRb = OrderedPairs [j][i]->xgLine->snr () / OrderedPairs [j][i]->xgLine->noise();
-                } else {
-                  SNRa = OrderedPairs [k][i]->xgLine->snr ();
-                  SNRb = OrderedPairs [j][i]->xgLine->snr ();
-                }
-
-                // Calculate the weighted average of the transfer ratio of each common line
-                Error = sqrt(pow (SNRa, -2.0) + pow (SNRb, -2.0));
-                AveRatio += Ratio / pow (Error, 2.0);
-                RatioDenom += pow (Error, -2.0);
-                AveError += 1.0 / Error;
-                oss.str (""); oss << Ratio << " +/- " << Ratio * Error;
-                row[colsDataComp.ratio] = oss.str ();
-                oss.str (""); oss << OrderedPairs [k][i]->xgLine->wavenumber();
-                row[colsDataComp.wavenumber] = oss.str ();
-                NumLinesCompared ++;
-              }
-            }
-
-            if (NumLinesCompared > 0) {
-              // Update the root node with the overall comparison information
-              AveRatio /= RatioDenom;
-              AveError /= RatioDenom;
-              parentRow[colsDataComp.ref] = SpectrumLabels[k];
-              parentRow[colsDataComp.comparison] = SpectrumLabels[j];
-              parentRow[colsDataComp.wavenumber] = "";
-              oss.str (""); oss << AveRatio << " +/- " << AveRatio * AveError;
-              parentRow[colsDataComp.ratio] = oss.str ();
-              NextRatioAndError.Ratio = AveRatio;
-              NextRatioAndError.Error = AveError;
-              NextRatioAndError.a = SpectrumOrder[k];
-              NextRatioAndError.b = SpectrumOrder[j];
-              RtnData.push_back (NextRatioAndError);
-            } else {
-              NoAppend = true;
-            }
-          }
-        }
-      }
+
+  // All the lines of linked spectra are compared, and their noise levels are
+  // only set once they have been profiled. Any list that has not been is
+  // profiled in the background, and the level refreshed once it is done.
+  for (unsigned int i = 0; i < LinkedSpectra.size (); i ++) {
+    for (unsigned int j = 0; j < ExptSpectra[LinkedSpectra[i].a].linesPtr2 () -> size (); j ++) {
+      profileLines (LinkedSpectra[i].a, j);
+    }
+    for (unsigned int j = 0; j < ExptSpectra[LinkedSpectra[i].b].linesPtr2 () -> size (); j ++) {
+      profileLines (LinkedSpectra[i].b, j);
     }
   }
-  if (NoAppend) { modelDataComp -> erase (parentRow); }
+
+  vector < vector <LineMatch> > Matches = lineMatches (OrderedPairs);
+  RtnData = engine ().transferRatios (Matches, SpectrumOrder, &Details);
+
+  // Add a row to the comparison list for each pair of spectra that could be
+  // compared, with a child row for each of the lines used
+  for (unsigned int n = 0; n < Details.size (); n ++) {
+    TransferRatio &Detail = Details[n];
+    parentRow = *(modelDataComp -> append ());
+    for (unsigned int i = 0; i < Detail.Lines.size (); i ++) {
+      row = *(modelDataComp -> append (parentRow->children()));
+      row[colsDataComp.ref] = SpectrumLabels[Detail.k];
+      row[colsDataComp.comparison] = SpectrumLabels[Detail.j];
+      oss.str (""); 
+      oss << Detail.Lines[i].Ratio << " +/- " 
+        << Detail.Lines[i].Ratio * Detail.Lines[i].Error;
+      row[colsDataComp.ratio] = oss.str ();
+      oss.str (""); oss << Detail.Lines[i].Wavenumber;
+      row[colsDataComp.wavenumber] = oss.str ();
+    }
+    parentRow[colsDataComp.ref] = SpectrumLabels[Detail.k];
+    parentRow[colsDataComp.comparison] = SpectrumLabels[Detail.j];
+    parentRow[colsDataComp.wavenumber] = "";
+    oss.str (""); 
+    if (Detail.Linked) {
+      oss << Detail.Ratio.Ratio << " +/- " << Detail.Ratio.Error;
+    } else {
+      oss << Detail.Ratio.Ratio << " +/- " << Detail.Ratio.Ratio * Detail.Ratio.Error;
+    }
+    parentRow[colsDataComp.ratio] = oss.str ();
+  }
   return RtnData;
 }
 
 
 //------------------------------------------------------------------------------
-// updatePlottedData () : 
+// displayedLevel () : Returns the index of the upper level selected in
+// treeLevelsBF, whose lines are shown in the line plot area, or -1 if no level
+// is selected.
 //
-void AnalyserWindow::updatePlottedData (bool CalcScaleFactors) {
-  ostringstream oss;
-  oss.precision (2);
-  oss << fixed;
-  // Check the current selection is valid. Only proceed if it is.
+int AnalyserWindow::displayedLevel () {
   Glib::RefPtr<Gtk::TreeSelection> treeSelection = treeLevelsBF.get_selection();
   if (treeSelection) {
-    Gtk::TreeModel::iterator iter = treeLevelsBF.get_selection()->get_selected();
+    Gtk::TreeModel::iterator iter = treeSelection -> get_selected();
     if (iter) {
+      return (*iter)[levelCols.index];
+    }
+  }
+  return -1;
+}
+
 
-      // Update the list of XGremlin lines and the list of br. frac. data
-      int Level = (*iter)[levelCols.index];
-      modelDataXGr -> clear ();
-      modelDataBF -> clear ();
-      if (CalcScaleFactors) {
-        modelDataComp -> clear ();
+//------------------------------------------------------------------------------
+// orderLinePairs (int, vector < vector <LinePair *> > &, vector <string> &,
+// vector <unsigned int> &) : Arranges the lines of the given upper level that
+// are not hidden into OrderedPairs, with one row per spectrum. The reference
+// spectrum comes first. SpectrumLabels and SpectrumOrder are filled with the
+// label and ExptSpectra index of the spectrum in each row.
+//
+void AnalyserWindow::orderLinePairs (int Level,
+  vector < vector <LinePair *> > &OrderedPairs, vector <string> &SpectrumLabels,
+  vector <unsigned int> &SpectrumOrder) {
+  vector <LinePair *> NextPairSet;
+  vector <unsigned int> LinesToPlot;
+  unsigned int RefIndex = 0;
+
+  // Look at each line in turn and see if it is plotted in at least one spectrum.
+  // If so, add its index to LinesToPlot. This is effectively scanning through each
+  // COLUMN in the line profile plot area to make sure something is visible.
+  for (unsigned int j = 0; j < LevelLines[Level][0].size (); j ++) {
+    for (unsigned int i = 0; i < LevelLines[Level].size (); i ++) {
+      if (LevelLines[Level][i][j].xgLineLineIndex != -1 && !LevelLines[Level][i][j].plot->hidden()) {
+        LinesToPlot.push_back (j);
+        break;
       }
-      if (LevelLines[Level].size () > 0) {
-        vector < vector <LinePair *> > OrderedPairs;
-        vector <LinePair *> NextPairSet;
-        vector <string> SpectrumLabels;
-        vector <unsigned int> SpectrumOrder;
-        vector <unsigned int> LinesToPlot;
-        unsigned int RefIndex = 0;
-        
+    }
+  }
 
-        // Look at each line in turn and see if it is plotted in at least one spectrum.
-		// If so, add its index to LinesToPlot. This is effectively scanning through each
-		// COLUMN in the line profile plot area to make sure something is visible.
-		for (unsigned int j = 0; j < LevelLines[Level][0].size (); j ++) {
-			for (unsigned int i = 0; i < LevelLines[Level].size (); i ++) {
-				if (LevelLines[Level][i][j].xgLineLineIndex != -1 && !LevelLines[Level][i][j].plot->hidden()) {
-					LinesToPlot.push_back (j);
-					break;
-				}
-			}
-		}
-
-        // Find the reference spectrum. This will be plotted first. Add it's details to the beginning of the
-        // SpectrumLabels and SpectrumOrder vectors so that it is always referenced first.
-        for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
-          if (ExptSpectra[i].isReference()) {
-            RefIndex = i;
-            break;
-          }
-        }
-        SpectrumLabels.push_back (ExptSpectra [RefIndex].index());
-        SpectrumOrder.push_back (RefIndex);
-
-        // Now copy all of the lines belonging to the currently selected level in the reference spectrum to
-        // NextPairSet.
-        for (unsigned int i = 0; i < LinesToPlot.size (); i ++){
-          // Create NextPairSet from the LevelLines matrix
-          NextPairSet.push_back (&LevelLines[Level][RefIndex][LinesToPlot[i]]);
-
-          // Add a note to the plot to say what the response function value is at the wavenumber of the
-          // current line. This will be a number between 0 and 1.
-          oss << "C=" << ExptSpectra [RefIndex].response (LevelLines[Level][RefIndex][LinesToPlot[i]].xgLine->wavenumber ());
-          LevelLines[Level][RefIndex][LinesToPlot[i]].plot -> clearText ();
-          LevelLines[Level][RefIndex][LinesToPlot[i]].plot -> addText (45, 15, oss.str ());
-		  oss.str ("");
-        }
+  // Find the reference spectrum. This will be plotted first. Add it's details to the beginning of the
+  // SpectrumLabels and SpectrumOrder vectors so that it is always referenced first.
+  for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
+    if (ExptSpectra[i].isReference()) {
+      RefIndex = i;
+      break;
+    }
+  }
+  SpectrumLabels.push_back (ExptSpectra [RefIndex].index());
+  SpectrumOrder.push_back (RefIndex);
+  for (unsigned int i = 0; i < LinesToPlot.size (); i ++){
+    NextPairSet.push_back (&LevelLines[Level][RefIndex][LinesToPlot[i]]);
+  }
+  OrderedPairs.push_back (NextPairSet);
+
+  // Now repeat the above steps to add the lines from all the other spectra to OrderedPairs
+  for (unsigned int i = 0; i < LevelLines[Level].size (); i ++) {
+    if (i != RefIndex) {
+      NextPairSet.clear ();
+      for (unsigned int j = 0; j < LinesToPlot.size (); j ++) {
+        NextPairSet.push_back (&LevelLines[Level][i][LinesToPlot[j]]);
+      }
+      SpectrumLabels.push_back (ExptSpectra [i].index());
+      SpectrumOrder.push_back (i);
+      OrderedPairs.push_back (NextPairSet);
+    }
+  }
+}
 
-		// Finally, add NextPairSet to OrderedPairs for future use.
-        OrderedPairs.push_back (NextPairSet);
-
-        // Now repeat the above steps to add the lines from all the other spectra to OrderedPairs
-        for (unsigned int i = 0; i < LevelLines[Level].size (); i ++) {
-          NextPairSet.clear ();
-          if (i != RefIndex) {
-            for (unsigned int j = 0; j < LinesToPlot.size (); j ++) {
-              // Create NextPairSet from the LevelLines matrix
-              NextPairSet.push_back (&LevelLines[Level][i][LinesToPlot[j]]);
-
-			  // Add a note to the plot to say what the response function value is at the wavenumber of the
-			  // current line. This will be a number between 0 and 1.
-              oss << "C=" << ExptSpectra [i].response (LevelLines[Level][i][LinesToPlot[j]].xgLine->wavenumber ());
-              LevelLines[Level][i][LinesToPlot[j]].plot -> clearText ();
-              LevelLines[Level][i][LinesToPlot[j]].plot -> addText (45, 15, oss.str ());
-              oss.str ("");
-            }
-
-            // Add the details for the current spectrum to the end of the SpectrumLabels, SpectrumOrder and OrderedPairs vectors.
-            SpectrumLabels.push_back (ExptSpectra [i].index());
-            SpectrumOrder.push_back (i);
-            OrderedPairs.push_back (NextPairSet);
-          }
-        }
 
-        plotLines (OrderedPairs, SpectrumOrder);
-        if (CalcScaleFactors) {
-          ScalingFactors = updateComparisonList (OrderedPairs, SpectrumLabels, SpectrumOrder);
+//------------------------------------------------------------------------------
+// markDirty (unsigned int) : Flags the AW_DIRTY_* Parts of the displayed level
+// as out of date. They are refreshed by refreshDirty () once the GUI is idle,
+// so that several changes made in quick succession (eg. the user clicking on
+// a number of line profiles) only cause one refresh.
+//
+void AnalyserWindow::markDirty (unsigned int Parts) {
+  Dirty |= Parts;
+  if (!RefreshConnection.connected ()) {
+    RefreshConnection = Glib::signal_idle ().connect (sigc::mem_fun (*this,
+      &AnalyserWindow::on_refresh_idle));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_refresh_idle () : Refreshes the parts of the window flagged by markDirty ()
+// and returns false so that it is not called again until they next change.
+//
+bool AnalyserWindow::on_refresh_idle () {
+  refreshDirty ();
+  return false;
+}
+
+
+//------------------------------------------------------------------------------
+// refreshDirty () : Rebuilds the parts of the displayed level that have been
+// flagged in Dirty, and leaves the rest alone. A pending idle refresh then has
+// nothing left to do.
+//
+void AnalyserWindow::refreshDirty () {
+  TRACE_SCOPE ("refreshDirty");
+  unsigned int Parts = Dirty;
+  int Level = displayedLevel ();
+  Dirty = 0;
+  if (Parts == 0 || Level == -1) return;
+
+  // The branching fractions are only cleared if there are none to replace them,
+  // as modelDataBF can update the rows it already has
+  if (Parts & AW_DIRTY_XGREMLIN) modelDataXGr -> clear ();
+  if (Parts & AW_DIRTY_COMPARISON) modelDataComp -> clear ();
+  if ((Parts & AW_DIRTY_BF) && LevelLines[Level].size () == 0) {
+    modelDataBF -> clear ();
+  }
+  if (LevelLines[Level].size () > 0 && (Parts & ~AW_DIRTY_TARGETS)) {
+    vector < vector <LinePair *> > OrderedPairs;
+    vector <string> SpectrumLabels;
+    vector <unsigned int> SpectrumOrder;
+    orderLinePairs (Level, OrderedPairs, SpectrumLabels, SpectrumOrder);
+
+    if (Parts & AW_DIRTY_PLOTS) {
+      ostringstream oss;
+      oss.precision (2);
+      oss << fixed;
+
+      // Add a note to each plot to say what the response function value is at
+      // the wavenumber of the line. This will be a number between 0 and 1.
+      for (unsigned int i = 0; i < OrderedPairs.size (); i ++) {
+        for (unsigned int j = 0; j < OrderedPairs[i].size (); j ++) {
+          oss.str ("");
+          oss << "C=" << ExptSpectra [SpectrumOrder[i]].response (
+            OrderedPairs[i][j] -> xgLine -> wavenumber ());
+          OrderedPairs[i][j] -> plot -> clearText ();
+          OrderedPairs[i][j] -> plot -> addText (45, 15, oss.str ());
         }
-        updateXGremlinList (OrderedPairs, SpectrumLabels, SpectrumOrder);
-        updateBranchingFractions (OrderedPairs, SpectrumLabels, SpectrumOrder);
       }
-
-      // Update the list of Kurucz lines
-      updateKuruczList (KuruczList.upperLevel(Level));
+      plotLines (OrderedPairs, SpectrumOrder);
+    }
+    if (Parts & AW_DIRTY_COMPARISON) {
+      ScalingFactors = updateComparisonList (OrderedPairs, SpectrumLabels, SpectrumOrder);
+    }
+    if (Parts & AW_DIRTY_XGREMLIN) {
+      updateXGremlinList (OrderedPairs, SpectrumLabels, SpectrumOrder);
+    }
+    if (Parts & AW_DIRTY_BF) {
+      updateBranchingFractions (OrderedPairs, SpectrumLabels, SpectrumOrder);
     }
   }
+
+  // Update the list of Kurucz lines
+  if (Parts & AW_DIRTY_TARGETS) {
+    updateKuruczList (KuruczList.upperLevel(Level));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// updatePlottedData (bool) : Rebuilds everything shown for the displayed level
+// straight away, including any refresh still waiting for the GUI to go idle.
+// The spectrum scaling factors are only recalculated if CalcScaleFactors is
+// true.
+//
+void AnalyserWindow::updatePlottedData (bool CalcScaleFactors) {
+  TRACE_SCOPE ("updatePlottedData");
+  unsigned int Parts = AW_DIRTY_ALL;
+  if (!CalcScaleFactors) Parts &= ~AW_DIRTY_COMPARISON;
+  Dirty |= Parts;
+  refreshDirty ();
 }
 
 
@@ -777,9 +724,10 @@ void AnalyserWindow::refreshKuruczList () {
 // refreshSpectraList () : Clears the information currently displayed in the  
 // "Experimental Spectra" list and then uses refreshSpectraList (XgSpectrum, 
 // int, bool, bool) below to refresh it. By default, the first item in the list
-// is selected as the reference spectrum.
+// is selected as the reference spectrum. If Rematch is false, LevelLines is
+// assumed to be up to date already and the lines are not matched again.
 //
-void AnalyserWindow::refreshSpectraList () {
+void AnalyserWindow::refreshSpectraList (bool Rematch) {
   if (ExptSpectra.size () > 0) {
     m_refTreeModel -> clear ();
     addToSpectraList (ExptSpectra [0], 0, ExptSpectra[0].isReference (), true);
@@ -789,7 +737,7 @@ void AnalyserWindow::refreshSpectraList () {
 
     // Finally, perform the calculations to determine how much of each upper level
     // is seen, and what the associated level branching fraction parameters are.
-    getLinePairs ();
+    if (Rematch) getLinePairs ();
     updateKuruczCompleteness ();
   }
 }
@@ -904,3 +852,111 @@ void AnalyserWindow::addToSpectraList (XgSpectrum NewSpectrum,
     }
   }
 }
+
+
+//------------------------------------------------------------------------------
+// treeModelUsage (string, Glib::RefPtr<Gtk::TreeStore>) : Returns the number of
+// rows in Model, and an estimate of the memory they use. Each row of a
+// TreeStore is a GNode holding a list of cells of two pointers each. The
+// characters of any strings in the cells are not counted.
+//
+static MemoryUse treeModelUsage (string Name, Glib::RefPtr<Gtk::TreeStore> Model) {
+  MemoryUse Usage (Name, 0, 0);
+  vector <Gtk::TreeModel::Children> Todo;
+
+  Todo.push_back (Model -> children ());
+  while (Todo.size () > 0) {
+    Gtk::TreeModel::Children Rows = Todo.back ();
+    Todo.pop_back ();
+    for (Gtk::TreeModel::iterator iter = Rows.begin (); iter != Rows.end ();
+      iter ++) {
+      Usage.Items ++;
+      if (iter -> children ().size () > 0) Todo.push_back (iter -> children ());
+    }
+  }
+  Usage.Bytes = Usage.Items
+    * (sizeof (GNode) + Model -> get_n_columns () * 2 * sizeof (void *));
+  return Usage;
+}
+
+
+//------------------------------------------------------------------------------
+// memoryUsage () : Returns the memory used by each loaded spectrum, line list
+// and set of line plots, the target lines, the widgets that display the plots
+// and the tree models. This is shown in the performance window. Nothing is
+// measured while an exclusive job is running, as the data may be changing.
+//
+vector <MemoryUse> AnalyserWindow::memoryUsage () {
+  vector <MemoryUse> Usage;
+  ostringstream oss;
+
+  if (Jobs.locked ()) {
+    Usage.push_back (MemoryUse ("Not measured while a job is running", 0, 0));
+    return Usage;
+  }
+
+  for (unsigned int i = 0; i < ExptSpectra.size (); i ++) {
+    XgSpectrum &Spectrum = ExptSpectra[i];
+    oss.str ("");
+    oss << Spectrum.name () << ": spectrum";
+    Usage.push_back (MemoryUse (oss.str (), Spectrum.numDataPoints (),
+      Spectrum.dataBytes ()));
+    for (unsigned int j = 0; j < Spectrum.linesPtr2 () -> size (); j ++) {
+      oss.str ("");
+      oss << Spectrum.name () << ": line list " << j + 1;
+      Usage.push_back (MemoryUse (oss.str (),
+        Spectrum.linesPtr2 () -> at (j).size (), Spectrum.lineBytes (j)));
+    }
+
+    MemoryUse Plots (Spectrum.name () + ": line plots", 0, 0);
+    vector < vector <LineData *> > SpectrumPlots;
+    if (i < LinePlots.size ()) SpectrumPlots = LinePlots[i];
+    for (unsigned int j = 0; j < SpectrumPlots.size (); j ++) {
+      for (unsigned int k = 0; k < SpectrumPlots[j].size (); k ++) {
+        if (SpectrumPlots[j][k]) {
+          Plots.Items ++;
+          Plots.Bytes += SpectrumPlots[j][k] -> bytes ();
+        }
+      }
+    }
+    Usage.push_back (Plots);
+  }
+
+  Usage.push_back (MemoryUse ("Target lines", KuruczList.size (),
+    KuruczList.bytes ()));
+  MemoryUse Pairs ("Matched line pairs", 0, 0);
+  for (unsigned int i = 0; i < LevelLines.size (); i ++) {
+    for (unsigned int j = 0; j < LevelLines[i].size (); j ++) {
+      Pairs.Items += LevelLines[i][j].size ();
+      Pairs.Bytes += LevelLines[i][j].capacity () * sizeof (LinePair);
+    }
+  }
+  Usage.push_back (Pairs);
+  Usage.push_back (MemoryUse ("Blank line plots", Placeholders.size (),
+    Placeholders.bytes ()));
+  Usage.push_back (MemoryUse ("Line plot widgets", Profiles.pool ().size (),
+    Profiles.pool ().bytes ()));
+  Usage.push_back (MemoryUse ("Spectrum overviews", Overview.size (),
+    Overview.bytes ()));
+
+  Usage.push_back (treeModelUsage ("Tree: spectra", m_refTreeModel));
+  Usage.push_back (treeModelUsage ("Tree: levels", levelTreeModel));
+  Usage.push_back (treeModelUsage ("Tree: level BFs", modelLevelsBF));
+  Usage.push_back (MemoryUse ("Tree: target lines", lineDataTreeModel -> size (),
+    TargetLines.capacity () * sizeof (KzLine) + TargetFound.capacity () / 8));
+  Usage.push_back (treeModelUsage ("Tree: experimental lines", modelDataXGr));
+  Usage.push_back (treeModelUsage ("Tree: comparison", modelDataComp));
+  Usage.push_back (MemoryUse ("Tree: line BFs", modelDataBF -> size (),
+    BrFracData.capacity () * sizeof (DataBF)));
+  return Usage;
+}
+
+
+//------------------------------------------------------------------------------
+// overviewSpectra () : Returns the spectra to show in the overview window, or
+// NULL while an exclusive job is running, as they may be changing.
+//
+vector <XgSpectrum> *AnalyserWindow::overviewSpectra () {
+  if (Jobs.locked ()) return NULL;
+  return &ExptSpectra;
+}
@@ -71,7 +71,8 @@ void AnalyserWindow::ref_spectrum_toggled (const Glib::ustring& PathIn) {
   }
   updateKuruczCompleteness ();
   updatePlottedData ();
-  projectHasChanged (true);
+  projectHasChanged (JournalRecord (JOURNAL_REFERENCE, ActiveRow[m_Columns.index],
+    0, 0, ToggleValue ? JOURNAL_REF : 0));
 }
 
 
@@ -104,13 +105,17 @@ void AnalyserWindow::newProject () {
       }
     } else if (Result == Gtk::RESPONSE_CANCEL) {
       return;
+    } else if (Result == Gtk::RESPONSE_NO) {
+      Journal.discard ();
     }
   }
   
   // If the user confirms the new project, delete all current data
   LevelLines.clear ();
+  PlotLevels.clear ();
   KuruczList.clear ();
   ExptSpectra.clear ();
+  deleteLinePlots ();
   LinkedSpectra.clear ();
   lineDataTreeModel -> clear ();
   levelTreeModel -> clear ();
@@ -120,7 +125,9 @@ void AnalyserWindow::newProject () {
   modelDataBF -> clear ();
   modelDataComp -> clear ();
   clearDisplayedPlots ();
+  Placeholders.reset ();
   CurrentFilename = "";
+  Journal.close ();
   projectHasChanged (false);
   
   Status.push ("New project created");
@@ -132,13 +139,12 @@ void AnalyserWindow::newProject () {
 // AnalyserWindow object.
 //
 void AnalyserWindow::clearDisplayedPlots () {
-  for (int i = LineBoxes.size () - 1; i >= 0; i --) {
-    delete hboxSpectrumPlots [i];
-    delete frameSpectrumPlots [i];
-  }
+  Profiles.clear ();
   LineBoxes.clear ();
-  hboxSpectrumPlots.clear ();
-  frameSpectrumPlots.clear ();
+  PlotScales.clear ();
+  ScaleMins.clear ();
+  ScaleMaxes.clear ();
+  ScaleChanged.clear ();
 }
 
 
@@ -247,7 +253,8 @@ void AnalyserWindow::lifetimeEdited (const Glib::ustring& path_string, const Gli
       row[levelCols.lifetime_colour] = Gdk::Color (AW_EQWIDTH_NORM_COLOUR);
       updateKuruczBF ();
       updatePlottedData ();
-      projectHasChanged (true);
+      projectHasChanged (JournalRecord (JOURNAL_LIFETIME, row[levelCols.index],
+        0, 0, 0, row[levelCols.lifetime] * 1e-9, row[levelCols.err_lifetime] * 1e-9));
     }
   }
 }
@@ -292,7 +299,8 @@ void AnalyserWindow::lifetimeErrorEdited (const Glib::ustring& path_string, cons
       row[levelCols.err_lifetime_colour] = Gdk::Color(AW_EQWIDTH_NORM_COLOUR);
       updateKuruczBF ();
       updatePlottedData ();
-      projectHasChanged (true);
+      projectHasChanged (JournalRecord (JOURNAL_LIFETIME, row[levelCols.index],
+        0, 0, 0, row[levelCols.lifetime] * 1e-9, row[levelCols.err_lifetime] * 1e-9));
     }
   }
 }
@@ -304,11 +312,169 @@ void AnalyserWindow::lifetimeErrorEdited (const Glib::ustring& path_string, cons
 void AnalyserWindow::on_tools_options () {
   Options.set_modal (true);
   Gtk::Main::run(Options);
+  Jobs.threads (Options.num_threads ());
+  Cache.limit (uint64_t (Options.cache_limit ()) * 1048576);
   updatePlottedData (true);
   updateKuruczCompleteness ();
 }
 
 
+//------------------------------------------------------------------------------
+// on_tools_purge_cache () : Empties the cache of parsed input files, so that
+// every file is parsed again the next time it is loaded.
+//
+void AnalyserWindow::on_tools_purge_cache () {
+  ostringstream oss;
+  oss << "Input cache purged. " << Cache.purge () / 1024 << " kB freed.";
+  Status.push (oss.str ());
+}
+
+
+//------------------------------------------------------------------------------
+// on_tools_performance () : Shows the performance window. Unlike the options
+// box this is not modal, so that it can be watched while FAST is used.
+//
+void AnalyserWindow::on_tools_performance () {
+  Performance.set_transient_for (*this);
+  Performance.show ();
+  Performance.present ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_tools_overview () : Shows the spectrum overview window. Like the
+// performance window this is not modal.
+//
+void AnalyserWindow::on_tools_overview () {
+  Overview.set_transient_for (*this);
+  Overview.show ();
+  Overview.present ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_overview_line (unsigned int, unsigned int, unsigned int) : Called when a
+// line marker is clicked in the overview window. If the line is matched to a
+// Kurucz line, its upper level is selected and its plots are displayed.
+//
+void AnalyserWindow::on_overview_line (unsigned int Spectrum,
+  unsigned int List, unsigned int Line) {
+  typedef Gtk::TreeModel::Children type_children;
+  int Level = -1;
+  if (Jobs.locked ()) return;
+
+  for (unsigned int i = 0; i < LevelLines.size () && Level == -1; i ++) {
+    if (Spectrum >= LevelLines[i].size ()) continue;
+    for (unsigned int j = 0; j < LevelLines[i][Spectrum].size (); j ++) {
+      if (LevelLines[i][Spectrum][j].xgLineListIndex == int (List)
+        && LevelLines[i][Spectrum][j].xgLineLineIndex == int (Line)) {
+        Level = i;
+        break;
+      }
+    }
+  }
+  if (Level == -1) {
+    Status.push ("The selected line is not matched to a Kurucz line");
+    return;
+  }
+
+  // Select the level in both the "Levels" and "Br. Frac." tabs
+  type_children children = levelTreeModel -> children ();
+  for (type_children::iterator iter = children.begin ();
+    iter != children.end (); ++iter) {
+    if ((*iter)[levelCols.index] == Level) {
+      Gtk::TreePath path = levelTreeModel -> get_path (iter);
+      treeLevels.set_cursor (path);
+      treeLevels.scroll_to_row (path);
+      break;
+    }
+  }
+  children = modelLevelsBF -> children ();
+  for (type_children::iterator iter = children.begin ();
+    iter != children.end (); ++iter) {
+    if ((*iter)[levelColsBF.index] == Level) {
+      Gtk::TreePath path = modelLevelsBF -> get_path (iter);
+      treeLevelsBF.set_cursor (path);
+      treeLevelsBF.scroll_to_row (path);
+      break;
+    }
+  }
+  updatePlottedData ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_jobs_busy (bool) : Called when the background job queue becomes busy or
+// idle. The job progress is shown in the status bar while any job is queued.
+//
+void AnalyserWindow::on_jobs_busy (bool Busy) {
+  if (Busy) {
+    JobProgress.set_fraction (0.0);
+    JobProgress.show ();
+    JobCancel.show ();
+  } else {
+    JobProgress.hide ();
+    JobCancel.hide ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_jobs_locked (bool) : Called when the first exclusive job is queued, and
+// when the last one has finished. The menus and panes are disabled while such
+// jobs are running, since they read the loaded spectra and line lists from
+// their worker threads.
+//
+void AnalyserWindow::on_jobs_locked (bool Locked) {
+  m_refActionGroup -> set_sensitive (!Locked);
+  hpanedDivider.set_sensitive (!Locked);
+}
+
+
+//------------------------------------------------------------------------------
+// on_job_progress (string, double) : Shows the progress of the current job in
+// the status bar.
+//
+void AnalyserWindow::on_job_progress (string Description, double Fraction) {
+  JobProgress.set_text (Description);
+  JobProgress.set_fraction (Fraction > 1.0 ? 1.0 : Fraction);
+}
+
+
+//------------------------------------------------------------------------------
+// on_job_failed (string, string) : Called when a background job has stopped
+// because of an unexpected error. The job has already been aborted, so only
+// the error needs to be shown.
+//
+void AnalyserWindow::on_job_failed (string Description, string Message) {
+  Error Err (0, Description + " failed", Message);
+  display_error (&Err, Description + " failed");
+}
+
+
+//------------------------------------------------------------------------------
+// on_job_cancel () : Cancels all of the outstanding background jobs.
+//
+void AnalyserWindow::on_job_cancel () {
+  Jobs.cancelAll ();
+  Status.push ("Cancelled");
+}
+
+
+//------------------------------------------------------------------------------
+// on_compact_journal () : Called every AW_JOURNAL_COMPACT_SECONDS. If edits have
+// been journalled since the project was last saved, the project is saved in the
+// background, which folds them into the project file and empties the journal.
+// Nothing is done while other jobs are reading the project.
+//
+bool AnalyserWindow::on_compact_journal () {
+  if (Journal.size () > 0 && PendingSave == NULL && !Jobs.locked ()) {
+    saveProject (CurrentFilename, true);
+  }
+  return true;
+}
+
+
 //------------------------------------------------------------------------------
 // on_help_about () : Shows the FAST about box
 //
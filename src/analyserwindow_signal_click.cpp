@@ -71,7 +71,9 @@ void AnalyserWindow::on_click_treeSpectra (GdkEventButton* event)
           } else {
             if ((*iter)[m_Columns.line_index] != -1 
               && (*iter)[m_Columns.line_index] != -2) {
-              plotLines (ExptSpectra [(*iter)[m_Columns.index]], 
+              profileLines ((*iter)[m_Columns.index],
+                (*iter)[m_Columns.line_index]);
+              plotLines ((*iter)[m_Columns.index], 
                 (*iter)[m_Columns.line_index]);
             } else { 
               clearDisplayedPlots ();
@@ -214,13 +216,16 @@ void AnalyserWindow::on_click_level_list_bf (GdkEventButton* event) {
 
 
 //------------------------------------------------------------------------------
-// on_click_plot () : Updates branching fraction data when a new plot is either
-// selected or unselected.
+// on_click_plot (bool, LineData *) : Updates branching fraction data when the
+// line in Plot is either selected or unselected. Plot has already redrawn
+// itself, and selecting a line changes neither the layout of the plots nor the
+// scaling factors, so only the branching fractions and the completeness of the
+// levels that contain the line are refreshed.
 //
-void AnalyserWindow::on_click_plot (bool Selected) {
-  updatePlottedData (false);
-  updateKuruczCompleteness ();
-  projectHasChanged (true);
+void AnalyserWindow::on_click_plot (bool Selected, LineData *Plot) {
+  updateKuruczCompleteness (Plot);
+  markDirty (AW_DIRTY_BF);
+  lineHasChanged (Plot);
 }
 
 
@@ -30,13 +30,11 @@ using namespace::std;
 //------------------------------------------------------------------------------
 // loadXGremlinData () : Manages the duel loading of an XGremlin spectrum and
 // line list. If the user cancels the loading of a spectrum, no prompt is given
-// to load an associated line list.
+// to load an associated line list. Otherwise, the prompt is given once the
+// spectrum has been loaded in the background.
 //
 void AnalyserWindow::loadXGremlinData () {
-  int rtnCode = do_load_expt_spectrum ();
-  if (rtnCode == FLT_NO_ERROR) {
-	on_data_load_line_list ();
-  }
+  do_load_expt_spectrum (true);
 }
 
 //------------------------------------------------------------------------------
@@ -72,7 +70,7 @@ void AnalyserWindow::on_data_load_kurucz () {
     { 
       ostringstream oss;
       try {
-        KuruczList.read (dialog.get_filename());
+        readKuruczFile (dialog.get_filename());
         size_t FilePos = dialog.get_filename().find_last_of ("/\\") + 1;
         DefaultFolder = dialog.get_filename().substr (0, FilePos);
         getLinePairs();
@@ -154,9 +152,11 @@ void AnalyserWindow::on_data_load_expt_spectrum () {
 
 
 //------------------------------------------------------------------------------
-// do_load_expt_spectrum () : Loads a user specified XGremlin spectrum
+// do_load_expt_spectrum (bool) : Asks the user for an XGremlin spectrum, which is
+// then loaded by a LoadSpectrumJob. If LoadLineList is true, the user will be
+// asked for a line list to attach once the spectrum has been loaded.
 //
-int AnalyserWindow::do_load_expt_spectrum () {
+int AnalyserWindow::do_load_expt_spectrum (bool LoadLineList) {
   Gtk::FileChooserDialog dialog("Select an experimental data file to load",
 		  Gtk::FILE_CHOOSER_ACTION_OPEN);
   dialog.set_transient_for(*this);
@@ -185,60 +185,11 @@ int AnalyserWindow::do_load_expt_spectrum () {
   {
     case(Gtk::RESPONSE_OK):
     { 
-      ostringstream oss;
-      // Attempt to load the spectrum into a new XgSpectrum object.
-      try {
-        size_t FilePos = dialog.get_filename().find_last_of ("/\\") + 1;
-        DefaultFolder = dialog.get_filename().substr (0, FilePos);
-
-        XgSpectrum NewSpectrum;
-        try {
-          NewSpectrum.loadDat (dialog.get_filename());
-        } catch (Error e) {
-          if (e.code == FLT_FILE_HEAD_ERROR) {
-            NewSpectrum.loadAscii (dialog.get_filename());
-          } else {
-            throw (e);
-          }
-        }
-        NewSpectrum.name (dialog.get_filename().substr(FilePos));
-        string a; a.push_back (char (ExptSpectra.size () + ASCII_A));
-        NewSpectrum.index (a);
-        ExptSpectra.push_back (NewSpectrum);
-        oss << "Successfully added " << NewSpectrum.name() << ".";
-        Status.push (oss.str());
-        
-        // Fill the TreeView's model
-        Gtk::TreeModel::Row row = *(m_refTreeModel->append());
-        row[m_Columns.name] = dialog.get_filename().substr(FilePos);
-        row[m_Columns.emin] = int(NewSpectrum.data()[0].x + 0.5);
-        row[m_Columns.emax] = int(NewSpectrum.data()[NewSpectrum.data().size () - 1].x + 0.5);
-        row[m_Columns.index] = int(ExptSpectra.size ()) - 1;
-        row[m_Columns.line_index] = -1;
-        row[m_Columns.bg_colour] = Gdk::Color (AW_SPECTRUM_COLOUR);
-        if (ExptSpectra.size () == 1) {
-          row[m_Columns.ref] = true;
-          ExptSpectra[0].isReference (true);
-        } else {
-          row[m_Columns.ref] = false;
-        }
-        row[m_Columns.label] = NewSpectrum.index();
-
-        Glib::RefPtr<Gtk::TreeSelection> treeSelection = treeSpectra.get_selection();
-        if (treeSelection) {
-          treeSelection->select(row);
-        }
-        projectHasChanged (true);
-        return FLT_NO_ERROR;
-
-        
-      // If a file reading error occurs, inform the user. If another error has
-      // occurred, continue to throw it.
-      } catch (Error *Err) {
-        display_error (Err);
-        return FLT_DIALOG_CANCEL;
-      }          
-      break;
+      size_t FilePos = dialog.get_filename().find_last_of ("/\\") + 1;
+      DefaultFolder = dialog.get_filename().substr (0, FilePos);
+      Jobs.push (new LoadSpectrumJob (this, dialog.get_filename(), LoadLineList));
+      Status.push ("Loading " + dialog.get_filename().substr(FilePos) + "...");
+      return FLT_NO_ERROR;
     }
     
     // User clicked cancel or closed the dialog without clicking OK. Assume they
@@ -253,6 +204,46 @@ int AnalyserWindow::do_load_expt_spectrum () {
 }
 
 
+//------------------------------------------------------------------------------
+// addExptSpectrum (XgSpectrum, string) : Adds a spectrum loaded from Filename by
+// a LoadSpectrumJob to ExptSpectra and to treeSpectra. The first spectrum to be
+// loaded becomes the reference spectrum.
+//
+void AnalyserWindow::addExptSpectrum (XgSpectrum NewSpectrum, string Filename) {
+  ostringstream oss;
+  size_t FilePos = Filename.find_last_of ("/\\") + 1;
+
+  NewSpectrum.name (Filename.substr(FilePos));
+  string a; a.push_back (char (ExptSpectra.size () + ASCII_A));
+  NewSpectrum.index (a);
+  ExptSpectra.push_back (NewSpectrum);
+  oss << "Successfully added " << NewSpectrum.name() << ".";
+  Status.push (oss.str());
+        
+  // Fill the TreeView's model
+  Gtk::TreeModel::Row row = *(m_refTreeModel->append());
+  row[m_Columns.name] = Filename.substr(FilePos);
+  row[m_Columns.emin] = int(NewSpectrum.data()[0].x + 0.5);
+  row[m_Columns.emax] = int(NewSpectrum.data()[NewSpectrum.data().size () - 1].x + 0.5);
+  row[m_Columns.index] = int(ExptSpectra.size ()) - 1;
+  row[m_Columns.line_index] = -1;
+  row[m_Columns.bg_colour] = Gdk::Color (AW_SPECTRUM_COLOUR);
+  if (ExptSpectra.size () == 1) {
+    row[m_Columns.ref] = true;
+    ExptSpectra[0].isReference (true);
+  } else {
+    row[m_Columns.ref] = false;
+  }
+  row[m_Columns.label] = NewSpectrum.index();
+
+  Glib::RefPtr<Gtk::TreeSelection> treeSelection = treeSpectra.get_selection();
+  if (treeSelection) {
+    treeSelection->select(row);
+  }
+  projectHasChanged (true);
+}
+
+
 //------------------------------------------------------------------------------
 // on_data_load_line_list () : Loads a user specified XGremlin line list and
 // attaches it to the spectrum currently selected in treeSpectra in the bottom
@@ -296,65 +287,16 @@ void AnalyserWindow::on_data_load_line_list () {
       {
         case(Gtk::RESPONSE_OK):
         {
-          try {
-            // Read the XGremlin line list and store it in the Lines vector
-            Gtk::TreeModel::Row SelectedRow = *(iter);
-            vector <XgLine> NewLines;
-            vector <char> LinHeader;
-            try {
-              if (dialog.get_filename().substr(dialog.get_filename().size() - 4, 4) == ".lin") {
-                NewLines = readLinFile (dialog.get_filename());
-                LinHeader = readLinFileHeader (dialog.get_filename());
-              } else {
-                NewLines = readLineList (dialog.get_filename());
-              }
-            } catch (const char* e) {
-              cout << e << endl;
-              throw (Error (FLT_FILE_READ_ERROR, "File read error, check the terminal for details"));
-            }
-            
-            // Remove lines that are outside the spectrum
-            for (int i = NewLines.size () - 1; i >= 0; i --) {
-              if (NewLines[i].wavenumber () < ExptSpectra[SelectedRow[m_Columns.index]].data (0).x ||
-                NewLines[i].wavenumber () > ExptSpectra[SelectedRow[m_Columns.index]].data 
-                  (ExptSpectra[SelectedRow[m_Columns.index]].numDataPoints() - 1).x){
-                NewLines.erase (NewLines.begin () + i);
-              }
-            }
-            addNewLines (&ExptSpectra[SelectedRow[m_Columns.index]], NewLines);
-            ExptSpectra[SelectedRow[m_Columns.index]].lin_headers_push_back (LinHeader);
-            getLinePairs ();
-
-            // Attach the line list to treeSpectra as a child of the selected
-            // experimental spectrum.
-            Gtk::TreeModel::Row row = *(m_refTreeModel->append(SelectedRow->children()));
-            size_t FilePos = dialog.get_filename().find_last_of ("/\\") + 1;
-            DefaultFolder = dialog.get_filename().substr (0, FilePos);
-            int Index = (*iter)[m_Columns.index];
-            int LineIndex = ExptSpectra[Index].lines().size () - 1;
-            bool Ref = (*iter)[m_Columns.ref];
-            row[m_Columns.index] = Index;
-            row[m_Columns.line_index] = LineIndex;
-            row[m_Columns.ref] = Ref;
-            row[m_Columns.emin] = ExptSpectra[Index].lines()[LineIndex][0].wavenumber ();
-            row[m_Columns.emax] = ExptSpectra[Index].lines()[LineIndex][ExptSpectra[Index].lines()[LineIndex].size () - 1].wavenumber ();
-            row[m_Columns.name] = ExptSpectra[Index].lines()[LineIndex][0].name ();
-            row[m_Columns.bg_colour] = Gdk::Color (AW_LINELIST_COLOUR);
-            updateKuruczCompleteness ();
-
-            // Let the user know that the list has been attached successfully.
-            ostringstream oss;
-            string SpectrumName = SelectedRow[m_Columns.name];
-            oss << "Successfully attached " 
-              << dialog.get_filename().substr(FilePos) << " to "
-              << SpectrumName << ".";
-            Status.push (oss.str());
-            projectHasChanged (true);
-
-          } catch (Error *Err) {
-            display_error (Err);
-            return;
-          }
+          // Read the line list in the background. Only lines lying within the
+          // spectrum are kept.
+          int Index = (*iter)[m_Columns.index];
+          XgSpectrum *Spectrum = &ExptSpectra[Index];
+          size_t FilePos = dialog.get_filename().find_last_of ("/\\") + 1;
+          DefaultFolder = dialog.get_filename().substr (0, FilePos);
+          Jobs.push (new LoadLineListJob (this, dialog.get_filename(), Index,
+            Spectrum -> data (0).x, 
+            Spectrum -> data (Spectrum -> numDataPoints() - 1).x));
+          Status.push ("Loading " + dialog.get_filename().substr(FilePos) + "...");
           break;
         }
 
@@ -365,12 +307,72 @@ void AnalyserWindow::on_data_load_line_list () {
           break;
         }
       }
-      updatePlottedData ();
     }
   }
 }
 
 
+//------------------------------------------------------------------------------
+// attachLineList (int, string, vector <XgLine> &, vector <char>) : Attaches
+// the lines read from Filename by a LoadLineListJob to ExptSpectra[Index],
+// creating empty plots for them, and adds the list to treeSpectra as a child of
+// the spectrum. The lines are then matched to the Kurucz lines in the
+// background.
+//
+void AnalyserWindow::attachLineList (int Index, string Filename, 
+  vector <XgLine> &NewLines, vector <char> LinHeader) {
+  vector <LineProfile> NoProfiles;
+  ostringstream oss;
+  size_t FilePos = Filename.find_last_of ("/\\") + 1;
+
+  addNewLines (&ExptSpectra[Index], Index, NewLines, NoProfiles);
+  ExptSpectra[Index].lin_headers_push_back (LinHeader);
+
+  // Attach the line list to treeSpectra as a child of its spectrum
+  typedef Gtk::TreeModel::Children type_children;
+  type_children children = m_refTreeModel->children();
+  for (type_children::iterator iter = children.begin(); iter != children.end(); ++iter) {
+    int RowIndex = (*iter)[m_Columns.index];
+    int RowLineIndex = (*iter)[m_Columns.line_index];
+    if (RowIndex == Index && RowLineIndex == -1) {
+      Gtk::TreeModel::Row SelectedRow = *(iter);
+      Gtk::TreeModel::Row row = *(m_refTreeModel->append(SelectedRow->children()));
+      int LineIndex = ExptSpectra[Index].linesPtr2 () -> size () - 1;
+      vector <XgLine> &Lines = ExptSpectra[Index].linesPtr2 () -> at (LineIndex);
+      bool Ref = (*iter)[m_Columns.ref];
+      row[m_Columns.index] = Index;
+      row[m_Columns.line_index] = LineIndex;
+      row[m_Columns.ref] = Ref;
+      if (Lines.size () > 0) {
+        row[m_Columns.emin] = Lines[0].wavenumber ();
+        row[m_Columns.emax] = Lines[Lines.size () - 1].wavenumber ();
+        row[m_Columns.name] = Lines[0].name ();
+      }
+      row[m_Columns.bg_colour] = Gdk::Color (AW_LINELIST_COLOUR);
+
+      // Let the user know that the list has been attached successfully.
+      string SpectrumName = SelectedRow[m_Columns.name];
+      oss << "Successfully attached " << Filename.substr(FilePos) << " to "
+        << SpectrumName << ".";
+      Status.push (oss.str());
+      break;
+    }
+  }
+  projectHasChanged (true);
+  queueLineMatching (sigc::mem_fun (*this, &AnalyserWindow::lineListMatched));
+}
+
+
+//------------------------------------------------------------------------------
+// lineListMatched () : Called once the lines of a newly attached line list have
+// been matched to the Kurucz lines.
+//
+void AnalyserWindow::lineListMatched () {
+  updateKuruczCompleteness ();
+  updatePlottedData ();
+}
+
+
 //------------------------------------------------------------------------------
 // on_data_attach_standard_lamp_radiance () : Loads a user specified radiance
 // file and attaches the data to the spectrum currently selected in treeSpectra
@@ -595,11 +597,10 @@ void AnalyserWindow::on_data_remove_spectrum () {
     Gtk::TreeModel::iterator iter = refSelection->get_selected();
     if(iter) {
       Index = (*iter)[m_Columns.index];
-      clearDisplayedPlots ();
       a = ExptSpectra[Index].name ();
-      ExptSpectra.erase (ExptSpectra.begin() + Index);
+      removeSpectrum (Index);
       m_refTreeModel->erase (iter);
-      projectHasChanged (true);
+      projectHasChanged (JournalRecord (JOURNAL_REMOVE_SPECTRUM, Index));
       getLinePairs ();
       updateKuruczCompleteness ();
       updatePlottedData ();
@@ -608,14 +609,13 @@ void AnalyserWindow::on_data_remove_spectrum () {
     }
   }
   
-  // Update the spectrum label and index for all the remaining spectra
+  // Update the spectrum label and index shown for all the remaining spectra,
+  // which removeSpectrum () has already relabelled.
   typedef Gtk::TreeModel::Children type_children;
   type_children children = m_refTreeModel->children();
   Index = -1;
   for(type_children::iterator iter = children.begin(); iter != children.end(); ++iter) {
     Index ++;
-    a = ""; a.push_back (char (Index + ASCII_A));
-    ExptSpectra[Index].index (a);
     (*iter)[m_Columns.index] = Index;
     (*iter)[m_Columns.label] = ExptSpectra[Index].index();
   }
@@ -631,7 +631,8 @@ void AnalyserWindow::on_data_output_results () {
   vector <unsigned int> SpectrumOrder;
   unsigned int RefIndex = 0;  
   
-  vector <vector <DataBF> > Results;
+  vector < vector <LineMatch> > Matches;
+  vector <vector <BfResult> > Results;
   vector <vector <XgLine> > Fits;
   vector <XgLine> NextLevelFits;
   vector <vector <KzLine> > Targets;
@@ -675,8 +676,9 @@ void AnalyserWindow::on_data_output_results () {
 
     // Obtain the Branching Fraction results
     ScalingFactors = updateComparisonList (OrderedPairs, SpectrumLabels, SpectrumOrder);
-    Results.push_back (calculateBranchingFractions 
-      (OrderedPairs, SpectrumLabels, SpectrumOrder));
+    Matches = lineMatches (OrderedPairs);
+    Results.push_back (engine ().branchingFractions (Matches, SpectrumLabels,
+      SpectrumOrder, ScalingFactors));
     
     // Obtain the target lines and XGremlin fit parameters
     NextLevelFits.clear ();
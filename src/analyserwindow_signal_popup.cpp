@@ -88,6 +88,7 @@ void AnalyserWindow::do_link_spectrum (GdkEventButton* event) {
         row[m_Columns.emax] = 0;
         row[m_Columns.name] = oss.str().c_str();
         row[m_Columns.bg_colour] = Gdk::Color (AW_LINK_COLOUR);
+        projectHasChanged (JournalRecord (JOURNAL_LINK, NewLink -> a, NewLink -> b));
         
       } else {
         LinkedSpectra.pop_back ();
@@ -184,6 +185,117 @@ void AnalyserWindow::on_popup_export_linelist ()
 }
         
       
+//------------------------------------------------------------------------------
+// on_popup_refit_linelist () : Called when the user right clicks a line list in
+// treeSpectra and selects "Refit Lines". Every line in the list is refitted.
+//
+void AnalyserWindow::on_popup_refit_linelist ()
+{
+  Glib::RefPtr<Gtk::TreeView::Selection> refSelection = treeSpectra.get_selection();
+  if(refSelection) {
+    Gtk::TreeModel::iterator iter = refSelection->get_selected();
+    if(iter) {
+      int Index = (*iter)[m_Columns.index];
+      int LineIndex = (*iter)[m_Columns.line_index];
+      vector < vector < vector <unsigned int> > > Targets (Index + 1);
+      Targets[Index].resize (LineIndex + 1);
+      unsigned int NumLines = ExptSpectra[Index].linesPtr2 () -> at (LineIndex).size ();
+      for (unsigned int i = 0; i < NumLines; i ++) {
+        Targets[Index][LineIndex].push_back (i);
+      }
+      queueRefit (Targets, Options.fit_blends ());
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_popup_refit_dirty_blends () : Called when the user right clicks a line list
+// in treeSpectra and selects "Refit Changed Blends". Only the blend clusters
+// whose lines have changed since they were last fitted together are refitted.
+//
+void AnalyserWindow::on_popup_refit_dirty_blends ()
+{
+  Glib::RefPtr<Gtk::TreeView::Selection> refSelection = treeSpectra.get_selection();
+  if(refSelection) {
+    Gtk::TreeModel::iterator iter = refSelection->get_selected();
+    if(iter) {
+      int Index = (*iter)[m_Columns.index];
+      int LineIndex = (*iter)[m_Columns.line_index];
+      LineClusters *Clusters = ExptSpectra[Index].clusters (LineIndex);
+      if (Clusters == NULL) return;
+      vector <unsigned int> Dirty = Clusters -> dirtyClusters ();
+      vector < vector < vector <unsigned int> > > Targets (Index + 1);
+      Targets[Index].resize (LineIndex + 1);
+      for (unsigned int i = 0; i < Dirty.size (); i ++) {
+        vector <unsigned int> Members = Clusters -> cluster (Dirty[i]);
+        Targets[Index][LineIndex].insert (Targets[Index][LineIndex].end (),
+          Members.begin (), Members.end ());
+      }
+      ostringstream oss;
+      oss << " in " << Dirty.size () << " changed blends";
+      queueRefit (Targets, true, oss.str ());
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_popup_refit_spectrum () : Called when the user right clicks a spectrum in
+// treeSpectra and selects "Refit All Lines". Every line in every list attached
+// to the spectrum is refitted.
+//
+void AnalyserWindow::on_popup_refit_spectrum ()
+{
+  Glib::RefPtr<Gtk::TreeView::Selection> refSelection = treeSpectra.get_selection();
+  if(refSelection) {
+    Gtk::TreeModel::iterator iter = refSelection->get_selected();
+    if(iter) {
+      int Index = (*iter)[m_Columns.index];
+      vector < vector <XgLine> > *Lines = ExptSpectra[Index].linesPtr2 ();
+      vector < vector < vector <unsigned int> > > Targets (Index + 1);
+      Targets[Index].resize (Lines -> size ());
+      for (unsigned int j = 0; j < Lines -> size (); j ++) {
+        for (unsigned int i = 0; i < Lines -> at (j).size (); i ++) {
+          Targets[Index][j].push_back (i);
+        }
+      }
+      queueRefit (Targets, Options.fit_blends ());
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_popup_refit_level () : Called when the user right clicks a Kurucz level in
+// treeLevels and selects "Refit Level Lines". Every experimental line matched
+// to a transition from the level is refitted, in all loaded spectra.
+//
+void AnalyserWindow::on_popup_refit_level ()
+{
+  Glib::RefPtr<Gtk::TreeView::Selection> refSelection = treeLevels.get_selection();
+  if(refSelection) {
+    Gtk::TreeModel::iterator iter = refSelection->get_selected();
+    if(iter) {
+      int Level = (*iter)[levelCols.index];
+      vector < vector < vector <unsigned int> > > Targets 
+        (LevelLines[Level].size ());
+      for (unsigned int s = 0; s < LevelLines[Level].size (); s ++) {
+        Targets[s].resize (ExptSpectra[s].linesPtr2 () -> size ());
+        for (unsigned int i = 0; i < LevelLines[Level][s].size (); i ++) {
+          LinePair *Pair = &LevelLines[Level][s][i];
+          if (Pair -> xgLineListIndex != -1) {
+            Targets[s][Pair -> xgLineListIndex].push_back 
+              (Pair -> xgLineLineIndex);
+          }
+        }
+      }
+      queueRefit (Targets, Options.fit_blends ());
+    }
+  }
+}
+
+
 //------------------------------------------------------------------------------
 // on_popup_remove_linelist () : Called when the user right clicks a line list
 // in treeSpectra and selects "Remove Line List". The selected line list is
@@ -196,8 +308,9 @@ void AnalyserWindow::on_popup_remove_linelist ()
     Gtk::TreeModel::iterator iter = refSelection->get_selected();
     if(iter) {
       int Index = (*iter)[m_Columns.index];
+      int LineIndex = (*iter)[m_Columns.line_index];
       clearDisplayedPlots ();
-      ExptSpectra[Index].remove_linelist ((*iter)[m_Columns.line_index]);
+      removeLineList (Index, LineIndex);
       Gtk::TreePath Path = treeSpectra.get_model()->get_path(iter);
       Path.up ();
 
@@ -215,7 +328,7 @@ void AnalyserWindow::on_popup_remove_linelist ()
       // Finally, erase the list's entry in treeSpectra and update anything that
       // would have referenced the deleted line list.
       m_refTreeModel->erase (iter);
-      projectHasChanged (true);
+      projectHasChanged (JournalRecord (JOURNAL_REMOVE_LIST, Index, LineIndex));
       getLinePairs ();
       updatePlottedData ();
       updateKuruczCompleteness ();
@@ -239,7 +352,7 @@ void AnalyserWindow::on_popup_remove_standard_lamp_spectrum ()
       int Index = (*iter)[m_Columns.index];
       ExptSpectra[Index].remove_standard_lamp_spectrum ();
       m_refTreeModel->erase (iter);
-      projectHasChanged (true);
+      projectHasChanged (JournalRecord (JOURNAL_REMOVE_STD_LAMP, Index));
       updateKuruczCompleteness();
       updatePlottedData();
     }
@@ -263,7 +376,7 @@ void AnalyserWindow::on_popup_remove_radiance ()
       int Index = (*iter)[m_Columns.index];
       ExptSpectra[Index].remove_radiance ();
       m_refTreeModel->erase (iter);
-      projectHasChanged (true);
+      projectHasChanged (JournalRecord (JOURNAL_REMOVE_RADIANCE, Index));
       updateKuruczCompleteness();
       updatePlottedData();
     }
@@ -297,7 +410,7 @@ void AnalyserWindow::on_popup_remove_level()
         levelTreeModel -> clear ();
         modelLevelsBF -> clear ();
       }
-      projectHasChanged (true);
+      projectHasChanged (JournalRecord (JOURNAL_REMOVE_LEVEL, Level));
     }
   }
 }
@@ -307,14 +420,14 @@ void AnalyserWindow::on_popup_remove_level()
 // on_popup_disable_line () : Called when the user right clicks on a line
 // profile in the line plot area and chooses to enable or disable the line.
 // The actual act of disabling the line is done by the on_popup_disable_line ()
-// event handler in linedata.cpp.
-
+// event handler in linedata.cpp. The line stays where it is in the plot area,
+// but the scaling factors and everything calculated from them must be redone.
 //
-void AnalyserWindow::on_popup_disable_line (bool Disable)
+void AnalyserWindow::on_popup_disable_line (bool Disable, LineData *Plot)
 {
-	updatePlottedData (true);
-	updateKuruczCompleteness ();
-	projectHasChanged (true);
+	updateKuruczCompleteness (Plot);
+	markDirty (AW_DIRTY_COMPARISON | AW_DIRTY_XGREMLIN | AW_DIRTY_BF);
+	lineHasChanged (Plot);
 }
 
 //------------------------------------------------------------------------------
@@ -323,11 +436,13 @@ void AnalyserWindow::on_popup_disable_line (bool Disable)
 // The actual act of hiding the line is done by the on_popup_hide_line () event
 // handler in linedata.cpp.
 //
-void AnalyserWindow::on_popup_hide_line ()
+void AnalyserWindow::on_popup_hide_line (LineData *Plot)
 {
-	updatePlottedData (true);
-	updateKuruczCompleteness ();
-	projectHasChanged (true);
+	updateKuruczCompleteness (Plot);
+	updateSharedScale (Plot);
+	applyScale ();
+	markDirty (AW_DIRTY_ALL);
+	lineHasChanged (Plot);
 }
 
 
@@ -364,8 +479,15 @@ void AnalyserWindow::on_popup_show_hidden_lines () {
 	    	// currently selected spectrum and show any hidden lines.
 	    	if (LevelLines[LevelIndex].size () > 0) {
 	    		for (unsigned int i = 0; i < LevelLines[LevelIndex][SpectrumIndex].size (); i ++) {
-	    			if (LevelLines[LevelIndex][SpectrumIndex][i].plot->hidden()) {
-	    				LevelLines[LevelIndex][SpectrumIndex][i].plot->hidden(false);
+	    			LinePair &Pair = LevelLines[LevelIndex][SpectrumIndex][i];
+	    			if (Pair.plot->hidden()) {
+	    				Pair.plot->hidden(false);
+	    				if (Pair.xgLineListIndex >= 0) {
+	    					lineHasChanged (Pair.plot, SpectrumIndex, 
+	    					  Pair.xgLineListIndex, Pair.xgLineLineIndex);
+	    				} else {
+	    					projectHasChanged (true);
+	    				}
 	    				FoundHiddenLines = true;
 	    			}
 	    		}
@@ -374,7 +496,6 @@ void AnalyserWindow::on_popup_show_hidden_lines () {
 	    	// If some hidden lines were found, the project has changed. Update
 	    	// the it to take account of the newly re-activated lines.
 	    	if (FoundHiddenLines) {
-	    		projectHasChanged (true);
 	    		updateKuruczCompleteness();
 	    		updatePlottedData();
 	    	}
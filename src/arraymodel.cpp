@@ -0,0 +1,191 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ArrayModel class (arraymodel.cpp)
+//==============================================================================
+#include "arraymodel.h"
+
+//------------------------------------------------------------------------------
+// Constructor : Takes the number and type of each column from Columns. The
+// model is empty until reset () is called.
+//
+ArrayModel::ArrayModel (const Gtk::TreeModelColumnRecord &Columns,
+  SlotSource SourceIn) : Glib::ObjectBase (typeid (ArrayModel)),
+  Glib::Object () {
+  const GType *ColumnTypes = Columns.types ();
+  for (unsigned int i = 0; i < Columns.size (); i ++) {
+    Types.push_back (ColumnTypes[i]);
+  }
+  Source = SourceIn;
+  Rows = 0;
+  Stamp = g_random_int ();
+}
+
+
+//------------------------------------------------------------------------------
+// create (const Gtk::TreeModelColumnRecord &, SlotSource) : Returns a new,
+// empty model.
+//
+Glib::RefPtr<ArrayModel> ArrayModel::create
+  (const Gtk::TreeModelColumnRecord &Columns, SlotSource Source) {
+  return Glib::RefPtr<ArrayModel> (new ArrayModel (Columns, Source));
+}
+
+
+//------------------------------------------------------------------------------
+// reset (unsigned int) : Called after the array behind the model has changed
+// to give the new number of rows. Every row that remains is marked as changed.
+//
+void ArrayModel::reset (unsigned int NewRows) {
+  reset (NewRows, vector <bool> (NewRows, true));
+}
+
+
+//------------------------------------------------------------------------------
+// reset (unsigned int, const vector <bool> &) : Called after the array behind
+// the model has changed to give the new number of rows. Rows beyond the end of
+// the array are deleted first, the rows that remain are marked as changed if
+// Changed is true for them, and any new rows are then inserted at the end. The
+// stamp is changed, so that any iterator made before the reset is invalid.
+//
+void ArrayModel::reset (unsigned int NewRows, const vector <bool> &Changed) {
+  iterator iter;
+  Stamp ++;
+  while (Rows > NewRows) {
+    Rows --;
+    row_deleted (Path (1, Rows));
+  }
+  for (unsigned int i = 0; i < Rows; i ++) {
+    if (i < Changed.size () && !Changed[i]) continue;
+    makeIter (i, iter);
+    row_changed (Path (1, i), iter);
+  }
+  while (Rows < NewRows) {
+    makeIter (Rows, iter);
+    Rows ++;
+    row_inserted (Path (1, Rows - 1), iter);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// makeIter (unsigned int, iterator &) : Points iter at row Row
+//
+void ArrayModel::makeIter (unsigned int Row, iterator &iter) const {
+  iter.set_stamp (Stamp);
+  iter.gobj () -> user_data = GUINT_TO_POINTER (Row);
+}
+
+
+//------------------------------------------------------------------------------
+// row (const iterator &) : Returns the row iter points at
+//
+unsigned int ArrayModel::row (const iterator &iter) {
+  return GPOINTER_TO_UINT (iter.gobj () -> user_data);
+}
+
+
+//------------------------------------------------------------------------------
+// The Gtk::TreeModel interface. Every row is at the top level of the model, so
+// no row has a parent or any children.
+//
+Gtk::TreeModelFlags ArrayModel::get_flags_vfunc () const {
+  return Gtk::TREE_MODEL_LIST_ONLY;
+}
+
+int ArrayModel::get_n_columns_vfunc () const {
+  return Types.size ();
+}
+
+GType ArrayModel::get_column_type_vfunc (int index) const {
+  if (index < 0 || index >= int (Types.size ())) return G_TYPE_INVALID;
+  return Types[index];
+}
+
+void ArrayModel::get_value_vfunc (const iterator &iter, int column,
+  Glib::ValueBase &value) const {
+  if (!iter_is_valid (iter) || column < 0 || column >= int (Types.size ())) {
+    return;
+  }
+  value.init (Types[column]);
+  Source (row (iter), column, value);
+}
+
+bool ArrayModel::iter_next_vfunc (const iterator &iter,
+  iterator &iter_next) const {
+  if (iter_is_valid (iter) && row (iter) + 1 < Rows) {
+    makeIter (row (iter) + 1, iter_next);
+    return true;
+  }
+  iter_next = iterator ();
+  return false;
+}
+
+bool ArrayModel::iter_children_vfunc (const iterator &parent,
+  iterator &iter) const {
+  iter = iterator ();
+  return false;
+}
+
+bool ArrayModel::iter_has_child_vfunc (const iterator &iter) const {
+  return false;
+}
+
+int ArrayModel::iter_n_children_vfunc (const iterator &iter) const {
+  return 0;
+}
+
+int ArrayModel::iter_n_root_children_vfunc () const {
+  return Rows;
+}
+
+bool ArrayModel::iter_nth_child_vfunc (const iterator &parent, int n,
+  iterator &iter) const {
+  iter = iterator ();
+  return false;
+}
+
+bool ArrayModel::iter_nth_root_child_vfunc (int n, iterator &iter) const {
+  if (n >= 0 && (unsigned int) n < Rows) {
+    makeIter (n, iter);
+    return true;
+  }
+  iter = iterator ();
+  return false;
+}
+
+bool ArrayModel::iter_parent_vfunc (const iterator &child,
+  iterator &iter) const {
+  iter = iterator ();
+  return false;
+}
+
+Gtk::TreeModel::Path ArrayModel::get_path_vfunc (const iterator &iter) const {
+  return Path (1, row (iter));
+}
+
+bool ArrayModel::get_iter_vfunc (const Path &path, iterator &iter) const {
+  if (path.size () == 1) {
+    return iter_nth_root_child_vfunc (path[0], iter);
+  }
+  iter = iterator ();
+  return false;
+}
+
+bool ArrayModel::iter_is_valid (const iterator &iter) const {
+  return iter.get_stamp () == Stamp && row (iter) < Rows;
+}
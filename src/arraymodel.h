@@ -0,0 +1,101 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ArrayModel class (arraymodel.h)
+//==============================================================================
+// A read-only, flat Gtk::TreeModel whose rows are the elements of an array
+// held elsewhere, such as a vector of KzLine or DataBF. The model stores no
+// values of its own. It only knows how many rows there are, and asks its
+// Source slot for the value of a cell whenever a TreeView draws it, so only
+// the visible cells are ever computed.
+//
+// After the array has been changed, reset () must be called with its new
+// size. This tells any TreeView the rows that have been added, removed or
+// changed, without copying a single value into the model. If the caller knows
+// which of the remaining rows have changed, it passes them to reset () so that
+// only those are redrawn. The Source slot must check that the row it is asked
+// for is still in the array, since the array is changed before the model is
+// told about any rows that have gone.
+//
+#ifndef FAST_ARRAY_MODEL_H
+#define FAST_ARRAY_MODEL_H
+
+#include <gtkmm/treemodel.h>
+#include <glibmm/object.h>
+#include <sigc++/sigc++.h>
+#include <vector>
+
+using namespace::std;
+
+class ArrayModel : public Glib::Object, public Gtk::TreeModel {
+
+  public:
+    // Sets Value to column Column of row Row. Value has already been
+    // initialised to the type of the column.
+    typedef sigc::slot <void, unsigned int, int, Glib::ValueBase &> SlotSource;
+
+    static Glib::RefPtr<ArrayModel> create
+      (const Gtk::TreeModelColumnRecord &Columns, SlotSource Source);
+    virtual ~ArrayModel () { /* Does nothing */ }
+
+    void reset (unsigned int NewRows);
+    void reset (unsigned int NewRows, const vector <bool> &Changed);
+    void clear () { reset (0); }
+    unsigned int size () { return Rows; }
+
+    // Copy Data into Value, converting it to the type of Column
+    template <class T, class U>
+    static void set (Glib::ValueBase &Value, const Gtk::TreeModelColumn<T> &Column,
+      const U &Data) {
+      Glib::Value<T> Typed;
+      Typed.init (Glib::Value<T>::value_type ());
+      Typed.set (T (Data));
+      g_value_copy (Typed.gobj (), Value.gobj ());
+    }
+
+  protected:
+    ArrayModel (const Gtk::TreeModelColumnRecord &Columns, SlotSource SourceIn);
+
+    virtual Gtk::TreeModelFlags get_flags_vfunc () const;
+    virtual int get_n_columns_vfunc () const;
+    virtual GType get_column_type_vfunc (int index) const;
+    virtual void get_value_vfunc (const iterator &iter, int column,
+      Glib::ValueBase &value) const;
+    virtual bool iter_next_vfunc (const iterator &iter, iterator &iter_next) const;
+    virtual bool iter_children_vfunc (const iterator &parent, iterator &iter) const;
+    virtual bool iter_has_child_vfunc (const iterator &iter) const;
+    virtual int iter_n_children_vfunc (const iterator &iter) const;
+    virtual int iter_n_root_children_vfunc () const;
+    virtual bool iter_nth_child_vfunc (const iterator &parent, int n,
+      iterator &iter) const;
+    virtual bool iter_nth_root_child_vfunc (int n, iterator &iter) const;
+    virtual bool iter_parent_vfunc (const iterator &child, iterator &iter) const;
+    virtual Path get_path_vfunc (const iterator &iter) const;
+    virtual bool get_iter_vfunc (const Path &path, iterator &iter) const;
+    virtual bool iter_is_valid (const iterator &iter) const;
+
+  private:
+    vector <GType> Types;       // The type of each column
+    SlotSource Source;
+    unsigned int Rows;
+    int Stamp;                  // Identifies the iterators made by this model
+
+    void makeIter (unsigned int Row, iterator &iter) const;
+    static unsigned int row (const iterator &iter);
+};
+
+#endif // FAST_ARRAY_MODEL_H
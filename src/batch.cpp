@@ -0,0 +1,467 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// BatchRun class (batch.cpp)
+//==============================================================================
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include "batch.h"
+#include "lineprofile.h"
+#include "projectjournal.h"
+#include "voigtfit.h"
+#include "CoreDefs.h"
+
+using namespace::std;
+
+//------------------------------------------------------------------------------
+// Constructor : By default, every line is profiled using one thread for each
+// processor, and the S/N correction saved in the project is used.
+//
+BatchRun::BatchRun () {
+  ProjectFilename = "";
+  Delimiter = ",";
+  NumThreads = VoigtRefitter::defaultThreads ();
+  CorrectSNR = -1;
+}
+
+
+//------------------------------------------------------------------------------
+// requested (int, char *) : Returns true if BATCH_ARG is on the command line.
+//
+bool BatchRun::requested (int argc, char *argv[]) {
+  for (int i = 1; i < argc; i ++) {
+    if (string (argv[i]) == BATCH_ARG) return true;
+  }
+  return false;
+}
+
+
+//------------------------------------------------------------------------------
+// parse (int, char *) : Reads the command line. The file following BATCH_ARG is
+// treated as a project if it starts with a valid FTS file version, and as a job
+// description otherwise. Options given on the command line take precedence
+// over those in the job description.
+//
+void BatchRun::parse (int argc, char *argv[]) throw (Error) {
+  string Argument, Input = "", Format = "", OutputFile = "";
+  int Threads = 0;
+  unsigned int Version = 0;
+
+  for (int i = 1; i < argc; i ++) {
+    Argument = argv[i];
+    if (Argument != BATCH_ARG && Argument != "-o" && Argument != "-f"
+      && Argument != "-t") {
+      throw (Error (FLT_SYNTAX_ERROR, "Unknown argument " + Argument));
+    }
+    if (i + 1 >= argc) {
+      throw (Error (FLT_SYNTAX_ERROR, "No value given for " + Argument));
+    }
+    i ++;
+    if (Argument == BATCH_ARG) Input = argv[i];
+    if (Argument == "-o") OutputFile = argv[i];
+    if (Argument == "-f") Format = argv[i];
+    if (Argument == "-t") {
+      Threads = atoi (argv[i]);
+      if (Threads < 1) {
+        throw (Error (FLT_SYNTAX_ERROR, "Invalid number of threads"));
+      }
+    }
+  }
+
+  // Identify the input file from its first few bytes. A text job description
+  // never begins with a valid file version.
+  ifstream In (Input.c_str (), ios::in|ios::binary);
+  if (!In.is_open ()) {
+    throw (Error (FLT_FILE_OPEN_ERROR, "Unable to open " + Input));
+  }
+  In.read ((char*)&Version, sizeof (unsigned int));
+  bool IsProject = In.good () && Version >= 1 && Version <= FTS_FILE_VERSION;
+  In.close ();
+  if (IsProject) {
+    ProjectFilename = Input;
+  } else {
+    readJob (Input);
+  }
+
+  if (Threads > 0) NumThreads = Threads;
+  if (OutputFile != "" || Format != "") {
+    BatchOutput NewOutput;
+    NewOutput.Type = Format == "" ? OUTPUT_CSV : outputType (Format);
+    NewOutput.Filename = OutputFile;
+    Outputs.clear ();
+    Outputs.push_back (NewOutput);
+  }
+  if (Outputs.size () == 0) {
+    BatchOutput NewOutput;
+    NewOutput.Type = OUTPUT_CSV;
+    NewOutput.Filename = "";
+    Outputs.push_back (NewOutput);
+  }
+
+  // Outputs without a file name are written alongside the project
+  for (unsigned int i = 0; i < Outputs.size (); i ++) {
+    if (Outputs[i].Filename == "") {
+      Outputs[i].Filename = ProjectFilename;
+      if (Outputs[i].Filename.size () > 4 && Outputs[i].Filename.substr
+        (Outputs[i].Filename.size () - 4, 4) == ".fts") {
+        Outputs[i].Filename.resize (Outputs[i].Filename.size () - 4);
+      }
+    }
+    Outputs[i].Filename = ResultTable::filename (Outputs[i].Filename,
+      Outputs[i].Type);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// readJob (string) : Reads the job description in Filename. A project given
+// with a relative path is assumed to be in the same directory as the job file.
+//
+void BatchRun::readJob (string Filename) throw (Error) {
+  ifstream JobFile (Filename.c_str (), ios::in);
+  string Line, Key, Value;
+  unsigned int LineNum = 0;
+  ostringstream oss;
+
+  if (!JobFile.is_open ()) {
+    throw (Error (FLT_FILE_OPEN_ERROR, "Unable to open " + Filename));
+  }
+  while (getline (JobFile, Line)) {
+    LineNum ++;
+    size_t Start = Line.find_first_not_of (" \t\r");
+    if (Start == string::npos || Line[Start] == IO_COMMENT) continue;
+    size_t Equals = Line.find ('=');
+    if (Equals == string::npos) {
+      oss << Filename << ", line " << LineNum << ": expected key = value";
+      throw (Error (FLT_SYNTAX_ERROR, oss.str ()));
+    }
+    Key = Line.substr (Start, Equals - Start);
+    Key = Key.substr (0, Key.find_last_not_of (" \t") + 1);
+    Value = Line.substr (Equals + 1);
+    size_t First = Value.find_first_not_of (" \t");
+    Value = First == string::npos ? "" :
+      Value.substr (First, Value.find_last_not_of (" \t\r") - First + 1);
+
+    if (Key == "project") {
+      ProjectFilename = Value;
+      size_t DirPos = Filename.find_last_of ("/\\");
+      if (Value.size () > 0 && Value[0] != '/' && DirPos != string::npos) {
+        ProjectFilename = Filename.substr (0, DirPos + 1) + Value;
+      }
+    } else if (Key == "output") {
+      BatchOutput NewOutput;
+      size_t Space = Value.find_first_of (" \t");
+      NewOutput.Type = outputType (Value.substr (0, Space));
+      NewOutput.Filename = Space == string::npos ? "" :
+        Value.substr (Value.find_first_not_of (" \t", Space));
+      Outputs.push_back (NewOutput);
+    } else if (Key == "fields") {
+      istringstream Fields (Value);
+      string Field;
+      while (getline (Fields, Field, ',')) {
+        First = Field.find_first_not_of (" \t");
+        if (First == string::npos) continue;
+        FieldNames.push_back (Field.substr (First,
+          Field.find_last_not_of (" \t") - First + 1));
+      }
+    } else if (Key == "delimiter") {
+      if (Value == "tab") Delimiter = "\t";
+      else if (Value == "space") Delimiter = " ";
+      else Delimiter = Value;
+    } else if (Key == "threads") {
+      NumThreads = atoi (Value.c_str ()) > 0 ? atoi (Value.c_str ()) : 1;
+    } else if (Key == "correct_snr") {
+      CorrectSNR = (Value == "yes" || Value == "true" || Value == "1") ? 1 : 0;
+    } else {
+      oss << Filename << ", line " << LineNum << ": unknown key " << Key;
+      throw (Error (FLT_SYNTAX_ERROR, oss.str ()));
+    }
+  }
+  JobFile.close ();
+  if (ProjectFilename == "") {
+    throw (Error (FLT_SYNTAX_ERROR, Filename + " does not name a project"));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// outputType (string) : Returns the output file type called Name.
+//
+int BatchRun::outputType (string Name) throw (Error) {
+  if (Name == "csv" || Name == "text") return OUTPUT_CSV;
+  if (Name == "latex") return OUTPUT_LATEX;
+  if (Name == "aastex") return OUTPUT_AASTEX;
+  throw (Error (FLT_SYNTAX_ERROR, "Unknown output format " + Name,
+    "The format must be csv, latex or aastex"));
+}
+
+
+//------------------------------------------------------------------------------
+// stageDone (string) : Records the time taken by the stage that has just
+// finished, and restarts the timer for the next one.
+//
+void BatchRun::stageDone (string Name) {
+  StageNames.push_back (Name);
+  StageTimes.push_back (Timer.elapsed ());
+  Timer.reset ();
+}
+
+
+//------------------------------------------------------------------------------
+// run () : Performs the analysis, writes every output file, and prints the
+// time taken by each stage.
+//
+void BatchRun::run () throw (Error) {
+  vector < vector <BfResult> > Results;
+  vector < vector <XgLine> > Fits;
+  vector < vector <KzLine> > Fitted;
+  vector <JournalRecord> Edits;
+  double Total = 0.0;
+  char Buffer[128];
+
+  Timer.start ();
+  cout << "Loading " << ProjectFilename << "..." << endl;
+  loadProject ();
+  stageDone ("Load project");
+  if (ProjectJournal::read (ProjectFilename, Edits) && Edits.size () > 0) {
+    cout << "Warning: " << Edits.size () << " unsaved edits in the project's "
+      << "journal will be ignored. Open and save the project to keep them."
+      << endl;
+  }
+
+  profileLines ();
+  stageDone ("Profile lines");
+  matchLines ();
+  applyLineStates ();
+  stageDone ("Match lines");
+  calculate (Results, Fits, Fitted);
+  stageDone ("Transfer ratios and branching fractions");
+  writeOutputs (Results, Fits, Fitted);
+  stageDone ("Write output");
+
+  for (unsigned int i = 0; i < StageNames.size (); i ++) {
+    sprintf (Buffer, "  %-40s %10.3f s", StageNames[i].c_str (), StageTimes[i]);
+    cout << Buffer << endl;
+    Total += StageTimes[i];
+  }
+  sprintf (Buffer, "  %-40s %10.3f s", "Total", Total);
+  cout << Buffer << endl;
+}
+
+
+//------------------------------------------------------------------------------
+// loadProject () : Reads the project and installs its target list and spectra.
+//
+void BatchRun::loadProject () throw (Error) {
+  try {
+    ProjectFile::read (ProjectFilename, Project);
+  } catch (Error Err) {
+    if (Err.message == "") Err.message = "Unable to open " + ProjectFilename;
+    throw (Err);
+  }
+
+  if (Project.KuruczLines.size () > 0) {
+    Targets.push_back (Project.KuruczLines);
+    Targets.name (Project.KuruczName);
+    Targets.levelPrecision (Project.KuruczPrecision);
+  }
+  Spectra = Project.Spectra;
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    for (unsigned int j = 0; j < Project.SpectrumLines[i].size (); j ++) {
+      Spectra[i].lines_push_back (Project.SpectrumLines[i][j]);
+      if (i < Project.SpectrumProfiles.size ()
+        && j < Project.SpectrumProfiles[i].size ()) {
+        *Spectra[i].profiles (j) = Project.SpectrumProfiles[i][j];
+      }
+    }
+  }
+  Project.SpectrumLines.clear ();
+  Project.SpectrumProfiles.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// profileLines () : Profiles every line, which sets the noise levels used for
+// the S/N ratios. Profiles saved in the project are not recalculated.
+//
+void BatchRun::profileLines () throw (Error) {
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    Spectra[i].loadData ();
+    vector < vector <XgLine> > *Lines = Spectra[i].linesPtr2 ();
+    for (unsigned int j = 0; j < Lines -> size (); j ++) {
+      LineProfiler Profiler;
+      Profiler.compute (&Spectra[i], Lines -> at (j), NumThreads,
+        Spectra[i].profiles (j));
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// matchLines () : Matches the target lines of every upper level with the lines
+// of each spectrum. Every line starts off unselected and enabled.
+//
+void BatchRun::matchLines () {
+  BfEngine Engine (Spectra, Project.Links, Targets.levelPrecision (),
+    CorrectSNR == 1);
+  Levels.clear ();
+  for (unsigned int i = 0; i < Targets.numUpperLevels (); i ++) {
+    Levels.push_back (Engine.match (Targets.upperLevelLines (i)));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// applyLineStates () : Restores the line states saved at the end of the project
+// file, in the same order as AnalyserWindow::loadInterface (). Hidden lines
+// are neither selected nor used in the transfer ratios. The S/N correction is
+// also read from here unless it was given in the job description.
+//
+void BatchRun::applyLineStates () {
+  istringstream InterfaceIn (string (Project.Interface.begin (),
+    Project.Interface.end ()));
+  bool Selected, Disabled, Hidden, CorrectSignalToNoise;
+
+  for (unsigned int Level = 0; Level < Levels.size (); Level ++) {
+    for (unsigned int i = 0; i < Levels[Level].size (); i ++) {
+      for (unsigned int j = 0; j < Levels[Level][i].size (); j ++) {
+        LineMatch &Match = Levels[Level][i][j];
+        if (Match.xgLine == NULL || Match.xgLine -> wavenumber () <= 0.0) {
+          continue;
+        }
+        Disabled = Hidden = false;
+        InterfaceIn.read ((char*)&Selected, sizeof(bool));
+        if (Project.FileVersion > FTS_FILE_VERSION_UP_TO_0_6_5) {
+          InterfaceIn.read ((char*)&Disabled, sizeof(bool));
+          InterfaceIn.read ((char*)&Hidden, sizeof(bool));
+        }
+        if (!InterfaceIn.good ()) {
+          cout << "Warning: the project does not hold the state of every "
+            << "line. The remaining lines are unselected." << endl;
+          return;
+        }
+        Match.Selected = Selected && !Hidden;
+        Match.Disabled = Disabled || Hidden;
+      }
+    }
+  }
+  if (Project.FileVersion > 1) {
+    InterfaceIn.read ((char*)&CorrectSignalToNoise, sizeof(bool));
+    if (InterfaceIn.good () && CorrectSNR == -1) {
+      CorrectSNR = CorrectSignalToNoise ? 1 : 0;
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// calculate (...) : Calculates the transfer ratios and branching fractions of
+// every level, with the reference spectrum first, then collects the fitted
+// and target lines used, as in AnalyserWindow::on_data_output_results ().
+//
+void BatchRun::calculate (vector < vector <BfResult> > &Results,
+  vector < vector <XgLine> > &Fits, vector < vector <KzLine> > &Fitted) {
+  BfEngine Engine (Spectra, Project.Links, Targets.levelPrecision (),
+    CorrectSNR == 1);
+  vector < vector <LineMatch> > Ordered;
+  vector <string> SpectrumLabels;
+  vector <unsigned int> SpectrumOrder;
+  vector <RatioAndError> ScalingFactors;
+  vector <XgLine> NextLevelFits;
+  vector <KzLine> NextLevelTargets;
+  unsigned int RefIndex = 0;
+
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    if (Spectra[i].isReference ()) {
+      RefIndex = i;
+      break;
+    }
+  }
+  if (Spectra.size () > 0) {
+    SpectrumOrder.push_back (RefIndex);
+    SpectrumLabels.push_back (Spectra[RefIndex].index ());
+  }
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    if (i != RefIndex) {
+      SpectrumOrder.push_back (i);
+      SpectrumLabels.push_back (Spectra[i].index ());
+    }
+  }
+
+  for (unsigned int Level = 0; Level < Levels.size (); Level ++) {
+    Ordered.clear ();
+    for (unsigned int i = 0; i < SpectrumOrder.size (); i ++) {
+      Ordered.push_back (Levels[Level][SpectrumOrder[i]]);
+    }
+    ScalingFactors = Engine.transferRatios (Ordered, SpectrumOrder);
+    Results.push_back (Engine.branchingFractions (Ordered, SpectrumLabels,
+      SpectrumOrder, ScalingFactors));
+
+    NextLevelFits.clear ();
+    NextLevelTargets.clear ();
+    for (unsigned int i = 0; Ordered.size () > 0 && i < Ordered[0].size (); i ++) {
+      for (unsigned int j = 0; j < Ordered.size (); j ++) {
+        if (Ordered[j][i].xgLine != NULL
+          && Ordered[j][i].xgLine -> wavenumber () > 0.0
+          && Ordered[j][i].Selected) {
+          NextLevelFits.push_back (*Ordered[j][i].xgLine);
+          NextLevelTargets.push_back (*Ordered[j][i].kzLine);
+        }
+      }
+    }
+    Fits.push_back (NextLevelFits);
+    Fitted.push_back (NextLevelTargets);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// writeOutputs (...) : Writes the chosen fields to every output file. If no
+// fields were chosen, all the branching fraction fields are written.
+//
+void BatchRun::writeOutputs (vector < vector <BfResult> > &Results,
+  vector < vector <XgLine> > &Fits, vector < vector <KzLine> > &Fitted)
+  throw (Error) {
+  vector <OutputField> AllFields = ResultTable::fields (Results, Fits, Fitted);
+  vector <OutputField *> Selected;
+
+  if (FieldNames.size () == 0) {
+    for (unsigned int i = 0; i < AllFields.size (); i ++) {
+      if (AllFields[i].ResultIndex < NUM_BF_OUTPUT_FIELDS) {
+        Selected.push_back (&AllFields[i]);
+      }
+    }
+  }
+  for (unsigned int n = 0; n < FieldNames.size (); n ++) {
+    unsigned int i = 0;
+    while (i < AllFields.size () && AllFields[i].Name != FieldNames[n]) i ++;
+    if (i == AllFields.size ()) {
+      throw (Error (FLT_SYNTAX_ERROR, "Unknown output field " + FieldNames[n],
+        "The fields are named as in the Output Results window"));
+    }
+    Selected.push_back (&AllFields[i]);
+  }
+
+  for (unsigned int i = 0; i < Outputs.size (); i ++) {
+    ResultTable::write (Outputs[i].Filename, Outputs[i].Type, Selected,
+      Delimiter);
+    cout << "Wrote " << Outputs[i].Filename << endl;
+  }
+}
@@ -0,0 +1,112 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// BatchRun class (batch.h)
+//==============================================================================
+// Runs a complete branching fraction analysis from the command line, without
+// starting the user interface:
+//
+//   fast --batch <project | job file> [-o <output file>] [-f <format>]
+//        [-t <threads>]
+//
+// The input is either a saved FAST project or a text job description made up
+// of "key = value" lines. Lines starting with IO_COMMENT are ignored. The keys
+// are:
+//
+//   project     = <FAST project file>     (relative to the job file)
+//   output      = <csv|latex|aastex> <file>  (may be given more than once)
+//   fields      = <field name>, <field name>, ...
+//   delimiter   = <delimiter | tab | space>
+//   threads     = <number of threads used to profile the lines>
+//   correct_snr = <yes | no>
+//
+// The fields are named as in the Output Results window. By default, every
+// branching fraction field is written to <project>.csv. Each line keeps the
+// selected, disabled and hidden states saved in the project. Edits that are
+// still in the project's journal are NOT applied, since they are only folded
+// into the project when it is saved from the user interface.
+//
+// The time taken by each stage of the analysis is printed on completion.
+//
+#ifndef BATCH_RUN_H
+#define BATCH_RUN_H
+
+#include <vector>
+#include <string>
+#include <glibmm/timer.h>
+#include "ErrDefs.h"
+#include "kzlist.h"
+#include "xgspectrum.h"
+#include "projectfile.h"
+#include "bfengine.h"
+#include "resulttable.h"
+
+using namespace::std;
+
+#define BATCH_ARG "--batch"
+
+typedef struct batch_output {
+  int Type;               // OUTPUT_CSV, OUTPUT_LATEX or OUTPUT_AASTEX
+  string Filename;
+} BatchOutput;
+
+class BatchRun {
+
+  private:
+    string ProjectFilename;
+    vector <BatchOutput> Outputs;
+    vector <string> FieldNames;
+    string Delimiter;
+    unsigned int NumThreads;
+    int CorrectSNR;         // -1 to use the setting saved in the project
+
+    ProjectData Project;
+    vector <XgSpectrum> Spectra;
+    KzList Targets;
+    vector < vector < vector <LineMatch> > > Levels;
+
+    Glib::Timer Timer;
+    vector <string> StageNames;
+    vector <double> StageTimes;
+
+    void readJob (string Filename) throw (Error);
+    static int outputType (string Name) throw (Error);
+    void stageDone (string Name);
+
+    void loadProject () throw (Error);
+    void profileLines () throw (Error);
+    void matchLines ();
+    void applyLineStates ();
+    void calculate (vector < vector <BfResult> > &Results,
+      vector < vector <XgLine> > &Fits, vector < vector <KzLine> > &Fitted);
+    void writeOutputs (vector < vector <BfResult> > &Results,
+      vector < vector <XgLine> > &Fits, vector < vector <KzLine> > &Fitted)
+      throw (Error);
+
+  public:
+    BatchRun ();
+    ~BatchRun () { /* Does nothing */ }
+
+    // Returns true if the command line asks for a batch run
+    static bool requested (int argc, char *argv[]);
+
+    // Reads the command line, then runs the analysis it describes
+    void parse (int argc, char *argv[]) throw (Error);
+    void run () throw (Error);
+};
+
+#endif // BATCH_RUN_H
@@ -0,0 +1,544 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// Benchmark class (benchmark.cpp)
+//==============================================================================
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include "benchmark.h"
+#include "lineio.h"
+#include "modelspectrum.h"
+#include "lineprofile.h"
+#include "projectfile.h"
+#include "voigtfit.h"
+#include "CoreDefs.h"
+
+using namespace::std;
+
+//------------------------------------------------------------------------------
+// fileSize (string) : Returns the size of the file Filename in bytes.
+//
+static unsigned long fileSize (string Filename) {
+  ifstream In (Filename.c_str (), ios::in|ios::binary);
+  In.seekg (0, ios::end);
+  return In.good () ? (unsigned long)In.tellg () : 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Constructor : The synthetic files are written to, and read from, DirectoryIn.
+//
+Benchmark::Benchmark (BenchScale ScaleIn, string DirectoryIn) {
+  Scale = ScaleIn;
+  Directory = DirectoryIn;
+  Random = Scale.Seed;
+}
+
+
+//------------------------------------------------------------------------------
+// defaultScale () : Returns the scale used when none is given.
+//
+BenchScale Benchmark::defaultScale () {
+  BenchScale Default;
+  Default.Points = BENCH_DEF_POINTS;
+  Default.Lines = BENCH_DEF_LINES;
+  Default.Targets = BENCH_DEF_TARGETS;
+  Default.Branches = BENCH_DEF_BRANCHES;
+  Default.Spectra = BENCH_DEF_SPECTRA;
+  Default.Threads = VoigtRefitter::defaultThreads ();
+  Default.Seed = BENCH_DEF_SEED;
+  return Default;
+}
+
+
+//------------------------------------------------------------------------------
+// uniform () : Returns a random number in [0, 1). A 64-bit linear congruential
+// generator is used rather than rand (), so that the synthetic data is the same
+// on every platform.
+//
+double Benchmark::uniform () {
+  Random = Random * 6364136223846793005ULL + 1442695040888963407ULL;
+  return double (Random >> 11) / 9007199254740992.0;
+}
+
+
+//------------------------------------------------------------------------------
+// gaussian () : Returns a normally distributed random number with a mean of 0
+// and a standard deviation of 1, using the Box-Muller transform.
+//
+double Benchmark::gaussian () {
+  double u = 1.0 - uniform ();
+  return sqrt (-2.0 * log (u)) * cos (2.0 * M_PI * uniform ());
+}
+
+
+//------------------------------------------------------------------------------
+// path (string), spectrumPath (unsigned int, string) : Return the path of a
+// file in the benchmark directory. Spectra are numbered from 1.
+//
+string Benchmark::path (string Name) {
+  return Directory + "/" + Name;
+}
+
+string Benchmark::spectrumPath (unsigned int Index, string Extension) {
+  ostringstream oss;
+  oss << BENCH_SPECTRUM_NAME << Index + 1 << Extension;
+  return path (oss.str ());
+}
+
+
+//------------------------------------------------------------------------------
+// stageDone (string, unsigned long, string) : Records the time taken by the
+// stage that has just finished, and restarts the timer for the next one.
+//
+void Benchmark::stageDone (string Name, unsigned long Items, string Units) {
+  BenchStage Stage;
+  char Buffer[128];
+
+  Stage.Name = Name;
+  Stage.Seconds = Timer.elapsed ();
+  Stage.Items = Items;
+  Stage.Units = Units;
+  Stages.push_back (Stage);
+  sprintf (Buffer, "  %-20s %10.3f s", Name.c_str (), Stage.Seconds);
+  cerr << Buffer << endl;
+  Timer.reset ();
+}
+
+
+//==============================================================================
+// SYNTHETIC DATA GENERATOR
+//==============================================================================
+//------------------------------------------------------------------------------
+// generate () : Writes every synthetic file to the benchmark directory.
+//
+void Benchmark::generate () throw (Error) {
+  double Range = (Scale.Points - 1.0) * BENCH_POINT_SPACING;
+  vector <double> SpectrumPeaks (Scale.Lines);
+
+  if (Scale.Points < 2 || Scale.Lines == 0 || Scale.Spectra == 0
+    || Scale.Branches == 0) {
+    throw (Error (FLT_SYNTAX_ERROR, "The benchmark scale must not be zero"));
+  }
+  if (Range <= 2.0 * BENCH_EDGE) {
+    throw (Error (FLT_SYNTAX_ERROR, "Too few points for the benchmark spectra"));
+  }
+  if (Scale.Targets > Scale.Lines) {
+    throw (Error (FLT_SYNTAX_ERROR,
+      "There cannot be more target lines than lines in each spectrum"));
+  }
+
+  Random = Scale.Seed;
+  generateLines ();
+  for (unsigned int i = 0; i < Scale.Spectra; i ++) {
+    for (unsigned int k = 0; k < Scale.Lines; k ++) {
+      SpectrumPeaks[k] = Peaks[k] * (1.0 + 0.25 * i)
+        * (0.95 + 0.1 * uniform ());
+    }
+    writeSpectrum (i, SpectrumPeaks);
+    writeLineList (i, SpectrumPeaks);
+  }
+  writeTargets ();
+}
+
+
+//------------------------------------------------------------------------------
+// generateLines () : Spreads the lines evenly along the spectrum, with some
+// jitter, and chooses their widths and reference peaks.
+//
+void Benchmark::generateLines () {
+  double Range = (Scale.Points - 1.0) * BENCH_POINT_SPACING - 2.0 * BENCH_EDGE;
+  double Spacing = Range / Scale.Lines;
+
+  Centres.resize (Scale.Lines);
+  Widths.resize (Scale.Lines);
+  Peaks.resize (Scale.Lines);
+  for (unsigned int k = 0; k < Scale.Lines; k ++) {
+    Centres[k] = BENCH_MIN_WAVENUMBER + BENCH_EDGE
+      + (k + 0.5 + 0.5 * (uniform () - 0.5)) * Spacing;
+    Widths[k] = BENCH_MIN_WIDTH + (BENCH_MAX_WIDTH - BENCH_MIN_WIDTH) * uniform ();
+    Peaks[k] = 10.0 * pow (10.0, 2.0 * uniform ());
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// writeSpectrum (unsigned int, vector <double> &) : Writes spectrum Index as an
+// XGremlin DAT/HDR pair. Each line is a Gaussian (a Voigt profile without
+// damping) of the given peak, added to normally distributed noise. The first
+// spectrum is also written as an ASCII file.
+//
+void Benchmark::writeSpectrum (unsigned int Index, vector <double> &SpectrumPeaks)
+  throw (Error) {
+  vector <float> Y (Scale.Points);
+  string DatFile = spectrumPath (Index, ".dat");
+  string HdrFile = spectrumPath (Index, ".hdr");
+  FILE *Out;
+
+  for (unsigned int j = 0; j < Scale.Points; j ++) {
+    Y[j] = BENCH_NOISE * gaussian ();
+  }
+  for (unsigned int k = 0; k < Scale.Lines; k ++) {
+    double Width = Widths[k] / 1000.0;
+    int Start = int ((Centres[k] - 4.0 * Width - BENCH_MIN_WAVENUMBER)
+      / BENCH_POINT_SPACING);
+    int End = int ((Centres[k] + 4.0 * Width - BENCH_MIN_WAVENUMBER)
+      / BENCH_POINT_SPACING) + 1;
+    if (Start < 0) Start = 0;
+    if (End > int (Scale.Points)) End = Scale.Points;
+    for (int j = Start; j < End; j ++) {
+      double d = (BENCH_MIN_WAVENUMBER + j * BENCH_POINT_SPACING - Centres[k])
+        / Width;
+      Y[j] += SpectrumPeaks[k] * exp (-4.0 * M_LN2 * d * d);
+    }
+  }
+
+  Out = fopen (DatFile.c_str (), "wb");
+  if (Out == NULL) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error opening " + DatFile,
+      "Check that the benchmark directory exists and can be written to."));
+  }
+  size_t Written = fwrite (&Y[0], sizeof (float), Y.size (), Out);
+  if (fclose (Out) != 0 || Written != Y.size ()) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error writing " + DatFile));
+  }
+
+  // Only the fields read by XgSpectrum are written to the header. The value of
+  // each starts in the tenth column, as in a real XGremlin HDR file.
+  Out = fopen (HdrFile.c_str (), "w");
+  if (Out == NULL) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error opening " + HdrFile));
+  }
+  fprintf (Out, "%-8s= %22s / %s\n", "id", "'FAST benchmark'", "Spectrum");
+  fprintf (Out, "%-8s= %22u / %s\n", NUM_PTS_TAG, Scale.Points,
+    "Number of points");
+  fprintf (Out, "%-8s= %22.15E / %s\n", XMIN_TAG, BENCH_MIN_WAVENUMBER,
+    "Wavenumber of the first point");
+  fprintf (Out, "%-8s= %22.15E / %s\n", DELTAX_TAG, BENCH_POINT_SPACING,
+    "Point spacing");
+  fprintf (Out, "end\n");
+  if (fclose (Out) != 0) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error writing " + HdrFile));
+  }
+
+  if (Index == 0) {
+    string AscFile = spectrumPath (Index, ".asc");
+    Out = fopen (AscFile.c_str (), "w");
+    if (Out == NULL) {
+      throw (Error (FLT_FILE_WRITE_ERROR, "Error opening " + AscFile));
+    }
+    fprintf (Out, "%c FAST benchmark spectrum\n", XGREMLIN_COMMENT);
+    for (unsigned int j = 0; j < Scale.Points; j ++) {
+      fprintf (Out, "%14.5f %14.6E\n", BENCH_MIN_WAVENUMBER
+        + j * BENCH_POINT_SPACING, Y[j]);
+    }
+    if (fclose (Out) != 0) {
+      throw (Error (FLT_FILE_WRITE_ERROR, "Error writing " + AscFile));
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// writeLineList (unsigned int, vector <double> &) : Writes the lines of
+// spectrum Index to an XGremlin LIN file. Each wavenumber is moved slightly, as
+// it would be by a real fit.
+//
+void Benchmark::writeLineList (unsigned int Index, vector <double> &SpectrumPeaks)
+  throw (Error) {
+  vector <XgLine> Lines (Scale.Lines);
+  vector <char> Header (LIN_HEADER_SIZE, 0);
+  int NumLines = Scale.Lines;
+  float ListScale = 1.0, SigCorrection = 0.0;
+
+  for (unsigned int k = 0; k < Scale.Lines; k ++) {
+    Lines[k].line (k + 1);
+    Lines[k].wavenumber (Centres[k] + 0.0005 * gaussian ());
+    Lines[k].peak (SpectrumPeaks[k]);
+    Lines[k].width (Widths[k]);
+    Lines[k].dmp (0.0);
+    Lines[k].tags ("    ");
+    Lines[k].epstot (BENCH_NOISE / SpectrumPeaks[k]);
+    Lines[k].epsevn (0.0);
+    Lines[k].epsodd (0.0);
+    Lines[k].epsran (0.0);
+    Lines[k].id ("");
+  }
+
+  // The number of lines, scale and wavenumber correction are the only parts of
+  // the LIN header read by readLinFile ().
+  memcpy (&Header[0], &NumLines, sizeof (int));
+  memcpy (&Header[2 * sizeof (int) + sizeof (float)], &ListScale,
+    sizeof (float));
+  memcpy (&Header[2 * sizeof (int) + 2 * sizeof (float)], &SigCorrection,
+    sizeof (float));
+  writeLinFile (spectrumPath (Index, ".lin"), Header, Lines);
+}
+
+
+//------------------------------------------------------------------------------
+// writeTargets () : Writes a Kurucz list of Scale.Targets lines, taken evenly
+// from the lines of the spectra, grouped into levels of Scale.Branches lines.
+// The upper levels lie above the spectrum and are separated by much more than
+// the level precision.
+//
+void Benchmark::writeTargets () throw (Error) {
+  string Filename = path (BENCH_TARGETS_FILE);
+  ofstream Out (Filename.c_str ());
+  double MaxX = BENCH_MIN_WAVENUMBER + (Scale.Points - 1.0) * BENCH_POINT_SPACING;
+  unsigned int Step = Scale.Targets > 0 ? Scale.Lines / Scale.Targets : 1;
+  KzLine Target;
+
+  if (!Out.is_open ()) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error opening " + Filename));
+  }
+  Target.code (26.00);
+  Target.configLower ("3d6 4s2 a5");
+  Target.configUpper ("3d6 4s4p z");
+  for (unsigned int t = 0; t < Scale.Targets; t ++) {
+    unsigned int k = t * Step;
+    unsigned int Level = t / Scale.Branches;
+    double EUpper = MaxX + 1000.0 + Level;
+    if (t > 0 && t % Scale.Branches == 0) Out << '\n';
+    Target.lambda (1.0e7 / Centres[k]);
+    Target.loggf (-3.0 * uniform ());
+    Target.eUpper (EUpper);
+    Target.jUpper (2.5);
+    Target.eLower (EUpper - Centres[k]);
+    Target.jLower (1.5 + t % 3);
+    Out << Target.lineString () << '\n';
+  }
+  Out.close ();
+  if (Out.fail ()) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error writing " + Filename));
+  }
+}
+
+
+//==============================================================================
+// BENCHMARK STAGES
+//==============================================================================
+//------------------------------------------------------------------------------
+// run () : Times every stage of the analysis of the generated files.
+//
+void Benchmark::run () throw (Error) {
+  Stages.clear ();
+  Spectra.clear ();
+  Targets.clear ();
+  Links.clear ();
+  Levels.clear ();
+
+  Timer.start ();
+  loadSpectra ();
+  loadLineLists ();
+  loadTargets ();
+  profileLines ();
+  calculate ();
+  saveAndLoad ();
+  Timer.stop ();
+}
+
+
+//------------------------------------------------------------------------------
+// loadSpectra () : Loads every spectrum from its DAT/HDR pair, then loads the
+// ASCII copy of the first one on its own. The first spectrum is the reference.
+//
+void Benchmark::loadSpectra () throw (Error) {
+  XgSpectrum Ascii;
+  ostringstream oss;
+
+  Spectra.resize (Scale.Spectra);
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    oss.str ("");
+    oss << i + 1;
+    Spectra[i].loadDat (spectrumPath (i, ".dat"));
+    Spectra[i].name (BENCH_SPECTRUM_NAME + oss.str ());
+    Spectra[i].index (oss.str ());
+    Spectra[i].isReference (i == 0);
+  }
+  stageDone ("load_dat", (unsigned long)Scale.Points * Scale.Spectra, "points");
+
+  Ascii.loadAscii (spectrumPath (0, ".asc"));
+  stageDone ("load_ascii", Ascii.numDataPoints (), "points");
+}
+
+
+//------------------------------------------------------------------------------
+// loadLineLists () : Reads the LIN file of every spectrum.
+//
+void Benchmark::loadLineLists () throw (Error) {
+  unsigned long Total = 0;
+
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    vector <XgLine> Lines = readLinFile (spectrumPath (i, ".lin"));
+    Spectra[i].lines_push_back (Lines);
+    Spectra[i].lin_headers_push_back (readLinFileHeader (spectrumPath (i,
+      ".lin")));
+    Total += Lines.size ();
+  }
+  stageDone ("parse_lin", Total, "lines");
+}
+
+
+//------------------------------------------------------------------------------
+// loadTargets () : Reads the Kurucz list, then groups its lines by upper level
+// a second time on their own.
+//
+void Benchmark::loadTargets () throw (Error) {
+  Targets.read (path (BENCH_TARGETS_FILE));
+  stageDone ("parse_kurucz", Targets.size (), "lines");
+
+  vector <KzLine> Lines = Targets.lines ();
+  Timer.reset ();
+  KzList Grouped (Lines);
+  stageDone ("set_upper_levels", Grouped.size (), "lines");
+}
+
+
+//------------------------------------------------------------------------------
+// profileLines () : Renders the Voigt model of every line list, then profiles
+// every line, which also sets the noise levels used for the S/N ratios.
+//
+void Benchmark::profileLines () throw (Error) {
+  unsigned long Total = 0;
+
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    vector < vector <XgLine> > *Lines = Spectra[i].linesPtr2 ();
+    for (unsigned int j = 0; j < Lines -> size (); j ++) {
+      ModelSpectrum Model (Spectra[i].dataPtr () -> at (0).x,
+        Spectra[i].get_point_spacing (), Spectra[i].numDataPoints ());
+      Model.render (Lines -> at (j));
+      Total += Lines -> at (j).size ();
+    }
+  }
+  stageDone ("voigt_model", Total, "lines");
+
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    vector < vector <XgLine> > *Lines = Spectra[i].linesPtr2 ();
+    for (unsigned int j = 0; j < Lines -> size (); j ++) {
+      LineProfiler Profiler;
+      Profiler.compute (&Spectra[i], Lines -> at (j), Scale.Threads);
+    }
+  }
+  stageDone ("line_profiles", Total, "lines");
+}
+
+
+//------------------------------------------------------------------------------
+// calculate () : Matches the target lines of every level with each spectrum,
+// selects every line that was found, and then calculates the transfer ratios
+// and branching fractions of each level in turn. The spectra are already in
+// the spectrum order, as the first is the reference.
+//
+void Benchmark::calculate () {
+  BfEngine Engine (Spectra, Links, Targets.levelPrecision (), true);
+  vector < vector <RatioAndError> > Factors;
+  vector <unsigned int> Order;
+  vector <string> Labels;
+
+  for (unsigned int i = 0; i < Targets.numUpperLevels (); i ++) {
+    Levels.push_back (Engine.match (Targets.upperLevelLines (i)));
+  }
+  stageDone ("match_lines", Levels.size (), "levels");
+
+  for (unsigned int Level = 0; Level < Levels.size (); Level ++) {
+    for (unsigned int i = 0; i < Levels[Level].size (); i ++) {
+      for (unsigned int j = 0; j < Levels[Level][i].size (); j ++) {
+        LineMatch &Match = Levels[Level][i][j];
+        Match.Selected = Match.xgLine != NULL
+          && Match.xgLine -> wavenumber () > 0.0;
+      }
+    }
+  }
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    Order.push_back (i);
+    Labels.push_back (Spectra[i].index ());
+  }
+  Timer.reset ();
+
+  Factors.resize (Levels.size ());
+  for (unsigned int Level = 0; Level < Levels.size (); Level ++) {
+    Factors[Level] = Engine.transferRatios (Levels[Level], Order);
+  }
+  stageDone ("transfer_ratios", Levels.size (), "levels");
+
+  for (unsigned int Level = 0; Level < Levels.size (); Level ++) {
+    Engine.branchingFractions (Levels[Level], Labels, Order, Factors[Level]);
+  }
+  stageDone ("branching_fractions", Levels.size (), "levels");
+}
+
+
+//------------------------------------------------------------------------------
+// saveAndLoad () : Saves everything as a FAST project, then reads it back. The
+// data points of a project are only read from the file when they are first
+// used, so they are read here as part of the load.
+//
+void Benchmark::saveAndLoad () throw (Error) {
+  string Filename = path (BENCH_PROJECT_FILE);
+  ProjectSnapshot Project;
+  ProjectData Loaded;
+
+  ProjectFile::snapshot (Targets, Spectra, Links, Project);
+  Project.Changes = 0;
+  Project.Serial = 0;
+  ProjectFile::write (Filename, Project);
+  stageDone ("project_save", fileSize (Filename), "bytes");
+
+  ProjectFile::read (Filename, Loaded);
+  for (unsigned int i = 0; i < Loaded.Spectra.size (); i ++) {
+    Loaded.Spectra[i].loadData ();
+  }
+  stageDone ("project_load", fileSize (Filename), "bytes");
+}
+
+
+//------------------------------------------------------------------------------
+// report (ostream &) : Writes the benchmark scale and the time taken by each
+// stage to Out as a JSON object.
+//
+void Benchmark::report (ostream &Out) {
+  char Buffer[256];
+  double Total = 0.0;
+
+  Out << "{\n";
+  Out << "  \"fast_version\": \"" << FAST_VERSION << "\",\n";
+  Out << "  \"scale\": {\"points\": " << Scale.Points
+    << ", \"spectra\": " << Scale.Spectra
+    << ", \"lines\": " << Scale.Lines
+    << ", \"targets\": " << Scale.Targets
+    << ", \"branches\": " << Scale.Branches
+    << ", \"threads\": " << Scale.Threads
+    << ", \"seed\": " << Scale.Seed << "},\n";
+  Out << "  \"stages\": [\n";
+  for (unsigned int i = 0; i < Stages.size (); i ++) {
+    sprintf (Buffer, "    {\"name\": \"%s\", \"seconds\": %.6f, "
+      "\"items\": %lu, \"units\": \"%s\", \"rate\": %.6g}%s\n",
+      Stages[i].Name.c_str (), Stages[i].Seconds, Stages[i].Items,
+      Stages[i].Units.c_str (), Stages[i].Seconds > 0.0
+      ? Stages[i].Items / Stages[i].Seconds : 0.0,
+      i + 1 < Stages.size () ? "," : "");
+    Out << Buffer;
+    Total += Stages[i].Seconds;
+  }
+  sprintf (Buffer, "  ],\n  \"total_seconds\": %.6f\n}\n", Total);
+  Out << Buffer;
+}
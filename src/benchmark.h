@@ -0,0 +1,147 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// Benchmark class (benchmark.h)
+//==============================================================================
+// Measures the performance of the FAST core library on synthetic data. Built
+// and run with "make bench" (see fastbench.cpp).
+//
+// generate () writes a set of spectra, each as an XGremlin DAT/HDR pair with a
+// LIN file of the lines it contains, an ASCII copy of the first spectrum, and a
+// Kurucz list of target lines. The spectra share the same lines, with their
+// intensities scaled a little differently in each, so that every target line is
+// matched in every spectrum. The random numbers come from a fixed seed, so the
+// same scale always produces the same files.
+//
+// run () then times each stage of an analysis of those files in turn:
+//
+//   load_dat             XgSpectrum::loadDat () for every spectrum
+//   load_ascii           XgSpectrum::loadAscii () for the first spectrum
+//   parse_lin            readLinFile () and readLinFileHeader ()
+//   parse_kurucz         KzList::read (), which includes setUpperLevels ()
+//   set_upper_levels     Grouping the target lines by upper level on its own
+//   voigt_model          ModelSpectrum::render () for every line list
+//   line_profiles        LineProfiler::compute () for every line list
+//   match_lines          BfEngine::match () for every level, as getLinePairs ()
+//   transfer_ratios      BfEngine::transferRatios () for every level
+//   branching_fractions  BfEngine::branchingFractions () for every level
+//   project_save         ProjectFile::snapshot () and ProjectFile::write ()
+//   project_load         ProjectFile::read ()
+//
+// report () writes the scale and the stage times as JSON, so that the results
+// of different builds can be compared automatically.
+//
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <stdint.h>
+#include <glibmm/timer.h>
+#include "ErrDefs.h"
+#include "xgline.h"
+#include "xgspectrum.h"
+#include "kzlist.h"
+#include "bfengine.h"
+
+using namespace::std;
+
+// Default scale of the synthetic data
+#define BENCH_DEF_POINTS   1000000  /* per spectrum */
+#define BENCH_DEF_LINES    10000    /* per spectrum */
+#define BENCH_DEF_TARGETS  2000
+#define BENCH_DEF_BRANCHES 10       /* target lines per upper level */
+#define BENCH_DEF_SPECTRA  2
+#define BENCH_DEF_SEED     1
+
+// Shape of the synthetic spectra. Each line lies at least BENCH_EDGE from the
+// ends of the spectrum, so that its plot window is always inside it.
+#define BENCH_MIN_WAVENUMBER 10000.0 /* cm-1 */
+#define BENCH_POINT_SPACING  0.01    /* cm-1 */
+#define BENCH_EDGE           2.0     /* cm-1 */
+#define BENCH_MIN_WIDTH      120.0   /* mK */
+#define BENCH_MAX_WIDTH      180.0   /* mK */
+#define BENCH_NOISE          1.0
+
+// Names of the generated files in the benchmark directory
+#define BENCH_SPECTRUM_NAME  "spectrum"
+#define BENCH_TARGETS_FILE   "targets.txt"
+#define BENCH_PROJECT_FILE   "bench.fts"
+
+typedef struct bench_scale {
+  unsigned int Points, Lines, Targets, Branches, Spectra, Threads, Seed;
+} BenchScale;
+
+typedef struct bench_stage {
+  string Name;
+  double Seconds;
+  unsigned long Items;   // Number of Units processed by the stage
+  string Units;
+} BenchStage;
+
+class Benchmark {
+
+  private:
+    BenchScale Scale;
+    string Directory;
+    uint64_t Random;                  // State of the random number generator
+    vector <double> Centres;          // Wavenumbers of the lines
+    vector <double> Widths;           // Widths of the lines in mK
+    vector <double> Peaks;            // Peaks of the lines in the reference
+
+    vector <XgSpectrum> Spectra;
+    KzList Targets;
+    vector <TypeLinkSpectra> Links;
+    vector < vector < vector <LineMatch> > > Levels;
+
+    Glib::Timer Timer;
+    vector <BenchStage> Stages;
+
+    double uniform ();
+    double gaussian ();
+    string path (string Name);
+    string spectrumPath (unsigned int Index, string Extension);
+    void stageDone (string Name, unsigned long Items, string Units);
+
+    void generateLines ();
+    void writeSpectrum (unsigned int Index, vector <double> &SpectrumPeaks)
+      throw (Error);
+    void writeLineList (unsigned int Index, vector <double> &SpectrumPeaks)
+      throw (Error);
+    void writeTargets () throw (Error);
+
+    void loadSpectra () throw (Error);
+    void loadLineLists () throw (Error);
+    void loadTargets () throw (Error);
+    void profileLines () throw (Error);
+    void calculate ();
+    void saveAndLoad () throw (Error);
+
+  public:
+    Benchmark (BenchScale ScaleIn, string DirectoryIn);
+    ~Benchmark () { /* Does nothing */ }
+
+    // Returns the default scale, with one thread for each processor
+    static BenchScale defaultScale ();
+
+    void generate () throw (Error);
+    void run () throw (Error);
+    void report (ostream &Out);
+};
+
+#endif // BENCHMARK_H
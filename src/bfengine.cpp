@@ -0,0 +1,554 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// BfEngine class (bfengine.cpp)
+//==============================================================================
+#include <cmath>
+#include <cstdlib>
+#include "bfengine.h"
+#include "xgspectrum.h"
+#include "CoreDefs.h"
+#include "trace.h"
+
+using namespace::std;
+
+//------------------------------------------------------------------------------
+// Constructor : The engine works on the spectra and links passed in here, which
+// must outlive it. Lines are matched if their wavenumbers differ by less than
+// PrecisionIn.
+//
+BfEngine::BfEngine (vector <XgSpectrum> &SpectraIn,
+  vector <TypeLinkSpectra> &LinksIn, double PrecisionIn, bool CorrectSNRIn) {
+  Spectra = &SpectraIn;
+  Links = &LinksIn;
+  Precision = PrecisionIn;
+  CorrectSNR = CorrectSNRIn;
+}
+
+
+//------------------------------------------------------------------------------
+// match (vector <KzLine *>, unsigned int) : Given a list of lines from the
+// Kurucz database in Level, match will attempt to match each one with an
+// XGremlin line attached to spectrum Spec. When a match is found, a LineMatch
+// is created to link the Kurucz line and the XGremlin line, and that XGremlin
+// line is not used again. If no match is found, the LineMatch has a NULL xgLine
+// so that the returned vector is always the same size as Level.
+//
+vector <LineMatch> BfEngine::match (vector <KzLine *> Level, unsigned int Spec) {
+  vector <LineMatch> MatchedLines;
+  vector <LineMatch> AllXgLines;
+  vector <LineMatch> Candidates;
+  vector <vector <XgLine *> > PtrLines;
+  vector <int> CandidateIndicies;
+  double MinDifference;
+  int MinDiffIndex;
+  long Matched = 0;
+  LineMatch NextPair;
+  XgSpectrum &Spectrum = Spectra -> at (Spec);
+
+  // Copy all the lines attached to the spectrum into a single vector
+  NextPair.Selected = false;
+  NextPair.Disabled = false;
+  PtrLines = Spectrum.linesPtr();
+  for (unsigned int j = 0; j < Spectrum.linesPtr2()->size (); j ++) {
+    for (unsigned int k = 0; k < Spectrum.linesPtr2()->at(j).size (); k ++) {
+      NextPair.xgLine = PtrLines[j][k];
+      NextPair.xgLineListIndex = j;
+      NextPair.xgLineLineIndex = k;
+      AllXgLines.push_back (NextPair);
+    }
+  }
+
+  // Search through each line in Level and compare the wavenumbers to the
+  // lines in AllXgLines. If a line is found that matches the Kurucz wavenumber
+  // to within a tolerance of Precision, add that line to a list of candidates
+  // for the best match.
+  for (unsigned int i = 0; i < Level.size(); i ++) {
+    for (unsigned int j = 0; j < AllXgLines.size (); j ++) {
+      if (abs(AllXgLines[j].xgLine->wavenumber() - Level[i]->sigma()) < Precision) {
+        if (AllXgLines[j].xgLine->id() != FAKE_LINE_TAG) {
+          Candidates.push_back (AllXgLines[j]);
+          CandidateIndicies.push_back (j);
+        }
+      }
+    }
+
+    // Take all the candidate matches identified above and see which XGremlin
+    // line BEST matches the wavenumber of the Kurucz line.
+    if (Candidates.size () > 0) {
+      MinDifference = abs (Level[i]->sigma() - Candidates[0].xgLine->wavenumber());
+      MinDiffIndex = 0;
+      for (unsigned int j = 0; j < Candidates.size (); j ++) {
+        if (abs (Level[i]->sigma() - Candidates[j].xgLine->wavenumber()) < MinDifference) {
+          MinDifference = abs(Level[i]->sigma() - Candidates[j].xgLine->wavenumber());
+          MinDiffIndex = j;
+        }
+      }
+      NextPair = Candidates[MinDiffIndex];
+      NextPair.kzLine = Level[i];
+      MatchedLines.push_back (NextPair);
+      Matched ++;
+
+      // Remove the matched XGremlin line from AllXgLines so that it is not
+      // used again in subsequent matches.
+      AllXgLines.erase (AllXgLines.begin() + CandidateIndicies[MinDiffIndex]);
+      Candidates.clear ();
+      CandidateIndicies.clear ();
+
+    // If no candidate line was found, insert a blank line into the list of
+    // matched lines so that the final vector is of a known size, and is the
+    // same size for all loaded spectra.
+    } else {
+      NextPair.xgLine = NULL;
+      NextPair.kzLine = Level[i];
+      NextPair.xgLineListIndex = -1;
+      NextPair.xgLineLineIndex = -1;
+      MatchedLines.push_back (NextPair);
+    }
+  }
+  TRACE_COUNT ("lines matched", Matched);
+  return MatchedLines;
+}
+
+
+//------------------------------------------------------------------------------
+// match (vector <KzLine *>) : Calls match (vector <KzLine *>, unsigned int)
+// above to match the lines in Level with every spectrum. Lines that have no
+// corresponding experimental data in any of the spectra are then removed.
+//
+vector < vector <LineMatch> > BfEngine::match (vector <KzLine *> Level) {
+  TRACE_SCOPE ("BfEngine::match");
+  vector < vector <LineMatch> > Matches;
+
+  for (unsigned int i = 0; i < Spectra -> size (); i ++) {
+    Matches.push_back (match (Level, i));
+  }
+
+  if (Matches.size () > 0) {
+    bool LineFound;
+    for (int j = Matches[0].size () - 1; j >= 0; j --) {
+      LineFound = false;
+      for (unsigned int i = 0; i < Matches.size (); i ++) {
+        if (Matches[i][j].xgLineLineIndex != -1) {
+          LineFound = true;
+          break;
+        }
+      }
+      if (!LineFound) {
+        for (unsigned int i = 0; i < Matches.size (); i ++) {
+          Matches[i].erase (Matches[i].begin() + j);
+        }
+      }
+    }
+  }
+  return Matches;
+}
+
+
+//------------------------------------------------------------------------------
+// compareLinked (unsigned int, unsigned int, vector <LineRatio> &) : Compares
+// two spectra that have been linked by the user. Linking two spectra asserts
+// that the relative intensity of all lines in both spectra should be
+// identical. As a result, ANY line common to both spectra is used to calculate
+// the transfer ratio rather than just the lines from the current upper level.
+// The comparison of each line is added to Lines. The noise levels of the lines
+// must already have been set by profiling them.
+//
+RatioAndError BfEngine::compareLinked (unsigned int a, unsigned int b,
+  vector <LineRatio> &Lines) throw (int) {
+  vector <XgLine> List1 = Spectra -> at (a).linesVector ();
+  vector <XgLine> List2 = Spectra -> at (b).linesVector ();
+  double Ratio = 0.0, Error = 0.0, AveRatio = 0.0, AveError = 0.0, RatioDenom = 0.0;
+  double SNR1, SNR2;
+  RatioAndError RtnRatioAndError;
+  LineRatio NextLine;
+  unsigned int NumLinesCompared = 0;
+
+  for (unsigned int i = 0; i < List1.size (); i ++) {
+    for (unsigned int j = 0; j < List2.size (); j ++) {
+      if (abs (List1[i].wavenumber () - List2[j].wavenumber ()) < Precision) {
+        Ratio = List1[i].eqwidth () / List2[j].eqwidth ();
+        if (CorrectSNR) {
+          SNR1 = List1[i].snr ();
+          SNR2 = List2[j].snr ();
+        } else {
+          SNR1 = List1[i].snr () / List1[i].noise();
+          SNR2 = List2[j].snr () / List2[j].noise();
+        }
+        Error = sqrt(pow (SNR1, -2.0) + pow (SNR2, -2.0));
+        AveRatio += Ratio / pow (Error, 2.0);
+        RatioDenom += pow (Error, -2.0);
+        AveError += pow (Error, 2.0);
+        NextLine.Wavenumber = List1[i].wavenumber ();
+        NextLine.Ratio = Ratio;
+        NextLine.Error = Error;
+        Lines.push_back (NextLine);
+        NumLinesCompared ++;
+      }
+    }
+  }
+
+  if (NumLinesCompared == 0) {
+    throw (NO_COMPARISON_LINES_FOUNDS);
+  }
+  AveRatio /= RatioDenom;
+  AveError = pow (AveError, 0.5) / NumLinesCompared;
+  RtnRatioAndError.Ratio = AveRatio;
+  RtnRatioAndError.Error = AveError;
+  RtnRatioAndError.a = a;
+  RtnRatioAndError.b = b;
+  return RtnRatioAndError;
+}
+
+
+//------------------------------------------------------------------------------
+// transferRatios (vector < vector <LineMatch> > &, vector <unsigned int> &,
+// vector <TransferRatio> *) : Compares each of the spectra in Order with the
+// others, and returns the factors needed to put them on the same scale as the
+// reference spectrum, Order[0]. Spectra linked by the user are compared with
+// compareLinked (). Otherwise only the lines of the current level that have
+// been found in both spectra, and that have not been disabled, are used.
+//
+vector <RatioAndError> BfEngine::transferRatios (
+  vector < vector <LineMatch> > &Ordered, vector <unsigned int> &Order,
+  vector <TransferRatio> *Details) {
+  double Ratio, Error, AveRatio, AveError, RatioDenom, SNRa, SNRb;
+  RatioAndError NextRatioAndError;
+  vector <RatioAndError> RtnData;
+  TransferRatio NextDetail;
+  LineRatio NextLine;
+  bool LinkFound;
+  unsigned int NumLinesCompared = 0;
+
+  // First add null scaling for the reference spectrum. Then assess what factors
+  // are needed to put the other spectra on the same scale as the reference.
+  NextRatioAndError.Ratio = 1.0;
+  NextRatioAndError.Error = 0.0;
+  NextRatioAndError.a = Order[0];
+  NextRatioAndError.b = Order[0];
+  RtnData.push_back (NextRatioAndError);
+
+  if (Ordered.size () > 1) {
+    for (unsigned int k = 0; k < Ordered.size () - 1; k ++) {
+      for (unsigned int j = k + 1; j < Ordered.size (); j ++) {
+        AveRatio = 0.0;
+        AveError = 0.0;
+        RatioDenom = 0.0;
+        LinkFound = false;
+        NextDetail.k = k;
+        NextDetail.j = j;
+        NextDetail.Lines.clear ();
+
+        // First check to see if the spectra have been explicitly linked
+        // together by the user. Note that only the first link is examined.
+        for (unsigned int i = 0; i < Links -> size (); i ++) {
+          try {
+            if (Links -> at (i).a == Order[k] && Links -> at (i).b == Order[j]) {
+              LinkFound = true;
+              NextRatioAndError = compareLinked (Links -> at (i).a,
+                Links -> at (i).b, NextDetail.Lines);
+            } else if (Links -> at (i).b == Order[k] && Links -> at (i).a == Order[j]) {
+              LinkFound = true;
+              NextRatioAndError = compareLinked (Links -> at (i).b,
+                Links -> at (i).a, NextDetail.Lines);
+            }
+            if (LinkFound) {
+              RtnData.push_back (NextRatioAndError);
+              if (Details != NULL) {
+                NextDetail.Linked = true;
+                NextDetail.Ratio = NextRatioAndError;
+                Details -> push_back (NextDetail);
+              }
+            }
+            break;
+          } catch (int e) {
+            if (e == NO_COMPARISON_LINES_FOUNDS) break;
+          }
+        }
+
+        // If the spectra have not been linked by the user only the common lines
+        // belonging to the current upper level may be used.
+        if (!LinkFound) {
+          NumLinesCompared = 0;
+          for (unsigned int i = 0; i < Ordered[k].size (); i ++) {
+            LineMatch &a = Ordered[k][i];
+            LineMatch &b = Ordered[j][i];
+            if (a.xgLine != NULL && a.xgLine->wavenumber () > 0.0 && !a.Disabled
+              && b.xgLine != NULL && b.xgLine->wavenumber () > 0.0 && !b.Disabled) {
+              Ratio = (a.xgLine->eqwidth ()
+                / Spectra -> at (Order[k]).response (a.xgLine->wavenumber ()))
+                / (b.xgLine->eqwidth ()
+                / Spectra -> at (Order[j]).response (b.xgLine->wavenumber ()));
+              if (CorrectSNR) {
+                SNRa = a.xgLine->snr () / a.xgLine->noise();
+                SNRb = b.xgLine->snr () / b.xgLine->noise();
+              } else {
+                SNRa = a.xgLine->snr ();
+                SNRb = b.xgLine->snr ();
+              }
+
+              // Calculate the weighted average of the transfer ratio of each
+              // common line
+              Error = sqrt(pow (SNRa, -2.0) + pow (SNRb, -2.0));
+              AveRatio += Ratio / pow (Error, 2.0);
+              RatioDenom += pow (Error, -2.0);
+              AveError += 1.0 / Error;
+              NextLine.Wavenumber = a.xgLine->wavenumber ();
+              NextLine.Ratio = Ratio;
+              NextLine.Error = Error;
+              NextDetail.Lines.push_back (NextLine);
+              NumLinesCompared ++;
+            }
+          }
+
+          if (NumLinesCompared > 0) {
+            AveRatio /= RatioDenom;
+            AveError /= RatioDenom;
+            NextRatioAndError.Ratio = AveRatio;
+            NextRatioAndError.Error = AveError;
+            NextRatioAndError.a = Order[k];
+            NextRatioAndError.b = Order[j];
+            RtnData.push_back (NextRatioAndError);
+            if (Details != NULL) {
+              NextDetail.Linked = false;
+              NextDetail.Ratio = NextRatioAndError;
+              Details -> push_back (NextDetail);
+            }
+          }
+        }
+      }
+    }
+  }
+  return RtnData;
+}
+
+
+//------------------------------------------------------------------------------
+// bestScalingFactor (unsigned int, unsigned int, vector <RatioAndError>) :
+// Finds the best equivalent width scaling factor to use when overlapping the
+// two spectra specified at arg1 and arg2. If the two spectra do not overlap, or
+// if there are no common lines between them, this function will attempt to
+// calculate a compound scaling factor using intermediate spectra. Be careful:
+// this is a RECURSIVE function.
+//
+RatioAndError BfEngine::bestScalingFactor (unsigned int Start,
+  unsigned int End, vector <RatioAndError> Factors) throw (int) {
+
+  RatioAndError RtnFactor, NextFactor, Swap;
+  vector <RatioAndError> Subset;
+  RtnFactor.Error = -1;
+
+  // Search through all available Factors to find a link from spectrum 'Start',
+  // A, to spectrum 'End', B.
+  for (unsigned int i = 0; i < Factors.size (); i ++) {
+    if (Factors [i].a == Start) {
+      if (Factors [i].b == End) {
+        // Success: The factor linking A and B has been found. Return it.
+        return Factors [i];
+      } else {
+        // The current scaling factor starts at spectrum A, but does not link to
+        // B. It instead links to a third spectrum, C.
+        Subset = Factors;
+        Subset.erase (Subset.begin () + i);
+        try {
+          // Try to find to find another scaling factor that links C to B. This
+          // search is RECURSIVE, and so is capable of finding a suitable link
+          // from A to B with more than one intermediate spectrum.
+          NextFactor = bestScalingFactor (Factors [i].b, End, Subset);
+        } catch (int e) {
+          try {
+            // No factor was found linking C to B, but one might exist that
+            // links B to C. If so, this can be inverted.
+            NextFactor = bestScalingFactor (End, Factors [i].b, Subset);
+            Swap = NextFactor;
+            NextFactor.a = Swap.b;
+            NextFactor.b = Swap.a;
+            NextFactor.Ratio = 1.0 / Swap.Ratio;
+          } catch (int e) {
+            // No factor was found linking either C to B or B to C.
+            NextFactor.Error = -1;
+          }
+        }
+        // If a scaling factor was found linking C to B, combine it with the
+        // factor linking A to C to obtain the required link from A to B.
+        if (NextFactor.Error != -1) {
+          NextFactor.Ratio *= Factors [i].Ratio;
+          NextFactor.Error =
+            sqrt (pow (NextFactor.Error, 2) + pow (Factors[i].Error, 2));
+          // Depending on which spectra are loaded in the current project, it
+          // may be possible to link A to B through different intermediary
+          // spectra. If this is the case, keep only the scaling factor that has
+          // the lowest associated uncertainty.
+          if (RtnFactor.Error == -1 || NextFactor.Error < RtnFactor.Error) {
+            RtnFactor = NextFactor;
+          }
+        }
+      }
+    }
+  }
+  // If no suitable link was found from A to B, throw an error
+  if (RtnFactor.Error == -1) throw (NO_SCALING_RATIO_FOUND);
+  return RtnFactor;
+}
+
+
+//------------------------------------------------------------------------------
+// scalingFactor (unsigned int, unsigned int, vector <RatioAndError> &) : Returns
+// the factor that puts spectrum Spec on the scale of the reference spectrum,
+// Ref. If neither spectrum can be linked to the other, a ratio of 1.0 with no
+// uncertainty is returned.
+//
+RatioAndError BfEngine::scalingFactor (unsigned int Ref, unsigned int Spec,
+  vector <RatioAndError> &Factors) {
+  RatioAndError Factor, Swap;
+  try {
+    Factor = bestScalingFactor (Ref, Spec, Factors);
+  } catch (int e) {
+    try {
+      Swap = bestScalingFactor (Spec, Ref, Factors);
+      Factor = Swap;
+      Factor.a = Swap.b;
+      Factor.b = Swap.a;
+      Factor.Ratio = 1.0 / Swap.Ratio;
+    } catch (int e2) {
+      Factor.a = 0;
+      Factor.b = 0;
+      Factor.Ratio = 1.0;
+      Factor.Error = 0.0;
+    }
+  }
+  return Factor;
+}
+
+
+//------------------------------------------------------------------------------
+// branchingFractions (vector < vector <LineMatch> > &, vector <string> &,
+// vector <unsigned int> &, vector <RatioAndError> &) : Calculates the branching
+// fraction data of every selected line in the level. Factors are the transfer
+// ratios returned by transferRatios (). If a line is selected in more than one
+// spectrum, only the first selected instance is used.
+//
+vector <BfResult> BfEngine::branchingFractions (
+  vector < vector <LineMatch> > &Ordered, vector <string> &Labels,
+  vector <unsigned int> &Order, vector <RatioAndError> &Factors) {
+
+  vector <BfResult> AllBrFracData;
+  BfResult NextBrFracLine;
+  RatioAndError BestScalingFactor;
+  double gf;
+  double TotalEqWidth = 0.0, TotalKuruczBrFrac = 0.0, TotalErrInEqWidth = 0.0;
+
+  if (Ordered.size () == 0) return AllBrFracData;
+
+  // Cycle through each of the lines in the target upper level
+  for (unsigned int i = 0; i < Ordered[0].size (); i ++) {
+
+    // Cycle through each of the loaded spectra with j
+    for (unsigned int j = 0; j < Ordered.size (); j ++) {
+      LineMatch &Match = Ordered[j][i];
+      XgSpectrum &Spectrum = Spectra -> at (Order[j]);
+
+      // Only consider a line if it has a valid wavenumber and is selected
+      if (Match.xgLine != NULL && Match.xgLine -> wavenumber () > 0.0
+        && Match.Selected) {
+        BestScalingFactor = scalingFactor (Order[0], Order[j], Factors);
+        NextBrFracLine.spectrum = Labels[j];
+        NextBrFracLine.line = i;
+        NextBrFracLine.order = j;
+        NextBrFracLine.index = Match.xgLine->line ();
+        NextBrFracLine.wavenumber = Match.xgLine->wavenumber ();
+        NextBrFracLine.eqwidth = Match.xgLine->eqwidth ()
+          / Spectrum.response (Match.xgLine->wavenumber ())
+          * BestScalingFactor.Ratio;
+        if (CorrectSNR) {
+          NextBrFracLine.err_line = Match.xgLine->noise() / Match.xgLine->snr() * 100;
+        } else {
+          NextBrFracLine.err_line = 1.0 / Match.xgLine->snr() * 100;
+        }
+        NextBrFracLine.err_cal = Spectrum.response_error
+          (Match.xgLine->wavenumber ());
+        NextBrFracLine.err_trans = BestScalingFactor.Error * 100;
+        NextBrFracLine.err_total = sqrt (pow (NextBrFracLine.err_line, 2)
+          + pow (NextBrFracLine.err_cal / sqrt (2.0), 2)
+          + pow (NextBrFracLine.err_trans, 2));
+        NextBrFracLine.err_eqwidth =
+          NextBrFracLine.eqwidth * NextBrFracLine.err_total / 100;
+        NextBrFracLine.normalised =
+          Spectrum.response (Match.xgLine->wavenumber ()) != 1.0;
+        NextBrFracLine.calibrated = NextBrFracLine.err_cal != 0.0;
+
+        // Keep a running total of the equivalent width and its error, and the
+        // Kurucz branching fraction summed over all selected lines. These are
+        // used for normalisation of parameters later on.
+        TotalEqWidth += NextBrFracLine.eqwidth;
+        TotalErrInEqWidth +=
+          pow (NextBrFracLine.eqwidth * NextBrFracLine.err_total / 100, 2);
+        TotalKuruczBrFrac += Match.kzLine->brFrac ();
+
+        // The fields that depend upon the above level sum totals cannot be
+        // fully calculated until those sum totals are known. Therefore, the
+        // following fields contain only intermediate calculations, which are
+        // completed below.
+        NextBrFracLine.a = 1.0 / Match.kzLine->lifetime ();
+        NextBrFracLine.err_a = pow (100 * Match.kzLine->lifetime_error ()
+            / Match.kzLine->lifetime (), 2);
+        if (Match.kzLine->eUpper() > Match.kzLine->eLower()) {
+          gf =  1.499e-14 * (2 * Match.kzLine->jUpper () + 1)
+            * pow (Match.xgLine->airWavelength (), 2);
+        } else {
+          gf =  1.499e-14 * (2 * Match.kzLine->jLower () + 1)
+            * pow (Match.xgLine->airWavelength (), 2);
+        }
+        NextBrFracLine.loggf = gf;
+        AllBrFracData.push_back (NextBrFracLine);
+        break;
+      }
+    }
+  }
+  TotalErrInEqWidth = sqrt (TotalErrInEqWidth);
+
+  // Now consider the fields that require normalisation to the level's total
+  // eq. width, total error in eq. width, or total Kurucz branching fraction.
+  for (unsigned int j = 0; j < AllBrFracData.size (); j ++) {
+    AllBrFracData[j].br_frac =
+      AllBrFracData[j].eqwidth * TotalKuruczBrFrac / TotalEqWidth;
+  }
+
+  // Calculate U (BF) based on Equation 7 in C.M.Sikstrom et al., JQSRT,
+  // 74 pp. 355 (2002). Note that the coefficient (1- BF_k) should be squared as
+  // it is in Equation 6!
+  for (unsigned int j = 0; j < AllBrFracData.size (); j ++) {
+    AllBrFracData[j].err_br_frac = (1 - 2.0 * AllBrFracData[j].br_frac) *
+      pow (AllBrFracData[j].err_total, 2);
+    for (unsigned int k = 0; k < AllBrFracData.size (); k ++) {
+      AllBrFracData[j].err_br_frac += pow (AllBrFracData[k].br_frac, 2) *
+        pow (AllBrFracData[k].err_total, 2);
+    }
+    AllBrFracData[j].err_br_frac = sqrt (AllBrFracData[j].err_br_frac);
+  }
+
+  for (unsigned int j = 0; j < AllBrFracData.size (); j ++) {
+    gf = AllBrFracData[j].loggf;
+    AllBrFracData[j].a = AllBrFracData[j].br_frac * AllBrFracData[j].a;
+    AllBrFracData[j].err_a =
+      sqrt (pow (AllBrFracData[j].err_br_frac, 2) + AllBrFracData[j].err_a);
+    AllBrFracData[j].loggf = log10 (gf * AllBrFracData[j].a);
+    AllBrFracData[j].dex = log10 (gf * (1 + AllBrFracData[j].err_a / 100))
+      - log10 (gf);
+  }
+  return AllBrFracData;
+}
@@ -0,0 +1,133 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// BfEngine class (bfengine.h)
+//==============================================================================
+// Performs the calculations that turn a set of experimental spectra and a list
+// of target lines into branching fractions and log(gf) values:
+//
+//   match ()               Matches the target lines of an upper level with the
+//                          experimental lines of each spectrum
+//   transferRatios ()      Calculates the ratios that put the intensities of
+//                          every spectrum on the scale of the reference
+//   branchingFractions ()  Calculates the branching fraction, transition
+//                          probability and log(gf) of each selected line
+//
+// None of these functions use the user interface. The lines of an upper level
+// are passed around as LineMatch structures, which carry the selected and
+// disabled states chosen by the user. In each calculation, the first spectrum
+// in the spectrum order is the reference spectrum.
+//
+#ifndef BF_ENGINE_H
+#define BF_ENGINE_H
+
+#include <vector>
+#include <string>
+#include "ErrDefs.h"
+#include "xgline.h"
+#include "kzline.h"
+
+using namespace::std;
+
+class XgSpectrum;
+
+// RatioAndError typedef, used for calculating the transfer ratios and errors
+// needed to link a given intensity calibration across multiple spectra.
+typedef struct ratio_and_error {
+  unsigned int a, b;
+  double Ratio;
+  double Error;
+} RatioAndError;
+
+// A pair of spectra linked by the user, so that every line common to both is
+// used when calculating the transfer ratio between them
+typedef struct type_link_spectra { unsigned int a, b; } TypeLinkSpectra;
+
+// A target line and the experimental line it was matched with in one spectrum.
+// If no line was found, xgLine is NULL and both indices are -1.
+typedef struct line_match {
+  XgLine *xgLine;
+  KzLine *kzLine;
+  int xgLineListIndex, xgLineLineIndex;
+  bool Selected, Disabled;
+} LineMatch;
+
+// The ratio of the intensities of a line found in two spectra
+typedef struct line_ratio {
+  double Wavenumber, Ratio, Error;
+} LineRatio;
+
+// The transfer ratio between the spectra at positions k and j of the spectrum
+// order, and the lines it was calculated from. If Linked is true, the spectra
+// were linked by the user and every line common to both was used.
+typedef struct transfer_ratio {
+  unsigned int k, j;
+  bool Linked;
+  RatioAndError Ratio;
+  vector <LineRatio> Lines;
+} TransferRatio;
+
+// The branching fraction data of one line. line and order give the position of
+// the line in its level, and of its spectrum in the spectrum order.
+typedef struct bf_result {
+  int index;
+  double wavenumber, eqwidth, err_line, err_cal, err_trans, err_total,
+    err_eqwidth, br_frac, err_br_frac, a, err_a, loggf, dex;
+  std::string spectrum;
+  unsigned int line, order;
+  bool normalised;     // False if the response function was 1.0 at the line
+  bool calibrated;     // False if there was no uncertainty in the response
+} BfResult;
+
+class BfEngine {
+
+  private:
+    vector <XgSpectrum> *Spectra;
+    vector <TypeLinkSpectra> *Links;
+    double Precision;    // Maximum difference in wavenumber of matched lines
+    bool CorrectSNR;     // True if the line S/N ratios are noise corrected
+
+  public:
+    BfEngine (vector <XgSpectrum> &SpectraIn, vector <TypeLinkSpectra> &LinksIn,
+      double PrecisionIn, bool CorrectSNRIn);
+    ~BfEngine () { /* Does nothing */ }
+
+    // Line matching
+    vector <LineMatch> match (vector <KzLine *> Level, unsigned int Spec);
+    vector < vector <LineMatch> > match (vector <KzLine *> Level);
+
+    // Transfer ratios. Ordered[j] holds the lines of the level in spectrum
+    // Order[j]. The returned factors start with the null factor of the
+    // reference spectrum. If Details is not NULL, every comparison made is
+    // added to it.
+    RatioAndError compareLinked (unsigned int a, unsigned int b,
+      vector <LineRatio> &Lines) throw (int);
+    vector <RatioAndError> transferRatios (
+      vector < vector <LineMatch> > &Ordered, vector <unsigned int> &Order,
+      vector <TransferRatio> *Details = NULL);
+    static RatioAndError bestScalingFactor (unsigned int Start,
+      unsigned int End, vector <RatioAndError> Factors) throw (int);
+    static RatioAndError scalingFactor (unsigned int Ref, unsigned int Spec,
+      vector <RatioAndError> &Factors);
+
+    // Branching fractions of the selected lines of a level
+    vector <BfResult> branchingFractions (
+      vector < vector <LineMatch> > &Ordered, vector <string> &Labels,
+      vector <unsigned int> &Order, vector <RatioAndError> &Factors);
+};
+
+#endif // BF_ENGINE_H
@@ -0,0 +1,132 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// Benchmark main function (fastbench.cpp)
+//==============================================================================
+// Generates a set of synthetic spectra, line lists and a target list, times the
+// analysis of them with the FAST core library, and writes the results as JSON
+// (see benchmark.h). Progress is written to stderr, so that the JSON can be
+// sent to stdout. This is built and run by "make bench".
+//
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <string>
+#include <glibmm/thread.h>
+#include "benchmark.h"
+#include "trace.h"
+#include "CoreDefs.h"
+
+using namespace::std;
+
+#define ERROR_INVALID_ARGS    1
+#define ERROR_BENCH_FAILED    2
+#define NO_ERROR              0
+
+void showHelp () {
+  BenchScale Default = Benchmark::defaultScale ();
+  cout << "fastbench : Performance benchmark for the FTS Atomic Spectrum Tool" << endl;
+  cout << "------------------------------------------------------------------" << endl;
+  cout << "Syntax : fastbench [options]" << endl << endl;
+  cout << "  -d <directory>  Directory for the synthetic files (default .)" << endl;
+  cout << "  -o <file>       Write the JSON results to <file> instead of stdout" << endl;
+  cout << "  -p <points>     Points in each spectrum (default " << Default.Points << ")" << endl;
+  cout << "  -l <lines>      Lines in each spectrum (default " << Default.Lines << ")" << endl;
+  cout << "  -k <targets>    Lines in the target list (default " << Default.Targets << ")" << endl;
+  cout << "  -b <branches>   Target lines per upper level (default " << Default.Branches << ")" << endl;
+  cout << "  -s <spectra>    Number of spectra (default " << Default.Spectra << ")" << endl;
+  cout << "  -t <threads>    Threads used to profile the lines (default " << Default.Threads << ")" << endl;
+  cout << "  -r <seed>       Random number seed (default " << Default.Seed << ")" << endl;
+  cout << "  -h              Show this help" << endl;
+  cout << "  --trace <file>  Write a Chrome trace of the run to <file>" << endl;
+}
+
+int main (int argc, char *argv[]) {
+  BenchScale Scale = Benchmark::defaultScale ();
+  string Directory = ".", OutputFile = "", Argument;
+  unsigned int *Value;
+
+  if (!Glib::thread_supported ()) Glib::thread_init ();
+  Trace::parse (argc, argv);
+  for (int i = 1; i < argc; i ++) {
+    Argument = argv[i];
+    Value = NULL;
+    if (Argument == "-h") {
+      showHelp ();
+      return NO_ERROR;
+    }
+    if (i + 1 >= argc) {
+      cout << "Error: No value given for " << Argument << endl;
+      showHelp ();
+      return ERROR_INVALID_ARGS;
+    }
+    i ++;
+    if (Argument == "-d") Directory = argv[i];
+    else if (Argument == "-o") OutputFile = argv[i];
+    else if (Argument == "-p") Value = &Scale.Points;
+    else if (Argument == "-l") Value = &Scale.Lines;
+    else if (Argument == "-k") Value = &Scale.Targets;
+    else if (Argument == "-b") Value = &Scale.Branches;
+    else if (Argument == "-s") Value = &Scale.Spectra;
+    else if (Argument == "-t") Value = &Scale.Threads;
+    else if (Argument == "-r") Value = &Scale.Seed;
+    else {
+      cout << "Error: Unknown argument " << Argument << endl;
+      showHelp ();
+      return ERROR_INVALID_ARGS;
+    }
+    if (Value != NULL) {
+      char *End;
+      long NewValue = strtol (argv[i], &End, 10);
+      if (*End != '\0' || NewValue < 0) {
+        cout << "Error: Invalid value for " << Argument << endl;
+        return ERROR_INVALID_ARGS;
+      }
+      *Value = NewValue;
+    }
+  }
+  if (Scale.Threads == 0) Scale.Threads = 1;
+
+  try {
+    Benchmark Bench (Scale, Directory);
+    cerr << "FAST v" << FAST_VERSION << " benchmark: generating "
+      << Scale.Spectra << " spectra of " << Scale.Points << " points and "
+      << Scale.Lines << " lines, with " << Scale.Targets << " target lines, in "
+      << Directory << endl;
+    Bench.generate ();
+    cerr << "Running..." << endl;
+    Bench.run ();
+
+    if (OutputFile == "") {
+      Bench.report (cout);
+    } else {
+      ofstream Out (OutputFile.c_str ());
+      if (!Out.is_open ()) {
+        throw (Error (FLT_FILE_WRITE_ERROR, "Unable to open " + OutputFile));
+      }
+      Bench.report (Out);
+      Out.close ();
+      cerr << "Wrote " << OutputFile << endl;
+    }
+    Trace::stop ();
+  } catch (Error Err) {
+    cerr << "Error: " << Err.message << endl;
+    if (Err.subtext != "") cerr << Err.subtext << endl;
+    return Err.code == FLT_SYNTAX_ERROR ? ERROR_INVALID_ARGS : ERROR_BENCH_FAILED;
+  }
+  return NO_ERROR;
+}
@@ -0,0 +1,61 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// FAST core library (fastcore.h)
+//==============================================================================
+// Includes everything needed to use libfastcore, the part of FAST that does
+// not depend on GTK+. It is built with "make core" and only needs glibmm (for
+// threads) and GSL. A typical analysis runs as follows:
+//
+//   ProjectFile::read ()     Reads a FAST project into a ProjectData. Without
+//                            a project, the spectra are read by XgSpectrum,
+//                            the line lists by readLineList () or
+//                            readLinFile (), and the target list by KzList
+//   LineProfiler::compute () Profiles the lines of a spectrum, which sets the
+//                            noise level used for their S/N ratios
+//   BfEngine::match ()       Matches the target lines of an upper level with
+//                            the lines of each spectrum
+//   BfEngine::transferRatios (), BfEngine::branchingFractions ()
+//                            Calculate the branching fractions and log(gf)s
+//   ResultTable::write ()    Writes the results as a CSV, LaTeX or AASTeX table
+//
+// BatchRun (batch.cpp) is a complete example.
+//
+#ifndef FAST_CORE_H
+#define FAST_CORE_H
+
+#include "ErrDefs.h"
+#include "CoreDefs.h"
+#include "xgline.h"
+#include "kzline.h"
+#include "kzlist.h"
+#include "lineio.h"
+#include "voigtlsqfit.h"
+#include "modelspectrum.h"
+#include "voigtfit.h"
+#include "xgspectrum.h"
+#include "lineprofile.h"
+#include "profilestore.h"
+#include "inputcache.h"
+#include "projectfile.h"
+#include "projectjournal.h"
+#include "bfengine.h"
+#include "resulttable.h"
+#include "spectrumpyramid.h"
+#include "trace.h"
+
+#endif // FAST_CORE_H
@@ -0,0 +1,397 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// FtsWriter and FtsReader classes (ftsfile.cpp)
+//==============================================================================
+#include "ftsfile.h"
+#include <cstring>
+
+using namespace::std;
+
+//==============================================================================
+// FTSFLOATARRAY
+//==============================================================================
+
+FtsFloatArray::FtsFloatArray () {
+  File = NULL;
+  Offset = 0;
+  Count = 0;
+}
+
+
+FtsFloatArray::FtsFloatArray (GMappedFile *FileIn, uint64_t OffsetIn,
+  unsigned int CountIn) {
+  File = g_mapped_file_ref (FileIn);
+  Offset = OffsetIn;
+  Count = CountIn;
+}
+
+
+FtsFloatArray::FtsFloatArray (const FtsFloatArray &a) {
+  File = a.File != NULL ? g_mapped_file_ref (a.File) : NULL;
+  Offset = a.Offset;
+  Count = a.Count;
+  Values = a.Values;
+}
+
+
+FtsFloatArray &FtsFloatArray::operator= (const FtsFloatArray &a) {
+  if (this != &a) {
+    clear ();
+    File = a.File != NULL ? g_mapped_file_ref (a.File) : NULL;
+    Offset = a.Offset;
+    Count = a.Count;
+    Values = a.Values;
+  }
+  return *this;
+}
+
+
+FtsFloatArray::~FtsFloatArray () {
+  clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// data () : Returns the values of the array, which stay valid until the array
+// is changed or destroyed. Nothing is copied, so a mapped array can be written
+// out again without first being read into memory.
+//
+const float *FtsFloatArray::data () {
+  if (File != NULL) {
+    return (const float *)(g_mapped_file_get_contents (File) + Offset);
+  }
+  return Values.size () > 0 ? &Values[0] : NULL;
+}
+
+
+//------------------------------------------------------------------------------
+// read (vector <float> &) : Copies the values of the array into a.
+//
+void FtsFloatArray::read (vector <float> &a) {
+  if (File != NULL) {
+    a.resize (Count);
+    if (Count > 0) {
+      memcpy (&a[0], g_mapped_file_get_contents (File) + Offset,
+        sizeof (float) * Count);
+    }
+  } else {
+    a = Values;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// read (vector <float> &, unsigned int, unsigned int) : Copies Num values from
+// the array into a, starting at index First. The range must lie in the array.
+//
+void FtsFloatArray::read (vector <float> &a, unsigned int First,
+  unsigned int Num) {
+  a.resize (Num);
+  if (Num == 0) return;
+  if (File != NULL) {
+    memcpy (&a[0], g_mapped_file_get_contents (File) + Offset
+      + uint64_t (First) * sizeof (float), sizeof (float) * Num);
+  } else {
+    memcpy (&a[0], &Values[First], sizeof (float) * Num);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// clear () : Empties the array, releasing its reference to the file mapping.
+//
+void FtsFloatArray::clear () {
+  if (File != NULL) g_mapped_file_unref (File);
+  File = NULL;
+  Offset = 0;
+  Count = 0;
+  Values.clear ();
+}
+
+
+//==============================================================================
+// FTSWRITER
+//==============================================================================
+
+FtsWriter::FtsWriter (ostream *OutIn, unsigned int FileVersion) {
+  uint64_t TableOffset = 0;
+  Out = OutIn;
+  Start = Out -> tellp ();
+  writeUInt (FileVersion);
+  write (&TableOffset, sizeof (uint64_t));
+}
+
+
+//------------------------------------------------------------------------------
+// beginSection (unsigned int, unsigned int, unsigned int) : Starts a new
+// section. Everything written until endSection () is called belongs to it.
+//
+void FtsWriter::beginSection (unsigned int Type, unsigned int Spectrum,
+  unsigned int List) {
+  FtsSection NewSection;
+  NewSection.Type = Type;
+  NewSection.Spectrum = Spectrum;
+  NewSection.List = List;
+  NewSection.Reserved = 0;
+  NewSection.Offset = Out -> tellp () - Start;
+  NewSection.Length = 0;
+  Sections.push_back (NewSection);
+}
+
+
+//------------------------------------------------------------------------------
+// endSection () : Records the length of the current section.
+//
+void FtsWriter::endSection () {
+  FtsSection &Last = Sections.back ();
+  Last.Length = uint64_t (Out -> tellp () - Start) - Last.Offset;
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Writes the section table at the end of the file, then fills in
+// its offset at the start of the file.
+//
+void FtsWriter::finish () {
+  uint64_t TableOffset = Out -> tellp () - Start;
+  writeArray (Sections);
+  Out -> seekp (Start + streamoff (sizeof (unsigned int)));
+  write (&TableOffset, sizeof (uint64_t));
+  Out -> seekp (0, ios::end);
+}
+
+
+//------------------------------------------------------------------------------
+// writeString (const string &) : Writes the length of a string followed by
+// its characters.
+//
+void FtsWriter::writeString (const string &a) {
+  writeUInt (a.size ());
+  write (a.data (), a.size ());
+}
+
+
+//------------------------------------------------------------------------------
+// writeStrings (const vector <string> &) : Writes a set of strings as a single
+// block. The number of strings and the length of each are written first as
+// one array, followed by all their characters in a single call.
+//
+void FtsWriter::writeStrings (const vector <string> &a) {
+  vector <unsigned int> Lengths (a.size ());
+  string Characters;
+  size_t Total = 0;
+  for (unsigned int i = 0; i < a.size (); i ++) {
+    Lengths[i] = a[i].size ();
+    Total += a[i].size ();
+  }
+  Characters.reserve (Total);
+  for (unsigned int i = 0; i < a.size (); i ++) Characters += a[i];
+  writeArray (Lengths);
+  write (Characters.data (), Characters.size ());
+}
+
+
+//------------------------------------------------------------------------------
+// writeArray (FtsFloatArray &) : Writes the values of a in the same form as
+// writeArray (vector <float> &), straight from the file mapping if it has one.
+//
+void FtsWriter::writeArray (FtsFloatArray &a) {
+  writeUInt (a.size ());
+  if (a.size () > 0) write (a.data (), sizeof (float) * a.size ());
+}
+
+
+//==============================================================================
+// FTSREADER
+//==============================================================================
+
+FtsReader::FtsReader (istream *InIn, string Filename) throw (Error) {
+  uint64_t TableOffset;
+  In = InIn;
+  File = NULL;
+  End = fileSize ();
+
+  read (&TableOffset, sizeof (uint64_t));
+  if (TableOffset >= End) {
+    throw (Error (FLT_FILE_READ_ERROR, "", "The project file is incomplete."));
+  }
+  In -> seekg (TableOffset);
+  readArray (Sections);
+  for (unsigned int i = 0; i < Sections.size (); i ++) {
+    if (Sections[i].Offset + Sections[i].Length > TableOffset) {
+      throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+    }
+  }
+
+  // Windows will not let a mapped file be replaced, which would stop the
+  // project from being saved again, so the file is only mapped elsewhere.
+#ifndef _WIN32
+  if (Filename != "") {
+    File = g_mapped_file_new (Filename.c_str (), false, NULL);
+    if (File != NULL && g_mapped_file_get_length (File) != End) {
+      g_mapped_file_unref (File);
+      File = NULL;
+    }
+  }
+#endif
+}
+
+
+FtsReader::~FtsReader () {
+  if (File != NULL) g_mapped_file_unref (File);
+}
+
+
+//------------------------------------------------------------------------------
+// check (uint64_t) : Throws an error if Size bytes cannot be read from the
+// current section. This catches corrupt counts before any memory is allocated.
+//
+void FtsReader::check (uint64_t Size) throw (Error) {
+  if (uint64_t (In -> tellg ()) + Size > End) {
+    throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// fileSize () : Returns the length of the file in bytes.
+//
+uint64_t FtsReader::fileSize () {
+  streampos Current = In -> tellg ();
+  In -> seekg (0, ios::end);
+  uint64_t Size = In -> tellg ();
+  In -> seekg (Current);
+  return Size;
+}
+
+
+//------------------------------------------------------------------------------
+// seek (FtsSection &) : Moves to the start of Section. Reads are then limited
+// to the length of the section.
+//
+void FtsReader::seek (FtsSection &Section) {
+  In -> clear ();
+  In -> seekg (Section.Offset);
+  End = Section.Offset + Section.Length;
+}
+
+
+//------------------------------------------------------------------------------
+// read (void *, size_t) : Reads Size bytes into Data. If the file is mapped the
+// bytes are copied straight from the mapping, and the stream is only moved on.
+//
+void FtsReader::read (void *Data, size_t Size) throw (Error) {
+  check (Size);
+  if (File != NULL) {
+    uint64_t Pos = In -> tellg ();
+    memcpy (Data, g_mapped_file_get_contents (File) + Pos, Size);
+    In -> seekg (Pos + Size);
+    return;
+  }
+  In -> read ((char *)Data, Size);
+  if (In -> fail ()) {
+    throw (Error (FLT_FILE_READ_ERROR, "", "The project file is incomplete."));
+  }
+}
+
+
+unsigned int FtsReader::readUInt () throw (Error) {
+  unsigned int a;
+  read (&a, sizeof (unsigned int));
+  return a;
+}
+
+
+double FtsReader::readDouble () throw (Error) {
+  double a;
+  read (&a, sizeof (double));
+  return a;
+}
+
+
+bool FtsReader::readBool () throw (Error) {
+  bool a;
+  read (&a, sizeof (bool));
+  return a;
+}
+
+
+//------------------------------------------------------------------------------
+// readString () : Reads a string written by FtsWriter::writeString ().
+//
+string FtsReader::readString () throw (Error) {
+  unsigned int Size = readUInt ();
+  check (Size);
+  string a (Size, '\0');
+  if (Size > 0) read (&a[0], Size);
+  return a;
+}
+
+
+//------------------------------------------------------------------------------
+// readStrings () : Reads a block of strings written by writeStrings ().
+//
+vector <string> FtsReader::readStrings () throw (Error) {
+  vector <unsigned int> Lengths;
+  vector <string> Strings;
+  uint64_t Total = 0;
+  readArray (Lengths);
+  for (unsigned int i = 0; i < Lengths.size (); i ++) Total += Lengths[i];
+  check (Total);
+  string Characters (Total, '\0');
+  if (Total > 0) read (&Characters[0], Total);
+  Strings.resize (Lengths.size ());
+  size_t Pos = 0;
+  for (unsigned int i = 0; i < Lengths.size (); i ++) {
+    Strings[i] = Characters.substr (Pos, Lengths[i]);
+    Pos += Lengths[i];
+  }
+  return Strings;
+}
+
+
+//------------------------------------------------------------------------------
+// readRemainder () : Returns everything left in the current section.
+//
+vector <char> FtsReader::readRemainder () throw (Error) {
+  uint64_t Position = In -> tellg ();
+  vector <char> Data (End > Position ? End - Position : 0);
+  if (Data.size () > 0) read (&Data[0], Data.size ());
+  return Data;
+}
+
+
+//------------------------------------------------------------------------------
+// readArray (FtsFloatArray &) : Reads an array of floats written by
+// writeArray (). If the file has been mapped, a only records where the values
+// are, and they are not read until they are needed.
+//
+void FtsReader::readArray (FtsFloatArray &a) throw (Error) {
+  unsigned int Size = readUInt ();
+  uint64_t Length = uint64_t (Size) * sizeof (float);
+  check (Length);
+  if (File != NULL) {
+    uint64_t Position = In -> tellg ();
+    a = FtsFloatArray (File, Position, Size);
+    In -> seekg (Position + Length);
+  } else {
+    a.clear ();
+    a.values ().resize (Size);
+    if (Size > 0) read (&a.values ()[0], Length);
+  }
+}
@@ -0,0 +1,177 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// FtsWriter and FtsReader classes (ftsfile.h)
+//==============================================================================
+// From FTS_FILE_VERSION 4, a FAST project file is divided into sections. The
+// file starts with the file version and the offset of the section table, which
+// is written at the end of the file once the size of every section is known:
+//
+//   unsigned int  FileVersion
+//   uint64_t      Offset of the section table
+//   ...           Section data
+//   unsigned int  Number of sections
+//   FtsSection    Section table entries
+//
+// Each entry in the table gives the type of a section, the spectrum and line
+// list it belongs to (where relevant), and its offset and length in bytes. A
+// reader can therefore go straight to the section it needs. Within a section,
+// arrays are written in a single call as a count followed by the raw elements,
+// and strings as a length followed by their characters.
+//
+// FtsWriter and FtsReader only deal with this layout. The contents of each
+// section are defined by ProjectFile (see projectfile.cpp).
+//
+// Large float arrays, such as the points of a spectrum, can be read as an
+// FtsFloatArray rather than copied into memory straight away. Where possible
+// the reader maps the whole file into memory, and each FtsFloatArray keeps a
+// reference to that mapping until its values are copied out with read (). The
+// mapping stays valid even if the file is later replaced by a new save, since
+// the project file is always written to a temporary file and then renamed.
+// While the file is mapped, every other read is also copied from the mapping
+// rather than going through the stream.
+//
+#ifndef FTS_FILE_H
+#define FTS_FILE_H
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <glib.h>
+#include "ErrDefs.h"
+
+using namespace::std;
+
+// Section types
+#define FTS_SECTION_KURUCZ     1
+#define FTS_SECTION_SPECTRUM   2
+#define FTS_SECTION_LINES      3
+#define FTS_SECTION_LINKS      4
+#define FTS_SECTION_INTERFACE  5
+#define FTS_SECTION_PROFILES   6
+#define FTS_SECTION_SOURCE     7  // Only used in InputCache entries
+#define FTS_SECTION_LEVELS     8  // Likewise
+#define FTS_SECTION_FIT_ERRORS 9  // Uncertainties of refitted lines
+
+// An entry in the section table
+typedef struct fts_section {
+  unsigned int Type;
+  unsigned int Spectrum;     // Index of the spectrum, if any
+  unsigned int List;         // Index of the line list within the spectrum
+  unsigned int Reserved;
+  uint64_t Offset;           // From the start of the file
+  uint64_t Length;
+} FtsSection;
+
+// A float array in a project file. Copies of an FtsFloatArray share the same
+// mapping of the file. If the file could not be mapped, the values are held in
+// Values instead.
+class FtsFloatArray {
+
+  private:
+    GMappedFile *File;
+    uint64_t Offset;         // Of the first value, from the start of the file
+    unsigned int Count;
+    vector <float> Values;
+
+  public:
+    FtsFloatArray ();
+    FtsFloatArray (GMappedFile *FileIn, uint64_t OffsetIn, unsigned int CountIn);
+    FtsFloatArray (const FtsFloatArray &a);
+    FtsFloatArray &operator= (const FtsFloatArray &a);
+    ~FtsFloatArray ();
+
+    unsigned int size () { return File != NULL ? Count : Values.size (); }
+    vector <float> &values () { return Values; }
+    uint64_t bytes () { return Values.capacity () * sizeof (float); }
+    const float *data ();
+    void read (vector <float> &a);
+    void read (vector <float> &a, unsigned int First, unsigned int Num);
+    void clear ();
+};
+
+class FtsWriter {
+
+  private:
+    ostream *Out;
+    vector <FtsSection> Sections;
+    streampos Start;
+
+  public:
+    // Writes the file version and space for the table offset to OutIn
+    FtsWriter (ostream *OutIn, unsigned int FileVersion);
+    ~FtsWriter () { }
+
+    void beginSection (unsigned int Type, unsigned int Spectrum = 0,
+      unsigned int List = 0);
+    void endSection ();
+    void finish ();  // Writes the section table
+
+    void write (const void *Data, size_t Size) { Out -> write ((const char *)Data, Size); }
+    void writeUInt (unsigned int a) { write (&a, sizeof (unsigned int)); }
+    void writeDouble (double a) { write (&a, sizeof (double)); }
+    void writeBool (bool a) { write (&a, sizeof (bool)); }
+    void writeString (const string &a);
+    void writeStrings (const vector <string> &a);
+    template <class T> void writeArray (const vector <T> &a) {
+      writeUInt (a.size ());
+      if (a.size () > 0) write (&a[0], sizeof (T) * a.size ());
+    }
+    void writeArray (FtsFloatArray &a);
+};
+
+class FtsReader {
+
+  private:
+    istream *In;
+    GMappedFile *File;       // The whole file, or NULL if it was not mapped
+    vector <FtsSection> Sections;
+    uint64_t End;            // Offset of the end of the current section
+
+    void check (uint64_t Size) throw (Error);
+
+  public:
+    // Reads the section table. The file version must already have been read.
+    // If Filename is given, the file is also mapped into memory for use by
+    // readArray (FtsFloatArray &).
+    FtsReader (istream *InIn, string Filename = "") throw (Error);
+    ~FtsReader ();
+
+    unsigned int numSections () { return Sections.size (); }
+    FtsSection section (unsigned int i) { return Sections[i]; }
+    uint64_t fileSize ();
+    void seek (FtsSection &Section);
+
+    void read (void *Data, size_t Size) throw (Error);
+    unsigned int readUInt () throw (Error);
+    double readDouble () throw (Error);
+    bool readBool () throw (Error);
+    string readString () throw (Error);
+    vector <string> readStrings () throw (Error);
+    vector <char> readRemainder () throw (Error);
+    void readArray (FtsFloatArray &a) throw (Error);
+    template <class T> void readArray (vector <T> &a) throw (Error) {
+      unsigned int Size = readUInt ();
+      check (uint64_t (Size) * sizeof (T));
+      a.resize (Size);
+      if (Size > 0) read (&a[0], sizeof (T) * Size);
+    }
+};
+
+#endif // FTS_FILE_H
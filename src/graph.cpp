@@ -19,31 +19,33 @@
 //==============================================================================
 
 #include "graph.h"
+#include "trace.h"
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 
 //==============================================================================
 // CONSTRUCTORS / DESTRUCTORS
 //==============================================================================
 
-Graph::Graph () {
+unsigned long GraphData::LastRevision = 0;
+
+GraphData::GraphData () {
   GraphMin.x = 0.0; GraphMin.y = 0.0;
   GraphMax.x = 0.0; GraphMax.y = 0.0;
-  Selected = false;
-  Disabled = false;
-  Hidden = false;
+  HasMin = HasMax = false;
   AutoLimits = false;
+  changed ();
 }
 
 
-Graph::Graph (XgLine LineIn, vector <Coord> Points) {
-  GraphMin.x = 0.0; GraphMin.y = 0.0;
-  GraphMax.x = 0.0; GraphMax.y = 0.0;
+Graph::Graph () {
+  Data = NULL;
   Selected = false;
   Disabled = false;
   Hidden = false;
-  AutoLimits = false;
-  addPlot (LineIn, Points);
+  DecimatedWidth = DecimatedHeight = 0;
+  DecimatedRevision = SurfaceRevision = 0;
 }
 
 
@@ -62,9 +64,10 @@ Graph::~Graph () {
 //
 bool Graph::on_expose_event(GdkEventExpose* event)
 {
+  TRACE_SCOPE ("Graph::on_expose_event");
   // This is where we draw on the window
   Glib::RefPtr<Gdk::Window> window = get_window();
-  if (window && Plots.size () > 0 && !Hidden) {
+  if (window && Data && Data -> Plots.size () > 0 && !Hidden) {
     Gtk::Allocation allocation = get_allocation();
     const int width = allocation.get_width();
     const int height = allocation.get_height();
@@ -73,9 +76,8 @@ bool Graph::on_expose_event(GdkEventExpose* event)
     cr->rectangle(event->area.x, event->area.y, event->area.width, event->area.height);
     cr->clip ();
     
-    // Draw the graph border
-    cr->set_line_width(BORDER_WIDTH);
-    cr->save ();
+    // Fill the graph background with the colour showing whether the graph is
+    // selected or disabled. This is all that changes when the state does.
     cr->rectangle (GRAPH_PAD_LEFT, GRAPH_PAD_TOP, 
       width - TOTAL_X_PAD, height - TOTAL_Y_PAD);
     if (Selected) {
@@ -85,34 +87,140 @@ bool Graph::on_expose_event(GdkEventExpose* event)
       if (Disabled) cr -> set_source_rgb(COLOUR_DISABLED);
       else cr -> set_source_rgb(COLOUR_BACK);
     }
-    cr->fill_preserve ();
-    cr->restore ();
-    cr->stroke ();
-    
-    // Draw the tic marks on the graph
-    drawXTicMarks (cr, height, width);
-    drawYTicMarks (cr, height, width);
-    
-    // Plot the data
-    for (unsigned int i = 0; i < Plots.size (); i ++) {
-      cr->set_line_width(LineWidths[i]);
-      cr->set_source_rgb(LineColours[i].r, LineColours[i].g, LineColours[i].b);
-      cr->move_to ((Plots[i][0].x - GraphMin.x) / (GraphMax.x - GraphMin.x) * (width - TOTAL_X_PAD) + GRAPH_PAD_LEFT, 
-        height - ((Plots[i][0].y - GraphMin.y) / (GraphMax.y - GraphMin.y) * (height - TOTAL_Y_PAD) + GRAPH_PAD_BOTTOM));
-      
-      for (unsigned int j = 0; j < Plots[i].size (); j ++) {
-        cr->line_to ((Plots[i][j].x - GraphMin.x) / (GraphMax.x - GraphMin.x) * (width - TOTAL_X_PAD) + GRAPH_PAD_LEFT, 
-          height - ((Plots[i][j].y - GraphMin.y) / (GraphMax.y - GraphMin.y) * (height - TOTAL_Y_PAD) + GRAPH_PAD_BOTTOM));
-      }
-      cr->stroke ();
+    cr->fill ();
+
+    // Everything else is drawn over it from the cached surface
+    render (height, width);
+    if (Surface) {
+      cr->set_source (Surface, 0, 0);
+      cr->paint ();
     }
-    drawText (cr, height, width);
   }
   
   return true;
 }
 
 
+//------------------------------------------------------------------------------
+// render (const int, const int) : Draws the border, tic marks, plots and text of
+// the graph into Surface, on a transparent background, unless Surface is
+// already up to date for a graph of this size. Any change to the plots, text
+// or limits gives Data a new revision, which makes Surface stale.
+//
+void Graph::render (const int height, const int width) {
+  if (width <= 0 || height <= 0) return;
+  if (Surface && SurfaceRevision == Data -> Revision
+    && Surface -> get_width () == width
+    && Surface -> get_height () == height) return;
+  vector <int> &LineWidths = Data -> LineWidths;
+  vector <GraphColour> &LineColours = Data -> LineColours;
+
+  Surface = Cairo::ImageSurface::create (Cairo::FORMAT_ARGB32, width, height);
+  Cairo::RefPtr<Cairo::Context> cr = Cairo::Context::create (Surface);
+
+  // Draw the graph border
+  cr->set_line_width(BORDER_WIDTH);
+  cr->rectangle (GRAPH_PAD_LEFT, GRAPH_PAD_TOP, 
+    width - TOTAL_X_PAD, height - TOTAL_Y_PAD);
+  cr->stroke ();
+
+  // Draw the tic marks on the graph
+  drawXTicMarks (cr, height, width);
+  drawYTicMarks (cr, height, width);
+
+  // Plot the data
+  decimate (height, width);
+  for (unsigned int i = 0; i < Decimated.size (); i ++) {
+    if (Decimated[i].size () == 0) continue;
+    cr->set_line_width(LineWidths[i]);
+    cr->set_source_rgb(LineColours[i].r, LineColours[i].g, LineColours[i].b);
+    cr->move_to (Decimated[i][0].x, Decimated[i][0].y);
+    for (unsigned int j = 1; j < Decimated[i].size (); j ++) {
+      cr->line_to (Decimated[i][j].x, Decimated[i][j].y);
+    }
+    cr->stroke ();
+  }
+  drawText (cr, height, width);
+  SurfaceRevision = Data -> Revision;
+}
+
+
+//------------------------------------------------------------------------------
+// drawLayout (Cairo::RefPtr<Cairo::Context>, Glib::RefPtr<Pango::Layout>,
+// double, double) : Draws the text in layout with its top left corner at (x, y)
+// in the normal text colour of the widget.
+//
+void Graph::drawLayout (Cairo::RefPtr<Cairo::Context> cr,
+  Glib::RefPtr<Pango::Layout> layout, double x, double y) {
+  Gdk::Color Colour = get_style () -> get_text (Gtk::STATE_NORMAL);
+  cr -> save ();
+  cr -> set_source_rgb (Colour.get_red_p (), Colour.get_green_p (),
+    Colour.get_blue_p ());
+  cr -> move_to (x, y);
+  layout -> show_in_cairo_context (cr);
+  cr -> new_path ();
+  cr -> restore ();
+}
+
+
+//------------------------------------------------------------------------------
+// decimate (const int, const int) : Fills Decimated with the plots in pixel
+// coordinates for a graph of the given size. Within each pixel column only the
+// first, lowest, highest and last points are kept, in their original order, so
+// the drawn line covers the same pixels as one through every point. Nothing is
+// done if Decimated is already up to date.
+//
+void Graph::decimate (const int height, const int width) {
+  if (DecimatedRevision == Data -> Revision && DecimatedWidth == width
+    && DecimatedHeight == height) return;
+  vector < vector <Coord> > &Plots = Data -> Plots;
+  Coord GraphMin = Data -> GraphMin, GraphMax = Data -> GraphMax;
+
+  // Precompute the transform from data to pixel coordinates
+  double ScaleX = (width - TOTAL_X_PAD) / (GraphMax.x - GraphMin.x);
+  double OffsetX = GRAPH_PAD_LEFT - GraphMin.x * ScaleX;
+  double ScaleY = - (height - TOTAL_Y_PAD) / (GraphMax.y - GraphMin.y);
+  double OffsetY = height - GRAPH_PAD_BOTTOM - GraphMin.y * ScaleY;
+
+  Decimated.resize (Plots.size ());
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    vector <Coord> &Out = Decimated[i];
+    Out.clear ();
+    if (Plots[i].size () == 0) continue;
+
+    // Points in the current column, as indices into Plots[i]
+    unsigned int First = 0, Lowest = 0, Highest = 0, Last = 0;
+    double Column = floor (Plots[i][0].x * ScaleX + OffsetX);
+    for (unsigned int j = 0; j <= Plots[i].size (); j ++) {
+      double NextColumn = j < Plots[i].size () ?
+        floor (Plots[i][j].x * ScaleX + OffsetX) : Column + 1.0;
+      if (j > 0 && NextColumn == Column) {
+        if (Plots[i][j].y < Plots[i][Lowest].y) Lowest = j;
+        if (Plots[i][j].y > Plots[i][Highest].y) Highest = j;
+        Last = j;
+        continue;
+      }
+
+      // Write out the column just finished, unless this is the first point
+      if (j > 0) {
+        unsigned int Keep[4] = { First, std::min (Lowest, Highest),
+          std::max (Lowest, Highest), Last };
+        for (unsigned int k = 0; k < 4; k ++) {
+          if (k > 0 && Keep[k] == Keep[k - 1]) continue;
+          Out.push_back (Coord (Plots[i][Keep[k]].x * ScaleX + OffsetX,
+            Plots[i][Keep[k]].y * ScaleY + OffsetY));
+        }
+      }
+      First = Lowest = Highest = Last = j;
+      Column = NextColumn;
+    }
+  }
+  DecimatedWidth = width;
+  DecimatedHeight = height;
+  DecimatedRevision = Data -> Revision;
+}
+
+
 //------------------------------------------------------------------------------
 // drawXTicMarks (Cairo::RefPtr<Cairo::Context>, const int, const int) :
 // Calculates the optimal location of the X tic marks given the range of data to
@@ -122,6 +230,8 @@ bool Graph::on_expose_event(GdkEventExpose* event)
 void Graph::drawXTicMarks (Cairo::RefPtr<Cairo::Context> cr, 
   const int height, const int width) {
   
+  vector < vector <Coord> > &Plots = Data -> Plots;
+  Coord GraphMin = Data -> GraphMin, GraphMax = Data -> GraphMax;
   vector <double> XTics;
   vector <string> Labels;
   int Order;
@@ -177,9 +287,8 @@ void Graph::drawXTicMarks (Cairo::RefPtr<Cairo::Context> cr,
   for (unsigned int i = 0; i < Labels.size (); i ++) {
     layout -> set_text (Labels [i]);
     layout -> get_pixel_size (TxtWidth, TxtHeight);
-    get_window () ->draw_layout(get_style()->get_text_gc(Gtk::STATE_NORMAL), 
-      GRAPH_PAD_LEFT + XTics[i] - TxtWidth / 2.0, 
-      height - GRAPH_PAD_BOTTOM, layout);
+    drawLayout (cr, layout, GRAPH_PAD_LEFT + XTics[i] - TxtWidth / 2.0,
+      height - GRAPH_PAD_BOTTOM);
   }
 }
 
@@ -192,6 +301,7 @@ void Graph::drawXTicMarks (Cairo::RefPtr<Cairo::Context> cr,
 //
 void Graph::drawYTicMarks (Cairo::RefPtr<Cairo::Context> cr, 
   const int height, const int width) {
+  Coord GraphMin = Data -> GraphMin, GraphMax = Data -> GraphMax;
   vector <double> YTics;
   
   // Set a nominal tic spacing based on the order of magnitude of PlotYRange
@@ -256,14 +366,15 @@ void Graph::drawYTicMarks (Cairo::RefPtr<Cairo::Context> cr,
     oss << ((int) i - YTicsZeroPos) * YTicSpacing;
     layout -> set_text (oss.str());
     layout -> get_pixel_size (TxtWidth, TxtHeight);
-    get_window () ->draw_layout(get_style()->get_text_gc(Gtk::STATE_NORMAL), 
-      GRAPH_PAD_LEFT - TxtWidth - 5, YTics[i] - TxtHeight / 2.0, layout);
+    drawLayout (cr, layout, GRAPH_PAD_LEFT - TxtWidth - 5,
+      YTics[i] - TxtHeight / 2.0);
   }
 }
 
 
 void Graph::drawText (Cairo::RefPtr<Cairo::Context> cr,
 		  const int height, const int width) {
+	vector <Label> &Labels = Data -> Labels;
 	Glib::RefPtr<Pango::Context> lc = create_pango_context();
 	Glib::RefPtr<Pango::Layout> layout = Pango::Layout::create (lc);
 	ostringstream oss;
@@ -271,7 +382,7 @@ void Graph::drawText (Cairo::RefPtr<Cairo::Context> cr,
 	layout -> set_font_description(Pango::FontDescription (oss.str().c_str()));
 	for (unsigned int i = 0; i < Labels.size (); i ++) {
 		layout -> set_text (Labels[i].text);
-		get_window () -> draw_layout(get_style() -> get_text_gc(Gtk::STATE_NORMAL), Labels[i].x, Labels[i].y, layout);
+		drawLayout (cr, layout, Labels[i].x, Labels[i].y);
 	}
 }
 
@@ -286,7 +397,7 @@ void Graph::drawText (Cairo::RefPtr<Cairo::Context> cr,
 // plot the line.
 //
 
-void Graph::addPlot (XgLine LineIn, vector <Coord> AscLines, 
+void GraphData::addPlot (XgLine LineIn, vector <Coord> AscLines, 
   bool IncludeInMinima, bool IncludeInMaxima) {
   unsigned int XStart = 0;
   unsigned int XEnd = 0;
@@ -330,8 +441,8 @@ void Graph::addPlot (XgLine LineIn, vector <Coord> AscLines,
     }
   }
   Plots.push_back (Plot);
-  if (IncludeInMinima) Minima.push_back (Min);
-  if (IncludeInMaxima) Maxima.push_back (Max);
+  changed ();
+  includeInLimits (Min, Max, IncludeInMinima, IncludeInMaxima);
   LineWidths.push_back (DEF_PLOT_WIDTH);
   LineColours.push_back (GraphColour (DEF_PLOT_COLOUR));
   setAutoLimits ();
@@ -342,11 +453,12 @@ void Graph::addPlot (XgLine LineIn, vector <Coord> AscLines,
 // addPlot (vector <Coord>) : Adds a plot containing ALL the data points listed
 // in the coordinates vector at arg1.
 //
-void Graph::addPlot (vector <Coord> NewPlot, bool IncludeInMinima, 
+void GraphData::addPlot (vector <Coord> NewPlot, bool IncludeInMinima, 
   bool IncludeInMaxima) {
   Coord Min, Max;
 
   Plots.push_back (NewPlot);
+  changed ();
   Min.x = NewPlot[0].x; 
   Min.y = NewPlot[0].y;
   Max.x = NewPlot[NewPlot.size () - 1].x; 
@@ -357,24 +469,50 @@ void Graph::addPlot (vector <Coord> NewPlot, bool IncludeInMinima,
     if (NewPlot[i].x < Min.x) Min.x = NewPlot[i].x;
     if (NewPlot[i].y < Min.y) Min.y = NewPlot[i].y;
   }
-  if (IncludeInMinima) Minima.push_back (Min);
-  if (IncludeInMaxima) Maxima.push_back (Max);
+  includeInLimits (Min, Max, IncludeInMinima, IncludeInMaxima);
   LineWidths.push_back (DEF_PLOT_WIDTH);
   LineColours.push_back (GraphColour (DEF_PLOT_COLOUR));
   setAutoLimits ();
 }
 
 
-void Graph::addText (double x, double y, string textIn) {
+void GraphData::addText (double x, double y, string textIn) {
 	Label newLabel;
 	newLabel.x = x;
 	newLabel.y = y;
 	newLabel.text = textIn;
 	Labels.push_back (newLabel);
+	changed ();
 }
 
 
-vector <Coord> Graph::getPlotData (int i) throw (int) { 
+//------------------------------------------------------------------------------
+// bytes () : Returns the memory used by the plots
+//
+unsigned long GraphData::bytes () {
+  unsigned long Bytes = sizeof (GraphData);
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    Bytes += Plots[i].capacity () * sizeof (Coord);
+  }
+  return Bytes;
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the memory used by the graph and its cached drawing, but
+// not by the data it plots
+//
+unsigned long Graph::bytes () {
+  unsigned long Bytes = sizeof (Graph);
+  for (unsigned int i = 0; i < Decimated.size (); i ++) {
+    Bytes += Decimated[i].capacity () * sizeof (Coord);
+  }
+  if (Surface) Bytes += Surface -> get_stride () * Surface -> get_height ();
+  return Bytes;
+}
+
+
+vector <Coord> GraphData::getPlotData (int i) throw (int) { 
   if (i >= 0) {
     if (i < (int) Plots.size ()) {
       return Plots [i]; 
@@ -387,35 +525,79 @@ vector <Coord> Graph::getPlotData (int i) throw (int) {
 }
 
 //------------------------------------------------------------------------------
-// setAutoLimits ()
+// includeInLimits (Coord, Coord, bool, bool) : Extends the extent of the plots
+// used by setAutoLimits () to cover the minimum and maximum of a new plot.
 //
-void Graph::setAutoLimits () {
-  if (Minima.size () > 0 && Maxima.size () > 0) {
-    GraphMin = Minima[0];
-    for (unsigned int i = 0; i < Minima.size (); i ++) {
-      if (Minima[i].x < GraphMin.x) GraphMin.x = Minima[i].x;
-      if (Minima[i].y < GraphMin.y) GraphMin.y = Minima[i].y;
-    }
-    GraphMax = Maxima[0];
-    for (unsigned int i = 0; i < Maxima.size (); i ++) {
-      if (Maxima[i].x > GraphMax.x) GraphMax.x = Maxima[i].x;
-      if (Maxima[i].y > GraphMax.y) GraphMax.y = Maxima[i].y;
-    }
-    GraphMax.y /= Y_GRAPH_ZOOM;
-    GraphMin.y /= Y_GRAPH_ZOOM;
-    AutoLimits = true;
+void GraphData::includeInLimits (Coord Min, Coord Max, bool IncludeInMinima,
+  bool IncludeInMaxima) {
+  if (IncludeInMinima) {
+    if (!HasMin || Min.x < PlotsMin.x) PlotsMin.x = Min.x;
+    if (!HasMin || Min.y < PlotsMin.y) PlotsMin.y = Min.y;
+    HasMin = true;
+  }
+  if (IncludeInMaxima) {
+    if (!HasMax || Max.x > PlotsMax.x) PlotsMax.x = Max.x;
+    if (!HasMax || Max.y > PlotsMax.y) PlotsMax.y = Max.y;
+    HasMax = true;
   }
 }
 
 
+//------------------------------------------------------------------------------
+// limits (Coord, Coord) : Sets both corners of the plotted area. Returns true
+// if they have changed, in which case the graph must be redrawn.
+//
+bool GraphData::limits (Coord NewMin, Coord NewMax) {
+  AutoLimits = false;
+  if (NewMin.x == GraphMin.x && NewMin.y == GraphMin.y
+    && NewMax.x == GraphMax.x && NewMax.y == GraphMax.y) return false;
+  GraphMin = NewMin;
+  GraphMax = NewMax;
+  changed ();
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// naturalLimits (Coord &, Coord &) : Sets Min and Max to the limits that
+// setAutoLimits () would give the graph. Returns false if there are none.
+//
+bool GraphData::naturalLimits (Coord &Min, Coord &Max) {
+  if (!HasMin || !HasMax) return false;
+  Min = PlotsMin;
+  Max = PlotsMax;
+  Max.y /= Y_GRAPH_ZOOM;
+  Min.y /= Y_GRAPH_ZOOM;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// setAutoLimits () : Fits the plotted area to the plots. Returns true if the
+// limits have changed, in which case the graph must be redrawn.
+//
+bool GraphData::setAutoLimits () {
+  Coord Min, Max;
+  if (!naturalLimits (Min, Max)) return false;
+  AutoLimits = true;
+  if (Min.x == GraphMin.x && Min.y == GraphMin.y
+    && Max.x == GraphMax.x && Max.y == GraphMax.y) return false;
+  GraphMin = Min;
+  GraphMax = Max;
+  changed ();
+  return true;
+}
+
+
 //------------------------------------------------------------------------------
 // setWidth (int, float) : Sets the brush width of the ith plot to the value
 // passed in at arg2.
 //
-void Graph::setWidth (int Index, float nWidth) {
+void GraphData::setWidth (int Index, float nWidth) {
   if (Index >= 0 && (unsigned int) Index < LineWidths.size ()) {
     if (nWidth > 0.0) {
       LineWidths[Index] = nWidth;
+      changed ();
     }
   }
 }
@@ -425,10 +607,11 @@ void Graph::setWidth (int Index, float nWidth) {
 // setColour () : Sets the colour of the ith plot to the r,g,b values passed in
 // at args 2 to 4.
 //
-void Graph::setColour (int Index, float nr, float ng, float nb) {
+void GraphData::setColour (int Index, float nr, float ng, float nb) {
   if (Index >= 0 && (unsigned int) Index < LineColours.size ()) {
     if (nr >=0.0 && nr <=1.0 && ng >=0.0 && ng <=1.0 && nb >=0.0 && nb <=1.0) {
       LineColours[Index] = GraphColour (nr, ng, nb);
+      changed ();
     }
   }
 }
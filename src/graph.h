@@ -18,7 +18,8 @@
 // Graph class (graph.h)
 //==============================================================================
 // GtkGraph inherits Gtk::DrawingArea and uses its functionality to display
-// simple 2-D line plots. 
+// simple 2-D line plots. The plots themselves are held in a GraphData object,
+// so that they can be kept for lines that are not currently on screen.
 
 #ifndef GRAPH_H
 #define GRAPH_H
@@ -27,11 +28,14 @@
 #include <gtkmm/eventbox.h>
 #include <gtkmm/label.h>
 #include <gtkmm/drawingarea.h>
+#include <cairomm/surface.h>
+#include <pangomm/layout.h>
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <vector>
 #include "xgline.h"
+#include "CoreDefs.h"
 
 using namespace::std;
 
@@ -65,23 +69,11 @@ using namespace::std;
 #define Y_GRAPH_ZOOM     0.94
 #define FONT_SIZE        (int)(12 * ZOOM_FACTOR)
 
-#define PLOT_WIDTH_RANGE 0.004
-#define XGREMLIN_COMMENT '!'
-
 #define ERR_GRAPH_INDEX_TOO_LOW  -1
 
 //------------------------------------------------------------------------------
 // Type definitions
 //
-typedef struct td_coord {
-  double x;
-  double y;
-  
-  td_coord () { x = 0.0; y = 0.0; }
-  td_coord (double nx, double ny) { x = nx; y = ny; }
-  
-} Coord;
-
 typedef struct td_label {
 	double x;
 	double y;
@@ -99,23 +91,93 @@ typedef struct graph_colour {
 } GraphColour;
 
 //------------------------------------------------------------------------------
-// Class definition
+// Class definitions
 //
-class Graph : public Gtk::DrawingArea {
+
+// The plots, text and limits shown by a Graph. These hold no GTK+ objects, so
+// a project can keep one for every line it has loaded, and any Graph can be
+// pointed at them to draw them.
+class GraphData {
+
+  friend class Graph;
 
 private:
   vector < vector <Coord> > Plots;
-  vector <Coord> Minima, Maxima;
+  Coord PlotsMin, PlotsMax;  // Extent of the plots included in the limits,
+  bool HasMin, HasMax;       // extended as each plot is added
   vector <int> LineWidths;
   vector <GraphColour> LineColours;
   Coord GraphMin, GraphMax;
-  string XLabel, YLabel;
   vector <Label> Labels;
+  bool AutoLimits;  // true if limits were last set by setAutoLimits()
+
+  // Set to a new value by every change, so that a Graph can tell whether the
+  // data it last drew is still current. Values are never reused, even by
+  // different GraphData objects.
+  unsigned long Revision;
+  static unsigned long LastRevision;
+  void changed () { Revision = ++ LastRevision; }
+  void includeInLimits (Coord Min, Coord Max, bool IncludeInMinima,
+    bool IncludeInMaxima);
+
+public:
+  GraphData ();
+  ~GraphData () { /* Does nothing */ }
+
+  void addPlot (XgLine LineIn, vector <Coord> AscLines, 
+    bool IncludeInMinima = true, bool IncludeInMaxima = true);
+  void addPlot (vector <Coord> NewPlot, bool IncludeInMinima = true, 
+    bool IncludeInMaxima = true);
+  void addText (double x, double y, string textIn);
+  void clearText () { Labels.clear(); changed (); }
+  void clearPlots () { Plots.clear (); HasMin = HasMax = false;
+    LineWidths.clear (); LineColours.clear (); changed (); }
+  void max (Coord NewMax) { GraphMax = NewMax; AutoLimits = false;
+    changed (); }
+  void min (Coord NewMin) { GraphMin = NewMin; AutoLimits = false;
+    changed (); }
+  Coord max () { return GraphMax; }
+  Coord min () { return GraphMin; }
+  void setWidth (int Index, float nWidth);
+  void setColour (int Index, float nr, float ng, float nb);
+  bool limits (Coord NewMin, Coord NewMax);
+  bool naturalLimits (Coord &Min, Coord &Max);
+  bool setAutoLimits ();
+  bool autoLimits () { return AutoLimits; }
+  int numPlots () { return Plots.size (); }
+  unsigned long revision () { return Revision; }
+  unsigned long bytes ();
+  vector <Coord> getPlotData (int i) throw (int);
+};
+
+// Draws a GraphData. The data is not owned by the Graph, and may be replaced
+// at any time with data ().
+class Graph : public Gtk::DrawingArea {
+
+private:
+  GraphData *Data;  // NULL if there is nothing to draw
   bool Selected;    // true if the graph is currently selected
   bool Disabled;    // true if the graph is currently disabled
   bool Hidden;		// true if the graph is currently hidden from view
-  bool AutoLimits;  // true if limits were last set by setAutoLimits()
-  
+
+  // The plots in pixel coordinates, reduced to at most four points in each
+  // pixel column. These are only rebuilt when the data or size of the graph
+  // change, so the cost of a redraw depends on its width rather than on the
+  // number of data points.
+  vector < vector <Coord> > Decimated;
+  int DecimatedWidth, DecimatedHeight;
+  unsigned long DecimatedRevision;
+
+  // The border, tic marks, plots and text, drawn over the background colour of
+  // the graph on each expose. The background alone shows whether the graph is
+  // selected or disabled, so changing either does not redraw Surface.
+  Cairo::RefPtr<Cairo::ImageSurface> Surface;
+  unsigned long SurfaceRevision;  // Data -> Revision when Surface was drawn
+
+  void decimate (const int height, const int width);
+  void render (const int height, const int width);
+  void drawLayout (Cairo::RefPtr<Cairo::Context> cr,
+    Glib::RefPtr<Pango::Layout> layout, double x, double y);
   void drawXTicMarks (Cairo::RefPtr<Cairo::Context> cr, const int height, const int width);
   void drawYTicMarks (Cairo::RefPtr<Cairo::Context> cr, const int height, const int width);
   void drawText (Cairo::RefPtr<Cairo::Context> cr, const int height, const int width);
@@ -126,28 +188,14 @@ protected:
 
 public:
   Graph ();
-  Graph (XgLine LineIn, vector <Coord> Points);
   virtual ~Graph ();
 
-  void addPlot (XgLine LineIn, vector <Coord> AscLines, 
-    bool IncludeInMinima = true, bool IncludeInMaxima = true);
-  void addPlot (vector <Coord> NewPlot, bool IncludeInMinima = true, 
-    bool IncludeInMaxima = true);
-  void addText (double x, double y, string textIn);
-  void clearText () { Labels.clear(); }
-  void max (Coord NewMax) { GraphMax = NewMax; AutoLimits = false; }
-  void min (Coord NewMin) { GraphMin = NewMin; AutoLimits = false; }
-  Coord max () { return GraphMax; }
-  Coord min () { return GraphMin; }
+  void data (GraphData *DataIn) { Data = DataIn; queue_draw (); }
+  GraphData *data () { return Data; }
   void select (bool a) { Selected = a; queue_draw (); }
   void disable (bool a) { Selected = false; Disabled = a; queue_draw (); }
   void hide (bool a) { Hidden = a; queue_draw (); }
-  void setWidth (int Index, float nWidth);
-  void setColour (int Index, float nr, float ng, float nb);
-  void setAutoLimits ();
-  bool autoLimits () { return AutoLimits; }
-  int numPlots () { return Plots.size (); }
-  vector <Coord> getPlotData (int i) throw (int);
+  unsigned long bytes ();
 };
 
 #endif // GRAPH_H
@@ -0,0 +1,590 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// InputCache class (inputcache.cpp)
+//==============================================================================
+#include "inputcache.h"
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+using namespace::std;
+
+#define INPUT_CACHE_HASH_BLOCK 1048576 /* bytes */
+
+// A file in the cache directory, as listed by trim ()
+typedef struct input_cache_file {
+  string Path;
+  uint64_t Size;
+  int64_t Time;
+
+  bool operator< (const input_cache_file &a) const { return Time < a.Time; }
+} InputCacheFile;
+
+//==============================================================================
+// CONSTRUCTORS AND DESTRUCTORS
+//==============================================================================
+
+InputCache::InputCache () {
+  Directory = "";
+  Limit = 0;
+  Serial = 0;
+}
+
+
+//==============================================================================
+// PRIVATE FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// hashBytes (uint64_t &, const char *, size_t) : Adds Size bytes to Hash. Whole
+// 64 bit words are folded in at a time, which is enough to tell whether a file
+// has changed and much quicker than hashing one byte at a time.
+//
+static void hashBytes (uint64_t &Hash, const char *Bytes, size_t Size) {
+  uint64_t Word;
+  size_t i = 0;
+  for (; i + sizeof (uint64_t) <= Size; i += sizeof (uint64_t)) {
+    memcpy (&Word, Bytes + i, sizeof (uint64_t));
+    Hash ^= Word;
+    Hash *= 1099511628211ULL;
+  }
+  for (; i < Size; i ++) {
+    Hash ^= (unsigned char)Bytes[i];
+    Hash *= 1099511628211ULL;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// hashFile (string, uint64_t &) : Sets Hash to the hash of the contents of
+// Filename. Returns false if the file cannot be read.
+//
+static bool hashFile (string Filename, uint64_t &Hash) {
+  vector <char> Block (INPUT_CACHE_HASH_BLOCK);
+  size_t Read;
+  FILE *In = fopen (Filename.c_str (), "rb");
+  if (In == NULL) return false;
+  Hash = 14695981039346656037ULL;
+  while ((Read = fread (&Block[0], 1, Block.size (), In)) > 0) {
+    hashBytes (Hash, &Block[0], Read);
+  }
+  bool Failed = ferror (In) != 0;
+  fclose (In);
+  return !Failed;
+}
+
+
+//------------------------------------------------------------------------------
+// canonical (string) : Returns the absolute path of Filename with any symbolic
+// links, "." and ".." resolved, so that every name for a file gives the same
+// cache entry. Filename is returned unchanged if it cannot be resolved.
+//
+static string canonical (string Filename) {
+#ifdef _WIN32
+  char Path [_MAX_PATH];
+  if (_fullpath (Path, Filename.c_str (), _MAX_PATH) != NULL) return Path;
+#else
+  char *Path = realpath (Filename.c_str (), NULL);
+  if (Path != NULL) {
+    string Resolved = Path;
+    free (Path);
+    return Resolved;
+  }
+#endif
+  return Filename;
+}
+
+
+//------------------------------------------------------------------------------
+// entry (string, unsigned int) : Returns the path of the cache entry for the
+// source file Filename of the given Kind. Filename must be canonical.
+//
+string InputCache::entry (string Filename, unsigned int Kind) {
+  ostringstream oss;
+  uint64_t Hash = 14695981039346656037ULL;
+  hashBytes (Hash, (const char *)&Kind, sizeof (unsigned int));
+  hashBytes (Hash, Filename.data (), Filename.size ());
+  oss << directory () << "/" << hex << setw (16) << setfill ('0') << Hash
+    << INPUT_CACHE_EXTENSION;
+  return oss.str ();
+}
+
+
+//------------------------------------------------------------------------------
+// temporary (string) : Returns a unique name for the temporary file that a new
+// version of Entry is written to before it is renamed into place.
+//
+string InputCache::temporary (string Entry) {
+  ostringstream oss;
+  Glib::Mutex::Lock lock (CacheMutex);
+  oss << Entry << ".tmp" << Serial ++;
+  return oss.str ();
+}
+
+
+//------------------------------------------------------------------------------
+// stamp (string, unsigned int, double, InputCacheSource &, bool) : Fills a with
+// the details of the source file Filename. The contents of the file are only
+// hashed if Hash is true. Returns false if the cache is disabled or the file
+// cannot be read.
+//
+bool InputCache::stamp (string Filename, unsigned int Kind, double Precision,
+  InputCacheSource &a, bool Hash) {
+  struct stat Info;
+  memset (&a, 0, sizeof (InputCacheSource));
+  if (!enabled () || stat (Filename.c_str (), &Info) != 0) return false;
+  a.Kind = Kind;
+  a.Size = Info.st_size;
+  a.Time = Info.st_mtime;
+  a.LevelPrecision = Precision;
+  return !Hash || hashFile (Filename, a.Hash);
+}
+
+
+//------------------------------------------------------------------------------
+// open (string, ifstream &) : Opens the cache entry Entry and reads its file
+// version. Returns false if there is no usable entry.
+//
+bool InputCache::open (string Entry, ifstream &In) {
+  unsigned int Version = 0;
+  if (!enabled ()) return false;
+  In.open (Entry.c_str (), ios::in|ios::binary);
+  if (!In.is_open ()) return false;
+  In.read ((char *)&Version, sizeof (unsigned int));
+  return !In.fail () && Version == INPUT_CACHE_VERSION;
+}
+
+
+//------------------------------------------------------------------------------
+// valid (FtsReader &, string, unsigned int, double) : Returns true if the entry
+// being read by Fts was made from the current contents of Filename.
+//
+bool InputCache::valid (FtsReader &Fts, string Filename, unsigned int Kind,
+  double Precision) throw (Error) {
+  InputCacheSource Stored, Current;
+  if (!find (Fts, FTS_SECTION_SOURCE)) return false;
+  Fts.read (&Stored, sizeof (InputCacheSource));
+  if (Fts.readString () != Filename) return false;
+  if (!stamp (Filename, Kind, Precision, Current, false)) return false;
+  if (Stored.Kind != Current.Kind || Stored.Size != Current.Size
+    || Stored.LevelPrecision != Current.LevelPrecision) return false;
+  if (Stored.Time == Current.Time) return true;
+  return hashFile (Filename, Current.Hash) && Stored.Hash == Current.Hash;
+}
+
+
+//------------------------------------------------------------------------------
+// find (FtsReader &, unsigned int) : Moves Fts to the first section of the
+// given Type. Returns false if there is no such section.
+//
+bool InputCache::find (FtsReader &Fts, unsigned int Type) {
+  for (unsigned int i = 0; i < Fts.numSections (); i ++) {
+    FtsSection Section = Fts.section (i);
+    if (Section.Type == Type) {
+      Fts.seek (Section);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+//------------------------------------------------------------------------------
+// begin (FtsWriter &, string, InputCacheSource &) : Writes the section that
+// identifies the source file of a new entry.
+//
+void InputCache::begin (FtsWriter &Fts, string Filename,
+  InputCacheSource &Source) {
+  Fts.beginSection (FTS_SECTION_SOURCE);
+  Fts.write (&Source, sizeof (InputCacheSource));
+  Fts.writeString (Filename);
+  Fts.endSection ();
+}
+
+
+//------------------------------------------------------------------------------
+// install (string, string, bool) : Renames the newly written temporary file
+// Temp to Entry, unless writing it Failed, and then trims the cache.
+//
+void InputCache::install (string Temp, string Entry, bool Failed) {
+  if (Failed) {
+    g_remove (Temp.c_str ());
+    return;
+  }
+#ifdef _WIN32
+  g_remove (Entry.c_str ());
+#endif
+  if (g_rename (Temp.c_str (), Entry.c_str ()) != 0) {
+    g_remove (Temp.c_str ());
+    return;
+  }
+  trim ();
+}
+
+
+//==============================================================================
+// PUBLIC FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// directory (string) : Keeps the cache in Dir, creating it if necessary. The
+// cache is disabled if the directory cannot be created.
+//
+void InputCache::directory (string Dir) {
+  Glib::Mutex::Lock lock (CacheMutex);
+  Directory = g_mkdir_with_parents (Dir.c_str (), 0700) == 0 ? Dir : "";
+}
+
+
+//------------------------------------------------------------------------------
+// directory () : Returns the directory the cache is held in.
+//
+string InputCache::directory () {
+  Glib::Mutex::Lock lock (CacheMutex);
+  return Directory;
+}
+
+
+//------------------------------------------------------------------------------
+// limit (uint64_t) : Sets the largest size of the cache, removing old entries
+// if it is now too big. A limit of zero disables the cache.
+//
+void InputCache::limit (uint64_t Bytes) {
+  {
+    Glib::Mutex::Lock lock (CacheMutex);
+    Limit = Bytes;
+  }
+  if (enabled ()) trim ();
+}
+
+
+//------------------------------------------------------------------------------
+// limit () : Returns the largest size of the cache in bytes.
+//
+uint64_t InputCache::limit () {
+  Glib::Mutex::Lock lock (CacheMutex);
+  return Limit;
+}
+
+
+//------------------------------------------------------------------------------
+// enabled () : Returns true if the cache has a directory and a non-zero limit.
+//
+bool InputCache::enabled () {
+  Glib::Mutex::Lock lock (CacheMutex);
+  return Directory != "" && Limit > 0;
+}
+
+
+//------------------------------------------------------------------------------
+// read (string, double, vector <KzLine> &, vector < vector <unsigned int> > &) :
+// Reads the Kurucz lines cached for Filename, along with the indices of the
+// lines in each upper level when they were grouped with the given Precision.
+//
+bool InputCache::read (string Filename, double Precision,
+  vector <KzLine> &Lines, vector < vector <unsigned int> > &Levels) {
+  vector <KzLineRecord> Records;
+  vector <string> Strings;
+  vector <unsigned int> Counts, Indices;
+  ifstream In;
+
+  Filename = canonical (Filename);
+  string Entry = entry (Filename, INPUT_CACHE_KURUCZ);
+  if (!open (Entry, In)) return false;
+  try {
+    FtsReader Fts (&In, Entry);
+    if (!valid (Fts, Filename, INPUT_CACHE_KURUCZ, Precision)) return false;
+    if (!find (Fts, FTS_SECTION_KURUCZ)) return false;
+    Fts.readArray (Records);
+    Strings = Fts.readStrings ();
+    if (Strings.size () != Records.size () * KZLINE_RECORD_STRINGS) return false;
+    if (!find (Fts, FTS_SECTION_LEVELS)) return false;
+    Fts.readArray (Counts);
+    Fts.readArray (Indices);
+  } catch (Error e) {
+    return false;
+  }
+
+  Lines.resize (Records.size ());
+  for (unsigned int i = 0; i < Records.size (); i ++) {
+    Lines[i].unpack (Records[i], &Strings[i * KZLINE_RECORD_STRINGS]);
+  }
+  Levels.resize (Counts.size ());
+  size_t Next = 0;
+  for (unsigned int i = 0; i < Counts.size (); i ++) {
+    if (Next + Counts[i] > Indices.size ()) return false;
+    Levels[i].assign (Indices.begin () + Next, Indices.begin () + Next
+      + Counts[i]);
+    Next += Counts[i];
+  }
+  g_utime (Entry.c_str (), NULL);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// read (string, vector <XgLine> &, vector <char> &) : Reads the lines cached
+// for the line list in Filename, along with its .lin header if it has one.
+//
+bool InputCache::read (string Filename, vector <XgLine> &Lines,
+  vector <char> &Header) {
+  vector <XgLineRecord> Records;
+  vector <string> Strings;
+  ifstream In;
+
+  Filename = canonical (Filename);
+  string Entry = entry (Filename, INPUT_CACHE_LINES);
+  if (!open (Entry, In)) return false;
+  try {
+    FtsReader Fts (&In, Entry);
+    if (!valid (Fts, Filename, INPUT_CACHE_LINES, 0.0)) return false;
+    if (!find (Fts, FTS_SECTION_LINES)) return false;
+    Fts.readArray (Header);
+    Fts.readArray (Records);
+    Strings = Fts.readStrings ();
+    if (Strings.size () != Records.size () * XGLINE_RECORD_STRINGS) return false;
+  } catch (Error e) {
+    return false;
+  }
+
+  Lines.resize (Records.size ());
+  for (unsigned int i = 0; i < Records.size (); i ++) {
+    Lines[i].unpack (Records[i], &Strings[i * XGLINE_RECORD_STRINGS]);
+  }
+  g_utime (Entry.c_str (), NULL);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// read (string, vector <Coord> &) : Reads the points cached for the ASCII
+// spectrum in Filename.
+//
+bool InputCache::read (string Filename, vector <Coord> &Points) {
+  ifstream In;
+
+  Filename = canonical (Filename);
+  string Entry = entry (Filename, INPUT_CACHE_ASCII);
+  if (!open (Entry, In)) return false;
+  try {
+    FtsReader Fts (&In, Entry);
+    if (!valid (Fts, Filename, INPUT_CACHE_ASCII, 0.0)) return false;
+    if (!find (Fts, FTS_SECTION_SPECTRUM)) return false;
+    Fts.readArray (Points);
+  } catch (Error e) {
+    return false;
+  }
+  if (Points.size () < 2) return false;
+  g_utime (Entry.c_str (), NULL);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// write (string, double, vector <KzLine> &, vector < vector <unsigned int> > &)
+// : Caches the Kurucz lines parsed from Filename and their upper levels. The
+// indices of the lines in each level are written as a single array, preceded
+// by the number of lines in every level.
+//
+void InputCache::write (string Filename, double Precision,
+  vector <KzLine> &Lines, vector < vector <unsigned int> > &Levels) {
+  InputCacheSource Source;
+  vector <KzLineRecord> Records (Lines.size ());
+  vector <string> Strings;
+  vector <unsigned int> Counts, Indices;
+
+  Filename = canonical (Filename);
+  if (!stamp (Filename, INPUT_CACHE_KURUCZ, Precision, Source, true)) return;
+  for (unsigned int i = 0; i < Lines.size (); i ++) {
+    Lines[i].pack (Records[i], Strings);
+  }
+  for (unsigned int i = 0; i < Levels.size (); i ++) {
+    Counts.push_back (Levels[i].size ());
+    Indices.insert (Indices.end (), Levels[i].begin (), Levels[i].end ());
+  }
+
+  string Entry = entry (Filename, INPUT_CACHE_KURUCZ);
+  string Temp = temporary (Entry);
+  ofstream Out (Temp.c_str (), ios::out|ios::binary);
+  if (!Out.is_open ()) return;
+  FtsWriter Fts (&Out, INPUT_CACHE_VERSION);
+  begin (Fts, Filename, Source);
+  Fts.beginSection (FTS_SECTION_KURUCZ);
+  Fts.writeArray (Records);
+  Fts.writeStrings (Strings);
+  Fts.endSection ();
+  Fts.beginSection (FTS_SECTION_LEVELS);
+  Fts.writeArray (Counts);
+  Fts.writeArray (Indices);
+  Fts.endSection ();
+  Fts.finish ();
+  Out.close ();
+  install (Temp, Entry, Out.fail ());
+}
+
+
+//------------------------------------------------------------------------------
+// write (string, vector <XgLine> &, vector <char> &) : Caches the lines parsed
+// from the line list in Filename, along with its .lin header if it has one.
+//
+void InputCache::write (string Filename, vector <XgLine> &Lines,
+  vector <char> &Header) {
+  InputCacheSource Source;
+  vector <XgLineRecord> Records (Lines.size ());
+  vector <string> Strings;
+
+  Filename = canonical (Filename);
+  if (!stamp (Filename, INPUT_CACHE_LINES, 0.0, Source, true)) return;
+  for (unsigned int i = 0; i < Lines.size (); i ++) {
+    Lines[i].pack (Records[i], Strings);
+  }
+
+  string Entry = entry (Filename, INPUT_CACHE_LINES);
+  string Temp = temporary (Entry);
+  ofstream Out (Temp.c_str (), ios::out|ios::binary);
+  if (!Out.is_open ()) return;
+  FtsWriter Fts (&Out, INPUT_CACHE_VERSION);
+  begin (Fts, Filename, Source);
+  Fts.beginSection (FTS_SECTION_LINES);
+  Fts.writeArray (Header);
+  Fts.writeArray (Records);
+  Fts.writeStrings (Strings);
+  Fts.endSection ();
+  Fts.finish ();
+  Out.close ();
+  install (Temp, Entry, Out.fail ());
+}
+
+
+//------------------------------------------------------------------------------
+// write (string, vector <Coord> &) : Caches the points read from the ASCII
+// spectrum in Filename.
+//
+void InputCache::write (string Filename, vector <Coord> &Points) {
+  InputCacheSource Source;
+
+  Filename = canonical (Filename);
+  if (!stamp (Filename, INPUT_CACHE_ASCII, 0.0, Source, true)) return;
+
+  string Entry = entry (Filename, INPUT_CACHE_ASCII);
+  string Temp = temporary (Entry);
+  ofstream Out (Temp.c_str (), ios::out|ios::binary);
+  if (!Out.is_open ()) return;
+  FtsWriter Fts (&Out, INPUT_CACHE_VERSION);
+  begin (Fts, Filename, Source);
+  Fts.beginSection (FTS_SECTION_SPECTRUM);
+  Fts.writeArray (Points);
+  Fts.endSection ();
+  Fts.finish ();
+  Out.close ();
+  install (Temp, Entry, Out.fail ());
+}
+
+
+//------------------------------------------------------------------------------
+// size () : Returns the total size of the entries in the cache in bytes.
+//
+uint64_t InputCache::size () {
+  Glib::Mutex::Lock lock (CacheMutex);
+  GDir *Dir;
+  const gchar *Name;
+  struct stat Info;
+  uint64_t Total = 0;
+
+  if (Directory == "" || (Dir = g_dir_open (Directory.c_str (), 0, NULL)) == NULL) {
+    return 0;
+  }
+  while ((Name = g_dir_read_name (Dir)) != NULL) {
+    string Path = Directory + "/" + Name;
+    if (stat (Path.c_str (), &Info) == 0) Total += Info.st_size;
+  }
+  g_dir_close (Dir);
+  return Total;
+}
+
+
+//------------------------------------------------------------------------------
+// trim () : Removes the least recently used entries until the cache is no
+// larger than Limit. Each entry's modification time is updated whenever it is
+// read, so the oldest entries are those that have gone unused the longest.
+//
+void InputCache::trim () {
+  Glib::Mutex::Lock lock (CacheMutex);
+  vector <InputCacheFile> Files;
+  InputCacheFile NextFile;
+  GDir *Dir;
+  const gchar *Name;
+  struct stat Info;
+  uint64_t Total = 0;
+  size_t Ext = strlen (INPUT_CACHE_EXTENSION);
+
+  if (Directory == "" || (Dir = g_dir_open (Directory.c_str (), 0, NULL)) == NULL) {
+    return;
+  }
+  while ((Name = g_dir_read_name (Dir)) != NULL) {
+    string Filename = Name;
+    if (Filename.size () < Ext
+      || Filename.substr (Filename.size () - Ext) != INPUT_CACHE_EXTENSION) {
+      continue;
+    }
+    NextFile.Path = Directory + "/" + Filename;
+    if (stat (NextFile.Path.c_str (), &Info) != 0) continue;
+    NextFile.Size = Info.st_size;
+    NextFile.Time = Info.st_mtime;
+    Files.push_back (NextFile);
+    Total += NextFile.Size;
+  }
+  g_dir_close (Dir);
+
+  sort (Files.begin (), Files.end ());
+  for (unsigned int i = 0; i < Files.size () && Total > Limit; i ++) {
+    if (g_remove (Files[i].Path.c_str ()) == 0) Total -= Files[i].Size;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// purge () : Removes every entry from the cache, along with any temporary files
+// left behind by a crash. Returns the number of bytes freed.
+//
+uint64_t InputCache::purge () {
+  Glib::Mutex::Lock lock (CacheMutex);
+  GDir *Dir;
+  const gchar *Name;
+  struct stat Info;
+  uint64_t Freed = 0;
+
+  if (Directory == "" || (Dir = g_dir_open (Directory.c_str (), 0, NULL)) == NULL) {
+    return 0;
+  }
+  while ((Name = g_dir_read_name (Dir)) != NULL) {
+    string Filename = Name;
+    if (Filename.find (INPUT_CACHE_EXTENSION) == string::npos) continue;
+    string Path = Directory + "/" + Filename;
+    if (stat (Path.c_str (), &Info) == 0 && g_remove (Path.c_str ()) == 0) {
+      Freed += Info.st_size;
+    }
+  }
+  g_dir_close (Dir);
+  return Freed;
+}
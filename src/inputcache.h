@@ -0,0 +1,131 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// InputCache class (inputcache.h)
+//==============================================================================
+// Parsing a large Kurucz list, line list or ASCII spectrum is slow, and the same
+// files tend to be loaded again and again. An InputCache keeps the parsed form
+// of each source file in a directory in the user's home directory, so that the
+// next time the file is loaded it can be read straight back instead.
+//
+// Each cache entry is a small file in the sectioned FTS format (see ftsfile.h)
+// containing an FTS_SECTION_SOURCE section that identifies the source file,
+// followed by the parsed data in the same sections used by project files:
+//
+//   INPUT_CACHE_KURUCZ   FTS_SECTION_KURUCZ, then FTS_SECTION_LEVELS holding
+//                        the grouping of the lines into upper levels
+//   INPUT_CACHE_LINES    FTS_SECTION_LINES, with the .lin header if any
+//   INPUT_CACHE_ASCII    FTS_SECTION_SPECTRUM holding the points as Coords
+//
+// An entry is only used if the source file still has the size and modification
+// time it had when the entry was written. If only the time has changed, the
+// contents of the file are hashed and compared with the hash in the entry, so a
+// file that was merely touched or copied is not parsed again. Entries are
+// written to a temporary file and renamed into place, so a reader never sees a
+// partial entry, and any entry that cannot be read is treated as missing. An
+// entry is read through FtsReader, which maps the whole file into memory and
+// copies each array straight out of the mapping (except on Windows, where a
+// mapped entry could not be replaced). Source files are identified by their
+// canonical path, so ./a.dat and a.dat share one entry.
+//
+// The total size of the cache is kept below a limit by removing the entries
+// that were least recently used. A limit of zero disables the cache.
+//
+#ifndef INPUT_CACHE_H
+#define INPUT_CACHE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdint.h>
+#include <glibmm/thread.h>
+#include "ftsfile.h"
+#include "kzline.h"
+#include "xgline.h"
+#include "CoreDefs.h"
+
+using namespace::std;
+
+// Incremented whenever the parsers change what they produce, so that entries
+// written by older versions are parsed again. Version 2 reads the optional
+// Kurucz fields correctly.
+#define INPUT_CACHE_VERSION    2
+#define INPUT_CACHE_EXTENSION  ".cache"
+
+// The kinds of source file that are cached
+#define INPUT_CACHE_KURUCZ     1
+#define INPUT_CACHE_LINES      2
+#define INPUT_CACHE_ASCII      3
+
+// Identifies the source file of a cache entry
+typedef struct input_cache_source {
+  unsigned int Kind;
+  unsigned int Reserved;
+  uint64_t Size;
+  int64_t Time;              // Modification time of the source file
+  uint64_t Hash;             // Of the contents of the source file
+  double LevelPrecision;     // Used to group Kurucz lines into upper levels
+} InputCacheSource;
+
+class InputCache {
+
+  private:
+    string Directory;
+    uint64_t Limit;          // In bytes
+    unsigned int Serial;     // Used to name temporary files
+    Glib::Mutex CacheMutex;
+
+    string entry (string Filename, unsigned int Kind);
+    string temporary (string Entry);
+    bool stamp (string Filename, unsigned int Kind, double Precision,
+      InputCacheSource &a, bool Hash);
+    bool open (string Entry, ifstream &In);
+    bool valid (FtsReader &Fts, string Filename, unsigned int Kind,
+      double Precision) throw (Error);
+    bool find (FtsReader &Fts, unsigned int Type);
+    void begin (FtsWriter &Fts, string Filename, InputCacheSource &Source);
+    void install (string Temp, string Entry, bool Failed);
+
+  public:
+    InputCache ();
+    ~InputCache () { /* Does nothing */ }
+
+    // The cache is held in Dir, which is created if necessary. These may be
+    // called while worker threads are reading or writing entries.
+    void directory (string Dir);
+    string directory ();
+    void limit (uint64_t Bytes);
+    uint64_t limit ();
+    bool enabled ();
+
+    // Each read function returns false if there is no valid entry for Filename,
+    // in which case the file must be parsed and the result passed to write ().
+    bool read (string Filename, double Precision, vector <KzLine> &Lines,
+      vector < vector <unsigned int> > &Levels);
+    bool read (string Filename, vector <XgLine> &Lines, vector <char> &Header);
+    bool read (string Filename, vector <Coord> &Points);
+    void write (string Filename, double Precision, vector <KzLine> &Lines,
+      vector < vector <unsigned int> > &Levels);
+    void write (string Filename, vector <XgLine> &Lines, vector <char> &Header);
+    void write (string Filename, vector <Coord> &Points);
+
+    uint64_t size ();
+    void trim ();
+    uint64_t purge ();
+};
+
+#endif // INPUT_CACHE_H
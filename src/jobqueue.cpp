@@ -0,0 +1,311 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// Job and JobQueue classes (jobqueue.cpp)
+//==============================================================================
+#include <sstream>
+#include "jobqueue.h"
+#include "ErrDefs.h"
+
+using namespace::std;
+
+//==============================================================================
+// JOB FUNCTIONS
+//==============================================================================
+
+Job::Job (string DescriptionIn, bool ExclusiveIn) {
+  Queue = NULL;
+  Description = DescriptionIn;
+  Exclusive = ExclusiveIn;
+  Progress = 0.0;
+  LastReported = 0.0;
+  Cancelled = false;
+}
+
+
+//------------------------------------------------------------------------------
+// progress (double) : Records the fraction of the job that has been completed.
+// The main loop is only notified once the progress has changed by at least
+// JOB_PROGRESS_STEP, so that it is not flooded by jobs with many small steps.
+//
+void Job::progress (double a) {
+  bool Report = false;
+  {
+    Glib::Mutex::Lock lock (StateMutex);
+    Progress = a;
+    if (a - LastReported >= JOB_PROGRESS_STEP || a >= 1.0) {
+      LastReported = a;
+      Report = true;
+    }
+  }
+  if (Report && Queue != NULL) Queue -> reportProgress ();
+}
+
+
+//------------------------------------------------------------------------------
+// progress () : Returns the fraction of the job that has been completed.
+//
+double Job::progress () {
+  Glib::Mutex::Lock lock (StateMutex);
+  return Progress;
+}
+
+
+//------------------------------------------------------------------------------
+// cancel () : Asks the job to stop. A running job stops the next time it checks
+// cancelled (), and a job that has not yet started is never run.
+//
+void Job::cancel () {
+  Glib::Mutex::Lock lock (StateMutex);
+  Cancelled = true;
+}
+
+
+//------------------------------------------------------------------------------
+// cancelled () : Returns true if the job has been cancelled.
+//
+bool Job::cancelled () {
+  Glib::Mutex::Lock lock (StateMutex);
+  return Cancelled;
+}
+
+
+//==============================================================================
+// JOBQUEUE CONSTRUCTORS AND DESTRUCTORS
+//==============================================================================
+
+JobQueue::JobQueue () {
+  NumWorkers = 0;
+  MaxWorkers = 0;
+  NumRunning = 0;
+  RunningExclusive = false;
+  NumExclusive = 0;
+  ProgressDispatcher.connect (sigc::mem_fun (*this, &JobQueue::on_progress));
+  DoneDispatcher.connect (sigc::mem_fun (*this, &JobQueue::on_done));
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor : Cancels all outstanding jobs and waits for the workers to stop.
+// Jobs that have not been finished are deleted without calling finish ().
+//
+JobQueue::~JobQueue () {
+  cancelAll ();
+  {
+    Glib::Mutex::Lock lock (QueueMutex);
+    MaxWorkers = 0;
+    QueueCond.broadcast ();
+    while (NumWorkers > 0) WorkerCond.wait (QueueMutex);
+  }
+  for (unsigned int i = 0; i < Active.size (); i ++) {
+    delete Active[i];
+  }
+  Active.clear ();
+  Pending.clear ();
+  Completed.clear ();
+}
+
+
+//==============================================================================
+// PRIVATE FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// worker () : Repeatedly takes the next job from Pending and runs it, then
+// passes it back to the main loop. Run by every thread in the pool. A worker
+// exits once the pool holds more workers than MaxWorkers. If run () throws,
+// the job is cancelled, so that nothing half-built is passed back to the main
+// loop, and what was thrown is kept for signal_failed.
+//
+void JobQueue::worker () {
+  Job *Next;
+  bool Exclusive;
+  string Failure;
+  while (true) {
+    {
+      Glib::Mutex::Lock lock (QueueMutex);
+      while (NumWorkers <= MaxWorkers && !canStart ()) {
+        QueueCond.wait (QueueMutex);
+      }
+      if (NumWorkers > MaxWorkers) {
+        NumWorkers --;
+        WorkerCond.broadcast ();
+        return;
+      }
+      Next = Pending.front ();
+      Pending.pop_front ();
+      Exclusive = Next -> exclusive ();
+      NumRunning ++;
+      if (Exclusive) RunningExclusive = true;
+    }
+    Failure = "";
+    if (!Next -> cancelled ()) {
+      try {
+        Next -> run ();
+      } catch (Error &e) {
+        ostringstream oss;
+        oss << "Error " << e.code;
+        Failure = e.message != "" ? e.message : oss.str ();
+      } catch (std::exception &e) {
+        Failure = e.what ();
+      } catch (const char *e) {
+        Failure = e;
+      } catch (...) {
+        Failure = "Unknown error";
+      }
+    }
+    if (Failure != "") {
+      Glib::Mutex::Lock lock (Next -> StateMutex);
+      Next -> Failure = Failure;
+      Next -> Cancelled = true;
+    }
+    {
+      Glib::Mutex::Lock lock (QueueMutex);
+      Completed.push_back (Next);
+      if (Exclusive) RunningExclusive = false;
+      QueueCond.broadcast ();
+    }
+    DoneDispatcher ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// canStart () : Returns true if the job at the front of Pending may be started.
+// An exclusive job waits until every other job has been run and finished, so
+// that it never reads data that a finish () is still changing, and no job is
+// started while an exclusive one is running. QueueMutex must be held.
+//
+bool JobQueue::canStart () {
+  if (Pending.empty () || RunningExclusive) return false;
+  if (Pending.front () -> exclusive ()) return NumRunning == 0;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// on_progress () : Called on the main loop whenever a job reports progress.
+// Emits signal_progress for the oldest unfinished job.
+//
+void JobQueue::on_progress () {
+  if (Active.size () > 0) {
+    SignalProgress.emit (Active[0] -> description (), Active[0] -> progress ());
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_done () : Called on the main loop whenever a worker completes a job. Each
+// completed job is finished (or aborted, if cancelled) and then deleted. A job
+// may push further jobs from its finish () function.
+//
+void JobQueue::on_done () {
+  Job *Done;
+  string Description, Failure;
+  while (true) {
+    {
+      Glib::Mutex::Lock lock (QueueMutex);
+      if (Completed.empty ()) break;
+      Done = Completed.front ();
+      Completed.pop_front ();
+    }
+    if (Done -> cancelled ()) {
+      Done -> abort ();
+    } else {
+      Done -> finish ();
+    }
+    {
+      Glib::Mutex::Lock lock (QueueMutex);
+      NumRunning --;
+      QueueCond.broadcast ();
+    }
+    for (unsigned int i = 0; i < Active.size (); i ++) {
+      if (Active[i] == Done) {
+        Active.erase (Active.begin () + i);
+        break;
+      }
+    }
+    if (Done -> exclusive ()) {
+      NumExclusive --;
+      if (NumExclusive == 0) SignalLocked.emit (false);
+    }
+    Description = Done -> description ();
+    Failure = Done -> failure ();
+    delete Done;
+    if (Failure != "") SignalFailed.emit (Description, Failure);
+  }
+  if (Active.size () == 0) {
+    SignalBusy.emit (false);
+  } else {
+    on_progress ();
+  }
+}
+
+
+//==============================================================================
+// PUBLIC FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// threads (unsigned int) : Resizes the worker pool to NumThreads threads. At
+// least one worker is always kept. New workers are started straight away, while
+// surplus workers exit once their current job is complete.
+//
+void JobQueue::threads (unsigned int NumThreads) {
+  if (NumThreads < 1) NumThreads = 1;
+  Glib::Mutex::Lock lock (QueueMutex);
+  MaxWorkers = NumThreads;
+  while (NumWorkers < MaxWorkers) {
+    try {
+      Glib::Thread::create (sigc::mem_fun (*this, &JobQueue::worker), false);
+      NumWorkers ++;
+    } catch (Glib::ThreadError &e) {
+      if (NumWorkers > 0) MaxWorkers = NumWorkers;  // Use those created
+      break;
+    }
+  }
+  QueueCond.broadcast ();
+}
+
+
+//------------------------------------------------------------------------------
+// push (Job *) : Adds NewJob to the end of the queue. Must be called from the
+// main loop.
+//
+void JobQueue::push (Job *NewJob) {
+  NewJob -> Queue = this;
+  Active.push_back (NewJob);
+  if (Active.size () == 1) SignalBusy.emit (true);
+  if (NewJob -> exclusive ()) {
+    NumExclusive ++;
+    if (NumExclusive == 1) SignalLocked.emit (true);
+  }
+  SignalProgress.emit (Active[0] -> description (), Active[0] -> progress ());
+  Glib::Mutex::Lock lock (QueueMutex);
+  Pending.push_back (NewJob);
+  QueueCond.broadcast ();
+}
+
+
+//------------------------------------------------------------------------------
+// cancelAll () : Cancels every job that has not yet finished.
+//
+void JobQueue::cancelAll () {
+  for (unsigned int i = 0; i < Active.size (); i ++) {
+    Active[i] -> cancel ();
+  }
+}
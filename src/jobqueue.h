@@ -0,0 +1,146 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// Job and JobQueue classes (jobqueue.h)
+//==============================================================================
+// A Job is a unit of background work. Its run () function is called on one of
+// the JobQueue worker threads, and must not touch any GTK widget. Once run ()
+// returns, finish () is called on the thread running the GTK main loop, where
+// the results can be swapped into the rest of the program. If the job was
+// cancelled, abort () is called there instead. A job reports its progress by
+// calling progress () with a fraction between 0 and 1, and should regularly
+// check cancelled () so that it can return early. A job whose run () throws is
+// aborted, and the exception is reported through signal_failed.
+//
+// Most jobs read data that belongs to the main loop, so they are exclusive:
+// signal_locked tells the owner to stop the user from editing while any such
+// job is queued. An exclusive job only starts once every other job has
+// finished, including its finish () or abort () on the main loop, and no other
+// job starts while it runs. A job that only uses its own
+// copy of the data can be created as non-exclusive, and the user may carry on
+// working while it runs alongside other non-exclusive jobs.
+//
+// JobQueue owns a pool of worker threads that take jobs in the order they were
+// pushed. Progress reports and completed jobs are passed back to the main loop
+// through Glib::Dispatcher objects, so the queue must be created on the main
+// thread. Jobs are deleted by the queue once they have finished.
+//
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <glibmm/thread.h>
+#include <glibmm/dispatcher.h>
+#include <sigc++/sigc++.h>
+
+using namespace::std;
+
+// The smallest change in the progress of a job that is passed to the main loop
+#define JOB_PROGRESS_STEP 0.01
+
+class JobQueue;
+
+class Job {
+
+  friend class JobQueue;
+
+  private:
+    JobQueue *Queue;
+    string Description;
+    double Progress, LastReported;
+    bool Cancelled;
+    bool Exclusive;
+    string Failure;              // What run () threw, if it failed
+    Glib::Mutex StateMutex;
+
+  public:
+    Job (string DescriptionIn, bool ExclusiveIn = true);
+    virtual ~Job () { }
+
+    virtual void run () = 0;     // Called on a worker thread
+    virtual void finish () { }   // Called on the main loop after run ()
+    virtual void abort () { }    // Called on the main loop if cancelled
+
+    // Called from run () to report how much of the job has been completed
+    void progress (double a);
+    double progress ();
+    void cancel ();
+    bool cancelled ();
+    string description () { return Description; }
+    bool exclusive () { return Exclusive; }
+    string failure () { return Failure; }
+};
+
+class JobQueue {
+
+  private:
+    unsigned int NumWorkers;    // Worker threads that are still running
+    unsigned int MaxWorkers;    // Worker threads wanted in the pool
+    unsigned int NumRunning;    // Jobs taken by a worker and not yet finished
+    bool RunningExclusive;      // True while an exclusive job is being run
+    deque <Job *> Pending;      // Jobs waiting for a worker
+    deque <Job *> Completed;    // Jobs waiting for finish () on the main loop
+    vector <Job *> Active;      // All unfinished jobs. Main loop only.
+    unsigned int NumExclusive;  // Exclusive jobs in Active
+    Glib::Mutex QueueMutex;
+    Glib::Cond QueueCond;
+    Glib::Cond WorkerCond;      // Signalled when a worker thread exits
+    Glib::Dispatcher ProgressDispatcher;
+    Glib::Dispatcher DoneDispatcher;
+    sigc::signal <void, string, double> SignalProgress;
+    sigc::signal <void, bool> SignalBusy;
+    sigc::signal <void, bool> SignalLocked;
+    sigc::signal <void, string, string> SignalFailed;
+
+    void worker ();
+    bool canStart ();
+    void on_progress ();
+    void on_done ();
+
+  public:
+    JobQueue ();
+    ~JobQueue ();
+
+    // Set the number of worker threads. Surplus workers exit on their own once
+    // their current job is complete, so this never waits for a job.
+    void threads (unsigned int NumThreads);
+    unsigned int threads () { return MaxWorkers; }
+
+    // Add a job to the end of the queue. The queue takes ownership of the job.
+    void push (Job *NewJob);
+    void cancelAll ();
+    bool busy () { return Active.size () > 0; }
+    bool locked () { return NumExclusive > 0; }
+
+    // Called by Job::progress () on a worker thread
+    void reportProgress () { ProgressDispatcher (); }
+
+    // signal_progress is emitted on the main loop with the description and
+    // progress of the oldest unfinished job. signal_busy is emitted with true
+    // when the first job is pushed onto an idle queue, and with false once the
+    // queue becomes idle again. signal_locked does the same for exclusive jobs.
+    // signal_failed is emitted with the description of a job and the message of
+    // the exception its run () threw, after the job has been aborted.
+    sigc::signal <void, string, double> signal_progress () { return SignalProgress; }
+    sigc::signal <void, bool> signal_busy () { return SignalBusy; }
+    sigc::signal <void, bool> signal_locked () { return SignalLocked; }
+    sigc::signal <void, string, string> signal_failed () { return SignalFailed; }
+};
+
+#endif // JOB_QUEUE_H
@@ -21,6 +21,7 @@
 #include <sstream>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
 #include <cmath>
 #include "kzline.h"
 
@@ -130,20 +131,22 @@ void KzLine::readLine (string LineInfoIn) throw (Error) {
   }
   
   // Some of the fields are left blank if not used. Attempt to read them one at
-  // a time. If any are blank, just skip them and set the property to 0 
-  iss.str (LineInfoIn.substr (124, 5)); iss >> HfShiftLower;
-  if (iss.fail ()) { HfShiftLower = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (129, 5)); iss >> HfShiftUpper;
-  if (iss.fail ()) { HfShiftUpper = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (135, 1)); iss >> HfFLower;
-  if (iss.fail ()) { HfFLower = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (138, 1)); iss >> HfFUpper;
-  if (iss.fail ()) { HfFUpper = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (140, 1)); iss >> StrengthClass;
-  if (iss.fail ()) { StrengthClass = 0; iss.clear (); }
+  // a time. If any are blank, just skip them and set the property to 0. The
+  // stream state is cleared before each field, since reading a field that
+  // fills its substring to the end sets eofbit.
+  iss.clear (); iss.str (LineInfoIn.substr (124, 5)); iss >> HfShiftLower;
+  if (iss.fail ()) HfShiftLower = 0;
+  iss.clear (); iss.str (LineInfoIn.substr (129, 5)); iss >> HfShiftUpper;
+  if (iss.fail ()) HfShiftUpper = 0;
+  iss.clear (); iss.str (LineInfoIn.substr (135, 1)); iss >> HfFLower;
+  if (iss.fail ()) HfFLower = 0;
+  iss.clear (); iss.str (LineInfoIn.substr (138, 1)); iss >> HfFUpper;
+  if (iss.fail ()) HfFUpper = 0;
+  iss.clear (); iss.str (LineInfoIn.substr (140, 1)); iss >> StrengthClass;
+  if (iss.fail ()) StrengthClass = 0;
   
   // The next two parameters should always be present
-  iss.str (LineInfoIn.substr (144)); 
+  iss.clear (); iss.str (LineInfoIn.substr (144)); 
   iss >> LandeGLower >> LandeGUpper;
   if (iss.fail ()) {
     throw Error (FLT_FILE_READ_ERROR);
@@ -151,7 +154,7 @@ void KzLine::readLine (string LineInfoIn) throw (Error) {
   
   // The final parameter may or may not be present
   try {
-    iss.str (LineInfoIn.substr (154, 6)); iss >> IsotopeShift;
+    iss.clear (); iss.str (LineInfoIn.substr (154, 6)); iss >> IsotopeShift;
   } catch (out_of_range& Err) {
     IsotopeShift = 0;
   }
@@ -180,96 +183,11 @@ std::string KzLine::lineString () {
 
 
 //------------------------------------------------------------------------------
-// save (std::ofstream &) : Saves all the line properties to the binary stream
-// specified at arg1.
+// load (std::istream &) : Loads all the line properties from the binary stream
+// specified at arg1, as they were written to FAST project files before version
+// 4.
 //
-void KzLine::save (std::ofstream &BinOut) {
-  int Size;
-  
-  // Save the properties specified in the Kurucz database, and in the same order
-  // in which they are given in a Kurucz line string.
-  BinOut.write ((char*) &Lambda, sizeof (double));
-  BinOut.write ((char*) &Sigma, sizeof (double)); 
-  BinOut.write ((char*) &SigmaSet, sizeof (bool));
-  BinOut.write ((char*) &Loggf, sizeof (double));
-  BinOut.write ((char*) &Code, sizeof (double));
-  BinOut.write ((char*) &ELower, sizeof (double));
-  BinOut.write ((char*) &JLower, sizeof (double));
-  
-  // For string properties the size of the string must be saved as well as its
-  // contents
-  Size = ConfigLower.size ();
-  char ConfLow [Size]; 
-  for (int i = 0; i < Size; i ++) {
-    ConfLow[i] = ConfigLower[i];
-  }
-  BinOut.write ((char*) &Size, sizeof (int));
-  BinOut.write ((char*) &ConfLow, sizeof (char) * Size);
- 
-  BinOut.write ((char*) &EUpper, sizeof (double));
-  BinOut.write ((char*) &JUpper, sizeof (double));
-  
-  Size = ConfigUpper.size ();
-  char ConfUp [Size]; 
-  for (int i = 0; i < Size; i ++) {
-    ConfUp[i] = ConfigUpper[i];
-  }
-  BinOut.write ((char*) &Size, sizeof (int));
-  BinOut.write ((char*) &ConfUp, sizeof (char) * Size);  
-
-  BinOut.write ((char*) &GammaRad, sizeof (double));
-  BinOut.write ((char*) &GammaStark, sizeof (double));
-  BinOut.write ((char*) &GammaWaals, sizeof (double));
-  
-  Size = Ref.size ();
-  char RefChar [Size]; 
-  for (int i = 0; i < Size; i ++) {
-    RefChar[i] = Ref[i];
-  }
-  BinOut.write ((char*) &Size, sizeof (int));
-  BinOut.write ((char*) &RefChar, sizeof (char) * Size); 
-  
-  BinOut.write ((char*) &NlteLower, sizeof (int));
-  BinOut.write ((char*) &NlteUpper, sizeof (int));
-  BinOut.write ((char*) &Isotope, sizeof (int));
-  BinOut.write ((char*) &HfStrength, sizeof (double));
-  BinOut.write ((char*) &Isotope2, sizeof (int));
-  BinOut.write ((char*) &IsotopeAbundance, sizeof (double));
-  BinOut.write ((char*) &HfShiftLower, sizeof (int));
-  BinOut.write ((char*) &HfShiftUpper, sizeof (int));
-  BinOut.write ((char*) &HfFLower, sizeof (int));
-  BinOut.write ((char*) &HfNoteLower, sizeof (char));
-  BinOut.write ((char*) &HfFUpper, sizeof (int));
-  BinOut.write ((char*) &HfNoteUpper, sizeof (char));
-  BinOut.write ((char*) &StrengthClass, sizeof (int));
-
-  Size = TagCode.size ();
-  char Tag [Size]; 
-  for (int i = 0; i < Size; i ++) {
-    Tag[i] = TagCode[i];
-  }
-  BinOut.write ((char*) &Size, sizeof (int));
-  BinOut.write ((char*) &Tag, sizeof (char) * Size);    
-  
-  BinOut.write ((char*) &LandeGLower, sizeof (int));
-  BinOut.write ((char*) &LandeGUpper, sizeof (int));
-  BinOut.write ((char*) &IsotopeShift, sizeof (int));
-
-  // Finally, save the line properties derived from Kurucz properties
-  BinOut.write ((char*) &BranchingFraction, sizeof (double));
-  BinOut.write ((char*) &TransitionProb, sizeof (double));
-  BinOut.write ((char*) &Lifetime, sizeof (double));
-  BinOut.write ((char*) &LifetimeError, sizeof (double));
-}
-
-
-//------------------------------------------------------------------------------
-// load (std::ifstream &) : Loads all the line properties from the binary stream
-// specified at arg1. It is imperative that the structure of this function
-// matches that of the save (std::ofstream) function above or errors will occur
-// in loading the data.
-//
-void KzLine::load (std::ifstream& BinIn) {
+void KzLine::load (std::istream& BinIn) {
   int Size;
   BinIn.read ((char*) &Lambda, sizeof (double));
   BinIn.read ((char*) &Sigma, sizeof (double));
@@ -335,6 +253,96 @@ void KzLine::load (std::ifstream& BinIn) {
 }
 
 
+//------------------------------------------------------------------------------
+// pack (KzLineRecord &, vector <string> &) : Copies the numeric properties of
+// the line into Record, and appends its strings to Strings, in the form used
+// by version 4 FAST project files.
+//
+void KzLine::pack (KzLineRecord &Record, std::vector <std::string> &Strings) {
+  memset (&Record, 0, sizeof (KzLineRecord));
+  Record.Lambda = Lambda;
+  Record.Sigma = Sigma;
+  Record.Loggf = Loggf;
+  Record.Code = Code;
+  Record.ELower = ELower;
+  Record.JLower = JLower;
+  Record.EUpper = EUpper;
+  Record.JUpper = JUpper;
+  Record.GammaRad = GammaRad;
+  Record.GammaStark = GammaStark;
+  Record.GammaWaals = GammaWaals;
+  Record.HfStrength = HfStrength;
+  Record.IsotopeAbundance = IsotopeAbundance;
+  Record.BranchingFraction = BranchingFraction;
+  Record.TransitionProb = TransitionProb;
+  Record.Lifetime = Lifetime;
+  Record.LifetimeError = LifetimeError;
+  Record.NlteLower = NlteLower;
+  Record.NlteUpper = NlteUpper;
+  Record.Isotope = Isotope;
+  Record.Isotope2 = Isotope2;
+  Record.HfShiftLower = HfShiftLower;
+  Record.HfShiftUpper = HfShiftUpper;
+  Record.HfFLower = HfFLower;
+  Record.HfFUpper = HfFUpper;
+  Record.StrengthClass = StrengthClass;
+  Record.LandeGLower = LandeGLower;
+  Record.LandeGUpper = LandeGUpper;
+  Record.IsotopeShift = IsotopeShift;
+  Record.SigmaSet = SigmaSet;
+  Record.HfNoteLower = HfNoteLower;
+  Record.HfNoteUpper = HfNoteUpper;
+  Strings.push_back (ConfigLower);
+  Strings.push_back (ConfigUpper);
+  Strings.push_back (Ref);
+  Strings.push_back (TagCode);
+}
+
+
+//------------------------------------------------------------------------------
+// unpack (const KzLineRecord &, const string *) : The reverse of pack (). The
+// KZLINE_RECORD_STRINGS strings of the line start at Strings.
+//
+void KzLine::unpack (const KzLineRecord &Record, const std::string *Strings) {
+  Lambda = Record.Lambda;
+  Sigma = Record.Sigma;
+  Loggf = Record.Loggf;
+  Code = Record.Code;
+  ELower = Record.ELower;
+  JLower = Record.JLower;
+  EUpper = Record.EUpper;
+  JUpper = Record.JUpper;
+  GammaRad = Record.GammaRad;
+  GammaStark = Record.GammaStark;
+  GammaWaals = Record.GammaWaals;
+  HfStrength = Record.HfStrength;
+  IsotopeAbundance = Record.IsotopeAbundance;
+  BranchingFraction = Record.BranchingFraction;
+  TransitionProb = Record.TransitionProb;
+  Lifetime = Record.Lifetime;
+  LifetimeError = Record.LifetimeError;
+  NlteLower = Record.NlteLower;
+  NlteUpper = Record.NlteUpper;
+  Isotope = Record.Isotope;
+  Isotope2 = Record.Isotope2;
+  HfShiftLower = Record.HfShiftLower;
+  HfShiftUpper = Record.HfShiftUpper;
+  HfFLower = Record.HfFLower;
+  HfFUpper = Record.HfFUpper;
+  StrengthClass = Record.StrengthClass;
+  LandeGLower = Record.LandeGLower;
+  LandeGUpper = Record.LandeGUpper;
+  IsotopeShift = Record.IsotopeShift;
+  SigmaSet = Record.SigmaSet != 0;
+  HfNoteLower = Record.HfNoteLower;
+  HfNoteUpper = Record.HfNoteUpper;
+  ConfigLower = Strings[0];
+  ConfigUpper = Strings[1];
+  Ref = Strings[2];
+  TagCode = Strings[3];
+}
+
+
 //------------------------------------------------------------------------------
 // sigma () : Returns the value of Sigma specified by the user in the 
 // sigma (double) SET function. If none has been given, this function calculates
@@ -45,6 +45,21 @@
 
 using namespace::std;
 
+// The numeric properties of a KzLine as stored in a version 4 FAST project
+// file. Records for a whole Kurucz list are written as one contiguous array.
+// The KZLINE_RECORD_STRINGS strings of each line (lower and upper
+// configurations, reference and tag code) are stored separately. The record is
+// padded to a multiple of 8 bytes, so pack () zeroes it before filling it in.
+#define KZLINE_RECORD_STRINGS 4
+typedef struct kzline_record {
+  double Lambda, Sigma, Loggf, Code, ELower, JLower, EUpper, JUpper, GammaRad,
+    GammaStark, GammaWaals, HfStrength, IsotopeAbundance, BranchingFraction,
+    TransitionProb, Lifetime, LifetimeError;
+  int NlteLower, NlteUpper, Isotope, Isotope2, HfShiftLower, HfShiftUpper,
+    HfFLower, HfFUpper, StrengthClass, LandeGLower, LandeGUpper, IsotopeShift;
+  char SigmaSet, HfNoteLower, HfNoteUpper, Reserved;
+} KzLineRecord;
+
 class KzLine {
 
 private:
@@ -101,9 +116,11 @@ public:
   void readLine (std::string LineInfoIn) throw (Error);
   std::string lineString ();
   
-  // I/O functions for saving/loading a KzLine from to/from a FAST project file.
-  void save (std::ofstream& BinOut);
-  void load (std::ifstream& BinIn);
+  // I/O functions for loading a KzLine from a FAST project file. load () reads
+  // the format used before version 4.
+  void load (std::istream& BinIn);
+  void pack (KzLineRecord &Record, std::vector <std::string> &Strings);
+  void unpack (const KzLineRecord &Record, const std::string *Strings);
   
   // Public SET functions for Kurucz line properties.
   void lambda (double newLambda) { Lambda = newLambda; }
@@ -24,6 +24,7 @@
 #include <cmath>
 #include <vector>
 #include "kzlist.h"
+#include "trace.h"
 
 using namespace::std;
 
@@ -145,6 +146,21 @@ KzList KzList::upperLevel (unsigned int i) throw (string) {
   KzList RtnList (RtnLines);
   return RtnList;
 }
+
+
+//------------------------------------------------------------------------------
+// upperLevelIndices () : Returns the indices in Lines of the lines belonging to
+// each upper level, which can later be given back to assign (...).
+//
+std::vector < std::vector <unsigned int> > KzList::upperLevelIndices () {
+  std::vector < std::vector <unsigned int> > Indices (UpperLevels.size ());
+  for (unsigned int i = 0; i < UpperLevels.size (); i ++) {
+    for (unsigned int j = 0; j < UpperLevels[i].size (); j ++) {
+      Indices[i].push_back (UpperLevels[i][j] - &Lines[0]);
+    }
+  }
+  return Indices;
+}
   
 
 //==============================================================================
@@ -264,6 +280,43 @@ void KzList::levelPrecision (double NewPrecision) {
 }
 
 
+//------------------------------------------------------------------------------
+// assign (vector <KzLine> &, vector < vector <unsigned int> > &) : Replaces the
+// contents of the list with NewLines, grouped into the upper levels given by
+// the indices in Levels (see upperLevelIndices ()). This skips the search for
+// the upper levels made by setUpperLevels (), which is slow for long lists. The
+// levels are found again as usual if the indices do not fit NewLines.
+//
+void KzList::assign (std::vector <KzLine> &NewLines,
+  std::vector < std::vector <unsigned int> > &Levels) {
+  std::vector <unsigned int> Uses (NewLines.size (), 0);
+  bool Valid = true;
+
+  UpperLevels.clear ();
+  Lines = NewLines;
+  if (Lines.size () == 0) return;
+  for (unsigned int i = 0; i < Levels.size () && Valid; i ++) {
+    if (Levels[i].size () == 0) Valid = false;
+    for (unsigned int j = 0; j < Levels[i].size () && Valid; j ++) {
+      if (Levels[i][j] >= Lines.size () || Uses[Levels[i][j]] ++ > 0) {
+        Valid = false;
+      }
+    }
+  }
+  if (!Valid) {
+    setUpperLevels ();
+    return;
+  }
+  UpperLevels.resize (Levels.size ());
+  for (unsigned int i = 0; i < Levels.size (); i ++) {
+    for (unsigned int j = 0; j < Levels[i].size (); j ++) {
+      UpperLevels[i].push_back (&Lines[Levels[i][j]]);
+    }
+  }
+  calcBranchingFractions ();
+}
+
+
 //------------------------------------------------------------------------------
 // set_upper_level_lifetime (double, double) : Sets the upper level lifetime of
 // all lines belonging to upper level Index.
@@ -292,6 +345,19 @@ void KzList::set_upper_level_lifetime_error (double Index, double ErrLifetime) {
 }
 
 
+//------------------------------------------------------------------------------
+// bytes () : Returns the approximate memory used by the list. The characters
+// of long strings held by each line are not counted.
+//
+unsigned long KzList::bytes () {
+  unsigned long Bytes = Lines.capacity () * sizeof (KzLine);
+  for (unsigned int i = 0; i < UpperLevels.size (); i ++) {
+    Bytes += UpperLevels[i].capacity () * sizeof (KzLine *);
+  }
+  return Bytes;
+}
+
+
 //------------------------------------------------------------------------------
 // clear () : Removes all lines from the current list object
 //
@@ -313,6 +379,7 @@ void KzList::clear () {
 // (as specified by its name) or a file stream. 
 //
 void KzList::read (std::string ListFile) throw (Error) {
+  TRACE_SCOPE ("KzList::read");
   ostringstream oss, osssub;
   string ListNoDirectory = ListFile.substr(ListFile.find_last_of ("/\\") + 1);
   std::ifstream LinesToRead (ListFile.c_str());
@@ -532,15 +599,15 @@ void KzList::save (std::string OutFile) throw (Error) {
 
 
 //------------------------------------------------------------------------------
-// save (std::string) : Saves the current KzList as a text file using the normal
-// Kurucz database file format.
+// save (std::ostream &) : Writes the current KzList as text using the normal
+// Kurucz database file format, with the lines grouped by upper level.
 //
-void KzList::save (std::ofstream &Output) {
+void KzList::save (std::ostream &Output) {
   for (unsigned int i = 0; i < numUpperLevels (); i ++) {
-    for (unsigned int j = 0; j < upperLevel (i).size (); j ++) {
-      Output << upperLevel(i).line(j).lineString () << std::endl;
+    for (unsigned int j = 0; j < UpperLevels[i].size (); j ++) {
+      Output << UpperLevels[i][j] -> lineString () << '\n';
     }
-    Output << std::endl;
+    Output << '\n';
   }
 }
     
@@ -61,7 +61,6 @@ class KzList {
     bool noDuplicateExists (vector <KzLine *> NewLevel, KzLine *LineIn);
     
     void read (std::ifstream &ListToRead) throw (Error);
-    void save (std::ofstream &Output);
   
   public:
   
@@ -75,6 +74,7 @@ class KzList {
     // I/O functions for both text and binary read/save operations.
     void read (std::string ListFile) throw (Error);
     void save (std::string OutFile) throw (Error);
+    void save (std::ostream &Output);
     
     // Public GET functions
     KzLine line (int Index);
@@ -82,9 +82,11 @@ class KzList {
     std::vector <KzLine> lines (double Min, char Mode) throw (string);
     std::string name ();
     unsigned int size () { return Lines.size(); }
+    unsigned long bytes ();
     KzList upperLevel (unsigned int i) throw (string);
     std::vector <KzLine *> upperLevelLines (unsigned int i) { return UpperLevels[i]; }
     unsigned int numUpperLevels () { return UpperLevels.size (); }
+    std::vector < std::vector <unsigned int> > upperLevelIndices ();
     double levelPrecision () { return LevelPrecision; }
 
     // Public SET and modifier functions. These largely mirror the functions 
@@ -99,6 +101,8 @@ class KzList {
     void erase (int First, int Last);
     void eraseUpperLevel (int Index);
     void levelPrecision (double NewPrecision);
+    void assign (std::vector <KzLine> &NewLines,
+      std::vector < std::vector <unsigned int> > &Levels);
     void clear ();
     
     void set_upper_level_lifetime (double Index, double Lifetime);
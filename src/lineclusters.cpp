@@ -0,0 +1,283 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineClusters class (lineclusters.cpp)
+//==============================================================================
+#include "lineclusters.h"
+#include <algorithm>
+
+using namespace::std;
+
+// The wavenumber interval covered by the profile of line number Line.
+typedef struct line_interval {
+  double Start, End;
+  unsigned int Line;
+} LineInterval;
+
+// Comparison functions used to sort intervals and clusters by their start.
+static bool intervalLessThan (const LineInterval &a, const LineInterval &b) {
+  return a.Start < b.Start;
+}
+
+static bool clusterLessThan (const LineCluster &a, const LineCluster &b) {
+  return a.Start < b.Start;
+}
+
+// Returns true if clusters a and b contain exactly the same lines.
+static bool sameMembers (vector <unsigned int> a, vector <unsigned int> b) {
+  if (a.size () != b.size ()) return false;
+  sort (a.begin (), a.end ());
+  sort (b.begin (), b.end ());
+  return a == b;
+}
+
+
+//==============================================================================
+// CONSTRUCTORS AND DESTRUCTORS
+//==============================================================================
+
+LineClusters::LineClusters () {
+  Built = false;
+}
+
+
+//==============================================================================
+// PRIVATE FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// sweep (vector <XgLine> &, vector <unsigned int>, vector <LineCluster> &) :
+// Partitions the lines in Lines listed in Members into clusters, which are
+// appended to NewClusters. The line intervals are sorted by their start and a
+// new cluster begun whenever an interval starts beyond the end of all those
+// before it, or the current cluster has reached MAX_CLUSTER_SIZE lines.
+//
+void LineClusters::sweep (vector <XgLine> &Lines, vector <unsigned int> Members,
+  vector <LineCluster> &NewClusters) {
+  vector <LineInterval> Intervals (Members.size ());
+  LineCluster Next;
+
+  if (Members.size () == 0) return;
+  for (unsigned int i = 0; i < Members.size (); i ++) {
+    double HalfWidth = Lines[Members[i]].width () * CLUSTER_WIDTH_RANGE;
+    Intervals[i].Start = Lines[Members[i]].wavenumber () - HalfWidth;
+    Intervals[i].End = Lines[Members[i]].wavenumber () + HalfWidth;
+    Intervals[i].Line = Members[i];
+  }
+  sort (Intervals.begin (), Intervals.end (), intervalLessThan);
+
+  Next.Start = Intervals[0].Start;
+  Next.End = Intervals[0].End;
+  for (unsigned int i = 0; i < Intervals.size (); i ++) {
+    if (Intervals[i].Start > Next.End || Next.Lines.size () >= MAX_CLUSTER_SIZE) {
+      NewClusters.push_back (Next);
+      Next.Lines.clear ();
+      Next.Start = Intervals[i].Start;
+      Next.End = Intervals[i].End;
+    }
+    Next.Lines.push_back (Intervals[i].Line);
+    if (Intervals[i].End > Next.End) Next.End = Intervals[i].End;
+  }
+  NewClusters.push_back (Next);
+}
+
+
+//------------------------------------------------------------------------------
+// reindex (unsigned int) : Sorts the clusters by wavenumber and rebuilds the
+// look-up table giving the cluster that contains each line.
+//
+void LineClusters::reindex (unsigned int NumLines) {
+  sort (Clusters.begin (), Clusters.end (), clusterLessThan);
+  ClusterOf.assign (NumLines, -1);
+  for (unsigned int i = 0; i < Clusters.size (); i ++) {
+    for (unsigned int j = 0; j < Clusters[i].Lines.size (); j ++) {
+      if (Clusters[i].Lines[j] < NumLines) ClusterOf[Clusters[i].Lines[j]] = i;
+    }
+  }
+}
+
+
+//==============================================================================
+// PARTITIONING FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// build (vector <XgLine> &) : Partitions every line in Lines into clusters.
+//
+void LineClusters::build (vector <XgLine> &Lines) {
+  vector <unsigned int> Members (Lines.size ());
+  for (unsigned int i = 0; i < Lines.size (); i ++) Members[i] = i;
+  Clusters.clear ();
+  sweep (Lines, Members, Clusters);
+  reindex (Lines.size ());
+  Built = true;
+}
+
+
+//------------------------------------------------------------------------------
+// update (vector <XgLine> &, vector <unsigned int>, bool) : Re-partitions only
+// the part of the list affected by changes to the lines listed in Changed. The
+// clusters containing those lines are dissolved, along with any other cluster
+// that one of the changed lines now overlaps, and their lines swept again.
+//
+void LineClusters::update (vector <XgLine> &Lines, vector <unsigned int> Changed,
+  bool MarkDirty) {
+  vector <bool> Affected (Clusters.size (), false);
+  vector <bool> InPool (Lines.size (), false);
+  vector <unsigned int> Pool;
+  vector <LineInterval> PoolIntervals;
+  vector <LineCluster> Old, Remaining, New;
+  LineInterval NextInterval;
+
+  if (!Built) {
+    build (Lines);
+    return;
+  }
+  ClusterOf.resize (Lines.size (), -1);
+
+  // Gather the changed lines and the members of the clusters containing them
+  for (unsigned int i = 0; i < Changed.size (); i ++) {
+    if (Changed[i] >= Lines.size ()) continue;
+    if (ClusterOf[Changed[i]] >= 0) Affected[ClusterOf[Changed[i]]] = true;
+    if (!InPool[Changed[i]]) {
+      Pool.push_back (Changed[i]);
+      InPool[Changed[i]] = true;
+    }
+  }
+  for (unsigned int k = 0; k < Clusters.size (); k ++) {
+    if (!Affected[k]) continue;
+    for (unsigned int j = 0; j < Clusters[k].Lines.size (); j ++) {
+      if (!InPool[Clusters[k].Lines[j]]) {
+        Pool.push_back (Clusters[k].Lines[j]);
+        InPool[Clusters[k].Lines[j]] = true;
+      }
+    }
+  }
+
+  // Absorb any unaffected cluster that overlaps a line in the pool. Absorbed
+  // clusters add new intervals to the pool, so repeat until nothing changes.
+  for (unsigned int i = 0; i < Pool.size (); i ++) {
+    double HalfWidth = Lines[Pool[i]].width () * CLUSTER_WIDTH_RANGE;
+    NextInterval.Start = Lines[Pool[i]].wavenumber () - HalfWidth;
+    NextInterval.End = Lines[Pool[i]].wavenumber () + HalfWidth;
+    NextInterval.Line = Pool[i];
+    PoolIntervals.push_back (NextInterval);
+  }
+  bool Grew = true;
+  while (Grew) {
+    Grew = false;
+    for (unsigned int k = 0; k < Clusters.size (); k ++) {
+      if (Affected[k]) continue;
+      for (unsigned int i = 0; i < PoolIntervals.size (); i ++) {
+        if (PoolIntervals[i].Start <= Clusters[k].End
+          && PoolIntervals[i].End >= Clusters[k].Start) {
+          Affected[k] = true;
+          Grew = true;
+          break;
+        }
+      }
+      if (!Affected[k]) continue;
+      for (unsigned int j = 0; j < Clusters[k].Lines.size (); j ++) {
+        unsigned int l = Clusters[k].Lines[j];
+        if (InPool[l]) continue;
+        double HalfWidth = Lines[l].width () * CLUSTER_WIDTH_RANGE;
+        NextInterval.Start = Lines[l].wavenumber () - HalfWidth;
+        NextInterval.End = Lines[l].wavenumber () + HalfWidth;
+        NextInterval.Line = l;
+        PoolIntervals.push_back (NextInterval);
+        Pool.push_back (l);
+        InPool[l] = true;
+      }
+    }
+  }
+
+  // Sweep the pool into new clusters and decide which of them need refitting
+  for (unsigned int k = 0; k < Clusters.size (); k ++) {
+    if (Affected[k]) Old.push_back (Clusters[k]);
+    else Remaining.push_back (Clusters[k]);
+  }
+  sweep (Lines, Pool, New);
+  for (unsigned int i = 0; i < New.size (); i ++) {
+    New[i].Dirty = true;
+    if (!MarkDirty) {
+      for (unsigned int k = 0; k < Old.size (); k ++) {
+        if (!Old[k].Dirty && sameMembers (Old[k].Lines, New[i].Lines)) {
+          New[i].Dirty = false;
+          break;
+        }
+      }
+    }
+    Remaining.push_back (New[i]);
+  }
+  Clusters = Remaining;
+  reindex (Lines.size ());
+}
+
+
+//------------------------------------------------------------------------------
+// remove (vector <XgLine> &, unsigned int) : Removes line Index from its cluster
+// and shifts the indices of all later lines down by one. The remaining members
+// of the cluster are swept again, since they may no longer overlap.
+//
+void LineClusters::remove (vector <XgLine> &Lines, unsigned int Index) {
+  vector <unsigned int> Members;
+  vector <LineCluster> New;
+
+  if (!Built || Index >= ClusterOf.size ()) return;
+  int c = ClusterOf[Index];
+  if (c >= 0) {
+    for (unsigned int j = 0; j < Clusters[c].Lines.size (); j ++) {
+      unsigned int l = Clusters[c].Lines[j];
+      if (l != Index) Members.push_back (l > Index ? l - 1 : l);
+    }
+    Clusters.erase (Clusters.begin () + c);
+  }
+  for (unsigned int k = 0; k < Clusters.size (); k ++) {
+    for (unsigned int j = 0; j < Clusters[k].Lines.size (); j ++) {
+      if (Clusters[k].Lines[j] > Index) Clusters[k].Lines[j] --;
+    }
+  }
+  sweep (Lines, Members, New);
+  Clusters.insert (Clusters.end (), New.begin (), New.end ());
+  reindex (Lines.size ());
+}
+
+
+//==============================================================================
+// GET FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// clusterOf (unsigned int) : Returns the index of the cluster containing line
+// number Line, or -1 if the line is not in the partition.
+//
+int LineClusters::clusterOf (unsigned int Line) {
+  if (Line < ClusterOf.size ()) return ClusterOf[Line];
+  return -1;
+}
+
+
+//------------------------------------------------------------------------------
+// dirtyClusters () : Returns the indices of all clusters that need refitting.
+//
+vector <unsigned int> LineClusters::dirtyClusters () {
+  vector <unsigned int> Rtn;
+  for (unsigned int i = 0; i < Clusters.size (); i ++) {
+    if (Clusters[i].Dirty) Rtn.push_back (i);
+  }
+  return Rtn;
+}
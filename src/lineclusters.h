@@ -0,0 +1,100 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineClusters class (lineclusters.h)
+//==============================================================================
+// Partitions a list of XGremlin lines into clusters of blended lines whose
+// profiles overlap, so that each cluster can be fitted simultaneously by
+// VoigtFit. The partition is found by sorting the lines by the start of their
+// profile interval (centre +/- a multiple of the width) and sweeping through
+// them, starting a new cluster whenever a gap is found.
+//
+// Once built, the partition is cached and can be updated incrementally. When
+// lines are changed or added with update (), or removed with remove (), only
+// the clusters touching those lines are swept again. Every cluster also has a
+// dirty flag that is set whenever its membership or any of its lines change,
+// so that refits can be restricted to the clusters affected by an edit.
+//
+#ifndef LINE_CLUSTERS_H
+#define LINE_CLUSTERS_H
+
+#include <vector>
+#include "xgline.h"
+
+using namespace::std;
+
+// Half-width of the interval used to test whether two line profiles overlap,
+// as a multiple of the line width in mK. Two lines are considered blended if
+// their centres lie within four FWHM (in total) of each other.
+#define CLUSTER_WIDTH_RANGE 0.002
+
+// The largest number of lines fitted together. Long chains of overlapping
+// lines are broken into several clusters at this size, leaving the model
+// spectrum to account for the lines on either side of each break.
+#define MAX_CLUSTER_SIZE    12
+
+typedef struct line_cluster {
+  vector <unsigned int> Lines;  // Indices of the lines in the cluster
+  double Start, End;            // The wavenumber range spanned by the cluster
+  bool Dirty;                   // True if the cluster needs to be refitted
+
+  line_cluster () { Start = 0.0; End = 0.0; Dirty = true; }
+} LineCluster;
+
+class LineClusters {
+
+  private:
+    vector <LineCluster> Clusters;  // Sorted by Start
+    vector <int> ClusterOf;         // The cluster containing each line
+    bool Built;
+
+    void sweep (vector <XgLine> &Lines, vector <unsigned int> Members,
+      vector <LineCluster> &NewClusters);
+    void reindex (unsigned int NumLines);
+
+  public:
+    LineClusters ();
+    ~LineClusters () { }
+
+    // Partition the whole of Lines. All clusters are marked dirty.
+    void build (vector <XgLine> &Lines);
+
+    // Re-partition the clusters containing the lines listed in Changed, which
+    // may include the indices of lines newly appended to Lines. If MarkDirty is
+    // false, a resulting cluster is only marked dirty if its membership differs
+    // from a clean cluster that existed before the update.
+    void update (vector <XgLine> &Lines, vector <unsigned int> Changed,
+      bool MarkDirty = true);
+
+    // Remove line Index from the partition. This must be called after the line
+    // has been erased from Lines. The indices of all later lines are shifted.
+    void remove (vector <XgLine> &Lines, unsigned int Index);
+
+    // GET functions
+    bool built () { return Built; }
+    unsigned int size () { return Clusters.size (); }
+    vector <unsigned int> cluster (unsigned int i) { return Clusters[i].Lines; }
+    int clusterOf (unsigned int Line);
+    bool dirty (unsigned int i) { return Clusters[i].Dirty; }
+    vector <unsigned int> dirtyClusters ();
+
+    // SET functions
+    void dirty (unsigned int i, bool a) { Clusters[i].Dirty = a; }
+    void clear () { Clusters.clear (); ClusterOf.clear (); Built = false; }
+};
+
+#endif // LINE_CLUSTERS_H
@@ -19,7 +19,7 @@
 //==============================================================================
 
 #include "linedata.h"
-#include <sstream>
+#include "lineview.h"
 
 LineData::LineData () {
   doConstructor ();
@@ -28,12 +28,10 @@ LineData::LineData () {
 LineData::LineData (XgLine LineIn) {
   doConstructor ();
   setLine (LineIn);
-  prepareData();
 }
 
 LineData::~LineData () {
-  delete Plot;
-  delete Residual;
+  if (View) View -> unbind ();
 }
 
 //------------------------------------------------------------------------------
@@ -41,159 +39,91 @@ LineData::~LineData () {
 // to all class constructors.
 //
 void LineData::doConstructor () {
+  Revision = 0;
   Selected = false;
   Disabled = false;
   Hidden = false;
-  Ready = false;
   ShowData = false;
-  Plot = new Graph;
-  Residual = new Graph;
-  Plot -> set_size_request (200 * ZOOM_FACTOR, 200 * ZOOM_FACTOR);
-  Residual -> set_size_request (200 * ZOOM_FACTOR, 100 * ZOOM_FACTOR);
-  LineParams.set_size_request ((200 * ZOOM_FACTOR) - TOTAL_X_PAD, 200 * ZOOM_FACTOR);
-
-  Box.set_homogeneous (false);
-  Box.pack_start ((Gtk::Widget &) *Plot, false, false, 0);
-  Box.pack_start ((Gtk::Widget &) *Residual, false, false, 0);
-  Box.pack_start (ParamsBox, false, false, 0);
-  ParamsBox.pack_end (DataFrame, false, false, 0);
-  DataFrame.add (LineParams);
-  
-  //Create the Tree model
-  m_refTreeModel = Gtk::TreeStore::create(m_Columns);
-  LineParams.set_model(m_refTreeModel);
-  
-  //Fill the TreeView's model
-  Gtk::TreeModel::Row row = *(m_refTreeModel->append());
-  row[m_Columns.data] = "cm^{-1}";
-  row = *(m_refTreeModel->append());
-  row[m_Columns.data] = "";
-  row = *(m_refTreeModel->append());
-  row[m_Columns.data] = " mK";
-  row = *(m_refTreeModel->append());
-  row[m_Columns.data] = " mK";
-
-  LineParams.append_column("Properties", m_Columns.data);
-  LineParams.set_headers_visible (false);
-
-  add (Box);
-  show_all_children();
-  signal_button_press_event().connect(sigc::mem_fun(*this,
-              &LineData::on_button_press_event));
-  
-  // Construct the popup menus for a right click on a line profile
-  {
-	Gtk::Menu::MenuList& menulist = menuPlotDisablePopup.items();
-	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Disable Line",
-	sigc::mem_fun(*this, &LineData::on_popup_disable_line)));
-	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Hide Line",
-	sigc::mem_fun(*this, &LineData::on_popup_hide_line)));
-  }
-  {
-	Gtk::Menu::MenuList& menulist = menuPlotEnablePopup.items();
-	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Enable Line",
-	sigc::mem_fun(*this, &LineData::on_popup_enable_line)));
-	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Hide Line",
-	sigc::mem_fun(*this, &LineData::on_popup_hide_line)));
-  }
+  View = NULL;
+}
 
+//------------------------------------------------------------------------------
+// refreshView () : Shows the selected, disabled and hidden states of the line
+// in its view, if it has one.
+//
+void LineData::refreshView () {
+  if (View) View -> refresh ();
 }
 
-bool LineData::on_expose_event(GdkEventExpose* event) { 
-  if (!Ready) prepareData (); 
-  Plot -> select (Selected);
-  Residual -> select (Selected);
-  Plot -> disable (Disabled);
-  Residual -> disable (Disabled);
-
-  Gtk::EventBox::on_expose_event(event);
-  return true;
-}
-
-void LineData::prepareData () {
-  if (ShowData) {
-    ostringstream oss;
-    m_refTreeModel->clear ();
-    Gtk::TreeModel::Row row = *(m_refTreeModel->append());
-    oss << setprecision(6) << fixed << XgLine::wavenumber () << " K";
-    row[m_Columns.data] = oss.str ();
-    row = *(m_refTreeModel->append());
-    oss.str (""); oss << setprecision (2) << XgLine::peak ();
-    row[m_Columns.data] = oss.str ();
-    row = *(m_refTreeModel->append());
-    oss.str (""); oss << setprecision (2) << XgLine::width () << " mK";
-    row[m_Columns.data] = oss.str ();
-    row = *(m_refTreeModel->append());
-    oss.str (""); oss << setprecision (3) << XgLine::eqwidth () << " mK";
-    row[m_Columns.data] = oss.str ();
-    row = *(m_refTreeModel->append());
-    oss.str (""); oss << scientific << setprecision (4) << XgLine::epstot ();
-    row[m_Columns.data] = oss.str ();
-    row = *(m_refTreeModel->append());
-    oss.str (""); oss << setprecision (4) << XgLine::epsevn ();
-    row[m_Columns.data] = oss.str ();
-    row = *(m_refTreeModel->append());
-    oss.str (""); oss << setprecision (4) << XgLine::epsodd ();
-    row[m_Columns.data] = oss.str ();
-    row = *(m_refTreeModel->append());
-    oss.str (""); oss << setprecision (4) << XgLine::epsran ();
-    row[m_Columns.data] = oss.str ();
-    ParamsBox.show ();
-  } else {
-    ParamsBox.hide ();
-  }
-  queue_draw ();
-  Ready = true;
-}
-
-bool LineData::on_button_press_event(GdkEventButton* event) {
-	if (!Hidden && Plot -> numPlots() > 0) {
-		if ((event->type == GDK_BUTTON_PRESS)) {
-			if (event->button == 1 && !Disabled) {
-				Selected = !Selected;
-				Plot -> select (Selected);
-				Residual -> select (Selected);
-				m_signal_selected.emit(Selected);
-			}
-			else if (event->button == 3) {
-				if (Disabled) {
-					menuPlotEnablePopup.popup(event->button, event->time);
-				} else {
-					menuPlotDisablePopup.popup(event->button, event->time);
-				}
-			}
-		}
-	}
-	return true;
+//------------------------------------------------------------------------------
+// redraw () : Redraws the view of the line, if it has one, after the plots or
+// line parameters have been changed.
+//
+void LineData::redraw () {
+  if (View) View -> queue_draw ();
+}
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the approximate memory used by the line and its plots.
+//
+unsigned long LineData::bytes () {
+  return sizeof (LineData) - 2 * sizeof (GraphData) + PlotData.bytes ()
+    + ResidualData.bytes ();
 }
 
 GraphLimits LineData::plotLimits () {
   GraphLimits Limits;
-  Limits.min = Plot -> min ();
-  Limits.max = Plot -> max ();
+  Limits.min = PlotData.min ();
+  Limits.max = PlotData.max ();
   return Limits;
 }
 
 
 GraphLimits LineData::resLimits () {
   GraphLimits Limits;
-  Limits.min = Residual -> min ();
-  Limits.max = Residual -> max ();
+  Limits.min = ResidualData.min ();
+  Limits.max = ResidualData.max ();
   return Limits;
 }
 
 void LineData::plotLimits (GraphLimits lim) {
-  Plot -> min (lim.min);
-  Plot -> max (lim.max);
+  PlotData.min (lim.min);
+  PlotData.max (lim.max);
 }
 
 
 void LineData::resLimits (GraphLimits lim) {
-  Residual -> min (lim.min);
-  Residual -> max (lim.max);
+  ResidualData.min (lim.min);
+  ResidualData.max (lim.max);
+}
+
+
+//------------------------------------------------------------------------------
+// scaleY (double, double) : Shows intensities from MinY to MaxY, keeping the
+// wavenumber range fitted to the plots. Returns true if the limits have
+// changed, so that only those lines need be redrawn.
+//
+bool LineData::scaleY (double MinY, double MaxY) {
+  GraphLimits Limits;
+  if (!naturalLimits (Limits)) return false;
+  Limits.min.y = MinY;
+  Limits.max.y = MaxY;
+  return PlotData.limits (Limits.min, Limits.max);
+}
+
+
+//------------------------------------------------------------------------------
+// on_click_line () : Called when the user left clicks on an enabled line
+// profile in the line plot area to select or de-select it.
+//
+void LineData::on_click_line ()
+{
+	Selected = !Selected;
+	refreshView ();
+	m_signal_selected.emit(Selected);
 }
-    
-    
+
+
 //------------------------------------------------------------------------------
 // on_popup_enable_line () : Called when the user right clicks on a DISABLED
 // line profile in the line plot area and chooses to reactive the line.
@@ -201,8 +131,7 @@ void LineData::resLimits (GraphLimits lim) {
 void LineData::on_popup_enable_line ()
 {
 	Disabled = false;
-	Plot -> disable (false);
-	Residual -> disable (false);
+	refreshView ();
 	m_signal_disabled.emit(false);
 }
 
@@ -214,11 +143,8 @@ void LineData::on_popup_enable_line ()
 void LineData::on_popup_disable_line ()
 {
 	Disabled = true;
-	Plot -> disable (true);
-	Residual -> disable (true);
 	Selected = false;
-	Plot -> select (false);
-	Residual -> select (false);
+	refreshView ();
 	m_signal_disabled.emit(true);
 }
 
@@ -229,7 +155,18 @@ void LineData::on_popup_disable_line ()
 void LineData::on_popup_hide_line ()
 {
 	Hidden = true;
-	Plot -> hide (true);
-	Residual -> hide (true);
+	refreshView ();
 	m_signal_hidden.emit();
 }
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the approximate memory used by the blank lines and plots.
+//
+unsigned long LineArena::bytes () {
+  unsigned long Bytes = Lines.size () * sizeof (XgLine);
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    Bytes += Plots[i].bytes ();
+  }
+  return Bytes;
+}
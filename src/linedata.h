@@ -17,93 +17,105 @@
 //==============================================================================
 // Linedata class (linedata.h)
 //==============================================================================
-// The Linedata class inherits the functionality of an XGremlin line (XgLine)
-// and that of a Gtk::Eventbox, and combines the two to permit an XGremlin line
-// to be plotted in a GTK widget. Two Graph objects are added to LineData: one
-// to display the line profile, and a second to display XGremlin fit residuals.
+// The Linedata class extends an XGremlin line (XgLine) with everything needed
+// to plot it: the line profile and XGremlin fit residuals (as GraphData), and
+// whether the user has selected, disabled or hidden the line. LineData holds
+// no GTK+ widgets, so a project can keep one for every line it has loaded.
+//
+// A LineData is drawn by binding it to a LineView (see lineview.h), which is
+// only done while the line is on screen. view () returns the LineView it is
+// currently bound to, if any.
+//
+// LineArena holds the blank lines and plots created for target lines that are
+// not found in a spectrum, and frees them all at once.
 //
 #ifndef ANALYSER_GRAPH_H
 #define ANALYSER_GRAPH_H
 
-#include <gtkmm/box.h>
-#include <gtkmm/eventbox.h>
-#include <gtkmm/label.h>
-#include <gtkmm/frame.h>
-#include <gtkmm/table.h>
-#include <gdk/gdk.h>
-#include <gtkmm/treeview.h>
-#include <gtkmm/treestore.h>
 #include <sigc++/sigc++.h>
-#include <gtkmm/messagedialog.h>
-
 #include <string>
-#include <iomanip>
+#include <deque>
 #include "xgline.h"
 #include "graph.h"
 
 typedef struct graph_limits {
   Coord min, max;
-  
+
   graph_limits () {
     min.x = 0.0; max.x = 0.0; min.y = 0.0; max.y = 0.0;
   }
 } GraphLimits;
 
-class LineData : public XgLine, public Gtk::EventBox {
+class LineView;
+
+class LineData : public XgLine {
+
+  friend class LineView;
 
   public:
     LineData ();
     LineData (XgLine LineIn);
     ~LineData ();
 
-    // Overload XgLine SET functions to allow GTK widgets to be refreshed
-    virtual void line (int a) { Ready = false; XgLine::line (a); }
-    virtual void itn (int a) { Ready = false; XgLine::itn (a); }
-    virtual void h (int a) { Ready = false; XgLine::h (a); }
-    virtual void wavenumber (double a) { Ready = false; XgLine::wavenumber (a); }
-    virtual void peak (double a) { Ready = false; XgLine::peak (a); }
-    virtual void width (double a) { Ready = false; XgLine::width (a); }
-    virtual void dmp (double a) { Ready = false; XgLine::dmp (a); }
-    virtual void eqwidth (double a) { Ready = false; XgLine::eqwidth (a); }
-    virtual void epstot (double a) { Ready = false; XgLine::epstot (a); }
-    virtual void epsevn (double a) { Ready = false; XgLine::epsevn (a); }
-    virtual void epsodd (double a) { Ready = false; XgLine::epsodd (a); }
-    virtual void epsran (double a) { Ready = false; XgLine::epsran (a); }
-    virtual void wavelength (double a) { Ready = false; XgLine::wavelength (a); }
-    virtual void tags (string a) { Ready = false; XgLine::tags (a); }
-    virtual void id (string a) { Ready = false; XgLine::id (a); }
-    virtual void wavCorr (double a) { Ready = false; XgLine::wavCorr (a); }
-    virtual void airCorrection (double a) { Ready = false; XgLine::airCorrection (a); }
-    virtual void intensityCalibration (double a) { Ready = false; XgLine::intensityCalibration (a); }
-    virtual void createLine (string a) throw (const char*) { Ready = false; XgLine::createLine (a); }
-    virtual void operator= (XgLine a) { Ready = false; XgLine::operator= (a); }
-
-    void setLine (XgLine a) { Ready = false; XgLine::operator= (a); }
-    void addPlot (XgLine l, vector<Coord> a, bool mi = true, bool ma = true) { Plot -> addPlot (l, a, mi, ma); }
-    void addPlot (vector<Coord> a, bool mi = true, bool ma = true) { Plot -> addPlot (a, mi, ma); }
-    void addText (double x, double y, string textIn) { Plot -> addText (x, y, textIn); }
-    void clearText () { Plot -> clearText (); }
-    void setPlotColour (int i, float r, float g, float b) { Plot -> setColour (i, r, g, b); }
-    void setPlotWidth (int i, float w) { Plot -> setWidth (i, w); }
-    void addResidual (vector<Coord> a) { Residual -> addPlot (a); }
-    
+    // Overload XgLine SET functions so that the line parameters shown by a
+    // LineView are refreshed
+    virtual void line (int a) { Revision ++; XgLine::line (a); }
+    virtual void itn (int a) { Revision ++; XgLine::itn (a); }
+    virtual void h (int a) { Revision ++; XgLine::h (a); }
+    virtual void wavenumber (double a) { Revision ++; XgLine::wavenumber (a); }
+    virtual void peak (double a) { Revision ++; XgLine::peak (a); }
+    virtual void width (double a) { Revision ++; XgLine::width (a); }
+    virtual void dmp (double a) { Revision ++; XgLine::dmp (a); }
+    virtual void eqwidth (double a) { Revision ++; XgLine::eqwidth (a); }
+    virtual void epstot (double a) { Revision ++; XgLine::epstot (a); }
+    virtual void epsevn (double a) { Revision ++; XgLine::epsevn (a); }
+    virtual void epsodd (double a) { Revision ++; XgLine::epsodd (a); }
+    virtual void epsran (double a) { Revision ++; XgLine::epsran (a); }
+    virtual void wavelength (double a) { Revision ++; XgLine::wavelength (a); }
+    virtual void tags (string a) { Revision ++; XgLine::tags (a); }
+    virtual void id (string a) { Revision ++; XgLine::id (a); }
+    virtual void wavCorr (double a) { Revision ++; XgLine::wavCorr (a); }
+    virtual void airCorrection (double a) { Revision ++; XgLine::airCorrection (a); }
+    virtual void intensityCalibration (double a) { Revision ++; XgLine::intensityCalibration (a); }
+    virtual void createLine (string a) throw (const char*) { Revision ++; XgLine::createLine (a); }
+    virtual void operator= (XgLine a) { Revision ++; XgLine::operator= (a); }
+
+    void setLine (XgLine a) { Revision ++; XgLine::operator= (a); }
+    void addPlot (XgLine l, vector<Coord> a, bool mi = true, bool ma = true) { PlotData.addPlot (l, a, mi, ma); }
+    void addPlot (vector<Coord> a, bool mi = true, bool ma = true) { PlotData.addPlot (a, mi, ma); }
+    void addText (double x, double y, string textIn) { PlotData.addText (x, y, textIn); }
+    void clearText () { PlotData.clearText (); }
+    void setPlotColour (int i, float r, float g, float b) { PlotData.setColour (i, r, g, b); }
+    void setPlotWidth (int i, float w) { PlotData.setWidth (i, w); }
+    void addResidual (vector<Coord> a) { ResidualData.addPlot (a); }
+    void clearPlots () { PlotData.clearPlots (); ResidualData.clearPlots (); }
+    bool plotted () { return PlotData.numPlots () > 0; }
+    unsigned long bytes ();
+
     GraphLimits plotLimits ();
-    GraphLimits resLimits (); 
+    GraphLimits resLimits ();
     void plotLimits (GraphLimits NewLimits);
-    void resLimits (GraphLimits NewLimits); 
+    void resLimits (GraphLimits NewLimits);
+    bool naturalLimits (GraphLimits &Limits) {
+      return PlotData.naturalLimits (Limits.min, Limits.max); }
+    bool scaleY (double MinY, double MaxY);
     bool selected () { if (Hidden) return false; else return Selected; }
     bool disabled () { if (Hidden) return true; else return Disabled; }
     bool hidden () { return Hidden; }
-    void selected (bool a) { Selected = a; Plot->select(a); Residual->select(a); }
-    void disabled (bool a) { Selected = false; Disabled=a; Plot->disable(a); Residual->disable(a); }
-    void hidden (bool a) { Hidden = a; Plot->hide(a); Residual->hide(a); }
-    bool autoLimits () { return Plot -> autoLimits (); }
-    void setAutoLimits () { Plot -> setAutoLimits (); }
-    vector <Coord> getPlotData (int i) { return Plot -> getPlotData (i); }
-    vector <Coord> getResidualData (int i) { return Residual -> getPlotData (i); }
+    void selected (bool a) { Selected = a; refreshView (); }
+    void disabled (bool a) { Selected = false; Disabled=a; refreshView (); }
+    void hidden (bool a) { Hidden = a; refreshView (); }
+    bool autoLimits () { return PlotData.autoLimits (); }
+    bool setAutoLimits () { return PlotData.setAutoLimits (); }
+    vector <Coord> getPlotData (int i) { return PlotData.getPlotData (i); }
+    vector <Coord> getResidualData (int i) { return ResidualData.getPlotData (i); }
     bool showParams () { return ShowData; }
-    void showParams (bool Show) { ShowData = Show; Ready = false; }
-    
+    void showParams (bool Show) { ShowData = Show; Revision ++; refreshView (); }
+
+    // Redraw the line if it is currently on screen
+    void redraw ();
+    LineView *view () { return View; }
+
     // Create some signals that can be emitted when the user interacts with the plot object.
     // 1) A signal to be emitted when a line profile is selected or de-selected.
     // 2) A signal to be emitted when the user disables and enables a line profile.
@@ -113,50 +125,52 @@ class LineData : public XgLine, public Gtk::EventBox {
     type_signal_emit_bool signal_selected() { return m_signal_selected; }
     type_signal_emit_bool signal_disabled() { return m_signal_disabled; }
     type_signal_emit_void signal_hidden() { return m_signal_hidden; }
-       
-  protected:
-    virtual bool on_expose_event(GdkEventExpose* event);
-    virtual bool on_button_press_event(GdkEventButton* event);
-
-    class ModelColumns : public Gtk::TreeModel::ColumnRecord {
-      public:
-        Gtk::TreeModelColumn<string> data;
-        ModelColumns() { add(data); }
-    };
-
-    ModelColumns m_Columns;
 
+  protected:
     type_signal_emit_bool m_signal_selected;
     type_signal_emit_bool m_signal_disabled;
     type_signal_emit_void m_signal_hidden;
-      
+
   private:
-    bool Ready;			// True once the line textual data has been created with prepareData()
+    unsigned long Revision;	// Incremented whenever the line parameters change
     bool ShowData;		// True if the line textual data is to be shown
     bool Selected;		// True if the line has been selected by the user
     bool Disabled;		// True if the line has been disabled by the user
     bool Hidden;		// True if the line has been hidden from view by the user
-    Graph *Plot;
-    Graph *Residual;
-    Gtk::VBox Box;
-    Gtk::HBox ParamsBox;
-    Gtk::TreeView LineParams;
-    Glib::RefPtr<Gtk::TreeStore> m_refTreeModel;
-
-    Gtk::Frame DataFrame;
-    
-    
-
-    void prepareData ();
-    void doConstructor ();
+    GraphData PlotData;
+    GraphData ResidualData;
+    LineView *View;		// The view this line is bound to, or NULL
 
-    Gtk::Menu menuPlotEnablePopup;		// For a right click on a disabled line profile
-    Gtk::Menu menuPlotDisablePopup;		// For a right click on an enabled line profile
+    void doConstructor ();
+    void refreshView ();
 
+    // Called by LineView when the user clicks on the plot or uses its menu
+    void on_click_line ();
     void on_popup_enable_line ();
     void on_popup_disable_line ();
     void on_popup_hide_line ();
 
 };
-    
+
+// Storage for the blank lines and plots that stand in for target lines that
+// were not found in a spectrum. A deque never moves its elements, so pointers
+// to them stay valid until reset () frees them all.
+class LineArena {
+
+  private:
+    deque <XgLine> Lines;
+    deque <LineData> Plots;
+
+  public:
+    LineArena () { /* Does nothing */ }
+    ~LineArena () { /* Does nothing */ }
+
+    XgLine *newLine () { Lines.push_back (XgLine ()); return &Lines.back (); }
+    LineData *newPlot (XgLine &LineIn) {
+      Plots.push_back (LineData (LineIn)); return &Plots.back (); }
+    void reset () { Plots.clear (); Lines.clear (); }
+    unsigned int size () { return Plots.size (); }
+    unsigned long bytes ();
+};
+
 #endif // ANALYSER_GRAPH_H
@@ -28,30 +28,16 @@
 // Line objects is passed to either writeLines(...) or writeSynLines(...) and 
 // written in 'writelines' or 'syn' format respectively.
 // 
-#ifndef LINE_IO_CPP
-#define LINE_IO_CPP
-
-#define XG_WRITELINES_HEADER_LENGTH 4 /* rows */
-#define XG_WAVCORR_OFFSET 33
-#define LIN_HEADER_SIZE 320 /* bytes */
-#define LIN_RECORD_SIZE 80 /* bytes */
-
 #include <iostream>
 #include <sstream>
 #include <fstream>
-#include <vector>
-#include "ErrDefs.h"
-#include "xgline.h"
+#include <cstring>
+#include "lineio.h"
 #include "voigtlsqfit.h"
+#include "CoreDefs.h"
+#include "trace.h"
 
-// A namespace to store the header from the XGremlin writelines file. This can
-// then be used to copy the header to the output line list in writeLines().
-namespace writelines_header {
-  string WaveCorr;
-  string AirCorr;
-  string IntCal;
-  string Columns;
-}
+using namespace::std;
 
 // In XGremlin's lineio.f, the layout of a .lin file record is explained:
 // 
@@ -90,14 +76,6 @@ typedef struct line_io {
   char id [33];   // Add a char for '\0' terminator
 } LineIO;
 
-double getWavCorr (string HeaderLine) throw (Error);
-vector <XgLine> readLineList (string Filename) throw (Error);
-vector <XgLine> readLinFile (string LinFile) throw (Error);
-void readLinFileError (Error Err, int Line) throw (Error);
-void writeLines (vector <XgLine> Lines, ostream &Output) throw (const char*);
-void writeLines (vector <XgLine> Lines, string Filename) throw (int);
-void writeSynLines (vector <XgLine> Lines, string Filename) throw (int);
-
 //------------------------------------------------------------------------------
 // getWavCorr (string) : Extracts the wavenumber scaling factor from an XGremlin
 // 'writelines' header. If no scaling was applied to a line list, a value of
@@ -129,9 +107,11 @@ double getWavCorr (string HeaderLine) throw (Error) {
 // passed in by reference, is returned to the calling function.
 //
 vector <XgLine> readLineList (string Filename) throw (Error) {
+  TRACE_SCOPE ("readLineList");
   ostringstream oss, osssub;
   istringstream iss;
   string LineString;
+  string WaveCorrHeader, AirCorrHeader, IntCalHeader, ColumnsHeader;
   double WavCorr = 0.0;
   XgLine NewLine;
   vector <XgLine> Lines;
@@ -153,14 +133,14 @@ vector <XgLine> readLineList (string Filename) throw (Error) {
   // Extract the data from the ASCII line list. First asssume that the input is
   // an XGremlin writelines file and search for the header information.
   try {
-    getline (ListFile, writelines_header::WaveCorr); // wavenumber correction
-    WavCorr = getWavCorr (writelines_header::WaveCorr);
+    getline (ListFile, WaveCorrHeader); // wavenumber correction
+    WavCorr = getWavCorr (WaveCorrHeader);
     if (ListFile.fail()) throw(Error (FLT_FILE_READ_ERROR));
-    getline (ListFile, writelines_header::AirCorr);  // air correction
+    getline (ListFile, AirCorrHeader);  // air correction
     if (ListFile.fail()) throw(Error (FLT_FILE_READ_ERROR));
-    getline (ListFile, writelines_header::IntCal);   // intensity calibration
+    getline (ListFile, IntCalHeader);   // intensity calibration
     if (ListFile.fail()) throw(Error (FLT_FILE_READ_ERROR));
-    getline (ListFile, writelines_header::Columns);  // column headers
+    getline (ListFile, ColumnsHeader);  // column headers
     if (ListFile.fail()) throw(Error (FLT_FILE_READ_ERROR));
 
     while (!ListFile.eof ()) {
@@ -228,6 +208,7 @@ vector <XgLine> readLineList (string Filename) throw (Error) {
 // binary file as opposed to an ASCII line list.
 //
 vector <XgLine> readLinFile (string LinFile) throw (Error) {
+  TRACE_SCOPE ("readLinFile");
   ifstream LinIn;
   int NumLines; //FileSize, ResidualBytes;
   float Scale, SigCorrection;
@@ -407,21 +388,13 @@ vector <char> readLinFileHeader (string LinFile) throw (Error) {
 
 
 //------------------------------------------------------------------------------
-// writeLinFile (string) : Reads the header from a the LIN file specified at
-// arg1 and returns it.
+// writeLinFile (ostream &, vector <char> &, vector <XgLine> &) : Writes LinHeader
+// followed by a record for each of Lines to LinOut in the XGremlin LIN format.
 //
-void writeLinFile (string LinFile, vector <char> LinHeader, 
-  vector <XgLine> Lines) throw (Error) {
-  ofstream LinOut;
-  LinOut.open (LinFile.c_str (), ios::out|ios::binary);
-  if (!LinOut.is_open ()) {
-    ostringstream oss, osssub;
-    oss << "Error opening " << LinFile << " for output";
-    osssub << "Check you have permission to write to this location";
-    throw Error (FLT_FILE_WRITE_ERROR, oss.str (), osssub.str ());
-  }
-  for (unsigned int i = 0; i < LinHeader.size (); i ++) {
-    LinOut.write ((char*)&LinHeader[i], sizeof (char));
+void writeLinFile (ostream &LinOut, vector <char> &LinHeader,
+  vector <XgLine> &Lines) {
+  if (LinHeader.size () > 0) {
+    LinOut.write (&LinHeader[0], LinHeader.size ());
   }
   
   LineIO NextLineOut;
@@ -453,6 +426,24 @@ void writeLinFile (string LinFile, vector <char> LinHeader,
     LinOut.write ((char*)&NextLineOut.spare, sizeof (float));
     LinOut.write ((char*)&NextLineOut.id, sizeof (char) * 32);
   }
+}
+
+
+//------------------------------------------------------------------------------
+// writeLinFile (string, vector <char>, vector <XgLine>) : Writes LinHeader and
+// Lines to the LIN file LinFile.
+//
+void writeLinFile (string LinFile, vector <char> LinHeader, 
+  vector <XgLine> Lines) throw (Error) {
+  ofstream LinOut;
+  LinOut.open (LinFile.c_str (), ios::out|ios::binary);
+  if (!LinOut.is_open ()) {
+    ostringstream oss, osssub;
+    oss << "Error opening " << LinFile << " for output";
+    osssub << "Check you have permission to write to this location";
+    throw Error (FLT_FILE_WRITE_ERROR, oss.str (), osssub.str ());
+  }
+  writeLinFile (LinOut, LinHeader, Lines);
   LinOut.close ();
 }
 
@@ -460,18 +451,19 @@ void writeLinFile (string LinFile, vector <char> LinHeader,
 //------------------------------------------------------------------------------
 // writeLines (vector <Line>, ostream) : Requests the XGremlin writelines string
 // from each Line in the vector at arg1 and sends this string to the stream at
-// arg2.
+// arg2. The header is built from the lines alone, since no header is kept from
+// the lists that were read.
 //
-void writeLines (vector <XgLine> Lines, ostream &Output = std::cout) throw (const char*) {
+void writeLines (vector <XgLine> Lines, ostream &Output) throw (const char*) {
   if (Lines[0].wavCorr () != 0.0) {
     Output << "  WAVENUMBER CORRECTION APPLIED: wavcorr =   " 
       << Lines[0].wavCorr () << endl;
   }
   else {
-    Output << writelines_header::WaveCorr << endl;
+    Output << XG_NO_WAVCORR_HEADER << endl;
   }
-  Output << writelines_header::AirCorr << endl;
-  Output << writelines_header::IntCal << endl;
+  Output << XG_NO_AIRCORR_HEADER << endl;
+  Output << XG_NO_INTCAL_HEADER << endl;
   Output << "  line    wavenumber      peak    width      dmp   eq width   itn   H tags     epstot     epsevn     epsodd     epsran  identification" << endl;
 
   if (Output.fail()) throw "the file header";
@@ -512,7 +504,7 @@ void writeLines (vector <XgLine> Lines, string Filename) throw (int) {
 // from each Line in the vector at arg1 and sends this string to the stream at
 // arg2.
 //
-void writeSynLines (vector <XgLine> Lines, ostream &Output = std::cout) throw (const char*) {
+void writeSynLines (vector <XgLine> Lines, ostream &Output) throw (const char*) {
   for (unsigned int i = 0; i < Lines.size (); i ++) {
     Output << Lines[i].getLineSynString() << endl;
     if (Output.fail ()) {
@@ -543,5 +535,3 @@ void writeSynLines (vector <XgLine> Lines, string Filename) throw (int) {
     throw int (FLT_FILE_WRITE_ERROR);
   }
 }
-
-#endif // LINE_IO_CPP
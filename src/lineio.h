@@ -0,0 +1,63 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// lineio.h
+//==============================================================================
+// Routines for reading and writing XGremlin line lists (see lineio.cpp). They
+// keep no state between calls, so may be used from several threads at once.
+//
+#ifndef LINE_IO_H
+#define LINE_IO_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include "ErrDefs.h"
+#include "xgline.h"
+
+#define XG_WRITELINES_HEADER_LENGTH 4 /* rows */
+#define XG_WAVCORR_OFFSET 33
+#define LIN_HEADER_SIZE 320 /* bytes */
+#define LIN_RECORD_SIZE 80 /* bytes */
+
+// The 'writelines' header rows for corrections that have not been applied
+#define XG_NO_WAVCORR_HEADER "  NO WAVENUMBER CORRECTION APPLIED"
+#define XG_NO_AIRCORR_HEADER "  NO AIR CORRECTION APPLIED"
+#define XG_NO_INTCAL_HEADER "  NO INTENSITY CALIBRATION APPLIED"
+
+using namespace::std;
+
+// XGremlin 'writelines' and FAST ASCII line lists
+double getWavCorr (string HeaderLine) throw (Error);
+vector <XgLine> readLineList (string Filename) throw (Error);
+void writeLines (vector <XgLine> Lines, ostream &Output = std::cout)
+  throw (const char*);
+void writeLines (vector <XgLine> Lines, string Filename) throw (int);
+void writeSynLines (vector <XgLine> Lines, ostream &Output = std::cout)
+  throw (const char*);
+void writeSynLines (vector <XgLine> Lines, string Filename) throw (int);
+
+// XGremlin binary LIN files
+vector <XgLine> readLinFile (string LinFile) throw (Error);
+void readLinFileError (Error Err, int Line) throw (Error);
+vector <char> readLinFileHeader (string LinFile) throw (Error);
+void writeLinFile (ostream &LinOut, vector <char> &LinHeader,
+  vector <XgLine> &Lines);
+void writeLinFile (string LinFile, vector <char> LinHeader,
+  vector <XgLine> Lines) throw (Error);
+
+#endif // LINE_IO_H
@@ -0,0 +1,286 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineProfiler class (lineprofile.cpp)
+//==============================================================================
+#include "lineprofile.h"
+#include "voigtlsqfit.h"
+#include "trace.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace::std;
+
+//==============================================================================
+// CONSTRUCTORS AND DESTRUCTORS
+//==============================================================================
+
+LineProfiler::LineProfiler () {
+  Spectrum = NULL;
+  Lines = NULL;
+  NextLine = 0;
+  Failed = false;
+}
+
+
+//==============================================================================
+// PRIVATE FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// hashBytes (uint64_t &, const void *, size_t) : Adds Size bytes to Key using
+// the 64 bit FNV-1a hash.
+//
+static void hashBytes (uint64_t &Key, const void *Bytes, size_t Size) {
+  const unsigned char *Next = (const unsigned char *)Bytes;
+  for (size_t i = 0; i < Size; i ++) {
+    Key ^= Next[i];
+    Key *= 1099511628211ULL;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// hashLine (uint64_t &, XgLine &) : Adds the parameters of Line that are used
+// to render its Voigt profile to Key.
+//
+static void hashLine (uint64_t &Key, XgLine &Line) {
+  double Params[4] = { Line.wavenumber (), Line.peak (), Line.width (),
+    Line.dmp () };
+  hashBytes (Key, Params, sizeof (Params));
+}
+
+
+//------------------------------------------------------------------------------
+// worker () : Repeatedly takes the next batch of lines from Todo and computes
+// their profiles until none remain. Run concurrently by every thread in
+// compute (). The first error raised by any worker stops all of them.
+//
+void LineProfiler::worker () {
+  unsigned int First, Last;
+  while (true) {
+    {
+      Glib::Mutex::Lock lock (LineMutex);
+      if (Failed) return;
+      First = NextLine;
+      NextLine += PROFILE_BATCH_SIZE;
+    }
+    if (First >= Todo.size ()) return;
+    Last = First + PROFILE_BATCH_SIZE;
+    if (Last > Todo.size ()) Last = Todo.size ();
+    try {
+      for (unsigned int i = First; i < Last; i ++) {
+        profile (Lines -> at (Todo[i]), Profiles[Todo[i]]);
+      }
+    } catch (Error e) {
+      Glib::Mutex::Lock lock (LineMutex);
+      if (!Failed) ProfileError = e;
+      Failed = true;
+      return;
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// profile (XgLine &, LineProfile &) : Calculates the profile of a single line.
+// The Voigt profile is generated exactly as XGremlin would plot it. Widths in
+// the line list are given in mK.
+//
+void LineProfiler::profile (XgLine &Line, LineProfile &Profile) {
+  VoigtLsqfit VoigtGen;
+  unsigned int NumPoints;
+  double ResidualRMS;
+  int Start, End;
+
+  if (Spectrum -> numDataPoints () > 0) {
+    window (Line, Model.origin (), Model.step (), Start, End);
+    Profile.Data = Spectrum -> data (Start, End);
+    Profile.Start = Start;
+  } else {
+    Profile.Data = Spectrum -> data (Line.wavenumber (),
+      Line.width () * PLOT_WIDTH_RANGE);
+  }
+  NumPoints = Profile.Data.size ();
+  Profile.Voigt.assign (NumPoints, Coord ());
+  Profile.Residual.assign (NumPoints, Coord ());
+
+  if (NumPoints > 1) {
+    vector <double> x (NumPoints), y (NumPoints, 0.0);
+    for (unsigned int k = 0; k < NumPoints; k ++) x[k] = Profile.Data[k].x;
+    VoigtGen.voigt (NumPoints, &x[0], &y[0],
+      0.0005 * Line.width () / (x[1] - x[0]), Line.peak (), Line.dmp (),
+      Line.wavenumber ());
+    for (unsigned int k = 0; k < NumPoints; k ++) {
+      Profile.Voigt[k] = Coord (x[k], y[k]);
+    }
+  }
+
+  // Calculate the residuals from the difference between the experimental line
+  // data and the model spectrum generated from the XGremlin fits.
+  ResidualRMS = 0.0;
+  for (unsigned int k = 0; k < NumPoints; k ++) {
+    Profile.Residual[k] = Coord (Profile.Data[k].x,
+      Profile.Data[k].y - Model.value (Profile.Data[k].x));
+    ResidualRMS += Profile.Residual[k].y * Profile.Residual[k].y;
+  }
+  if (NumPoints > 0) ResidualRMS = sqrt (ResidualRMS / NumPoints);
+  Profile.Noise = ResidualRMS;
+  Line.noise (ResidualRMS);
+}
+
+
+//------------------------------------------------------------------------------
+// calculateKeys (vector <Coord> &) : Sets Keys[i] to the key of the profile of
+// line i, given the points of the whole spectrum in Data. The key covers the
+// position and intensities of the spectrum points in the plot window and the
+// parameters of the line. It also covers every line in the list whose model
+// overlaps the window, since these all contribute to the residual. The
+// wavenumbers of the points are left out, as they are recreated with slightly
+// different rounding when a spectrum is read back from a project file. Model
+// must already be gridded. A line whose window does not lie within the
+// spectrum is given a key of zero.
+//
+void LineProfiler::calculateKeys (vector <Coord> &Data) {
+  vector < pair <int, unsigned int> > Ranges (Lines -> size ());
+  vector < pair <int, unsigned int> >::iterator Next;
+  vector <int> RangeEnds (Lines -> size ());
+  unsigned int Version = PROFILE_KEY_VERSION;
+  int MaxLength = 0, Start, End;
+  uint64_t Key;
+
+  Keys.assign (Lines -> size (), 0);
+  if (Data.size () == 0) return;
+
+  // Sort the model ranges of the lines so that those overlapping each window
+  // can be found quickly
+  for (unsigned int i = 0; i < Lines -> size (); i ++) {
+    Model.lineRange (Lines -> at (i), Start, End);
+    Ranges[i] = pair <int, unsigned int> (Start, i);
+    RangeEnds[i] = End;
+    if (End - Start > MaxLength) MaxLength = End - Start;
+  }
+  sort (Ranges.begin (), Ranges.end ());
+
+  for (unsigned int i = 0; i < Lines -> size (); i ++) {
+    window (Lines -> at (i), Model.origin (), Model.step (), Start, End);
+    if (Start < 0 || End >= (int)Data.size () || End <= Start) continue;
+    Key = 14695981039346656037ULL;
+    hashBytes (Key, &Version, sizeof (unsigned int));
+    hashBytes (Key, &Start, sizeof (int));
+    hashBytes (Key, &End, sizeof (int));
+    for (int k = Start; k < End; k ++) {
+      hashBytes (Key, &Data[k].y, sizeof (double));
+    }
+    hashLine (Key, Lines -> at (i));
+    Next = lower_bound (Ranges.begin (), Ranges.end (),
+      pair <int, unsigned int> (Start - MaxLength, 0));
+    for (; Next != Ranges.end () && Next -> first < End; Next ++) {
+      if (RangeEnds[Next -> second] > Start) {
+        hashLine (Key, Lines -> at (Next -> second));
+      }
+    }
+    Keys[i] = Key != 0 ? Key : 1;
+  }
+}
+
+
+//==============================================================================
+// PUBLIC FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// compute (XgSpectrum *, vector <XgLine> &, unsigned int, ProfileStore *) :
+// Takes the profile of each line in LinesIn from Stored if its key is found
+// there. The model spectrum of LinesIn is then rendered and the remaining
+// profiles calculated, sharing the work between NumThreads threads (including
+// the calling thread). The spectrum is only read by the workers, so it may be
+// shared with other threads that also leave it unchanged. Throws the first
+// Error raised by any line.
+//
+void LineProfiler::compute (XgSpectrum *SpectrumIn, vector <XgLine> &LinesIn,
+  unsigned int NumThreads, ProfileStore *Stored) throw (Error) {
+  TRACE_SCOPE ("LineProfiler::compute");
+  vector <Glib::Thread *> Workers;
+
+  Spectrum = SpectrumIn;
+  Lines = &LinesIn;
+  Profiles.assign (Lines -> size (), LineProfile ());
+  Todo.clear ();
+  NextLine = 0;
+  Failed = false;
+
+  // Any data points left in a project file must be read before the workers
+  // share the spectrum
+  Spectrum -> loadData ();
+  vector <Coord> &Data = *Spectrum -> dataPtr ();
+  if (Data.size () > 0) {
+    Model.grid (Data[0].x, Spectrum -> get_point_spacing (), Data.size ());
+  }
+
+  // Take whatever profiles can be found in Stored, then work out which lines
+  // are left
+  calculateKeys (Data);
+  for (unsigned int i = 0; i < Lines -> size (); i ++) {
+    if (Stored != NULL && Stored -> find (Keys[i], Data, Profiles[i])) {
+      Lines -> at (i).noise (Profiles[i].Noise);
+    } else {
+      Todo.push_back (i);
+    }
+  }
+  if (Todo.size () == 0) return;
+  TRACE_COUNT ("profiles computed", Todo.size ());
+
+  // Render every line in the list once onto the spectrum grid. The residual of
+  // each line is then taken from the difference between the experimental data
+  // and this model, which accounts for all blended neighbours at once.
+  if (Data.size () > 0) {
+    Model.render (LinesIn);
+  } else {
+    Model.clear ();
+  }
+
+  unsigned int NumBatches = (Todo.size () + PROFILE_BATCH_SIZE - 1)
+    / PROFILE_BATCH_SIZE;
+  if (NumThreads > NumBatches) NumThreads = NumBatches;
+  for (unsigned int i = 1; i < NumThreads; i ++) {
+    try {
+      Workers.push_back (Glib::Thread::create
+        (sigc::mem_fun (*this, &LineProfiler::worker), true));
+    } catch (Glib::ThreadError &e) {
+      break;  // Carry on with however many threads were created
+    }
+  }
+  worker ();
+  for (unsigned int i = 0; i < Workers.size (); i ++) {
+    Workers[i] -> join ();
+  }
+  if (Failed) throw (ProfileError);
+}
+
+
+//------------------------------------------------------------------------------
+// window (XgLine &, double, double, int &, int &) : Returns in Start and End
+// the indices of the first and one past the last spectrum point in the plot
+// window of Line, on a grid starting at Origin with a spacing of Step.
+//
+void LineProfiler::window (XgLine &Line, double Origin, double Step,
+  int &Start, int &End) {
+  double HalfWidth = Line.width () * PLOT_WIDTH_RANGE;
+  Start = int ((Line.wavenumber () - Origin - HalfWidth) / Step);
+  End = int ((Line.wavenumber () - Origin + HalfWidth) / Step) + 1;
+}
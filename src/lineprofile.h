@@ -0,0 +1,100 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineProfiler class (lineprofile.h)
+//==============================================================================
+// LineProfiler calculates the data that is shown in the profile plot of every
+// line in a list: the experimental spectrum around the line, the Voigt profile
+// described by the XGremlin line parameters, and the residual left after the
+// model of the whole list is subtracted from the data. The RMS of the residual
+// is also stored as the noise level of each line.
+//
+// None of this touches a GTK widget, so the profiles of a long line list can
+// be calculated on a pool of worker threads (or from a background job) and the
+// LineData plots filled in afterwards on the main loop. Each worker owns its
+// own VoigtLsqfit object, as the Voigt kernel is not re-entrant.
+//
+// LineProfiler also calculates the key of every profile, which is a hash of
+// everything the profile depends on. When a ProfileStore is passed to
+// compute (), any line whose key is found in the store takes its profile from
+// there. The model spectrum is then only rendered if a line must be profiled
+// afresh.
+//
+#ifndef LINE_PROFILE_H
+#define LINE_PROFILE_H
+
+#include <vector>
+#include <stdint.h>
+#include <glibmm/thread.h>
+#include "xgline.h"
+#include "xgspectrum.h"
+#include "modelspectrum.h"
+#include "profilestore.h"
+#include "ErrDefs.h"
+
+using namespace::std;
+
+// Number of lines taken from the list by a worker thread at a time
+#define PROFILE_BATCH_SIZE 64
+
+// Included in every profile key. This must be changed whenever the way that
+// the profiles are calculated changes, so that stored profiles are not reused.
+#define PROFILE_KEY_VERSION 1
+
+class LineProfiler {
+
+  private:
+    XgSpectrum *Spectrum;
+    vector <XgLine> *Lines;
+    ModelSpectrum Model;
+    vector <LineProfile> Profiles;
+    vector <uint64_t> Keys;
+    vector <unsigned int> Todo;       // Lines not found in the ProfileStore
+    unsigned int NextLine;
+    Glib::Mutex LineMutex;
+    Error ProfileError;
+    bool Failed;
+
+    void worker ();
+    void profile (XgLine &Line, LineProfile &Profile);
+    void calculateKeys (vector <Coord> &Data);
+
+  public:
+    LineProfiler ();
+    ~LineProfiler () { }
+
+    // Calculate the profile of every line in LinesIn, which must lie within
+    // SpectrumIn, using NumThreads threads. Profiles found in Stored are not
+    // recalculated. The noise level of each line in LinesIn is set to the RMS
+    // of its residual.
+    void compute (XgSpectrum *SpectrumIn, vector <XgLine> &LinesIn,
+      unsigned int NumThreads, ProfileStore *Stored = NULL) throw (Error);
+    vector <LineProfile> &profiles () { return Profiles; }
+    vector <uint64_t> &keys () { return Keys; }
+
+    // Indices of the lines whose profiles were calculated by the last call to
+    // compute () rather than taken from the ProfileStore
+    vector <unsigned int> &computed () { return Todo; }
+
+    // Returns the spectrum indices spanned by the plot window of Line, on a
+    // grid starting at Origin with points separated by Step. This matches
+    // XgSpectrum::data (double, double).
+    static void window (XgLine &Line, double Origin, double Step, int &Start,
+      int &End);
+};
+
+#endif // LINE_PROFILE_H
@@ -0,0 +1,254 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineView class (lineview.cpp)
+//==============================================================================
+
+#include "lineview.h"
+#include "trace.h"
+#include <sstream>
+#include <iomanip>
+
+//------------------------------------------------------------------------------
+// Default constructor : Creates the line profile and residual plots, the table
+// of line parameters and the popup menus. The view is empty until bind () is
+// called.
+//
+LineView::LineView () {
+  TRACE_COUNT ("widgets created", 1);
+  Line = NULL;
+  Revision = 0;
+  Plot.set_size_request (200 * ZOOM_FACTOR, 200 * ZOOM_FACTOR);
+  Residual.set_size_request (200 * ZOOM_FACTOR, 100 * ZOOM_FACTOR);
+  LineParams.set_size_request ((200 * ZOOM_FACTOR) - TOTAL_X_PAD, 200 * ZOOM_FACTOR);
+
+  Box.set_homogeneous (false);
+  Box.pack_start (Plot, false, false, 0);
+  Box.pack_start (Residual, false, false, 0);
+  Box.pack_start (ParamsBox, false, false, 0);
+  ParamsBox.pack_end (DataFrame, false, false, 0);
+  DataFrame.add (LineParams);
+
+  //Create the Tree model
+  m_refTreeModel = Gtk::TreeStore::create(m_Columns);
+  LineParams.set_model(m_refTreeModel);
+  LineParams.append_column("Properties", m_Columns.data);
+  LineParams.set_headers_visible (false);
+
+  add (Box);
+  show_all_children();
+  ParamsBox.hide ();
+
+  // Construct the popup menus for a right click on a line profile
+  {
+	Gtk::Menu::MenuList& menulist = menuPlotDisablePopup.items();
+	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Disable Line",
+	sigc::mem_fun(*this, &LineView::on_popup_disable_line)));
+	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Hide Line",
+	sigc::mem_fun(*this, &LineView::on_popup_hide_line)));
+  }
+  {
+	Gtk::Menu::MenuList& menulist = menuPlotEnablePopup.items();
+	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Enable Line",
+	sigc::mem_fun(*this, &LineView::on_popup_enable_line)));
+	menulist.push_back(Gtk::Menu_Helpers::MenuElem("Hide Line",
+	sigc::mem_fun(*this, &LineView::on_popup_hide_line)));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor : Releases the bound line, so that it does not point at a view
+// that no longer exists.
+//
+LineView::~LineView () {
+  unbind ();
+}
+
+
+//------------------------------------------------------------------------------
+// bind (LineData *) : Displays LineIn in the view. A line can only be bound to
+// one view at a time, so LineIn is first released from any other view.
+//
+void LineView::bind (LineData *LineIn) {
+  if (LineIn == Line) return;
+  unbind ();
+  if (LineIn == NULL) return;
+  if (LineIn -> View) LineIn -> View -> unbind ();
+  Line = LineIn;
+  Line -> View = this;
+  Plot.data (&Line -> PlotData);
+  Residual.data (&Line -> ResidualData);
+  prepareData ();
+  refresh ();
+}
+
+
+//------------------------------------------------------------------------------
+// unbind () : Removes the line from the view, leaving it empty.
+//
+void LineView::unbind () {
+  if (Line == NULL) return;
+  Line -> View = NULL;
+  Line = NULL;
+  Plot.data (NULL);
+  Residual.data (NULL);
+}
+
+
+//------------------------------------------------------------------------------
+// refresh () : Copies the selected, disabled and hidden states of the line to
+// the plots and redraws them.
+//
+void LineView::refresh () {
+  if (Line == NULL) return;
+  Plot.select (Line -> Selected);
+  Residual.select (Line -> Selected);
+  Plot.disable (Line -> Disabled);
+  Residual.disable (Line -> Disabled);
+  Plot.hide (Line -> Hidden);
+  Residual.hide (Line -> Hidden);
+  if (Revision != Line -> Revision) prepareData ();
+  queue_draw ();
+}
+
+
+bool LineView::on_expose_event(GdkEventExpose* event) {
+  if (Line && Revision != Line -> Revision) prepareData ();
+  Gtk::EventBox::on_expose_event(event);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// prepareData () : Fills the table of line parameters, if it is to be shown.
+//
+void LineView::prepareData () {
+  Revision = Line -> Revision;
+  if (Line -> ShowData) {
+    ostringstream oss;
+    m_refTreeModel->clear ();
+    Gtk::TreeModel::Row row = *(m_refTreeModel->append());
+    oss << setprecision(6) << fixed << Line -> XgLine::wavenumber () << " K";
+    row[m_Columns.data] = oss.str ();
+    row = *(m_refTreeModel->append());
+    oss.str (""); oss << setprecision (2) << Line -> XgLine::peak ();
+    row[m_Columns.data] = oss.str ();
+    row = *(m_refTreeModel->append());
+    oss.str (""); oss << setprecision (2) << Line -> XgLine::width () << " mK";
+    row[m_Columns.data] = oss.str ();
+    row = *(m_refTreeModel->append());
+    oss.str (""); oss << setprecision (3) << Line -> XgLine::eqwidth () << " mK";
+    row[m_Columns.data] = oss.str ();
+    row = *(m_refTreeModel->append());
+    oss.str (""); oss << scientific << setprecision (4) << Line -> XgLine::epstot ();
+    row[m_Columns.data] = oss.str ();
+    row = *(m_refTreeModel->append());
+    oss.str (""); oss << setprecision (4) << Line -> XgLine::epsevn ();
+    row[m_Columns.data] = oss.str ();
+    row = *(m_refTreeModel->append());
+    oss.str (""); oss << setprecision (4) << Line -> XgLine::epsodd ();
+    row[m_Columns.data] = oss.str ();
+    row = *(m_refTreeModel->append());
+    oss.str (""); oss << setprecision (4) << Line -> XgLine::epsran ();
+    row[m_Columns.data] = oss.str ();
+    ParamsBox.show ();
+  } else {
+    ParamsBox.hide ();
+  }
+  queue_draw ();
+}
+
+bool LineView::on_button_press_event(GdkEventButton* event) {
+	if (Line && !Line -> Hidden && Line -> plotted ()) {
+		if ((event->type == GDK_BUTTON_PRESS)) {
+			if (event->button == 1 && !Line -> Disabled) {
+				Line -> on_click_line ();
+			}
+			else if (event->button == 3) {
+				if (Line -> Disabled) {
+					menuPlotEnablePopup.popup(event->button, event->time);
+				} else {
+					menuPlotDisablePopup.popup(event->button, event->time);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the approximate memory used by the view, not counting the
+// line it displays or memory allocated inside GTK+.
+//
+unsigned long LineView::bytes () {
+  return sizeof (LineView) - 2 * sizeof (Graph) + Plot.bytes ()
+    + Residual.bytes ();
+}
+
+
+//==============================================================================
+// LineViewPool
+//==============================================================================
+
+LineViewPool::~LineViewPool () {
+  for (unsigned int i = 0; i < Views.size (); i ++) {
+    delete Views[i];
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// acquire (LineData *) : Returns a shown view bound to Line, reusing a free one
+// if there is one.
+//
+LineView *LineViewPool::acquire (LineData *Line) {
+  LineView *View;
+  if (Free.size () > 0) {
+    View = Free.back ();
+    Free.pop_back ();
+  } else {
+    View = new LineView;
+    Views.push_back (View);
+  }
+  View -> bind (Line);
+  View -> show ();
+  return View;
+}
+
+
+//------------------------------------------------------------------------------
+// release (LineView *) : Unbinds View and keeps it for the next call to
+// acquire (). View must already have been removed from its container.
+//
+void LineViewPool::release (LineView *View) {
+  View -> unbind ();
+  Free.push_back (View);
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the approximate memory used by every view in the pool
+//
+unsigned long LineViewPool::bytes () {
+  unsigned long Bytes = Views.capacity () * sizeof (LineView *);
+  for (unsigned int i = 0; i < Views.size (); i ++) {
+    Bytes += Views[i] -> bytes ();
+  }
+  return Bytes;
+}
@@ -0,0 +1,112 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineView class (lineview.h)
+//==============================================================================
+// The LineView class is a Gtk::EventBox that displays one LineData: a Graph of
+// the line profile, a second Graph of the XGremlin fit residuals, and an
+// optional table of the line parameters. Clicking on the view selects the
+// line, and a right click opens a menu to disable or hide it.
+//
+// A view is not tied to any one line. bind () points it at a LineData and
+// unbind () releases it again, so that a few views can display any number of
+// lines. LineViewPool keeps the views that are not in use for the next line
+// to be displayed.
+//
+#ifndef FAST_LINE_VIEW_H
+#define FAST_LINE_VIEW_H
+
+#include <gtkmm/box.h>
+#include <gtkmm/eventbox.h>
+#include <gtkmm/frame.h>
+#include <gtkmm/menu.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/treestore.h>
+#include <vector>
+#include "linedata.h"
+#include "graph.h"
+
+using namespace::std;
+
+class LineView : public Gtk::EventBox {
+
+  public:
+    LineView ();
+    ~LineView ();
+
+    // Display LineIn, first releasing any line already displayed
+    void bind (LineData *LineIn);
+    void unbind ();
+    LineData *line () { return Line; }
+
+    // Show the selected, disabled and hidden states of the bound line
+    void refresh ();
+    unsigned long bytes ();
+
+  protected:
+    virtual bool on_expose_event(GdkEventExpose* event);
+    virtual bool on_button_press_event(GdkEventButton* event);
+
+    class ModelColumns : public Gtk::TreeModel::ColumnRecord {
+      public:
+        Gtk::TreeModelColumn<string> data;
+        ModelColumns() { add(data); }
+    };
+
+    ModelColumns m_Columns;
+
+  private:
+    LineData *Line;		// The line displayed, or NULL
+    unsigned long Revision;	// Line -> Revision when LineParams was filled
+    Graph Plot;
+    Graph Residual;
+    Gtk::VBox Box;
+    Gtk::HBox ParamsBox;
+    Gtk::TreeView LineParams;
+    Glib::RefPtr<Gtk::TreeStore> m_refTreeModel;
+    Gtk::Frame DataFrame;
+
+    void prepareData ();
+
+    Gtk::Menu menuPlotEnablePopup;		// For a right click on a disabled line profile
+    Gtk::Menu menuPlotDisablePopup;		// For a right click on an enabled line profile
+
+    void on_popup_enable_line () { if (Line) Line -> on_popup_enable_line (); }
+    void on_popup_disable_line () { if (Line) Line -> on_popup_disable_line (); }
+    void on_popup_hide_line () { if (Line) Line -> on_popup_hide_line (); }
+};
+
+// The LineViews created so far, some of which are bound to lines and the rest
+// free to be bound to the next. Views are only created when every existing one
+// is in use, and are deleted with the pool.
+class LineViewPool {
+
+  private:
+    vector <LineView *> Views;
+    vector <LineView *> Free;
+
+  public:
+    LineViewPool () { /* Does nothing */ }
+    ~LineViewPool ();
+
+    LineView *acquire (LineData *Line);
+    void release (LineView *View);
+    unsigned int size () { return Views.size (); }
+    unsigned long bytes ();
+};
+
+#endif // FAST_LINE_VIEW_H
@@ -0,0 +1,207 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ModelSpectrum class (modelspectrum.cpp)
+//==============================================================================
+#include "modelspectrum.h"
+#include "voigtlsqfit.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace::std;
+
+// The grid range covered by the profile of line number Line.
+typedef struct line_range {
+  int Start, End;
+  unsigned int Line;
+} LineRange;
+
+// Comparison function used to sort line ranges by their first grid index.
+static bool lineRangeLessThan (const LineRange &a, const LineRange &b) {
+  return a.Start < b.Start;
+}
+
+
+//==============================================================================
+// CONSTRUCTORS AND DESTRUCTORS
+//==============================================================================
+
+ModelSpectrum::ModelSpectrum () {
+  Origin = 0.0;
+  Step = 0.0;
+  NumPoints = 0;
+}
+
+ModelSpectrum::ModelSpectrum (double OriginIn, double StepIn, int NumPointsIn) {
+  grid (OriginIn, StepIn, NumPointsIn);
+}
+
+
+//==============================================================================
+// RENDERING FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// grid (double, double, int) : Sets the wavenumber of the first point, the
+// point spacing, and the total number of points in the spectrum onto which the
+// model will be rendered. Any previously rendered model is discarded.
+//
+void ModelSpectrum::grid (double OriginIn, double StepIn, int NumPointsIn) {
+  Origin = OriginIn;
+  Step = StepIn;
+  NumPoints = NumPointsIn;
+  Segments.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// lineRange (XgLine &, int &, int &) : Returns in Start and End the grid
+// indices spanned by the rendered profile of Line. End is one past the last
+// point. Both are clipped to the extent of the spectrum. The width of a line is
+// its FWHM in mK, so its half-width in cm-1 is 0.0005 times the width, and a
+// Lorentzian falls to MODEL_PROFILE_TOLERANCE of its peak at sqrt (1 / tol - 1)
+// half-widths from its centre.
+//
+void ModelSpectrum::lineRange (XgLine &Line, int &Start, int &End) {
+  static const double Range = sqrt (1.0 / MODEL_PROFILE_TOLERANCE - 1.0);
+  double HalfWidth = 0.0005 * Line.width () * Range;
+  Start = int ((Line.wavenumber () - Origin - HalfWidth) / Step);
+  End = int ((Line.wavenumber () - Origin + HalfWidth) / Step) + 1;
+  if (Start < 0) Start = 0;
+  if (End > NumPoints) End = NumPoints;
+}
+
+
+//------------------------------------------------------------------------------
+// render (vector <XgLine> &) : Renders the Voigt profile of every line in Lines
+// once and sums them into the model. The line ranges are first sorted and swept
+// to merge overlapping ranges into segments, so that every profile can then be
+// added directly into the one segment that contains it.
+//
+void ModelSpectrum::render (vector <XgLine> &Lines) {
+  vector <LineRange> Ranges;
+  LineRange NextRange;
+  VoigtLsqfit voigtGen;
+
+  Segments.clear ();
+  if (Step <= 0.0 || NumPoints < 2) return;
+
+  // Find the grid range of each line, ignoring any that fall off the spectrum
+  for (unsigned int i = 0; i < Lines.size (); i ++) {
+    lineRange (Lines[i], NextRange.Start, NextRange.End);
+    NextRange.Line = i;
+    if (NextRange.End - NextRange.Start >= 2) Ranges.push_back (NextRange);
+  }
+  if (Ranges.size () == 0) return;
+  sort (Ranges.begin (), Ranges.end (), lineRangeLessThan);
+
+  // Sweep through the sorted ranges, merging those that overlap into segments
+  vector <int> SegmentEnds;
+  vector <unsigned int> LineSegment (Ranges.size ());
+  ModelSegment NextSegment;
+  NextSegment.Start = Ranges[0].Start;
+  int CurrentEnd = Ranges[0].End;
+  for (unsigned int i = 0; i < Ranges.size (); i ++) {
+    if (Ranges[i].Start > CurrentEnd) {
+      Segments.push_back (NextSegment);
+      SegmentEnds.push_back (CurrentEnd);
+      NextSegment.Start = Ranges[i].Start;
+      CurrentEnd = Ranges[i].End;
+    } else if (Ranges[i].End > CurrentEnd) {
+      CurrentEnd = Ranges[i].End;
+    }
+    LineSegment[i] = Segments.size ();
+  }
+  Segments.push_back (NextSegment);
+  SegmentEnds.push_back (CurrentEnd);
+  for (unsigned int i = 0; i < Segments.size (); i ++) {
+    Segments[i].Y.assign (SegmentEnds[i] - Segments[i].Start, 0.0);
+  }
+
+  // Render each line once, accumulating its profile into its segment. Only the
+  // first two x values are used by VoigtLsqfit::voigt to set the grid spacing.
+  for (unsigned int i = 0; i < Ranges.size (); i ++) {
+    XgLine &Line = Lines[Ranges[i].Line];
+    ModelSegment &Segment = Segments[LineSegment[i]];
+    unsigned int n = Ranges[i].End - Ranges[i].Start;
+    vector <double> x (n), y (n, 0.0);
+    for (unsigned int k = 0; k < n; k ++) {
+      x[k] = Origin + (Ranges[i].Start + (int)k) * Step;
+    }
+    voigtGen.voigt (n, &x[0], &y[0], 0.0005 * Line.width () / Step,
+      Line.peak (), Line.dmp (), Line.wavenumber ());
+    int Offset = Ranges[i].Start - Segment.Start;
+    for (unsigned int k = 0; k < n; k ++) {
+      Segment.Y[Offset + k] += y[k];
+    }
+  }
+}
+
+
+//==============================================================================
+// GET FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// index (double) : Returns the index of the grid point nearest to Wavenumber.
+//
+int ModelSpectrum::index (double Wavenumber) {
+  if (Step <= 0.0) return 0;
+  return int (floor ((Wavenumber - Origin) / Step + 0.5));
+}
+
+
+//------------------------------------------------------------------------------
+// value (int) : Returns the model at grid point Index. A binary search is used
+// to find the segment containing the point. Zero is returned for any point not
+// covered by a line.
+//
+double ModelSpectrum::value (int Index) {
+  int a = 0, b = Segments.size () - 1;
+  while (a <= b) {
+    int m = (a + b) / 2;
+    if (Index < Segments[m].Start) {
+      b = m - 1;
+    } else if (Index >= Segments[m].end ()) {
+      a = m + 1;
+    } else {
+      return Segments[m].Y[Index - Segments[m].Start];
+    }
+  }
+  return 0.0;
+}
+
+
+//------------------------------------------------------------------------------
+// value (double) : Returns the model at the grid point nearest to Wavenumber.
+//
+double ModelSpectrum::value (double Wavenumber) {
+  return value (index (Wavenumber));
+}
+
+
+//------------------------------------------------------------------------------
+// numStoredPoints () : Returns the number of grid points held in the sparse
+// accumulation buffer.
+//
+unsigned int ModelSpectrum::numStoredPoints () {
+  unsigned int Total = 0;
+  for (unsigned int i = 0; i < Segments.size (); i ++) {
+    Total += Segments[i].Y.size ();
+  }
+  return Total;
+}
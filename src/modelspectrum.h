@@ -0,0 +1,93 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ModelSpectrum class (modelspectrum.h)
+//==============================================================================
+// A synthetic spectrum built from the fitted Voigt profiles of a list of
+// XGremlin lines. Each line is rendered exactly once onto the grid of the
+// experimental spectrum (defined by its first wavenumber, point spacing and
+// number of points) and summed into an accumulation buffer. Only the parts of
+// the grid that are covered by at least one line are stored, so the buffer is
+// made of a sorted set of dense segments rather than one array spanning the
+// whole spectrum.
+//
+// Once rendered, value () returns the model at any grid point, and the residual
+// of a line is simply the experimental data minus the model over that line's
+// plot window. Every blended neighbour is therefore accounted for, however many
+// of them overlap the line.
+//
+#ifndef MODEL_SPECTRUM_H
+#define MODEL_SPECTRUM_H
+
+#include <vector>
+#include "xgline.h"
+
+using namespace::std;
+
+// Each line profile is rendered out to where it has fallen below this fraction
+// of its peak, so that its wings still contribute to the residuals of its
+// neighbours. The range is found from a Lorentzian with the same width as the
+// line, whose wings fall more slowly than those of any Voigt profile of that
+// width. For 1e-3 this is about 32 half-widths either side of the centre, or
+// four times the plot window (PLOT_WIDTH_RANGE in CoreDefs.h). Anything beyond
+// it is left out of the model, so a residual may be off by up to this fraction
+// of the peak of each neighbour that is further away.
+#define MODEL_PROFILE_TOLERANCE 1.0e-3
+
+// A contiguous run of model points starting at grid index Start.
+typedef struct model_segment {
+  int Start;
+  vector <double> Y;
+
+  model_segment () { Start = 0; }
+  int end () const { return Start + (int)Y.size (); }
+} ModelSegment;
+
+class ModelSpectrum {
+
+  private:
+    vector <ModelSegment> Segments;  // Sorted, non-overlapping segments
+    double Origin;                   // Wavenumber of grid point 0
+    double Step;                     // Grid point spacing
+    int NumPoints;                   // Number of points in the full grid
+
+  public:
+    ModelSpectrum ();
+    ModelSpectrum (double OriginIn, double StepIn, int NumPointsIn);
+    ~ModelSpectrum () { }
+
+    // Define the spectrum grid and render a set of lines onto it. Any data from
+    // a previous call to render () is discarded.
+    void grid (double OriginIn, double StepIn, int NumPointsIn);
+    void render (vector <XgLine> &Lines);
+    void clear () { Segments.clear (); }
+
+    // Returns the grid indices spanned by the rendered profile of Line
+    void lineRange (XgLine &Line, int &Start, int &End);
+
+    // GET functions for the rendered model
+    double value (int Index);
+    double value (double Wavenumber);
+    int index (double Wavenumber);
+    double origin () { return Origin; }
+    double step () { return Step; }
+    int numPoints () { return NumPoints; }
+    unsigned int numSegments () { return Segments.size (); }
+    unsigned int numStoredPoints ();
+};
+
+#endif // MODEL_SPECTRUM_H
@@ -48,6 +48,39 @@ OptionsWindow::OptionsWindow () :
   Gtk::RadioButton::Group group = ButtonCorrectSNR.get_group();
   ButtonDoNotCorrectSNR.set_group (group);
 
+  // Add the option to refit blended lines simultaneously
+  BoxOptions.pack_start (FrameFitBlends, false, false, 0);
+  FrameFitBlends.set_label ("Line refitting");
+  FrameFitBlends.add (BoxFitBlends);
+  BoxFitBlends.pack_start (ButtonFitSingleLines);
+  BoxFitBlends.pack_start (ButtonFitBlends);
+  ButtonFitSingleLines.set_label ("Fit each line separately. Hold blended lines fixed.");
+  ButtonFitBlends.set_label      ("Fit all the lines in a blend simultaneously.");
+  Gtk::RadioButton::Group fitGroup = ButtonFitBlends.get_group();
+  ButtonFitSingleLines.set_group (fitGroup);
+
+  // Add the number of threads used for background jobs and line fitting
+  BoxOptions.pack_start (FrameThreads, false, false, 0);
+  FrameThreads.set_label ("Background jobs");
+  FrameThreads.add (BoxThreads);
+  BoxThreads.pack_start (LabelThreads, false, false, 5);
+  BoxThreads.pack_start (SpinThreads, false, false, 0);
+  LabelThreads.set_text ("Number of worker threads:");
+  SpinThreads.set_range (1, 64);
+  SpinThreads.set_increments (1, 4);
+  SpinThreads.set_digits (0);
+
+  // Add the size limit of the cache of parsed input files
+  BoxOptions.pack_start (FrameCache, false, false, 0);
+  FrameCache.set_label ("Input file cache");
+  FrameCache.add (BoxCache);
+  BoxCache.pack_start (LabelCache, false, false, 5);
+  BoxCache.pack_start (SpinCache, false, false, 0);
+  LabelCache.set_text ("Size limit in MB (0 to disable):");
+  SpinCache.set_range (0, 65536);
+  SpinCache.set_increments (64, 1024);
+  SpinCache.set_digits (0);
+
   // Add the OK and Cancel buttons to the bottom of the window
   BaseVBox.pack_start (BoxOKCancel, false, false, 10);
   BoxOKCancel.pack_end (ButtonOK, false, false, 2);
@@ -63,6 +96,12 @@ OptionsWindow::OptionsWindow () :
   
   CorrectSignalToNoise = false;
   ButtonDoNotCorrectSNR.set_active (true);
+  FitBlends = true;
+  ButtonFitBlends.set_active (true);
+  NumThreads = 1;
+  SpinThreads.set_value (NumThreads);
+  CacheLimit = 0;
+  SpinCache.set_value (CacheLimit);
 }
 
 
@@ -72,6 +111,10 @@ OptionsWindow::OptionsWindow () :
 void OptionsWindow::on_button_ok () {
   if (ButtonCorrectSNR.get_active ()) CorrectSignalToNoise = true;
   if (ButtonDoNotCorrectSNR.get_active ()) CorrectSignalToNoise = false;
+  if (ButtonFitBlends.get_active ()) FitBlends = true;
+  if (ButtonFitSingleLines.get_active ()) FitBlends = false;
+  NumThreads = SpinThreads.get_value_as_int ();
+  CacheLimit = SpinCache.get_value_as_int ();
   hide ();  
 }
 
@@ -87,6 +130,15 @@ void OptionsWindow::on_button_cancel () {
     ButtonCorrectSNR.set_active (false);
     ButtonDoNotCorrectSNR.set_active (true);
   }
+  if (FitBlends == true) {
+    ButtonFitBlends.set_active (true);
+    ButtonFitSingleLines.set_active (false);
+  } else {
+    ButtonFitBlends.set_active (false);
+    ButtonFitSingleLines.set_active (true);
+  }
+  SpinThreads.set_value (NumThreads);
+  SpinCache.set_value (CacheLimit);
   hide ();  
 }
 
@@ -100,9 +152,36 @@ void OptionsWindow::set_correct_snr (bool a) {
 }
 
 
+//------------------------------------------------------------------------------
+// set_fit_blends () :
+//
+void OptionsWindow::set_fit_blends (bool a) {
+  FitBlends = a;
+  on_button_cancel ();
+}
+
+
+
+
 
 
 
 
 
 
+//------------------------------------------------------------------------------
+// set_num_threads () :
+//
+void OptionsWindow::set_num_threads (unsigned int a) {
+  NumThreads = a < 1 ? 1 : a;
+  on_button_cancel ();
+}
+
+
+//------------------------------------------------------------------------------
+// set_cache_limit () :
+//
+void OptionsWindow::set_cache_limit (unsigned int a) {
+  CacheLimit = a;
+  on_button_cancel ();
+}
@@ -30,6 +30,8 @@
 #include <gtkmm/radiobutton.h>
 #include <gtkmm/stock.h>
 #include <gtkmm/frame.h>
+#include <gtkmm/label.h>
+#include <gtkmm/spinbutton.h>
 #include <string>
 
 using namespace::std;
@@ -37,6 +39,9 @@ using namespace::std;
 class OptionsWindow : public Gtk::Window {
   private:
     bool CorrectSignalToNoise;
+    bool FitBlends;
+    unsigned int NumThreads;
+    unsigned int CacheLimit;
 
     // GTKmm widgets
     Gtk::ScrolledWindow Scroll;
@@ -49,6 +54,18 @@ class OptionsWindow : public Gtk::Window {
     Gtk::VBox BoxCorrectSNR;
     Gtk::RadioButton ButtonDoNotCorrectSNR;
     Gtk::RadioButton ButtonCorrectSNR;
+    Gtk::Frame FrameFitBlends;
+    Gtk::VBox BoxFitBlends;
+    Gtk::RadioButton ButtonFitSingleLines;
+    Gtk::RadioButton ButtonFitBlends;
+    Gtk::Frame FrameThreads;
+    Gtk::HBox BoxThreads;
+    Gtk::Label LabelThreads;
+    Gtk::SpinButton SpinThreads;
+    Gtk::Frame FrameCache;
+    Gtk::HBox BoxCache;
+    Gtk::Label LabelCache;
+    Gtk::SpinButton SpinCache;
 
     Gtk::HBox BoxOKCancel;
     Gtk::Button ButtonOK;
@@ -64,6 +81,12 @@ class OptionsWindow : public Gtk::Window {
 
     bool correct_snr () { return CorrectSignalToNoise; }
     void set_correct_snr (bool a);
+    bool fit_blends () { return FitBlends; }
+    void set_fit_blends (bool a);
+    unsigned int num_threads () { return NumThreads; }
+    void set_num_threads (unsigned int a);
+    unsigned int cache_limit () { return CacheLimit; }
+    void set_cache_limit (unsigned int a);
 };
 
 #endif // LINE_ANALYSER_OPTIONS_WINDOW
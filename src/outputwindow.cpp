@@ -206,7 +206,7 @@ void OutputWindow::set_button_signals () {
 //------------------------------------------------------------------------------
 // set_results (...) :
 //
-void OutputWindow::set_results (vector <vector <DataBF> > ResultsIn, 
+void OutputWindow::set_results (vector <vector <BfResult> > ResultsIn, 
   vector <vector <XgLine> > FitsIn, vector <vector <KzLine> > TargetsIn) {
   Fits.clear ();
   Targets.clear ();
@@ -224,201 +224,11 @@ void OutputWindow::set_results (vector <vector <DataBF> > ResultsIn,
 
 
 //------------------------------------------------------------------------------
-// set_result_strings () :
+// set_result_strings () : Formats the results as a set of output fields (see
+// ResultTable::fields ()).
 //
 void OutputWindow::set_result_strings () {
-  OutputField NextField;
-  vector <string> ResultsForNextLevel;
-  ostringstream oss;
-
-  ResultStrings.clear ();
-  oss.setf( std::ios::fixed, std:: ios::floatfield);
-  NextField.Active = false;
-  NextField.Selected =false;
-  for (unsigned int l = 0; l < NUM_BF_OUTPUT_FIELDS; l ++) {
-    NextField.Name = FAST_BF_FIELD_NAMES [l];
-    NextField.List = OUTPUT_BF_LIST;
-    NextField.Value.clear ();
-    for (unsigned int Level = 0; Level < Results.size (); Level ++) {
-      ResultsForNextLevel.clear ();
-      for (unsigned int Line = 0; Line < Results[Level].size (); Line ++) {
-        switch (l) {
-          case 0:
-            NextField.List = OUTPUT_BF_LIST + OUTPUT_FITTED_LIST;
-            ResultsForNextLevel.push_back(Results[Level][Line].spectrum);
-            break;
-          case 1:
-            oss.str (""); oss << Results[Level][Line].index;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 2:
-            NextField.List = OUTPUT_BF_LIST + OUTPUT_FITTED_LIST + OUTPUT_TARGET_LIST;
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Results[Level][Line].wavenumber;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 3:
-            NextField.List = OUTPUT_BF_LIST + OUTPUT_FITTED_LIST;
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(0) << Results[Level][Line].eqwidth;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 4:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_line;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 5:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_cal;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 6:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_trans;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 7:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_total;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 8:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(0) << Results[Level][Line].err_eqwidth;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 9:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(4) << Results[Level][Line].br_frac;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 10:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_br_frac;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 11:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << (Results[Level][Line].a / pow(10.0,6));
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 12:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_a;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 13:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Results[Level][Line].loggf;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 14:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Results[Level][Line].dex;
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-        }
-      }
-      oss.unsetf (ios::scientific);
-      oss.unsetf (ios::fixed);
-      NextField.Value.push_back (ResultsForNextLevel);
-    }
-    NextField.ResultIndex = l;
-    ResultStrings.push_back (NextField);
-  }
-  
-  for (unsigned int l = 0; l < NUM_FITTED_OUTPUT_FIELDS; l ++) {
-    NextField.Name = FAST_FITTED_FIELD_NAMES [l];
-    NextField.List = OUTPUT_FITTED_LIST;
-    NextField.Value.clear ();
-    for (unsigned int Level = 0; Level < Fits.size (); Level ++) {
-      ResultsForNextLevel.clear ();
-      for (unsigned int Line = 0; Line < Fits[Level].size (); Line ++) {
-        switch (l) {
-          case 0:
-            oss.str (""); oss << Fits[Level][Line].line ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 1:
-            ResultsForNextLevel.push_back(Fits[Level][Line].id ());
-            break;
-          case 2:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(1) << Fits[Level][Line].peak ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 3:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Fits[Level][Line].width ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 4:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(4) << Fits[Level][Line].dmp ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 5:
-            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epstot ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 6:
-            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epsevn ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 7:
-            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epsodd ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 8:
-            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epsran ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-        }
-      }
-      oss.unsetf (ios::scientific);
-      oss.unsetf (ios::fixed);
-      NextField.Value.push_back (ResultsForNextLevel); 
-    }
-    NextField.ResultIndex = NUM_BF_OUTPUT_FIELDS + l;
-    ResultStrings.push_back (NextField);    
-  }
-
-  for (unsigned int l = 0; l < NUM_TARGET_OUTPUT_FIELDS; l ++) {
-    NextField.Name = FAST_TARGET_FIELD_NAMES [l];
-    NextField.List = OUTPUT_TARGET_LIST;
-    NextField.Value.clear ();
-    for (unsigned int Level = 0; Level < Fits.size (); Level ++) {
-      ResultsForNextLevel.clear ();
-      for (unsigned int Line = 0; Line < Fits[Level].size (); Line ++) {
-        switch (l) {
-          case 0:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(4) << Targets[Level][Line].lambda ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 1:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].loggf ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 2:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].brFrac ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 3:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].eLower ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 4:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(1) << Targets[Level][Line].jLower ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 5:
-            ResultsForNextLevel.push_back (Targets[Level][Line].configLower ());
-            break;
-          case 6:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].eUpper ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 7:
-            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(1) << Targets[Level][Line].jUpper ();
-            ResultsForNextLevel.push_back (oss.str ());
-            break;
-          case 8:
-            ResultsForNextLevel.push_back (Targets[Level][Line].configUpper ());
-            break;
-        }
-      }
-      oss.unsetf (ios::scientific);
-      oss.unsetf (ios::fixed);
-      NextField.Value.push_back (ResultsForNextLevel);
-    }
-    NextField.ResultIndex = NUM_BF_OUTPUT_FIELDS + NUM_FITTED_OUTPUT_FIELDS + l;
-    ResultStrings.push_back (NextField);
-  }
+  ResultStrings = ResultTable::fields (Results, Fits, Targets);
 }
 
 
@@ -725,25 +535,28 @@ void OutputWindow::on_change_combo_output () {
 void OutputWindow::on_button_save () {
   string Filename = EntryFileSelection.get_text ();
   int FileType = ComboOutputType.get_active_row_number ();
+  string Delimiter;
   try {
     if (SelectedFields.size () == 0)
       throw (Error (FLT_SYNTAX_ERROR, "Please specify some fields to output", "The list of 'Selected Fields' is currently empty"));
     if (Filename == "") 
       throw (Error (FLT_SYNTAX_ERROR, "Please specify an output file name", "The 'Output file name' box is currently empty"));
-    switch (FileType) {
-      case 0: writeCSV (Filename); break;
-      case 1: writeLaTeX (Filename); break;
-      case 2: writeAASTeX (Filename); break;
-      default: 
-        throw (Error (FLT_SYNTAX_ERROR, 
-          "Please select an output file type", 
-          "Use the drop down box on the left of the window"));
-    }
+    if (FileType < OUTPUT_CSV || FileType > OUTPUT_AASTEX)
+      throw (Error (FLT_SYNTAX_ERROR, 
+        "Please select an output file type", 
+        "Use the drop down box on the left of the window"));
+    if (ButtonDelimitComma.get_active ()) Delimiter = ",";
+    if (ButtonDelimitSpace.get_active ()) Delimiter = " ";
+    if (ButtonDelimitTab.get_active ()) Delimiter = "\t";
+    if (ButtonDelimitOther.get_active ()) Delimiter = EntryDelimitOther.get_text ();
+    Filename = ResultTable::filename (Filename, FileType);
+    confirm_file_overwrite (Filename);
+    ResultTable::write (Filename, FileType, SelectedFields, Delimiter);
     hide ();
-  } catch (Error *Err) {
-    if (Err->code != FLT_SAVE_ABORTED) {
-      Gtk::MessageDialog dialog(*this, Err->message, false, Gtk::MESSAGE_ERROR, Gtk::BUTTONS_OK);
-      dialog.set_secondary_text(Err->subtext);
+  } catch (Error Err) {
+    if (Err.code != FLT_SAVE_ABORTED) {
+      Gtk::MessageDialog dialog(*this, Err.message, false, Gtk::MESSAGE_ERROR, Gtk::BUTTONS_OK);
+      dialog.set_secondary_text(Err.subtext);
       dialog.run();
     }
   }
@@ -771,195 +584,3 @@ void OutputWindow::confirm_file_overwrite (string Filename) throw (Error) {
     if (result == Gtk::RESPONSE_NO) { throw (Error (FLT_SAVE_ABORTED)); }
   }
 }
-
-
-//------------------------------------------------------------------------------
-// writeCSV (string, string) : 
-//
-void OutputWindow::writeCSV (string Filename) throw (Error) {
-  ostringstream oss;
-  string Delimiter;
-  
-  // Ensure the filename has a ".csv" or ".txt" extension then use it to open an
-  // output file stream
-  if (Filename.substr (Filename.size () - 4, 4) != ".csv" && 
-    Filename.substr (Filename.size () - 4, 4) != ".txt") {
-    Filename = Filename + ".csv";
-  }
-  confirm_file_overwrite (Filename);
-  ofstream Output (Filename.c_str(), ios::out);
-  
-  if (ButtonDelimitComma.get_active ()) Delimiter = ",";
-  if (ButtonDelimitSpace.get_active ()) Delimiter = " ";
-  if (ButtonDelimitTab.get_active ()) Delimiter = "\t";
-  if (ButtonDelimitOther.get_active ()) Delimiter = EntryDelimitOther.get_text ();
-  
-  // Only proceed with the output if the file has been opened correctly
-  if (Output.is_open ()) {
-  
-    // Output the column headers
-    for (unsigned int Field = 0; Field < SelectedFields.size (); Field ++) {
-      oss << SelectedFields[Field] -> Name << Delimiter;
-    }
-    Output << oss.str().substr (0, oss.str().size() - Delimiter.size ()) << endl;
-    oss.str("");
-
-    // Construct the delimited output strings, one spectral line at a time, and
-    // output them to file. Close the output file once finished.
-    for (unsigned int Level = 0; Level < SelectedFields[0]->Value.size (); Level ++) {
-      for (unsigned int Line = 0; Line < SelectedFields[0]->Value[Level].size (); Line ++) {
-        for (unsigned int Field = 0; Field < SelectedFields.size (); Field ++) {
-//          cout << Level << " " << Line << " " << Field << ": " << flush << SelectedFields[Field] -> Value[Level][Line] << endl;
-          oss << SelectedFields[Field] -> Value[Level][Line] << Delimiter;
-        }
-        Output << oss.str().substr (0, oss.str().size() - Delimiter.size ()) << endl;
-        oss.str("");
-      }
-      Output << endl;
-    }
-    Output.close ();
-    
-  // If an error was encountered on trying to open the output file, generate an
-  // Error to inform the user of the problem.
-  } else {
-    oss.str ("");
-    oss << "Unable to open " << Filename;
-    throw (Error (FLT_FILE_OPEN_ERROR, oss.str (), "Check you have write permission for this file"));
-  }
-}
-
-
-//------------------------------------------------------------------------------
-// writeLaTeX (string) : 
-//
-void OutputWindow::writeLaTeX (string Filename) throw (Error) {
-  ostringstream oss;
-  
-  // Ensure the filename has a ".tex" extension then use it to open an output
-  // file stream
-  if (Filename.substr (Filename.size () - 4, 4) != ".tex") {
-    Filename = Filename + ".tex";
-  }
-  confirm_file_overwrite (Filename);
-  ofstream Output (Filename.c_str(), ios::out);
-  
-  // Only proceed with the output if the file has been opened correctly
-  if (Output.is_open ()) {
-  
-    // Generate the LaTeX table header
-    Output << "\\begin{table}" << endl;
-    Output << "\\centering" << endl;
-    Output << "\\begin{tabular}{";
-    for (unsigned int Field = 0; Field < SelectedFields.size (); Field ++) {
-      Output << "l";
-    }
-    Output << "}" << endl;
-    for (unsigned int Field = 0; Field < SelectedFields.size (); Field ++) {
-      oss << SelectedFields[Field] -> Name << " & ";
-    }
-    Output << oss.str().substr (0, oss.str().size() - 2) << "\\\\" << endl;
-    Output << "\\hline \\hline" << endl;
-    
-    // Write the FAST results to file
-    Output << getLaTeXRows () << endl;
-
-    // Finish off the table and close the output file
-    Output << "\\end{tabular}" << endl;
-    Output << "\\caption{Your caption goes here}" << endl;
-    Output << "\\label{table:fastresults}" << endl;
-    Output << "\\end{table}" << endl;
-    Output.close ();
-  
-  // If an error was encountered on trying to open the output file, generate an
-  // Error to inform the user of the problem.
-  } else {
-    oss.str ("");
-    oss << "Unable to open " << Filename;
-    throw (Error (FLT_FILE_OPEN_ERROR, oss.str (), "Check you have write permission for this file"));
-  }
-}
-
-
-//------------------------------------------------------------------------------
-// writeAASTeX (string) : 
-//
-void OutputWindow::writeAASTeX (string Filename) throw (Error) {
-  ostringstream oss;
-  
-  // Ensure the filename has a ".tex" extension then use it to open an output
-  // file stream
-  if (Filename.substr (Filename.size () - 4, 4) != ".tex") {
-    Filename = Filename + ".tex";
-  }
-  confirm_file_overwrite (Filename);
-  ofstream Output (Filename.c_str(), ios::out);
-  
-  // Only proceed with the output if the file has been opened correctly
-  if (Output.is_open ()) {
-  
-    // Generate the AASTeX deluxe table header
-    Output << "\\begin{deluxetable}{";
-    for (unsigned int Field = 0; Field < SelectedFields.size (); Field ++) {
-      Output << "l";
-    }
-    Output << "}" << endl;
-    Output << "\\tablewidth{0pt}" << endl;
-    Output << "\\tabletypesize{\\scriptsize}" << endl;
-    Output << "\\tablecaption{Your caption goes here}" << endl;
-    Output << "\\tablehead{" << endl << "  ";
-    for (unsigned int Field = 0; Field < SelectedFields.size (); Field ++) {
-      oss << "\\colhead{" << SelectedFields[Field] -> Name << "} & ";
-    }
-    Output << oss.str().substr (0, oss.str().size() - 3) << endl << "}" << endl;
-    
-    // Output the data to file.
-    Output << "\\startdata" << endl;
-    Output << getLaTeXRows () << endl;
-    Output << "\\enddata" << endl;
-
-    // Finish off the table and close the output file
-    Output << "\\label{table:fastresults}" << endl;
-    Output << "\\end{deluxetable}" << endl;
-    Output.close ();
-  
-  // If an error was encountered on trying to open the output file, generate an
-  // Error to inform the user of the problem.
-  } else {
-    oss.str ("");
-    oss << "Unable to open " << Filename;
-    throw (Error (FLT_FILE_OPEN_ERROR, oss.str (), "Check you have write permission for this file"));
-  }
-}
-
-
-//------------------------------------------------------------------------------
-// getLaTeXRows () :Construct a stringstream containing the output data in LaTeX
-// table format. Take care to use "\\" at the end of all lines rather than a
-// field delimiter. Return the stringstream string for output in the calling
-// function.
-//
-string OutputWindow::getLaTeXRows () {
-  ostringstream oss;
-  for (unsigned int Level = 0; Level < SelectedFields[0]->Value.size (); Level ++) {
-    for (unsigned int Line = 0; Line < SelectedFields[0]->Value[Level].size (); Line ++) {
-      for (unsigned int Field = 0; Field < SelectedFields.size (); Field ++) {
-        oss << "$" << SelectedFields[Field] -> Value[Level][Line] << "$ & ";
-      }
-      oss.seekp ((long)oss.tellp () - 2);
-      oss << "\\\\\n";
-    }
-    oss << endl;
-  }
-  return oss.str().substr (0, oss.str().size() - 3);
-}
-
-
-
-
-
-
-
-
-
-
-
@@ -49,21 +49,8 @@
 #include "xgline.h"
 #include "kzline.h"
 #include "linedata.h"
-
-#define OUTPUT_BF_LIST 0x01
-#define OUTPUT_TARGET_LIST 0x02
-#define OUTPUT_FITTED_LIST 0x04
-
-using namespace::std;
-
-typedef struct output_field {
-  string Name;                        // Field name to be displayed
-  unsigned int ResultIndex;           // Index of this element in the 'Results' vector
-  bool Active;                        // Set to true when this field is included in move operations
-  bool Selected;                      // Set to true when this field is selected for output
-  vector < vector <string> > Value;   // A copy of the field value, obtained from AnalyserWindow
-  unsigned short int List;
-} OutputField;
+#include "bfengine.h"
+#include "resulttable.h"
 
 #define NUM_OUTPUTWINDOW_TYPES 3
 const string OUTPUTWINDOW_TYPES [NUM_OUTPUTWINDOW_TYPES] = 
@@ -71,7 +58,7 @@ const string OUTPUTWINDOW_TYPES [NUM_OUTPUTWINDOW_TYPES] =
 
 class OutputWindow : public Gtk::Window {
   private:
-    vector <vector <DataBF> > Results;
+    vector <vector <BfResult> > Results;
     vector <vector <XgLine> > Fits;
     vector <vector <KzLine> > Targets;
     vector <OutputField> ResultStrings;
@@ -151,10 +138,6 @@ class OutputWindow : public Gtk::Window {
     void set_display_fields ();
     void display_fields ();
     
-    void writeCSV (string Filename) throw (Error);
-    void writeLaTeX (string Filename) throw (Error);
-    void writeAASTeX (string Filename) throw (Error);
-    string getLaTeXRows ();
     void confirm_file_overwrite (string Filename) throw (Error);
     
     class ColumnsFields : public Gtk::TreeModel::ColumnRecord {
@@ -170,7 +153,7 @@ class OutputWindow : public Gtk::Window {
     OutputWindow ();
     ~OutputWindow () { /* Does nothing */ }
 
-    void set_results (vector <vector <DataBF> > ResultsIn, vector <vector <XgLine> > FitsIn, vector <vector <KzLine> >);
+    void set_results (vector <vector <BfResult> > ResultsIn, vector <vector <XgLine> > FitsIn, vector <vector <KzLine> >);
 };
 
 #endif // LINE_ANALYSER_OUTPUT_WINDOW
@@ -0,0 +1,415 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// OverviewPlot class (overviewplot.cpp)
+//==============================================================================
+#include "overviewplot.h"
+#include "xgspectrum.h"
+#include "trace.h"
+#include <pangomm/layout.h>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// Default constructor : Creates an empty plot. Nothing is drawn until a source
+// is given with source ().
+//
+OverviewPlot::OverviewPlot () {
+  DataRevision = LinesRevision = 0;
+  DataMin = DataMax = Step = 0.0;
+  ViewMin = ViewMax = 0.0;
+  ColumnsMin = ColumnsMax = 0.0;
+  Dragging = Moved = false;
+  DragX = DragViewMin = 0.0;
+  set_size_request (400, 120);
+  add_events (Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK
+    | Gdk::POINTER_MOTION_MASK | Gdk::SCROLL_MASK);
+}
+
+
+//------------------------------------------------------------------------------
+// changed (XgSpectrum *) : Returns true if Spectrum is not the spectrum that
+// Pyramid and Markers were built for. A spectrum is recognised by its name and
+// by the revisions of its data and lines, which change with every edit. NULL
+// means that the spectrum cannot be read at the moment, rather than that it
+// has gone, so it never counts as a change.
+//
+bool OverviewPlot::changed (XgSpectrum *Spectrum) {
+  if (Spectrum == NULL) return false;
+  return Spectrum -> name () != Name
+    || Spectrum -> dataRevision () != DataRevision
+    || Spectrum -> linesRevision () != LinesRevision;
+}
+
+
+//------------------------------------------------------------------------------
+// spectrum () : Returns the spectrum to plot, or NULL if it cannot be read at
+// the moment, after rebuilding Pyramid and Markers if the spectrum has changed.
+// While the spectrum cannot be read, the pyramid, markers and view are kept as
+// they are. The whole spectrum is shown if it has been replaced by a different
+// one.
+//
+XgSpectrum *OverviewPlot::spectrum () {
+  XgSpectrum *Spectrum = Source.empty () ? NULL : Source ();
+  if (!changed (Spectrum)) return Spectrum;
+  TRACE_SCOPE ("OverviewPlot::spectrum");
+
+  bool NewData = Spectrum -> dataRevision () != DataRevision;
+  Name = Spectrum -> name ();
+  LinesRevision = Spectrum -> linesRevision ();
+  Markers.clear ();
+  ColumnsMin = ColumnsMax = 0.0;
+
+  // Build the pyramid, and find the wavenumber range and point spacing, of a
+  // spectrum that has not been plotted before
+  if (NewData) {
+    vector <Coord> &Data = *Spectrum -> dataPtr ();
+    DataRevision = Spectrum -> dataRevision ();
+    Pyramid.build (Data);
+    DataMin = DataMax = Step = 0.0;
+    if (Data.size () > 1) {
+      DataMin = Data.front ().x;
+      DataMax = Data.back ().x;
+      Step = (DataMax - DataMin) / (Data.size () - 1);
+    }
+    reset ();
+  }
+
+  // Mark every line in every list
+  vector < vector <XgLine> > *Lists = Spectrum -> linesPtr2 ();
+  for (unsigned int i = 0; i < Lists -> size (); i ++) {
+    for (unsigned int j = 0; j < (*Lists)[i].size (); j ++) {
+      OverviewMarker Marker;
+      Marker.x = (*Lists)[i][j].wavenumber ();
+      Marker.List = i;
+      Marker.Line = j;
+      Markers.push_back (Marker);
+    }
+  }
+  sort (Markers.begin (), Markers.end ());
+  return Spectrum;
+}
+
+
+//------------------------------------------------------------------------------
+// view (double, double) : Shows the wavenumbers from Min to Max. The range is
+// limited to between OV_MIN_POINTS data points and twice the whole spectrum.
+//
+void OverviewPlot::view (double Min, double Max) {
+  double Centre = (Min + Max) / 2.0, Span = Max - Min;
+  if (Step > 0.0) {
+    Span = max (Span, Step * OV_MIN_POINTS);
+    Span = min (Span, 2.0 * (DataMax - DataMin));
+  }
+  if (!(Span > 0.0)) return;
+  ViewMin = Centre - Span / 2.0;
+  ViewMax = Centre + Span / 2.0;
+  queue_draw ();
+}
+
+
+//------------------------------------------------------------------------------
+// reset () : Shows the whole spectrum
+//
+void OverviewPlot::reset () {
+  if (DataMax > DataMin) view (DataMin, DataMax);
+}
+
+
+//------------------------------------------------------------------------------
+// userView (double, double) : Changes the range in view in response to the
+// user, and tells anything that is following the plot.
+//
+void OverviewPlot::userView (double Min, double Max) {
+  view (Min, Max);
+  m_signal_view_changed.emit (ViewMin, ViewMax);
+}
+
+
+//------------------------------------------------------------------------------
+// columns (vector <Coord> &, int) : Finds the lowest and highest intensity in
+// each pixel column of a plot Width pixels wide, unless they have already been
+// found for the current view. Each column takes the points whose wavenumbers
+// fall within it.
+//
+void OverviewPlot::columns (vector <Coord> &Data, int Width) {
+  if (ColumnsMin == ViewMin && ColumnsMax == ViewMax
+    && int (Filled.size ()) == Width) return;
+  ColumnLow.assign (Width, 0.0);
+  ColumnHigh.assign (Width, 0.0);
+  Filled.assign (Width, false);
+  double PerColumn = (ViewMax - ViewMin) / Width;
+
+  // The index of the first data point at or beyond the left of a column
+  unsigned int First, Last = 0;
+  for (int i = 0; i <= Width; i ++) {
+    double Index = ceil ((ViewMin + i * PerColumn - DataMin) / Step);
+    First = Last;
+    Last = (unsigned int) max (0.0, min (Index, double (Data.size ())));
+    if (i > 0) {
+      Filled[i - 1] = Pyramid.range (Data, First, Last,
+        ColumnLow[i - 1], ColumnHigh[i - 1]);
+    }
+  }
+  ColumnsMin = ViewMin;
+  ColumnsMax = ViewMax;
+}
+
+
+//------------------------------------------------------------------------------
+// drawSpectrum (Cairo::RefPtr<Cairo::Context>, vector <Coord> &, int, int,
+// int) : Draws the part of Data in view between the rows Top and Bottom,
+// scaled to fit the lowest and highest points in view.
+//
+void OverviewPlot::drawSpectrum (Cairo::RefPtr<Cairo::Context> cr,
+  vector <Coord> &Data, int Width, int Top, int Bottom) {
+  double Scale = Width / (ViewMax - ViewMin);
+  double Min = 0.0, Max = 0.0;
+  bool Found = false;
+
+  // Join the points themselves if there are fewer of them than pixels
+  int FirstPoint = max (0, int (floor ((ViewMin - DataMin) / Step)));
+  int LastPoint = min (int (Data.size ()) - 1,
+    int (ceil ((ViewMax - DataMin) / Step)));
+  bool Sparse = LastPoint - FirstPoint < Width;
+  if (Sparse) {
+    for (int i = FirstPoint; i <= LastPoint; i ++) {
+      if (!Found || Data[i].y < Min) Min = Data[i].y;
+      if (!Found || Data[i].y > Max) Max = Data[i].y;
+      Found = true;
+    }
+  } else {
+    columns (Data, Width);
+    for (int i = 0; i < Width; i ++) {
+      if (!Filled[i]) continue;
+      if (!Found || ColumnLow[i] < Min) Min = ColumnLow[i];
+      if (!Found || ColumnHigh[i] > Max) Max = ColumnHigh[i];
+      Found = true;
+    }
+  }
+  if (!Found) return;
+  if (Max == Min) { Max += 1.0; Min -= 1.0; }
+  double YScale = - (Bottom - Top) / (Max - Min);
+  double YOffset = Bottom - Min * YScale;
+
+  cr -> set_line_width (1.0);
+  cr -> set_source_rgb (0.0, 0.0, 0.0);
+  if (Sparse) {
+    for (int i = FirstPoint; i <= LastPoint; i ++) {
+      double x = (Data[i].x - ViewMin) * Scale, y = Data[i].y * YScale + YOffset;
+      if (i == FirstPoint) cr -> move_to (x, y);
+      else cr -> line_to (x, y);
+    }
+  } else {
+    bool Started = false;
+    for (int i = 0; i < Width; i ++) {
+      if (!Filled[i]) continue;
+      double High = ColumnHigh[i] * YScale + YOffset;
+      double Low = ColumnLow[i] * YScale + YOffset;
+      if (!Started) cr -> move_to (i + 0.5, High);
+      else cr -> line_to (i + 0.5, High);
+      cr -> line_to (i + 0.5, max (Low, High + 1.0));
+      Started = true;
+    }
+  }
+  cr -> stroke ();
+}
+
+
+//------------------------------------------------------------------------------
+// drawMarkers (Cairo::RefPtr<Cairo::Context>, int) : Draws a tick above the
+// spectrum for each line in view. Lines that fall in the same pixel column
+// share a tick, so at most Width ticks are drawn.
+//
+void OverviewPlot::drawMarkers (Cairo::RefPtr<Cairo::Context> cr, int Width) {
+  double Scale = Width / (ViewMax - ViewMin);
+  OverviewMarker Start;
+  Start.x = ViewMin;
+  vector <OverviewMarker>::iterator it = lower_bound (Markers.begin (),
+    Markers.end (), Start);
+  int LastColumn = -1;
+
+  cr -> set_line_width (1.0);
+  cr -> set_source_rgb (0.8, 0.0, 0.0);
+  for (; it != Markers.end () && it -> x <= ViewMax; it ++) {
+    int Column = int ((it -> x - ViewMin) * Scale);
+    if (Column == LastColumn) continue;
+    cr -> move_to (Column + 0.5, 1.0);
+    cr -> line_to (Column + 0.5, OV_MARKER_HEIGHT - 1.0);
+    LastColumn = Column;
+  }
+  cr -> stroke ();
+}
+
+
+//------------------------------------------------------------------------------
+// drawText (Cairo::RefPtr<Cairo::Context>, int, int) : Writes the name of the
+// spectrum at the top left of the plot, and the wavenumbers at either end of
+// the range in view along the bottom.
+//
+void OverviewPlot::drawText (Cairo::RefPtr<Cairo::Context> cr, int Width,
+  int Height) {
+  ostringstream oss;
+  int TextWidth, TextHeight;
+  oss.precision (3);
+  oss << fixed;
+
+  cr -> set_source_rgb (0.0, 0.0, 0.0);
+  Glib::RefPtr<Pango::Layout> Layout = create_pango_layout (Name);
+  cr -> move_to (4, OV_MARKER_HEIGHT);
+  Layout -> show_in_cairo_context (cr);
+
+  oss << ViewMin << " K";
+  Layout = create_pango_layout (oss.str ());
+  Layout -> get_pixel_size (TextWidth, TextHeight);
+  cr -> move_to (2, Height - TextHeight);
+  Layout -> show_in_cairo_context (cr);
+
+  oss.str ("");
+  oss << ViewMax << " K";
+  Layout = create_pango_layout (oss.str ());
+  Layout -> get_pixel_size (TextWidth, TextHeight);
+  cr -> move_to (Width - TextWidth - 2, Height - TextHeight);
+  Layout -> show_in_cairo_context (cr);
+  cr -> new_path ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_expose_event (GdkEventExpose *) : Draws the spectrum, its line markers and
+// the axis labels.
+//
+bool OverviewPlot::on_expose_event (GdkEventExpose *event) {
+  TRACE_SCOPE ("OverviewPlot::on_expose_event");
+  Glib::RefPtr<Gdk::Window> window = get_window ();
+  if (!window) return true;
+  Gtk::Allocation allocation = get_allocation ();
+  const int Width = allocation.get_width ();
+  const int Height = allocation.get_height ();
+
+  Cairo::RefPtr<Cairo::Context> cr = window -> create_cairo_context ();
+  cr -> rectangle (event -> area.x, event -> area.y, event -> area.width,
+    event -> area.height);
+  cr -> clip ();
+  cr -> set_source_rgb (1.0, 1.0, 1.0);
+  cr -> paint ();
+
+  XgSpectrum *Spectrum = spectrum ();
+  if (Spectrum == NULL || Step <= 0.0 || Width <= 0
+    || Height <= OV_MARKER_HEIGHT + OV_AXIS_HEIGHT) return true;
+
+  drawSpectrum (cr, *Spectrum -> dataPtr (), Width, OV_MARKER_HEIGHT,
+    Height - OV_AXIS_HEIGHT);
+  drawMarkers (cr, Width);
+  drawText (cr, Width, Height);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// on_scroll_event (GdkEventScroll *) : Zooms in or out by OV_ZOOM_STEP, keeping
+// the wavenumber under the pointer where it is.
+//
+bool OverviewPlot::on_scroll_event (GdkEventScroll *event) {
+  int Width = get_allocation ().get_width ();
+  if (Width <= 0 || ViewMax <= ViewMin) return true;
+  double Factor;
+  if (event -> direction == GDK_SCROLL_UP) Factor = 1.0 / OV_ZOOM_STEP;
+  else if (event -> direction == GDK_SCROLL_DOWN) Factor = OV_ZOOM_STEP;
+  else return true;
+
+  double Fraction = event -> x / Width;
+  double Anchor = ViewMin + Fraction * (ViewMax - ViewMin);
+  double Span = (ViewMax - ViewMin) * Factor;
+  userView (Anchor - Fraction * Span, Anchor + (1.0 - Fraction) * Span);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// on_button_press_event (GdkEventButton *) : Starts a drag with the left
+// button, or shows the whole spectrum for the right button.
+//
+bool OverviewPlot::on_button_press_event (GdkEventButton *event) {
+  if (event -> type != GDK_BUTTON_PRESS) return true;
+  if (event -> button == 1) {
+    Dragging = true;
+    Moved = false;
+    DragX = event -> x;
+    DragViewMin = ViewMin;
+  } else if (event -> button == 3) {
+    reset ();
+    m_signal_view_changed.emit (ViewMin, ViewMax);
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// on_motion_notify_event (GdkEventMotion *) : Pans the plot while the left
+// button is held down.
+//
+bool OverviewPlot::on_motion_notify_event (GdkEventMotion *event) {
+  int Width = get_allocation ().get_width ();
+  if (!Dragging || Width <= 0) return true;
+  if (fabs (event -> x - DragX) > 2.0) Moved = true;
+  if (Moved) {
+    double Span = ViewMax - ViewMin;
+    double Min = DragViewMin - (event -> x - DragX) * Span / Width;
+    userView (Min, Min + Span);
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// on_button_release_event (GdkEventButton *) : Ends a drag. If the pointer did
+// not move, this was a click, and the line whose marker is nearest to it is
+// passed on with signal_line_clicked ().
+//
+bool OverviewPlot::on_button_release_event (GdkEventButton *event) {
+  int Width = get_allocation ().get_width ();
+  if (event -> button != 1 || !Dragging) return true;
+  Dragging = false;
+  if (Moved || Width <= 0 || Markers.size () == 0) return true;
+
+  double PerPixel = (ViewMax - ViewMin) / Width;
+  OverviewMarker Click;
+  Click.x = ViewMin + event -> x * PerPixel;
+  vector <OverviewMarker>::iterator Next = lower_bound (Markers.begin (),
+    Markers.end (), Click);
+  vector <OverviewMarker>::iterator Nearest = Next;
+  if (Next == Markers.end () || (Next != Markers.begin ()
+    && Click.x - (Next - 1) -> x < Next -> x - Click.x)) {
+    Nearest = Next - 1;
+  }
+  if (fabs (Nearest -> x - Click.x) <= OV_CLICK_PIXELS * PerPixel) {
+    m_signal_line_clicked.emit (Nearest -> List, Nearest -> Line);
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the memory used by the pyramid, markers and columns
+//
+uint64_t OverviewPlot::bytes () {
+  return Pyramid.bytes () + Markers.capacity () * sizeof (OverviewMarker)
+    + (ColumnLow.capacity () + ColumnHigh.capacity ()) * sizeof (double)
+    + Filled.capacity () / 8;
+}
@@ -0,0 +1,137 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// OverviewPlot class (overviewplot.h)
+//==============================================================================
+// Plots any part of a whole XgSpectrum, from the full wavenumber range down to
+// individual data points, with a marker above the spectrum for each line in
+// its line lists. The scroll wheel zooms in and out around the pointer,
+// dragging with the left button pans, and the right button shows the whole
+// spectrum again. Clicking on a line marker emits signal_line_clicked ().
+//
+// Each pixel column is drawn from the lowest to the highest point in it,
+// which is found with a SpectrumPyramid, so the time taken to draw the plot
+// depends only on its width. Once fewer points than pixels are in view, the
+// points themselves are joined instead.
+//
+// The plot does not keep a pointer to its spectrum, since the spectra of a
+// project move whenever one is added or removed. Instead the spectrum is
+// fetched from the Source slot each time it is needed. The pyramid and line
+// markers are rebuilt whenever the spectrum returned differs from the one they
+// were built for. While the slot returns NULL, such as during an exclusive
+// job, nothing is drawn but the pyramid, markers and view are all kept.
+//
+#ifndef FAST_OVERVIEW_PLOT_H
+#define FAST_OVERVIEW_PLOT_H
+
+#include <gtkmm/drawingarea.h>
+#include <cairomm/context.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "CoreDefs.h"
+#include "spectrumpyramid.h"
+
+using namespace::std;
+
+class XgSpectrum;
+
+#define OV_MARKER_HEIGHT 10    /* pixels above the spectrum for line markers */
+#define OV_AXIS_HEIGHT   16    /* pixels below the spectrum for the axis */
+#define OV_CLICK_PIXELS  4     /* greatest distance of a click from a marker */
+#define OV_ZOOM_STEP     1.25  /* change in wavenumber range per scroll step */
+#define OV_MIN_POINTS    8     /* fewest data points that can be shown */
+
+// A line marker, which refers to line Line of line list List
+typedef struct overview_marker {
+  double x;
+  unsigned int List, Line;
+
+  bool operator< (const struct overview_marker &b) const { return x < b.x; }
+} OverviewMarker;
+
+class OverviewPlot : public Gtk::DrawingArea {
+
+  private:
+    sigc::slot <XgSpectrum *> Source;
+    SpectrumPyramid Pyramid;
+    vector <OverviewMarker> Markers;      // Every line, sorted by wavenumber
+
+    // The spectrum that Pyramid and Markers were built for
+    string Name;
+    unsigned long DataRevision, LinesRevision;
+    double DataMin, DataMax, Step;
+
+    // The wavenumber range in view
+    double ViewMin, ViewMax;
+
+    // The lowest and highest intensity in each pixel column. Filled[i] is false
+    // for a column with no data points.
+    vector <double> ColumnLow, ColumnHigh;
+    vector <bool> Filled;
+    double ColumnsMin, ColumnsMax;        // ViewMin and ViewMax for the columns
+
+    // The state of a drag with the left button
+    bool Dragging, Moved;
+    double DragX, DragViewMin;
+
+    sigc::signal <void, double, double> m_signal_view_changed;
+    sigc::signal <void, unsigned int, unsigned int> m_signal_line_clicked;
+
+    XgSpectrum *spectrum ();
+    bool changed (XgSpectrum *Spectrum);
+    void columns (vector <Coord> &Data, int Width);
+    void drawSpectrum (Cairo::RefPtr<Cairo::Context> cr, vector <Coord> &Data,
+      int Width, int Top, int Bottom);
+    void drawMarkers (Cairo::RefPtr<Cairo::Context> cr, int Width);
+    void drawText (Cairo::RefPtr<Cairo::Context> cr, int Width, int Height);
+    void userView (double Min, double Max);
+
+  protected:
+    virtual bool on_expose_event (GdkEventExpose *event);
+    virtual bool on_scroll_event (GdkEventScroll *event);
+    virtual bool on_button_press_event (GdkEventButton *event);
+    virtual bool on_button_release_event (GdkEventButton *event);
+    virtual bool on_motion_notify_event (GdkEventMotion *event);
+
+  public:
+    OverviewPlot ();
+    ~OverviewPlot () { /* Does nothing */ }
+
+    void source (sigc::slot <XgSpectrum *> SourceIn) { Source = SourceIn; }
+
+    // Show the wavenumbers from Min to Max, or the whole spectrum
+    void view (double Min, double Max);
+    void reset ();
+    double viewMin () { return ViewMin; }
+    double viewMax () { return ViewMax; }
+
+    // Returns true if the spectrum has changed since the plot was last drawn
+    bool stale () { return changed (Source.empty () ? NULL : Source ()); }
+    uint64_t bytes ();
+
+    // Emitted when the user zooms or pans the plot, with the new range
+    sigc::signal <void, double, double> signal_view_changed () {
+      return m_signal_view_changed; }
+
+    // Emitted when the user clicks on the marker of a line, with the indices of
+    // its line list and of the line in that list
+    sigc::signal <void, unsigned int, unsigned int> signal_line_clicked () {
+      return m_signal_line_clicked; }
+};
+
+#endif // FAST_OVERVIEW_PLOT_H
@@ -0,0 +1,188 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// OverviewWindow class (overviewwindow.cpp)
+//==============================================================================
+// Displays the FAST spectrum overview window.
+//
+#include <glibmm/main.h>
+#include "overviewwindow.h"
+#include "xgspectrum.h"
+
+//------------------------------------------------------------------------------
+// Default constructor : Lays out the window. The plots are created when the
+// window is shown.
+//
+OverviewWindow::OverviewWindow () :
+  ButtonReset ("Reset View"), ButtonClose (Gtk::Stock::CLOSE) {
+
+  // Set the basic window properties
+  set_title("Spectrum Overview");
+  set_default_size(800, 400);
+  set_position(Gtk::WIN_POS_CENTER);
+  add (BaseVBox);
+
+  BaseVBox.pack_start (BoxPlots, true, true, 0);
+  BaseVBox.pack_start (LabelHelp, false, false, 2);
+  LabelHelp.set_text ("Scroll to zoom, drag to pan, right click to show the "
+    "whole spectrum, and click on a line marker to select its level.");
+
+  // Add the Reset and Close buttons to the bottom of the window
+  BaseVBox.pack_start (BoxButtons, false, false, 10);
+  BoxButtons.pack_end (ButtonClose, false, false, 2);
+  BoxButtons.pack_end (ButtonReset, false, false, 2);
+  ButtonClose.set_size_request (75);
+  ButtonReset.signal_clicked().connect (sigc::mem_fun (*this,
+    &OverviewWindow::on_button_reset));
+  ButtonClose.signal_clicked().connect (sigc::mem_fun (*this,
+    &OverviewWindow::on_button_close));
+
+  show_all_children();
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor : Frees the plots
+//
+OverviewWindow::~OverviewWindow () {
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    delete Plots[i];
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_show () : Refreshes the plots regularly while the window is visible
+//
+void OverviewWindow::on_show () {
+  refresh ();
+  if (!RefreshConnection.connected ()) {
+    RefreshConnection = Glib::signal_timeout ().connect (sigc::mem_fun (*this,
+      &OverviewWindow::on_refresh_timeout), OV_REFRESH_MS);
+  }
+  Gtk::Window::on_show ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_hide () : Stops refreshing the plots
+//
+void OverviewWindow::on_hide () {
+  RefreshConnection.disconnect ();
+  Gtk::Window::on_hide ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_refresh_timeout () : Called every OV_REFRESH_MS while the window is
+// shown. Returns true to keep the timeout connected.
+//
+bool OverviewWindow::on_refresh_timeout () {
+  refresh ();
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// spectrum (unsigned int) : Returns spectrum Index of the project, or NULL if
+// there is no such spectrum or the spectra cannot be read at the moment. This
+// is the source of the plot with the same index.
+//
+XgSpectrum *OverviewWindow::spectrum (unsigned int Index) {
+  if (SpectraSource.empty ()) return NULL;
+  vector <XgSpectrum> *Spectra = SpectraSource ();
+  if (Spectra == NULL || Index >= Spectra -> size ()) return NULL;
+  return &(*Spectra)[Index];
+}
+
+
+//------------------------------------------------------------------------------
+// refresh () : Adds or removes plots so that there is one for each spectrum,
+// and redraws any plot whose spectrum has changed. Plots of unchanged spectra
+// are left alone.
+//
+void OverviewWindow::refresh () {
+  if (SpectraSource.empty ()) return;
+  vector <XgSpectrum> *Spectra = SpectraSource ();
+  if (Spectra == NULL) return;
+
+  while (Plots.size () > Spectra -> size ()) {
+    BoxPlots.remove (*Plots.back ());
+    delete Plots.back ();
+    Plots.pop_back ();
+  }
+  while (Plots.size () < Spectra -> size ()) {
+    unsigned int i = Plots.size ();
+    Plots.push_back (new OverviewPlot);
+    Plots[i] -> source (sigc::bind (sigc::mem_fun (*this,
+      &OverviewWindow::spectrum), i));
+    Plots[i] -> signal_view_changed ().connect (sigc::mem_fun (*this,
+      &OverviewWindow::on_view_changed));
+    Plots[i] -> signal_line_clicked ().connect (sigc::bind (sigc::mem_fun
+      (*this, &OverviewWindow::on_line_clicked), i));
+    BoxPlots.pack_start (*Plots[i], true, true, 2);
+    Plots[i] -> show ();
+  }
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    if (Plots[i] -> stale ()) Plots[i] -> queue_draw ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_view_changed (double, double) : Shows the same range in every plot after
+// the user has zoomed or panned one of them.
+//
+void OverviewWindow::on_view_changed (double Min, double Max) {
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    if (Plots[i] -> viewMin () != Min || Plots[i] -> viewMax () != Max) {
+      Plots[i] -> view (Min, Max);
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_line_clicked (unsigned int, unsigned int, unsigned int) : Passes on a
+// click on a line marker in plot Spectrum.
+//
+void OverviewWindow::on_line_clicked (unsigned int List, unsigned int Line,
+  unsigned int Spectrum) {
+  m_signal_line_clicked.emit (Spectrum, List, Line);
+}
+
+
+//------------------------------------------------------------------------------
+// on_button_reset () : Shows the whole of each spectrum
+//
+void OverviewWindow::on_button_reset () {
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    Plots[i] -> reset ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the memory used by all the plots
+//
+uint64_t OverviewWindow::bytes () {
+  uint64_t Bytes = 0;
+  for (unsigned int i = 0; i < Plots.size (); i ++) {
+    Bytes += Plots[i] -> bytes ();
+  }
+  return Bytes;
+}
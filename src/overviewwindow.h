@@ -0,0 +1,92 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// OverviewWindow class (overviewwindow.h)
+//==============================================================================
+// Shows an OverviewPlot of every spectrum in the project, one above the other.
+// All the plots show the same wavenumber range, so zooming or panning one of
+// them moves the others with it.
+//
+// The spectra are supplied by the owner of the window through the slot given
+// to spectra_source (), which should return NULL while the spectra cannot be
+// read. The window checks for added, removed or changed spectra every
+// OV_REFRESH_MS while it is shown.
+//
+#ifndef LINE_ANALYSER_OVERVIEW_WINDOW
+#define LINE_ANALYSER_OVERVIEW_WINDOW
+
+// Include the GTK+ environment from GTKmm header files
+#include <gtkmm/window.h>
+#include <gtkmm/box.h>
+#include <gtkmm/button.h>
+#include <gtkmm/stock.h>
+#include <gtkmm/label.h>
+#include <vector>
+#include <stdint.h>
+#include "overviewplot.h"
+
+using namespace::std;
+
+#define OV_REFRESH_MS 1000
+
+class OverviewWindow : public Gtk::Window {
+  private:
+    sigc::slot < vector <XgSpectrum> * > SpectraSource;
+    sigc::connection RefreshConnection;
+    vector <OverviewPlot *> Plots;
+
+    // GTKmm widgets
+    Gtk::VBox BaseVBox;
+    Gtk::VBox BoxPlots;
+    Gtk::Label LabelHelp;
+    Gtk::HBox BoxButtons;
+    Gtk::Button ButtonReset;
+    Gtk::Button ButtonClose;
+
+    XgSpectrum *spectrum (unsigned int Index);
+    void on_button_reset ();
+    void on_button_close () { hide (); }
+    bool on_refresh_timeout ();
+    void on_view_changed (double Min, double Max);
+    void on_line_clicked (unsigned int List, unsigned int Line,
+      unsigned int Spectrum);
+
+    sigc::signal <void, unsigned int, unsigned int, unsigned int>
+      m_signal_line_clicked;
+
+  protected:
+    virtual void on_show ();
+    virtual void on_hide ();
+
+  public:
+
+    OverviewWindow ();
+    ~OverviewWindow ();
+
+    void spectra_source (sigc::slot < vector <XgSpectrum> * > Source) {
+      SpectraSource = Source; }
+    void refresh ();
+    unsigned int size () { return Plots.size (); }
+    uint64_t bytes ();
+
+    // Emitted when a line marker is clicked, with the index of the spectrum,
+    // of its line list, and of the line in that list
+    sigc::signal <void, unsigned int, unsigned int, unsigned int>
+      signal_line_clicked () { return m_signal_line_clicked; }
+};
+
+#endif // LINE_ANALYSER_OVERVIEW_WINDOW
@@ -0,0 +1,198 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// PerformanceWindow class (perfwindow.cpp)
+//==============================================================================
+// Displays the FAST performance and memory window.
+//
+#include <sstream>
+#include <iomanip>
+#include <glibmm/main.h>
+#include "perfwindow.h"
+#include "trace.h"
+
+//------------------------------------------------------------------------------
+// Default constructor : Lays out the window. Nothing is shown in the lists
+// until the window is shown.
+//
+PerformanceWindow::PerformanceWindow () :
+  ButtonReset ("Reset Timings"), ButtonClose (Gtk::Stock::CLOSE) {
+
+  // Set the basic window properties
+  set_title("Performance");
+  set_default_size(480, 600);
+  set_position(Gtk::WIN_POS_CENTER);
+  add (BaseVBox);
+
+  // The time taken by each traced stage, in milliseconds
+  BaseVBox.pack_start (FrameStages, true, true, 0);
+  FrameStages.set_label ("Stage timings");
+  FrameStages.add (ScrollStages);
+  ScrollStages.set_policy (Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+  ScrollStages.add (TreeStages);
+  modelStages = Gtk::ListStore::create (stageCols);
+  TreeStages.set_model (modelStages);
+  TreeStages.append_column ("Stage", stageCols.Name);
+  TreeStages.append_column ("Calls", stageCols.Calls);
+  TreeStages.append_column_numeric ("Last / ms", stageCols.Last, "%10.2f");
+  TreeStages.append_column_numeric ("Mean / ms", stageCols.Mean, "%10.2f");
+  TreeStages.append_column_numeric ("Max / ms", stageCols.Max, "%10.2f");
+
+  // The totals of the traced counters
+  BaseVBox.pack_start (FrameCounters, false, false, 0);
+  FrameCounters.set_label ("Counters");
+  FrameCounters.add (ScrollCounters);
+  ScrollCounters.set_policy (Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+  ScrollCounters.set_size_request (-1, 100);
+  ScrollCounters.add (TreeCounters);
+  modelCounters = Gtk::ListStore::create (counterCols);
+  TreeCounters.set_model (modelCounters);
+  TreeCounters.append_column ("Counter", counterCols.Name);
+  TreeCounters.append_column_numeric ("Total", counterCols.Total, "%.0f");
+  TreeCounters.append_column_numeric ("Last", counterCols.Last, "%.0f");
+
+  // The memory used by each loaded spectrum, line list and set of widgets
+  BaseVBox.pack_start (FrameMemory, true, true, 0);
+  FrameMemory.set_label ("Memory");
+  FrameMemory.add (BoxMemory);
+  BoxMemory.pack_start (ScrollMemory, true, true, 0);
+  BoxMemory.pack_start (LabelTotal, false, false, 2);
+  ScrollMemory.set_policy (Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+  ScrollMemory.add (TreeMemory);
+  modelMemory = Gtk::ListStore::create (memoryCols);
+  TreeMemory.set_model (modelMemory);
+  TreeMemory.append_column ("Data", memoryCols.Name);
+  TreeMemory.append_column ("Items", memoryCols.Items);
+  TreeMemory.append_column_numeric ("Size / kB", memoryCols.Size, "%10.1f");
+
+  // Add the Reset and Close buttons to the bottom of the window
+  BaseVBox.pack_start (BoxButtons, false, false, 10);
+  BoxButtons.pack_end (ButtonClose, false, false, 2);
+  BoxButtons.pack_end (ButtonReset, false, false, 2);
+  ButtonClose.set_size_request (75);
+  ButtonReset.signal_clicked().connect (sigc::mem_fun (*this,
+    &PerformanceWindow::on_button_reset));
+  ButtonClose.signal_clicked().connect (sigc::mem_fun (*this,
+    &PerformanceWindow::on_button_close));
+
+  show_all_children();
+}
+
+
+//------------------------------------------------------------------------------
+// on_show () : Starts monitoring the traced stages, if this has not already
+// been done, and refreshes the window regularly while it is visible.
+//
+void PerformanceWindow::on_show () {
+  Trace::monitor (true);
+  refresh ();
+  if (!RefreshConnection.connected ()) {
+    RefreshConnection = Glib::signal_timeout ().connect (sigc::mem_fun (*this,
+      &PerformanceWindow::on_refresh_timeout), PERF_REFRESH_MS);
+  }
+  Gtk::Window::on_show ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_hide () : Stops refreshing the window. The stages are still monitored, so
+// that the timings are up to date when the window is shown again.
+//
+void PerformanceWindow::on_hide () {
+  RefreshConnection.disconnect ();
+  Gtk::Window::on_hide ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_button_reset () : Discards the stage timings and counters recorded so far
+//
+void PerformanceWindow::on_button_reset () {
+  Trace::resetStats ();
+  refresh ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_refresh_timeout () : Called every PERF_REFRESH_MS while the window is
+// shown. Returns true to keep the timeout connected.
+//
+bool PerformanceWindow::on_refresh_timeout () {
+  refresh ();
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// refresh () : Updates every list in the window
+//
+void PerformanceWindow::refresh () {
+  refreshStages ();
+  refreshMemory ();
+}
+
+
+//------------------------------------------------------------------------------
+// refreshStages () : Fills the stage and counter lists from Trace::stats (),
+// in the order each stage was first seen.
+//
+void PerformanceWindow::refreshStages () {
+  vector <TraceStat> Stats = Trace::stats ();
+  Gtk::TreeModel::Row row;
+
+  modelStages -> clear ();
+  modelCounters -> clear ();
+  for (unsigned int i = 0; i < Stats.size (); i ++) {
+    if (Stats[i].Counter) {
+      row = *(modelCounters -> append ());
+      row[counterCols.Name] = Stats[i].Name;
+      row[counterCols.Total] = Stats[i].Total;
+      row[counterCols.Last] = Stats[i].Last;
+    } else {
+      row = *(modelStages -> append ());
+      row[stageCols.Name] = Stats[i].Name;
+      row[stageCols.Calls] = Stats[i].Calls;
+      row[stageCols.Last] = Stats[i].Last * 1000.0;
+      row[stageCols.Mean] = Stats[i].Total / Stats[i].Calls * 1000.0;
+      row[stageCols.Max] = Stats[i].Max * 1000.0;
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// refreshMemory () : Fills the memory list from the slot given to
+// memory_source (), and shows the total beneath it.
+//
+void PerformanceWindow::refreshMemory () {
+  vector <MemoryUse> Memory;
+  uint64_t Total = 0;
+  Gtk::TreeModel::Row row;
+  ostringstream oss;
+
+  if (!MemorySource.empty ()) Memory = MemorySource ();
+  modelMemory -> clear ();
+  for (unsigned int i = 0; i < Memory.size (); i ++) {
+    row = *(modelMemory -> append ());
+    row[memoryCols.Name] = Memory[i].Name;
+    row[memoryCols.Items] = Memory[i].Items;
+    row[memoryCols.Size] = Memory[i].Bytes / 1024.0;
+    Total += Memory[i].Bytes;
+  }
+  oss << "Total " << fixed << setprecision (1) << Total / 1048576.0 << " MB";
+  LabelTotal.set_text (oss.str ());
+}
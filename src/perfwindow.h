@@ -0,0 +1,135 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// PerformanceWindow class (perfwindow.h)
+//==============================================================================
+// Displays the time taken by each traced stage of FAST (see trace.h), the
+// totals of the traced counters, and the memory used by each loaded spectrum,
+// line list and the widgets that display them. The window is refreshed every
+// PERF_REFRESH_MS while it is shown.
+//
+// Stage timings are only recorded once the window has been opened for the
+// first time. The memory figures are supplied by the owner of the window
+// through the slot given to memory_source ().
+//
+#ifndef LINE_ANALYSER_PERFORMANCE_WINDOW
+#define LINE_ANALYSER_PERFORMANCE_WINDOW
+
+// Include the GTK+ environment from GTKmm header files
+#include <gtkmm/window.h>
+#include <gtkmm/scrolledwindow.h>
+#include <gtkmm/box.h>
+#include <gtkmm/button.h>
+#include <gtkmm/stock.h>
+#include <gtkmm/frame.h>
+#include <gtkmm/label.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/liststore.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace::std;
+
+#define PERF_REFRESH_MS 1000
+
+// The memory used by one part of FAST
+typedef struct memory_use {
+  string Name;
+  unsigned long Items;       // Number of points, lines, widgets or rows
+  uint64_t Bytes;
+
+  memory_use () { Items = 0; Bytes = 0; }
+  memory_use (string NameIn, unsigned long ItemsIn, uint64_t BytesIn) {
+    Name = NameIn; Items = ItemsIn; Bytes = BytesIn; }
+} MemoryUse;
+
+class PerformanceWindow : public Gtk::Window {
+  private:
+    sigc::slot < vector <MemoryUse> > MemorySource;
+    sigc::connection RefreshConnection;
+
+    // GTKmm widgets
+    Gtk::VBox BaseVBox;
+    Gtk::Frame FrameStages;
+    Gtk::ScrolledWindow ScrollStages;
+    Gtk::TreeView TreeStages;
+    Gtk::Frame FrameCounters;
+    Gtk::ScrolledWindow ScrollCounters;
+    Gtk::TreeView TreeCounters;
+    Gtk::Frame FrameMemory;
+    Gtk::VBox BoxMemory;
+    Gtk::ScrolledWindow ScrollMemory;
+    Gtk::TreeView TreeMemory;
+    Gtk::Label LabelTotal;
+
+    Gtk::HBox BoxButtons;
+    Gtk::Button ButtonReset;
+    Gtk::Button ButtonClose;
+    Glib::RefPtr<Gtk::ListStore> modelStages;
+    Glib::RefPtr<Gtk::ListStore> modelCounters;
+    Glib::RefPtr<Gtk::ListStore> modelMemory;
+
+    void on_button_reset ();
+    void on_button_close () { hide (); }
+    bool on_refresh_timeout ();
+
+    void refreshStages ();
+    void refreshMemory ();
+
+    class ColumnsStages : public Gtk::TreeModel::ColumnRecord {
+      public:
+        Gtk::TreeModelColumn<string> Name;
+        Gtk::TreeModelColumn<unsigned long> Calls;
+        Gtk::TreeModelColumn<double> Last, Mean, Max;
+        ColumnsStages() { add (Name); add (Calls); add (Last); add (Mean);
+          add (Max); }
+    };
+    ColumnsStages stageCols;
+
+    class ColumnsCounters : public Gtk::TreeModel::ColumnRecord {
+      public:
+        Gtk::TreeModelColumn<string> Name;
+        Gtk::TreeModelColumn<double> Total, Last;
+        ColumnsCounters() { add (Name); add (Total); add (Last); }
+    };
+    ColumnsCounters counterCols;
+
+    class ColumnsMemory : public Gtk::TreeModel::ColumnRecord {
+      public:
+        Gtk::TreeModelColumn<string> Name;
+        Gtk::TreeModelColumn<unsigned long> Items;
+        Gtk::TreeModelColumn<double> Size;
+        ColumnsMemory() { add (Name); add (Items); add (Size); }
+    };
+    ColumnsMemory memoryCols;
+
+  protected:
+    virtual void on_show ();
+    virtual void on_hide ();
+
+  public:
+
+    PerformanceWindow ();
+    ~PerformanceWindow () { /* Does nothing */ }
+
+    void memory_source (sigc::slot < vector <MemoryUse> > Source) {
+      MemorySource = Source; }
+    void refresh ();
+};
+
+#endif // LINE_ANALYSER_PERFORMANCE_WINDOW
@@ -0,0 +1,202 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProfileGrid class (profilegrid.cpp)
+//==============================================================================
+#include <algorithm>
+#include "profilegrid.h"
+#include "trace.h"
+
+//------------------------------------------------------------------------------
+// Default constructor : Creates an empty grid.
+//
+ProfileGrid::ProfileGrid () {
+  CellWidth = 0;
+  CellHeight = 0;
+  TitleHeight = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor : Removes every cell from the layout and deletes the row titles.
+// The views themselves are deleted with Pool.
+//
+ProfileGrid::~ProfileGrid () {
+  HConnection.disconnect ();
+  VConnection.disconnect ();
+  clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// on_realize () : Starts following the scroll position of the grid. The
+// adjustments are only given to the layout when it is added to the
+// ScrolledWindow, so this cannot be done in the constructor.
+//
+void ProfileGrid::on_realize () {
+  Gtk::Layout::on_realize ();
+  HConnection.disconnect ();
+  VConnection.disconnect ();
+  if (get_hadjustment ()) {
+    HConnection = get_hadjustment () -> signal_value_changed ().connect (
+      sigc::mem_fun (*this, &ProfileGrid::on_scrolled));
+  }
+  if (get_vadjustment ()) {
+    VConnection = get_vadjustment () -> signal_value_changed ().connect (
+      sigc::mem_fun (*this, &ProfileGrid::on_scrolled));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// on_size_allocate (Gtk::Allocation &) : Places the cells that have come into
+// view after the grid has been resized.
+//
+void ProfileGrid::on_size_allocate (Gtk::Allocation &Allocation) {
+  Gtk::Layout::on_size_allocate (Allocation);
+  place ();
+}
+
+
+//------------------------------------------------------------------------------
+// set (vector < vector <LineData *> > &, vector <string> &) : Replaces the
+// contents of the grid with CellsIn. TitlesIn[i] is shown above row i. Nothing
+// is drawn here except the row titles; the cells are placed by place () once
+// the size of the visible area is known.
+//
+void ProfileGrid::set (vector < vector <LineData *> > &CellsIn,
+  vector <string> &TitlesIn) {
+  clear ();
+  for (unsigned int i = 0; i < CellsIn.size (); i ++) {
+    if (CellsIn[i].size () == 0) continue;
+    Cells.push_back (CellsIn[i]);
+    Titles.push_back (new Gtk::Label (i < TitlesIn.size () ? TitlesIn[i] : ""));
+    Titles.back () -> set_alignment (0.0, 0.5);
+  }
+  measure ();
+  for (unsigned int i = 0; i < Titles.size (); i ++) {
+    put (*Titles[i], PG_TITLE_PAD,
+      i * (TitleHeight + CellHeight) + PG_TITLE_PAD);
+    Titles[i] -> show ();
+  }
+  place ();
+}
+
+
+//------------------------------------------------------------------------------
+// clear () : Removes every cell from the grid, returning their views to Pool,
+// and deletes the row titles.
+//
+void ProfileGrid::clear () {
+  for (unsigned int i = 0; i < Placed.size (); i ++) {
+    LineView *View = Placed[i] -> view ();
+    remove (*View);
+    Pool.release (View);
+  }
+  for (unsigned int i = 0; i < Titles.size (); i ++) {
+    remove (*Titles[i]);
+    delete Titles[i];
+  }
+  Placed.clear ();
+  Titles.clear ();
+  Cells.clear ();
+  set_size (0, 0);
+}
+
+
+//------------------------------------------------------------------------------
+// measure () : Sets the size of a cell from the size requested by a view of
+// the first one, and the height of a title from the first title, then sizes
+// the layout to fit every row.
+//
+void ProfileGrid::measure () {
+  unsigned int Columns = 0;
+  CellWidth = CellHeight = TitleHeight = 0;
+  if (Cells.size () == 0) return;
+
+  LineView *Probe = Pool.acquire (Cells[0][0]);
+  Gtk::Requisition Size = Probe -> size_request ();
+  Pool.release (Probe);
+  CellWidth = max (Size.width, 1);
+  CellHeight = max (Size.height, 1);
+  TitleHeight = Titles[0] -> size_request ().height + 2 * PG_TITLE_PAD;
+
+  for (unsigned int i = 0; i < Cells.size (); i ++) {
+    Columns = max (Columns, (unsigned int) Cells[i].size ());
+  }
+  set_size (Columns * CellWidth, Cells.size () * (TitleHeight + CellHeight));
+}
+
+
+//------------------------------------------------------------------------------
+// place () : Binds a view to each cell that overlaps the visible part of the
+// grid and adds it to the layout, and returns the views of the cells that no
+// longer do to Pool. A cell already in the layout is never moved, since its
+// position depends only on its row and column.
+//
+void ProfileGrid::place () {
+  TRACE_SCOPE ("ProfileGrid::place");
+  vector <LineData *> Visible;
+  Gtk::Adjustment *H = get_hadjustment (), *V = get_vadjustment ();
+  if (Cells.size () == 0 || CellWidth == 0) return;
+
+  // Find the region of the grid that is currently visible
+  int Left = H ? int (H -> get_value ()) : 0;
+  int Top = V ? int (V -> get_value ()) : 0;
+  int Right = Left + (H ? int (H -> get_page_size ())
+    : get_allocation ().get_width ());
+  int Bottom = Top + (V ? int (V -> get_page_size ())
+    : get_allocation ().get_height ());
+  int RowHeight = TitleHeight + CellHeight;
+
+  // Find every cell in that region
+  vector <int> X, Y;
+  for (unsigned int i = 0; i < Cells.size (); i ++) {
+    int CellTop = i * RowHeight + TitleHeight;
+    if (CellTop + CellHeight <= Top || CellTop >= Bottom) continue;
+    unsigned int First = max (Left, 0) / CellWidth;
+    unsigned int Last = min ((unsigned int) Cells[i].size (),
+      (unsigned int) (max (Right, 0) + CellWidth - 1) / CellWidth);
+    for (unsigned int j = First; j < Last; j ++) {
+      Visible.push_back (Cells[i][j]);
+      X.push_back (j * CellWidth);
+      Y.push_back (CellTop);
+    }
+  }
+
+  // Return the views of the cells that have been scrolled out of view to the
+  // pool first, so that they can be reused for the cells coming into view
+  vector <LineData *> Sorted = Visible;
+  sort (Sorted.begin (), Sorted.end ());
+  Sorted.erase (unique (Sorted.begin (), Sorted.end ()), Sorted.end ());
+  for (unsigned int i = 0; i < Placed.size (); i ++) {
+    if (!binary_search (Sorted.begin (), Sorted.end (), Placed[i])) {
+      LineView *View = Placed[i] -> view ();
+      remove (*View);
+      Pool.release (View);
+    }
+  }
+
+  // Place the cells that are not already in the layout. A line that appears
+  // in more than one cell is only placed in the first.
+  for (unsigned int i = 0; i < Visible.size (); i ++) {
+    if (Visible[i] -> view () == NULL) {
+      put (*Pool.acquire (Visible[i]), X[i], Y[i]);
+    }
+  }
+  Placed = Sorted;
+}
@@ -0,0 +1,79 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProfileGrid class (profilegrid.h)
+//==============================================================================
+// Displays a grid of line profile plots, with one titled row per spectrum and
+// one cell per line, inside a Gtk::ScrolledWindow. Every cell is the same size,
+// so the position of each one is known without laying the grid out. Only the
+// cells that overlap the visible part of the grid are given a LineView from
+// the grid's LineViewPool and placed in the layout. When a cell is scrolled
+// out of view its LineView is removed and returned to the pool, ready to be
+// bound to the next cell that comes into view, so the number of widgets
+// depends on the size of the window rather than on the number of lines.
+//
+// The grid does not own the LineData objects it is given. clear () must be
+// called before any of them are deleted.
+//
+#ifndef FAST_PROFILE_GRID_H
+#define FAST_PROFILE_GRID_H
+
+#include <gtkmm/layout.h>
+#include <gtkmm/label.h>
+#include <gtkmm/adjustment.h>
+#include <string>
+#include <vector>
+#include "linedata.h"
+#include "lineview.h"
+
+using namespace::std;
+
+#define PG_TITLE_PAD 4    /* pixels around each row title */
+
+class ProfileGrid : public Gtk::Layout {
+
+  private:
+    vector < vector <LineData *> > Cells;   // Non-empty rows only
+    vector <Gtk::Label *> Titles;           // The title of each row of Cells
+    vector <LineData *> Placed;             // Cells currently in the layout
+    LineViewPool Pool;
+    int CellWidth, CellHeight;              // Zero until measure () is called
+    int TitleHeight;
+    sigc::connection HConnection, VConnection;
+
+    void measure ();
+    void place ();
+    void on_scrolled () { place (); }
+
+  protected:
+    virtual void on_realize ();
+    virtual void on_size_allocate (Gtk::Allocation &Allocation);
+
+  public:
+    ProfileGrid ();
+    ~ProfileGrid ();
+
+    // Replace the grid with CellsIn, where row i is headed by TitlesIn[i].
+    // Rows with no cells are not shown.
+    void set (vector < vector <LineData *> > &CellsIn,
+      vector <string> &TitlesIn);
+    void clear ();
+
+    LineViewPool &pool () { return Pool; }
+};
+
+#endif // FAST_PROFILE_GRID_H
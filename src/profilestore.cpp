@@ -0,0 +1,169 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProfileStore class (profilestore.cpp)
+//==============================================================================
+#include "profilestore.h"
+
+using namespace::std;
+
+//==============================================================================
+// PRIVATE FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// sortKeys () : Builds the sorted list of keys used by find ().
+//
+void ProfileStore::sortKeys () {
+  Sorted.resize (Keys.size ());
+  for (unsigned int i = 0; i < Keys.size (); i ++) {
+    Sorted[i] = pair <uint64_t, unsigned int> (Keys[i], i);
+  }
+  sort (Sorted.begin (), Sorted.end ());
+}
+
+
+//==============================================================================
+// PUBLIC FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// set (const vector <uint64_t> &, vector <LineProfile> &) : Replaces the
+// contents of the store with Profiles, where KeysIn[i] is the key of
+// Profiles[i].
+//
+void ProfileStore::set (const vector <uint64_t> &KeysIn,
+  vector <LineProfile> &Profiles) {
+  clear ();
+  First.push_back (0);
+  for (unsigned int i = 0; i < Profiles.size () && i < KeysIn.size (); i ++) {
+    LineProfile &Next = Profiles[i];
+    if (KeysIn[i] == 0 || Next.Voigt.size () != Next.Residual.size ()) continue;
+    Keys.push_back (KeysIn[i]);
+    Noise.push_back (Next.Noise);
+    Start.push_back (Next.Start);
+    for (unsigned int k = 0; k < Next.Voigt.size (); k ++) {
+      VoigtY.values ().push_back (Next.Voigt[k].y);
+      ResidualY.values ().push_back (Next.Residual[k].y);
+    }
+    First.push_back (VoigtY.size ());
+  }
+  sortKeys ();
+}
+
+
+//------------------------------------------------------------------------------
+// find (uint64_t, vector <Coord> &, LineProfile &) : Fills Profile from the
+// entry with the given Key. Data must hold the points of the whole spectrum,
+// since the experimental data and the x values of the profile are taken from
+// it. Returns false if there is no entry for Key, or if it does not fit Data.
+//
+bool ProfileStore::find (uint64_t Key, vector <Coord> &Data,
+  LineProfile &Profile) {
+  vector < pair <uint64_t, unsigned int> >::iterator Match;
+  vector <float> Voigt, Residual;
+  unsigned int i, Num;
+
+  if (Key == 0) return false;
+  Match = lower_bound (Sorted.begin (), Sorted.end (),
+    pair <uint64_t, unsigned int> (Key, 0));
+  if (Match == Sorted.end () || Match -> first != Key) return false;
+  i = Match -> second;
+  Num = First[i+1] - First[i];
+  if (uint64_t (Start[i]) + Num > Data.size ()) return false;
+
+  VoigtY.read (Voigt, First[i], Num);
+  ResidualY.read (Residual, First[i], Num);
+  Profile.Data.assign (Data.begin () + Start[i], Data.begin () + Start[i] + Num);
+  Profile.Voigt.resize (Num);
+  Profile.Residual.resize (Num);
+  for (unsigned int k = 0; k < Num; k ++) {
+    Profile.Voigt[k] = Coord (Profile.Data[k].x, Voigt[k]);
+    Profile.Residual[k] = Coord (Profile.Data[k].x, Residual[k]);
+  }
+  Profile.Noise = Noise[i];
+  Profile.Start = Start[i];
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the memory used by the store, not counting any part of it
+// that is still mapped from a project file.
+//
+uint64_t ProfileStore::bytes () {
+  return Keys.capacity () * sizeof (uint64_t)
+    + Noise.capacity () * sizeof (double)
+    + (Start.capacity () + First.capacity ()) * sizeof (unsigned int)
+    + Sorted.capacity () * sizeof (pair <uint64_t, unsigned int>)
+    + VoigtY.bytes () + ResidualY.bytes ();
+}
+
+
+//------------------------------------------------------------------------------
+// clear () : Removes every entry from the store.
+//
+void ProfileStore::clear () {
+  Keys.clear ();
+  Noise.clear ();
+  Start.clear ();
+  First.clear ();
+  VoigtY.clear ();
+  ResidualY.clear ();
+  Sorted.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// write (FtsWriter *) : Writes the store to the current section of Fts. The
+// profile values are written straight from memory or the file mapping.
+//
+void ProfileStore::write (FtsWriter *Fts) {
+  Fts -> writeArray (Keys);
+  Fts -> writeArray (Noise);
+  Fts -> writeArray (Start);
+  Fts -> writeArray (First);
+  Fts -> writeArray (VoigtY);
+  Fts -> writeArray (ResidualY);
+}
+
+
+//------------------------------------------------------------------------------
+// read (FtsReader *) : Reads a store written by write () from the current
+// section of Fts. The profile values are only read when find () needs them.
+//
+void ProfileStore::read (FtsReader *Fts) throw (Error) {
+  clear ();
+  Fts -> readArray (Keys);
+  Fts -> readArray (Noise);
+  Fts -> readArray (Start);
+  Fts -> readArray (First);
+  Fts -> readArray (VoigtY);
+  Fts -> readArray (ResidualY);
+
+  bool Valid = Noise.size () == Keys.size () && Start.size () == Keys.size ()
+    && First.size () == Keys.size () + 1 && First[0] == 0
+    && First.back () == VoigtY.size () && VoigtY.size () == ResidualY.size ();
+  for (unsigned int i = 0; Valid && i < Keys.size (); i ++) {
+    if (First[i+1] < First[i]) Valid = false;
+  }
+  if (!Valid) {
+    clear ();
+    throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+  }
+  sortKeys ();
+}
@@ -0,0 +1,92 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProfileStore class (profilestore.h)
+//==============================================================================
+// A ProfileStore keeps the plot profiles calculated for one line list so that
+// they can be saved in the project file and reused when it is next opened.
+// For each line it holds the Voigt profile, the residual and the noise level.
+// It also holds the index of the first spectrum point in the plot window. The
+// experimental data is not stored, since it is already in the spectrum.
+//
+// Each entry is identified by a key calculated by LineProfiler from everything
+// the profile depends on. This covers the spectrum data in the plot window and
+// the parameters of the line. It also covers every line whose model overlaps
+// the window. An entry is only reused when its key matches, so profiles are
+// recalculated only for lines whose own data has changed.
+//
+// Profile values read from a project file are left in the file as
+// FtsFloatArrays until they are needed.
+//
+#ifndef PROFILE_STORE_H
+#define PROFILE_STORE_H
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "CoreDefs.h"
+#include "ftsfile.h"
+#include "ErrDefs.h"
+
+using namespace::std;
+
+// The plot data for a single line
+typedef struct line_profile {
+  vector <Coord> Data;      // Experimental spectrum around the line
+  vector <Coord> Voigt;     // Voigt profile from the XGremlin line parameters
+  vector <Coord> Residual;  // Data minus the model spectrum of the list
+  double Noise;             // RMS of Residual
+  int Start;                // Spectrum index of the first point in Data
+
+  line_profile () { Noise = 0.0; Start = 0; }
+} LineProfile;
+
+class ProfileStore {
+
+  private:
+    vector <uint64_t> Keys;
+    vector <double> Noise;
+    vector <unsigned int> Start;      // Spectrum index of the first point
+    vector <unsigned int> First;      // Offset of each profile in VoigtY and
+                                      // ResidualY, plus the total at the end
+    FtsFloatArray VoigtY, ResidualY;
+    vector < pair <uint64_t, unsigned int> > Sorted;  // Keys in sorted order
+
+    void sortKeys ();
+
+  public:
+    ProfileStore () { }
+    ~ProfileStore () { }
+
+    // Replace the contents of the store with Profiles. Profiles with a key of
+    // zero are not stored.
+    void set (const vector <uint64_t> &KeysIn, vector <LineProfile> &Profiles);
+
+    // Fill Profile from the entry matching Key, taking the experimental data
+    // from Data. Returns false if there is no such entry.
+    bool find (uint64_t Key, vector <Coord> &Data, LineProfile &Profile);
+
+    unsigned int size () { return Keys.size (); }
+    uint64_t bytes ();
+    void clear ();
+
+    // Read or write the store as the body of an FTS_SECTION_PROFILES section
+    void write (FtsWriter *Fts);
+    void read (FtsReader *Fts) throw (Error);
+};
+
+#endif // PROFILE_STORE_H
@@ -0,0 +1,621 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProjectFile class (projectfile.cpp)
+//==============================================================================
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <cstdio>
+#include "projectfile.h"
+#include "CoreDefs.h"
+#include "trace.h"
+
+using namespace::std;
+
+//------------------------------------------------------------------------------
+// read (string, ProjectData &, Job *) : Reads the project saved in Filename
+// into Project. An Error is thrown if the file cannot be opened, if it was
+// saved by a newer version of FAST, or if it is corrupt.
+//
+void ProjectFile::read (string Filename, ProjectData &Project, Job *Progress)
+  throw (Error) {
+  TRACE_SCOPE ("ProjectFile::read");
+  ifstream BinIn (Filename.c_str (), ios::in|ios::binary);
+  if (!BinIn.is_open ()) {
+    throw (Error (FLT_FILE_OPEN_ERROR));
+  }
+
+  // First read the FTS file version from the input file. If FileVersion is
+  // greater than FTS_FILE_VERSION, the user must be running an old version of
+  // FAST and thus attempting to load a file that is newer than, and so not
+  // compatible with the running code.
+  Project.FileVersion = readFileVersion (&BinIn);
+  if (Project.FileVersion > FTS_FILE_VERSION) {
+    throw (Error (FLT_FILE_HEAD_ERROR, "", "This file was saved with a newer version of FAST.\nPlease upgrade FAST to the latest version and try again."));
+  }
+
+  // File version is OK, so continue loading. The interface settings can only
+  // be applied once the lines have been matched, so they are kept as raw data.
+  if (Project.FileVersion >= FTS_FILE_VERSION_SECTIONS) {
+    readSections (&BinIn, Filename, Project, Progress);
+  } else {
+    readKuruczList (&BinIn, Project);
+    readExptSpectra (&BinIn, Project, Progress);
+    Project.Interface.assign (istreambuf_iterator <char> (BinIn),
+      istreambuf_iterator <char> ());
+  }
+  BinIn.close ();
+}
+
+
+//------------------------------------------------------------------------------
+// Read a file version tag from the beginning of the file. Files from version 4
+// onwards are written by FtsWriter, which places the version first.
+// 
+int ProjectFile::readFileVersion (istream *BinIn) {
+  unsigned int Version;
+  BinIn->read ((char*)&Version, sizeof (unsigned int));
+  return Version;
+}
+
+
+//------------------------------------------------------------------------------
+// readSections (istream *, string, ProjectData &, Job *) : Reads a project
+// saved with FTS_FILE_VERSION_SECTIONS or later, which has been opened from
+// Filename and its version read, into Project. The line lists are kept
+// separate from the spectra, since their plots can only be created by the user
+// interface. The spectrum data points are left in the file until they are
+// first used. If Progress is not NULL, the fraction of the file read is
+// reported to it, and reading stops early if it is cancelled.
+//
+void ProjectFile::readSections (istream *BinIn, string Filename,
+  ProjectData &Project, Job *Progress) throw (Error) {
+  FtsReader Fts (BinIn, Filename);
+  FtsSection Section;
+  vector < vector < vector <char> > > LinHeaders;
+  vector <KzLineRecord> KzRecords;
+  vector <XgLineRecord> XgRecords;
+  vector <double> FitErrors;
+  vector <string> Strings;
+  FtsFloatArray Y;
+  vector <Coord> Points;
+  vector <ErrRange> Errors;
+  vector <char> Header;
+  double FileSize = Fts.fileSize ();
+
+  for (unsigned int n = 0; n < Fts.numSections (); n ++) {
+    Section = Fts.section (n);
+    if (Progress != NULL) {
+      if (Progress -> cancelled ()) return;
+      Progress -> progress (Section.Offset / FileSize);
+    }
+    Fts.seek (Section);
+    switch (Section.Type) {
+
+      case FTS_SECTION_KURUCZ:
+      {
+        Project.KuruczName = Fts.readString ();
+        Project.KuruczPrecision = Fts.readDouble ();
+        Fts.readArray (KzRecords);
+        Strings = Fts.readStrings ();
+        if (Strings.size () != KzRecords.size () * KZLINE_RECORD_STRINGS) {
+          throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+        }
+        Project.KuruczLines.resize (KzRecords.size ());
+        for (unsigned int i = 0; i < KzRecords.size (); i ++) {
+          Project.KuruczLines[i].unpack (KzRecords[i],
+            &Strings[i * KZLINE_RECORD_STRINGS]);
+        }
+        break;
+      }
+
+      case FTS_SECTION_SPECTRUM:
+      {
+        if (Section.Spectrum != Project.Spectra.size ()) {
+          throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+        }
+        Project.Spectra.push_back (XgSpectrum ());
+        Project.SpectrumLines.push_back (vector < vector <XgLine> > ());
+        Project.SpectrumProfiles.push_back (vector <ProfileStore> ());
+        LinHeaders.push_back (vector < vector <char> > ());
+        XgSpectrum &Spectrum = Project.Spectra.back ();
+        Spectrum.name (Fts.readString ());
+        Spectrum.standard_lamp_file (Fts.readString ());
+        Spectrum.radiance_file (Fts.readString ());
+        Spectrum.index (Fts.readString ());
+        Spectrum.isReference (Fts.readBool ());
+        double MinX = Fts.readDouble ();
+        double PointSpacing = Fts.readDouble ();
+        Fts.readArray (Y);
+        Spectrum.data (Y, MinX, PointSpacing);
+        Fts.readArray (Header);
+        Spectrum.headerFile (Header);
+        Fts.readArray (Points);
+        Spectrum.standard_lamp_spectrum (Points);
+        Fts.readArray (Points);
+        Spectrum.radiance (Points);
+        Fts.readArray (Errors);
+        Spectrum.radiance_errors (Errors);
+        break;
+      }
+
+      case FTS_SECTION_LINES:
+      {
+        if (Section.Spectrum >= Project.Spectra.size () 
+          || Section.List != Project.SpectrumLines[Section.Spectrum].size ()) {
+          throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+        }
+        Fts.readArray (Header);
+        LinHeaders[Section.Spectrum].push_back (Header);
+        Fts.readArray (XgRecords);
+        Strings = Fts.readStrings ();
+        if (Strings.size () != XgRecords.size () * XGLINE_RECORD_STRINGS) {
+          throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+        }
+        vector <XgLine> Lines (XgRecords.size ());
+        for (unsigned int i = 0; i < XgRecords.size (); i ++) {
+          Lines[i].unpack (XgRecords[i], &Strings[i * XGLINE_RECORD_STRINGS]);
+        }
+        Project.SpectrumLines[Section.Spectrum].push_back (Lines);
+        break;
+      }
+
+      case FTS_SECTION_PROFILES:
+      {
+        if (Section.Spectrum >= Project.Spectra.size ()
+          || Section.List >= Project.SpectrumLines[Section.Spectrum].size ()) {
+          throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+        }
+        vector <ProfileStore> &Stores = Project.SpectrumProfiles[Section.Spectrum];
+        if (Stores.size () <= Section.List) Stores.resize (Section.List + 1);
+        Stores[Section.List].read (&Fts);
+        break;
+      }
+
+      case FTS_SECTION_FIT_ERRORS:
+      {
+        if (Section.Spectrum >= Project.Spectra.size ()
+          || Section.List >= Project.SpectrumLines[Section.Spectrum].size ()) {
+          throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+        }
+        vector <XgLine> &Lines =
+          Project.SpectrumLines[Section.Spectrum][Section.List];
+        Fts.readArray (FitErrors);
+        if (FitErrors.size () != Lines.size () * 4) {
+          throw (Error (FLT_FILE_READ_ERROR, "", "The project file is corrupt."));
+        }
+        for (unsigned int i = 0; i < Lines.size (); i ++) {
+          Lines[i].fitErrors (FitErrors[i * 4], FitErrors[i * 4 + 1],
+            FitErrors[i * 4 + 2], FitErrors[i * 4 + 3]);
+        }
+        break;
+      }
+
+      case FTS_SECTION_LINKS:
+        Fts.readArray (Project.Links);
+        break;
+
+      case FTS_SECTION_INTERFACE:
+        Project.Interface = Fts.readRemainder ();
+        break;
+
+      default:
+        break;  // Sections added by later versions of FAST are skipped
+    }
+  }
+
+  for (unsigned int i = 0; i < Project.Spectra.size (); i ++) {
+    for (unsigned int j = 0; j < LinHeaders[i].size (); j ++) {
+      Project.Spectra[i].lin_headers_push_back (LinHeaders[i][j]);
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// readExptSpectra (istream *, ProjectData &, Job *) : Reads experimental
+// spectrum information from the istream at arg 1 that was saved in a file
+// older than FTS_FILE_VERSION_SECTIONS, and stores it in Project. The line
+// lists are kept separate from the spectra, since their plots can only be
+// created by the user interface. If Progress is not NULL, the fraction of the
+// stream read is reported to it, and reading stops early if it is cancelled.
+//
+void ProjectFile::readExptSpectra (istream *BinIn, ProjectData &Project,
+  Job *Progress) {
+  unsigned int NumSpectra, DataSize, LinesSize, NumLists, StrSize, StdLampSize,
+    RadianceSize, RadErrSize, HeaderSize, LinHeaderSize;
+  XgLine NextLine;
+  XgSpectrum NextSpectrum;
+  Coord NextCoord;
+  ErrRange NextError;
+  vector <Coord> LoadedPoints;
+  vector <XgLine> NextLineSet;
+  vector <char> NextLinHeader;
+  vector <ErrRange> LoadedErrors;
+  vector < vector <XgLine> > NextLineLists;
+  float NextPoint, PointSpacing, MinX;
+  char NextChar;
+
+  // Find the length of the stream so that progress can be reported
+  streampos StartPos = BinIn -> tellg ();
+  BinIn -> seekg (0, ios::end);
+  double StreamSize = double (BinIn -> tellg ());
+  BinIn -> seekg (StartPos);
+  
+  // Determine how many experimental spectra there are and either load each in
+  // turn. If there are no spectra, only the NumSpectra will be loaded.
+  BinIn->read ((char*)&NumSpectra, sizeof(unsigned int));
+//  cout << "NumSpectra: " << NumSpectra << endl;
+  // Load each experimental spectrum in turn
+  for (unsigned int i = 0; i < NumSpectra; i ++) {
+    if (Progress != NULL) {
+      if (Progress -> cancelled ()) return;
+      Progress -> progress (double (BinIn -> tellg ()) / StreamSize);
+    }
+    NextSpectrum.clear ();
+    NextLineLists.clear ();
+    
+    // Determine how many data points there are in the spectrum
+    BinIn->read ((char*)&DataSize, sizeof (unsigned int));
+    BinIn->read ((char*)&MinX, sizeof (float));
+    BinIn->read ((char*)&PointSpacing, sizeof (float));
+    NextSpectrum.set_point_spacing (PointSpacing);
+    
+    // Read each data point into NextSpectrum
+    LoadedPoints.clear ();
+    for (unsigned int j = 0; j < DataSize; j ++) {
+      BinIn->read ((char*)&NextPoint, sizeof (float));
+      NextCoord.x = (double(j) * PointSpacing) + double(MinX);
+      NextCoord.y = NextPoint;
+      LoadedPoints.push_back (NextCoord);
+    }
+    NextSpectrum.data (LoadedPoints);
+    
+    // Load the file header
+    vector <char> HeaderFile;
+    BinIn->read ((char*)&HeaderSize, sizeof (unsigned int));
+    for (unsigned int j = 0; j < HeaderSize; j ++) {
+      BinIn->read ((char*) &NextChar, sizeof (char));
+      HeaderFile.push_back (NextChar);
+    }
+    NextSpectrum.headerFile (HeaderFile);
+
+    // Determine how many line lists are attached to the spectrum
+    BinIn->read ((char*)&NumLists, sizeof (unsigned int));
+    // Read each line list in turn into NextSpectrum
+    for (unsigned int j = 0; j < NumLists; j ++) {
+      BinIn->read ((char*)&LinHeaderSize, sizeof (unsigned int));
+      NextLinHeader.clear ();
+      for (unsigned int k = 0; k < LinHeaderSize; k ++) {
+        BinIn->read ((char*)&NextChar, sizeof (char));
+        NextLinHeader.push_back (NextChar);
+      }
+      BinIn->read ((char*)&LinesSize, sizeof (unsigned int));
+      NextLineSet.clear ();
+      for (unsigned int k = 0; k < LinesSize; k ++) {
+        NextLine.load (*BinIn);
+        NextLineSet.push_back (NextLine);
+      }
+      NextLineLists.push_back (NextLineSet);
+      NextSpectrum.lin_headers_push_back (NextLinHeader);
+    }
+    
+    // Read the standard lamp spectrum, if one exists
+    LoadedPoints.clear ();
+    BinIn->read ((char*)&StdLampSize, sizeof (unsigned int));
+    for (unsigned int j = 0; j < StdLampSize; j ++) {
+      BinIn->read ((char*)&NextCoord, sizeof (Coord));
+      LoadedPoints.push_back (NextCoord);
+    }      
+    NextSpectrum.standard_lamp_spectrum (LoadedPoints);
+
+    // Read the standard lamp radiance data, if any exists
+    LoadedPoints.clear ();
+    BinIn->read ((char*)&RadianceSize, sizeof (unsigned int));
+    for (unsigned int j = 0; j < RadianceSize; j ++) {
+      BinIn->read ((char*)&NextCoord, sizeof (Coord));
+      LoadedPoints.push_back (NextCoord);
+    }
+    NextSpectrum.radiance (LoadedPoints);
+    
+    // Read the standard lamp radiance uncertainties, if any exist
+    LoadedErrors.clear ();
+    BinIn->read ((char*)&RadErrSize, sizeof (unsigned int));
+    for (unsigned int j = 0; j < RadErrSize; j ++) {
+      BinIn->read ((char*)&NextError, sizeof (ErrRange));
+      LoadedErrors.push_back (NextError);
+    }
+    NextSpectrum.radiance_errors (LoadedErrors);
+    
+    // Finally, read the name, response file name, index, and reference status 
+    // of the spectrum
+    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
+    char NameIn [StrSize + 1];
+    BinIn->read (NameIn, sizeof(char) * StrSize);
+    NameIn [StrSize] = '\0';
+    NextSpectrum.name (string (NameIn));
+
+    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
+    char StdLampIn [StrSize + 1];
+    BinIn->read (StdLampIn, sizeof(char) * StrSize);
+    StdLampIn [StrSize] = '\0';
+    NextSpectrum.standard_lamp_file (string (StdLampIn));
+
+    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
+    char RadianceIn [StrSize + 1];
+    BinIn->read (RadianceIn, sizeof(char) * StrSize);
+    RadianceIn [StrSize] = '\0';
+    NextSpectrum.radiance_file (string (RadianceIn));
+
+    BinIn->read ((char*)&StrSize, sizeof (unsigned int));
+    char IndexIn [StrSize + 1];
+    BinIn->read (IndexIn, sizeof(char) * StrSize);
+    IndexIn [StrSize] = '\0';
+    NextSpectrum.index (string (IndexIn));
+
+    bool Ref;
+    BinIn->read ((char*)&Ref, sizeof(bool));
+    NextSpectrum.isReference (Ref);
+    Project.Spectra.push_back (NextSpectrum);
+    Project.SpectrumLines.push_back (NextLineLists);
+  }
+  
+  unsigned int LinkSize;
+  TypeLinkSpectra NextLink;
+  BinIn->read ((char*)&LinkSize, sizeof (unsigned int));
+  for (unsigned int i = 0; i < LinkSize; i ++) {
+    BinIn->read ((char*)&NextLink.a, sizeof (unsigned int));
+    BinIn->read ((char*)&NextLink.b, sizeof (unsigned int));
+    Project.Links.push_back (NextLink);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// readKuruczList (istream *, ProjectData &) : Reads Kurucz list information
+// from the istream at arg 1 that was saved in a file older than
+// FTS_FILE_VERSION_SECTIONS, and stores it in Project.
+//
+void ProjectFile::readKuruczList (istream *BinIn, ProjectData &Project) {
+  unsigned int Size, NameSize;
+  KzLine NextLine;
+  double PrecisionIn;
+  vector <KzLine> Lines;
+
+  // Determine how many lines are in the Kurucz list and either load each in
+  // turn or abort if there are no Kurucz lists available.
+  BinIn->read ((char*)&Size, sizeof (unsigned int));
+  if (Size == 0) return;  
+  for (unsigned int i = 0; i < Size; i ++) {
+    NextLine.load (*BinIn);
+    Lines.push_back (NextLine);
+  }
+  Project.KuruczLines = Lines;
+
+  // Load the name of the KuruczList
+  BinIn->read ((char*)&NameSize, sizeof (unsigned int));
+  char NameIn [NameSize + 1];
+  BinIn->read (NameIn, sizeof(char) * NameSize);
+  NameIn [NameSize] = '\0';
+  Project.KuruczName = NameIn;
+
+  // Load the Kurucz list level precision variable
+  BinIn->read ((char*)&PrecisionIn, sizeof(double));
+  Project.KuruczPrecision = PrecisionIn;
+}
+
+
+//------------------------------------------------------------------------------
+// snapshot (KzList &, vector <XgSpectrum> &, vector <TypeLinkSpectra> &,
+// ProjectSnapshot &) : Copies everything that is saved in an FTS file, other
+// than the interface settings, into Project. The points of a spectrum that
+// have not yet been read from the open project file are not copied. The
+// snapshot shares the file mapping instead, so they are only read when the
+// snapshot is written.
+//
+void ProjectFile::snapshot (KzList &Targets, vector <XgSpectrum> &Spectra,
+  vector <TypeLinkSpectra> &Links, ProjectSnapshot &Project) {
+  Project.KuruczLines = Targets.lines ();
+  Project.KuruczName = Targets.name ();
+  Project.KuruczPrecision = Targets.levelPrecision ();
+
+  Project.Spectra.resize (Spectra.size ());
+  for (unsigned int i = 0; i < Spectra.size (); i ++) {
+    SpectrumSnapshot &Spectrum = Project.Spectra[i];
+    Spectra[i].intensities (Spectrum.Intensities);
+    Spectrum.MinX = Spectra[i].firstWavenumber ();
+    Spectrum.PointSpacing = Spectra[i].get_point_spacing ();
+    Spectrum.HeaderFile = Spectra[i].headerFile ();
+    Spectrum.Lines = Spectra[i].lines ();
+    Spectrum.LinHeaders = Spectra[i].linHeaders ();
+    Spectrum.Profiles.resize (Spectrum.Lines.size ());
+    for (unsigned int j = 0; j < Spectrum.Lines.size (); j ++) {
+      Spectrum.Profiles[j] = *Spectra[i].profiles (j);
+    }
+    Spectrum.StandardLamp = Spectra[i].standard_lamp_spectrum ();
+    Spectrum.Radiance = Spectra[i].radiance ();
+    Spectrum.RadianceErrors = Spectra[i].radiance_error_ranges ();
+    Spectrum.Name = Spectra[i].name ();
+    Spectrum.StandardLampFile = Spectra[i].standard_lamp_file ();
+    Spectrum.RadianceFile = Spectra[i].radiance_file ();
+    Spectrum.Index = Spectra[i].index ();
+    Spectrum.Ref = Spectra[i].isReference ();
+  }
+  Project.Links = Links;
+}
+
+
+//------------------------------------------------------------------------------
+// write (string, ProjectSnapshot &, Job *) : Writes Project to the FTS file
+// Filename. The data is written to a temporary file alongside Filename,
+// which then replaces Filename in a single rename, so the original file is left
+// untouched if the save fails or is cancelled. Each snapshot uses a different
+// temporary file. Does not touch any widget, so may be called from a worker
+// thread.
+//
+void ProjectFile::write (string Filename, ProjectSnapshot &Project,
+  Job *Progress) throw (Error) {
+  TRACE_SCOPE ("ProjectFile::write");
+  ostringstream oss;
+  oss << Filename << ".tmp" << Project.Serial;
+  string TempFilename = oss.str ();
+  ofstream BinOut (TempFilename.c_str(), ios::out|ios::binary);
+  if (!BinOut.is_open ()) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "", 
+      "Check you have write permissions for the specified location."));
+  }
+  FtsWriter Fts (&BinOut, FTS_FILE_VERSION);
+  writeKuruczList (&Fts, Project);
+  writeExptSpectra (&Fts, Project, Progress);
+  Fts.beginSection (FTS_SECTION_INTERFACE);
+  if (Project.Interface.size () > 0) {
+    Fts.write (&Project.Interface[0], Project.Interface.size ());
+  }
+  Fts.endSection ();
+  Fts.finish ();
+  BinOut.close ();
+
+  if (BinOut.fail () || (Progress != NULL && Progress -> cancelled ())) {
+    remove (TempFilename.c_str ());
+    throw (Error (FLT_FILE_WRITE_ERROR, "",
+      "The existing file has not been changed."));
+  }
+#if defined (_WIN32)
+  remove (Filename.c_str ());  // rename () will not replace a file on Windows
+#endif
+  if (rename (TempFilename.c_str (), Filename.c_str ()) != 0) {
+    remove (TempFilename.c_str ());
+    throw (Error (FLT_FILE_WRITE_ERROR, "",
+      "Check you have write permissions for the specified location."));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// writeExptSpectra (FtsWriter *, ProjectSnapshot &, Job *) : Writes a section
+// for each spectrum in Project, followed by a section for each of its line
+// lists and the saved profiles of those lists, and then the spectrum links. If
+// this function is changed, care must be taken to ensure that readSections ()
+// is modified in a similar way or loading saved data will fail due to binary
+// bit mismatches. If Progress is not NULL, the fraction of the spectra saved is
+// reported to it.
+//
+void ProjectFile::writeExptSpectra (FtsWriter *Fts, ProjectSnapshot &Project,
+  Job *Progress) {
+  vector <XgLineRecord> Records;
+  vector <double> FitErrors;
+  vector <string> Strings;
+
+  for (unsigned int i = 0; i < Project.Spectra.size (); i ++) {
+    SpectrumSnapshot &Spectrum = Project.Spectra[i];
+    if (Progress != NULL) {
+      Progress -> progress (double (i) / Project.Spectra.size ());
+    }
+
+    // The spectrum itself. The intensities are stored as a single array of
+    // floats, from which the wavenumbers are recreated using MinX and the
+    // point spacing.
+    Fts -> beginSection (FTS_SECTION_SPECTRUM, i);
+    Fts -> writeString (Spectrum.Name);
+    Fts -> writeString (Spectrum.StandardLampFile);
+    Fts -> writeString (Spectrum.RadianceFile);
+    Fts -> writeString (Spectrum.Index);
+    Fts -> writeBool (Spectrum.Ref);
+    Fts -> writeDouble (Spectrum.MinX);
+    Fts -> writeDouble (Spectrum.PointSpacing);
+    Fts -> writeArray (Spectrum.Intensities);
+    Fts -> writeArray (Spectrum.HeaderFile);
+    Fts -> writeArray (Spectrum.StandardLamp);
+    Fts -> writeArray (Spectrum.Radiance);
+    Fts -> writeArray (Spectrum.RadianceErrors);
+    Fts -> endSection ();
+
+    // Each line list is written as an array of fixed size records followed by
+    // a block containing the strings of every line.
+    for (unsigned int j = 0; j < Spectrum.Lines.size (); j ++) {
+      Records.resize (Spectrum.Lines[j].size ());
+      Strings.clear ();
+      for (unsigned int k = 0; k < Spectrum.Lines[j].size (); k ++) {
+        Spectrum.Lines[j][k].pack (Records[k], Strings);
+      }
+      Fts -> beginSection (FTS_SECTION_LINES, i, j);
+      Fts -> writeArray (Spectrum.LinHeaders[j]);
+      Fts -> writeArray (Records);
+      Fts -> writeStrings (Strings);
+      Fts -> endSection ();
+
+      // The uncertainties of refitted lines are kept in a section of their
+      // own, which older versions of FAST skip. It is only written if some
+      // line in the list has been refitted.
+      FitErrors.resize (Spectrum.Lines[j].size () * 4);
+      bool Refitted = false;
+      for (unsigned int k = 0; k < Spectrum.Lines[j].size (); k ++) {
+        XgLine &Line = Spectrum.Lines[j][k];
+        double Correction = 1.0 + Line.wavCorr ();
+        FitErrors[k * 4] = Line.peakError ();
+        FitErrors[k * 4 + 1] = Line.widthError () / Correction;
+        FitErrors[k * 4 + 2] = Line.dmpError ();
+        FitErrors[k * 4 + 3] = Line.wavenumberError () / Correction;
+        if (Line.peakError () != 0.0 || Line.widthError () != 0.0
+          || Line.dmpError () != 0.0 || Line.wavenumberError () != 0.0) {
+          Refitted = true;
+        }
+      }
+      if (Refitted) {
+        Fts -> beginSection (FTS_SECTION_FIT_ERRORS, i, j);
+        Fts -> writeArray (FitErrors);
+        Fts -> endSection ();
+      }
+
+      if (Spectrum.Profiles[j].size () > 0) {
+        Fts -> beginSection (FTS_SECTION_PROFILES, i, j);
+        Spectrum.Profiles[j].write (Fts);
+        Fts -> endSection ();
+      }
+    }
+  }
+
+  Fts -> beginSection (FTS_SECTION_LINKS);
+  Fts -> writeArray (Project.Links);
+  Fts -> endSection ();
+}
+
+
+
+//------------------------------------------------------------------------------
+// writeKuruczList (FtsWriter *, ProjectSnapshot &) : Writes the Kurucz list in
+// Project to its own section as an array of fixed size records, followed by a
+// block containing the strings of every line. If this function is changed,
+// care must be taken to ensure that readSections () is modified in a similar
+// way or loading saved data will fail due to binary bit mismatches.
+//
+void ProjectFile::writeKuruczList (FtsWriter *Fts, ProjectSnapshot &Project) {
+  vector <KzLineRecord> Records (Project.KuruczLines.size ());
+  vector <string> Strings;
+
+  if (Project.KuruczLines.size () == 0) return;
+  for (unsigned int i = 0; i < Project.KuruczLines.size (); i ++) {
+    Project.KuruczLines[i].pack (Records[i], Strings);
+  }
+  Fts -> beginSection (FTS_SECTION_KURUCZ);
+  Fts -> writeString (Project.KuruczName);
+  Fts -> writeDouble (Project.KuruczPrecision);
+  Fts -> writeArray (Records);
+  Fts -> writeStrings (Strings);
+  Fts -> endSection ();
+}
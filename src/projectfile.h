@@ -0,0 +1,123 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProjectFile class (projectfile.h)
+//==============================================================================
+// Reads a FAST project file into a ProjectData structure, and writes one from a
+// ProjectSnapshot, without touching any part of the user interface. Files from
+// FTS_FILE_VERSION_SECTIONS onwards are read section by section with an
+// FtsReader (see ftsfile.h). Older files are read in the order in which they
+// were written.
+//
+// The line lists are kept separate from the spectra, since the plots of the
+// lines can only be created by the user interface. The interface settings at
+// the end of the file are likewise kept as raw data, as they can only be
+// applied once the lines have been matched with the target list.
+//
+// A project is written from a ProjectSnapshot, which is a copy of everything
+// saved in the file. Once a snapshot has been taken, the file can be written
+// from any thread while the original data continues to be edited. The
+// interface settings in the snapshot are filled in by AnalyserWindow.
+//
+#ifndef PROJECT_FILE_H
+#define PROJECT_FILE_H
+
+#include <vector>
+#include <string>
+#include <istream>
+#include "ErrDefs.h"
+#include "kzline.h"
+#include "xgline.h"
+#include "kzlist.h"
+#include "xgspectrum.h"
+#include "ftsfile.h"
+#include "profilestore.h"
+#include "bfengine.h"
+#include "jobqueue.h"
+
+using namespace::std;
+
+// The contents of an FTS project file
+typedef struct project_data {
+  int FileVersion;
+  vector <KzLine> KuruczLines;
+  string KuruczName;
+  double KuruczPrecision;
+  vector <XgSpectrum> Spectra;  // Spectra without their line lists
+  vector < vector < vector <XgLine> > > SpectrumLines;
+  vector < vector <ProfileStore> > SpectrumProfiles;  // Where saved
+  vector <TypeLinkSpectra> Links;
+  vector <char> Interface;      // The interface settings at the file end
+} ProjectData;
+
+// Copies of the project data that are written to an FTS file
+typedef struct spectrum_snapshot {
+  FtsFloatArray Intensities;    // May share the mapping of the open project
+  double MinX, PointSpacing;
+  vector <char> HeaderFile;
+  vector < vector <XgLine> > Lines;
+  vector < vector <char> > LinHeaders;
+  vector <ProfileStore> Profiles;
+  vector <Coord> StandardLamp, Radiance;
+  vector <ErrRange> RadianceErrors;
+  string Name, StandardLampFile, RadianceFile, Index;
+  bool Ref;
+} SpectrumSnapshot;
+typedef struct project_snapshot {
+  vector <KzLine> KuruczLines;
+  string KuruczName;
+  double KuruczPrecision;
+  vector <SpectrumSnapshot> Spectra;
+  vector <TypeLinkSpectra> Links;
+  vector <char> Interface;
+  unsigned int Changes;         // Edits made when the snapshot was taken
+  unsigned int Serial;          // Distinguishes the temporary save files
+} ProjectSnapshot;
+
+class ProjectFile {
+
+  public:
+    // Reads the project in Filename into Project. If Progress is not NULL, the
+    // fraction of the file read is reported to it, and reading stops early if
+    // it is cancelled.
+    static void read (string Filename, ProjectData &Project,
+      Job *Progress = NULL) throw (Error);
+
+    static int readFileVersion (istream *BinIn);
+    static void readSections (istream *BinIn, string Filename,
+      ProjectData &Project, Job *Progress) throw (Error);
+    static void readExptSpectra (istream *BinIn, ProjectData &Project,
+      Job *Progress);
+    static void readKuruczList (istream *BinIn, ProjectData &Project);
+
+    // Copies the target list, spectra and spectrum links into Project. The
+    // interface settings, Changes and Serial are left for the caller to set.
+    static void snapshot (KzList &Targets, vector <XgSpectrum> &Spectra,
+      vector <TypeLinkSpectra> &Links, ProjectSnapshot &Project);
+
+    // Writes Project to Filename. If Progress is not NULL, the fraction of the
+    // spectra written is reported to it, and the file is left unchanged if it
+    // is cancelled.
+    static void write (string Filename, ProjectSnapshot &Project,
+      Job *Progress = NULL) throw (Error);
+
+    static void writeExptSpectra (FtsWriter *Fts, ProjectSnapshot &Project,
+      Job *Progress);
+    static void writeKuruczList (FtsWriter *Fts, ProjectSnapshot &Project);
+};
+
+#endif // PROJECT_FILE_H
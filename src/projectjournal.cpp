@@ -0,0 +1,203 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProjectJournal class (projectjournal.cpp)
+//==============================================================================
+#include "projectjournal.h"
+#include <cstring>
+#include <sys/stat.h>
+
+using namespace::std;
+
+static const char JournalMagic[8] = "FASTJNL";
+
+//==============================================================================
+// CONSTRUCTORS AND DESTRUCTORS
+//==============================================================================
+
+ProjectJournal::ProjectJournal () {
+  Project = "";
+  File = NULL;
+  memset (&Header, 0, sizeof (JournalHeader));
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor : Closes the journal file, leaving it on disk so that any edits
+// that have not been saved can be recovered.
+//
+ProjectJournal::~ProjectJournal () {
+  close ();
+}
+
+
+//==============================================================================
+// PRIVATE FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// stamp (string, JournalHeader &) : Fills a with the header of a journal for
+// the project file Filename. Returns false if the file does not exist.
+//
+bool ProjectJournal::stamp (string Filename, JournalHeader &a) {
+  struct stat Info;
+  memset (&a, 0, sizeof (JournalHeader));
+  if (stat (Filename.c_str (), &Info) != 0) return false;
+  memcpy (a.Magic, JournalMagic, sizeof (a.Magic));
+  a.Version = JOURNAL_VERSION;
+  a.ProjectSize = Info.st_size;
+  a.ProjectTime = Info.st_mtime;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// create () : Writes a new journal file containing Header and Records, which is
+// then left open for further records to be appended. Returns false, and stops
+// journalling, if the file cannot be written.
+//
+bool ProjectJournal::create () {
+  string Filename = Project + JOURNAL_EXTENSION;
+  File = fopen (Filename.c_str (), "wb");
+  if (File == NULL) {
+    Project = "";
+    return false;
+  }
+  fwrite (&Header, sizeof (JournalHeader), 1, File);
+  if (Records.size () > 0) {
+    fwrite (&Records[0], sizeof (JournalRecord), Records.size (), File);
+  }
+  if (fflush (File) != 0) {
+    fclose (File);
+    File = NULL;
+    remove (Filename.c_str ());
+    Project = "";
+    return false;
+  }
+  return true;
+}
+
+
+//==============================================================================
+// PUBLIC FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// start (string, unsigned int) : Starts journalling the edits to Filename once
+// it has been saved from a snapshot taken after edit number After. Any later
+// edits already in the journal are carried over to the new one.
+//
+void ProjectJournal::start (string Filename, unsigned int After) {
+  vector <JournalRecord> Kept;
+  for (unsigned int i = 0; i < Records.size (); i ++) {
+    if (Records[i].Change > After) Kept.push_back (Records[i]);
+  }
+  start (Filename, Kept);
+}
+
+
+//------------------------------------------------------------------------------
+// start (string, vector <JournalRecord> &) : Starts journalling the edits to
+// Filename, beginning with the records in Kept. The journal of any other
+// project is removed. The journal file itself is only created once it has some
+// records to hold.
+//
+void ProjectJournal::start (string Filename, vector <JournalRecord> &Kept) {
+  string Previous = Project;
+  close ();
+  if (Previous != "" && Previous != Filename) {
+    remove ((Previous + JOURNAL_EXTENSION).c_str ());
+  }
+  Records = Kept;
+  if (!stamp (Filename, Header)) {
+    Records.clear ();
+    return;
+  }
+  Project = Filename;
+  if (Records.size () > 0) {
+    create ();
+  } else {
+    remove ((Project + JOURNAL_EXTENSION).c_str ());
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// append (JournalRecord) : Adds a to the end of the journal. The record is
+// passed to the operating system straight away but not synced to the disk, so
+// this is cheap enough to be called for every edit. Does nothing if the journal
+// has not been started.
+//
+void ProjectJournal::append (JournalRecord a) {
+  if (Project == "") return;
+  Records.push_back (a);
+  if (File == NULL) {
+    create ();
+  } else if (fwrite (&a, sizeof (JournalRecord), 1, File) != 1
+    || fflush (File) != 0) {
+    close ();  // The next save will still fold in the edits
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// close () : Stops journalling. The journal file is left on disk.
+//
+void ProjectJournal::close () {
+  if (File != NULL) fclose (File);
+  File = NULL;
+  Project = "";
+  Records.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// discard () : Stops journalling and deletes the journal file, abandoning any
+// edits that have not been saved.
+//
+void ProjectJournal::discard () {
+  string Previous = Project;
+  close ();
+  if (Previous != "") remove ((Previous + JOURNAL_EXTENSION).c_str ());
+}
+
+
+//------------------------------------------------------------------------------
+// read (string, vector <JournalRecord> &) : Reads the records of the journal of
+// the project in Filename into Replay, up to the first barrier or the end of
+// the last complete record. Returns false if there is no journal, or if it
+// was written for a different version of the project file.
+//
+bool ProjectJournal::read (string Filename, vector <JournalRecord> &Replay) {
+  JournalHeader Expected, Found;
+  JournalRecord Next;
+  Replay.clear ();
+  if (!stamp (Filename, Expected)) return false;
+  FILE *In = fopen ((Filename + JOURNAL_EXTENSION).c_str (), "rb");
+  if (In == NULL) return false;
+  if (fread (&Found, sizeof (JournalHeader), 1, In) != 1
+    || memcmp (&Found, &Expected, sizeof (JournalHeader)) != 0) {
+    fclose (In);
+    return false;
+  }
+  while (fread (&Next, sizeof (JournalRecord), 1, In) == 1) {
+    if (Next.Type == JOURNAL_BARRIER) break;
+    Replay.push_back (Next);
+  }
+  fclose (In);
+  return true;
+}
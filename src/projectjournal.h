@@ -0,0 +1,127 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ProjectJournal class (projectjournal.h)
+//==============================================================================
+// A ProjectJournal records the edits made to a saved project in a small file
+// alongside it, named after the project with JOURNAL_EXTENSION added. Each edit
+// is appended to the journal as a single fixed size record as soon as it is
+// made, so the work since the last save survives a crash without the whole
+// project having to be rewritten:
+//
+//   JournalHeader   Identifies the project file the edits apply to
+//   JournalRecord   One for each edit, in the order they were made
+//
+// The header holds the size and modification time of the project file when the
+// journal was started. A journal whose project file has since been replaced is
+// therefore ignored, rather than being replayed over the wrong data.
+//
+// Only edits that can be described by indices and a couple of values are kept
+// in the journal (see the JOURNAL_ record types below). Anything else, such as
+// loading a spectrum or refitting lines, is recorded as a JOURNAL_BARRIER, and
+// none of the records after a barrier are replayed. Either way the edits are
+// folded into the project file itself the next time it is saved, when the
+// journal is started again with only the edits made since the snapshot that
+// was saved.
+//
+#ifndef PROJECT_JOURNAL_H
+#define PROJECT_JOURNAL_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <stdint.h>
+
+using namespace::std;
+
+#define JOURNAL_EXTENSION ".journal"
+#define JOURNAL_VERSION   1
+
+// Record types. A, B and C are the indices listed for each type.
+#define JOURNAL_BARRIER          0  // An edit that cannot be journalled
+#define JOURNAL_LINE_STATE       1  // Spectrum, line list, line
+#define JOURNAL_LIFETIME         2  // Upper level
+#define JOURNAL_REFERENCE        3  // Spectrum
+#define JOURNAL_LINK             4  // Spectrum, linked spectrum
+#define JOURNAL_REMOVE_SPECTRUM  5  // Spectrum
+#define JOURNAL_REMOVE_LIST      6  // Spectrum, line list
+#define JOURNAL_REMOVE_STD_LAMP  7  // Spectrum
+#define JOURNAL_REMOVE_RADIANCE  8  // Spectrum
+#define JOURNAL_REMOVE_LEVEL     9  // Upper level
+
+// Flags for JOURNAL_LINE_STATE and JOURNAL_REFERENCE records
+#define JOURNAL_SELECTED   1
+#define JOURNAL_DISABLED   2
+#define JOURNAL_HIDDEN     4
+#define JOURNAL_REF        1
+
+typedef struct journal_header {
+  char Magic[8];
+  unsigned int Version;
+  unsigned int Reserved;
+  uint64_t ProjectSize;      // Of the project file the journal applies to
+  int64_t ProjectTime;       // Modification time of the same
+} JournalHeader;
+
+struct JournalRecord {
+  unsigned int Type;
+  unsigned int Change;       // The number of the edit in its session
+  unsigned int A, B, C;
+  unsigned int Flags;
+  double Value, Error;       // Lifetime and its error in seconds
+
+  JournalRecord (unsigned int TypeIn = JOURNAL_BARRIER, unsigned int AIn = 0,
+    unsigned int BIn = 0, unsigned int CIn = 0, unsigned int FlagsIn = 0,
+    double ValueIn = 0.0, double ErrorIn = 0.0) : Type (TypeIn), Change (0),
+    A (AIn), B (BIn), C (CIn), Flags (FlagsIn), Value (ValueIn),
+    Error (ErrorIn) { }
+};
+
+class ProjectJournal {
+
+  private:
+    string Project;                // The project file, or "" if not started
+    JournalHeader Header;
+    vector <JournalRecord> Records;  // Every record in the journal file
+    FILE *File;                    // Open once the first record is written
+
+    static bool stamp (string Filename, JournalHeader &a);
+    bool create ();
+
+  public:
+    ProjectJournal ();
+    ~ProjectJournal ();
+
+    // Starts journalling edits to the project saved in Filename. Records from
+    // the current journal with a Change greater than After are kept, and any
+    // others are dropped since they are now part of the project file.
+    void start (string Filename, unsigned int After);
+    void start (string Filename, vector <JournalRecord> &Kept);
+    void append (JournalRecord a);
+    void close ();
+    void discard ();
+
+    unsigned int size () { return Records.size (); }
+    bool started () { return Project != ""; }
+
+    // Reads the journal of the project in Filename into Replay, stopping at the
+    // first barrier. Returns false if there is no journal for that version of
+    // the project file.
+    static bool read (string Filename, vector <JournalRecord> &Replay);
+};
+
+#endif // PROJECT_JOURNAL_H
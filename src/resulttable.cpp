@@ -0,0 +1,398 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ResultTable class (resulttable.cpp)
+//==============================================================================
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include "resulttable.h"
+#include "CoreDefs.h"
+
+using namespace::std;
+
+//------------------------------------------------------------------------------
+// fields (vector <vector <BfResult> > &, vector <vector <XgLine> > &,
+// vector <vector <KzLine> > &) : Formats the results of every level as a set of
+// output fields. No field is initially active or selected.
+//
+vector <OutputField> ResultTable::fields (vector <vector <BfResult> > &Results,
+  vector <vector <XgLine> > &Fits, vector <vector <KzLine> > &Targets) {
+  vector <OutputField> ResultStrings;
+  OutputField NextField;
+  vector <string> ResultsForNextLevel;
+  ostringstream oss;
+
+  oss.setf( std::ios::fixed, std:: ios::floatfield);
+  NextField.Active = false;
+  NextField.Selected =false;
+  for (unsigned int l = 0; l < NUM_BF_OUTPUT_FIELDS; l ++) {
+    NextField.Name = FAST_BF_FIELD_NAMES [l];
+    NextField.List = OUTPUT_BF_LIST;
+    NextField.Value.clear ();
+    for (unsigned int Level = 0; Level < Results.size (); Level ++) {
+      ResultsForNextLevel.clear ();
+      for (unsigned int Line = 0; Line < Results[Level].size (); Line ++) {
+        switch (l) {
+          case 0:
+            NextField.List = OUTPUT_BF_LIST + OUTPUT_FITTED_LIST;
+            ResultsForNextLevel.push_back(Results[Level][Line].spectrum);
+            break;
+          case 1:
+            oss.str (""); oss << Results[Level][Line].index;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 2:
+            NextField.List = OUTPUT_BF_LIST + OUTPUT_FITTED_LIST + OUTPUT_TARGET_LIST;
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Results[Level][Line].wavenumber;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 3:
+            NextField.List = OUTPUT_BF_LIST + OUTPUT_FITTED_LIST;
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(0) << Results[Level][Line].eqwidth;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 4:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_line;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 5:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_cal;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 6:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_trans;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 7:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_total;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 8:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(0) << Results[Level][Line].err_eqwidth;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 9:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(4) << Results[Level][Line].br_frac;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 10:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_br_frac;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 11:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << (Results[Level][Line].a / pow(10.0,6));
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 12:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Results[Level][Line].err_a;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 13:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Results[Level][Line].loggf;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 14:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Results[Level][Line].dex;
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+        }
+      }
+      oss.unsetf (ios::scientific);
+      oss.unsetf (ios::fixed);
+      NextField.Value.push_back (ResultsForNextLevel);
+    }
+    NextField.ResultIndex = l;
+    ResultStrings.push_back (NextField);
+  }
+  
+  for (unsigned int l = 0; l < NUM_FITTED_OUTPUT_FIELDS; l ++) {
+    NextField.Name = FAST_FITTED_FIELD_NAMES [l];
+    NextField.List = OUTPUT_FITTED_LIST;
+    NextField.Value.clear ();
+    for (unsigned int Level = 0; Level < Fits.size (); Level ++) {
+      ResultsForNextLevel.clear ();
+      for (unsigned int Line = 0; Line < Fits[Level].size (); Line ++) {
+        switch (l) {
+          case 0:
+            oss.str (""); oss << Fits[Level][Line].line ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 1:
+            ResultsForNextLevel.push_back(Fits[Level][Line].id ());
+            break;
+          case 2:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(1) << Fits[Level][Line].peak ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 3:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(2) << Fits[Level][Line].width ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 4:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(4) << Fits[Level][Line].dmp ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 5:
+            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epstot ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 6:
+            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epsevn ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 7:
+            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epsodd ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 8:
+            oss.str (""); oss << setiosflags(ios::scientific) << setprecision(4) << Fits[Level][Line].epsran ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+        }
+      }
+      oss.unsetf (ios::scientific);
+      oss.unsetf (ios::fixed);
+      NextField.Value.push_back (ResultsForNextLevel); 
+    }
+    NextField.ResultIndex = NUM_BF_OUTPUT_FIELDS + l;
+    ResultStrings.push_back (NextField);    
+  }
+
+  for (unsigned int l = 0; l < NUM_TARGET_OUTPUT_FIELDS; l ++) {
+    NextField.Name = FAST_TARGET_FIELD_NAMES [l];
+    NextField.List = OUTPUT_TARGET_LIST;
+    NextField.Value.clear ();
+    for (unsigned int Level = 0; Level < Fits.size (); Level ++) {
+      ResultsForNextLevel.clear ();
+      for (unsigned int Line = 0; Line < Fits[Level].size (); Line ++) {
+        switch (l) {
+          case 0:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(4) << Targets[Level][Line].lambda ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 1:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].loggf ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 2:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].brFrac ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 3:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].eLower ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 4:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(1) << Targets[Level][Line].jLower ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 5:
+            ResultsForNextLevel.push_back (Targets[Level][Line].configLower ());
+            break;
+          case 6:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(3) << Targets[Level][Line].eUpper ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 7:
+            oss.str (""); oss << setiosflags(ios::fixed) << setprecision(1) << Targets[Level][Line].jUpper ();
+            ResultsForNextLevel.push_back (oss.str ());
+            break;
+          case 8:
+            ResultsForNextLevel.push_back (Targets[Level][Line].configUpper ());
+            break;
+        }
+      }
+      oss.unsetf (ios::scientific);
+      oss.unsetf (ios::fixed);
+      NextField.Value.push_back (ResultsForNextLevel);
+    }
+    NextField.ResultIndex = NUM_BF_OUTPUT_FIELDS + NUM_FITTED_OUTPUT_FIELDS + l;
+    ResultStrings.push_back (NextField);
+  }
+  return ResultStrings;
+}
+
+
+//------------------------------------------------------------------------------
+// filename (string, int) : Ensures Filename has a ".csv" or ".txt" extension
+// for a Text/CSV file, or a ".tex" extension for a LaTeX or AASTeX table.
+//
+string ResultTable::filename (string Filename, int Type) {
+  string Extension = Filename.size () >= 4 ? 
+    Filename.substr (Filename.size () - 4, 4) : "";
+  if (Type == OUTPUT_CSV) {
+    if (Extension != ".csv" && Extension != ".txt") Filename = Filename + ".csv";
+  } else {
+    if (Extension != ".tex") Filename = Filename + ".tex";
+  }
+  return Filename;
+}
+
+
+//------------------------------------------------------------------------------
+// write (string, int, vector <OutputField *> &, string) : Writes the values of
+// Fields to Filename in the format given by Type.
+//
+void ResultTable::write (string Filename, int Type, 
+  vector <OutputField *> &Fields, string Delimiter) throw (Error) {
+  ostringstream oss;
+
+  if (Fields.size () == 0) {
+    throw (Error (FLT_SYNTAX_ERROR, "Please specify some fields to output", "The list of 'Selected Fields' is currently empty"));
+  }
+  ofstream Output (Filename.c_str(), ios::out);
+
+  // Only proceed with the output if the file has been opened correctly
+  if (Output.is_open ()) {
+    switch (Type) {
+      case OUTPUT_CSV: writeCSV (Output, Fields, Delimiter); break;
+      case OUTPUT_LATEX: writeLaTeX (Output, Fields); break;
+      case OUTPUT_AASTEX: writeAASTeX (Output, Fields); break;
+      default:
+        Output.close ();
+        throw (Error (FLT_SYNTAX_ERROR, "Unknown output file type",
+          "The file type must be Text/CSV, LaTeX or AASTeX"));
+    }
+    Output.close ();
+
+  // If an error was encountered on trying to open the output file, generate an
+  // Error to inform the user of the problem.
+  } else {
+    oss << "Unable to open " << Filename;
+    throw (Error (FLT_FILE_OPEN_ERROR, oss.str (), "Check you have write permission for this file"));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// writeCSV (ostream &, vector <OutputField *> &, string) : Writes the field
+// names as a header, then one line of delimited values for each spectral line.
+// The levels are separated by blank lines.
+//
+void ResultTable::writeCSV (ostream &Output, vector <OutputField *> &Fields,
+  string Delimiter) {
+  ostringstream oss;
+
+  // Output the column headers
+  for (unsigned int Field = 0; Field < Fields.size (); Field ++) {
+    oss << Fields[Field] -> Name << Delimiter;
+  }
+  Output << oss.str().substr (0, oss.str().size() - Delimiter.size ()) << endl;
+  oss.str("");
+
+  // Construct the delimited output strings, one spectral line at a time, and
+  // output them to file.
+  for (unsigned int Level = 0; Level < Fields[0]->Value.size (); Level ++) {
+    for (unsigned int Line = 0; Line < Fields[0]->Value[Level].size (); Line ++) {
+      for (unsigned int Field = 0; Field < Fields.size (); Field ++) {
+        oss << Fields[Field] -> Value[Level][Line] << Delimiter;
+      }
+      Output << oss.str().substr (0, oss.str().size() - Delimiter.size ()) << endl;
+      oss.str("");
+    }
+    Output << endl;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// writeLaTeX (ostream &, vector <OutputField *> &) : Writes Fields as a LaTeX
+// table.
+//
+void ResultTable::writeLaTeX (ostream &Output, vector <OutputField *> &Fields) {
+  ostringstream oss;
+
+  // Generate the LaTeX table header
+  Output << "\\begin{table}" << endl;
+  Output << "\\centering" << endl;
+  Output << "\\begin{tabular}{";
+  for (unsigned int Field = 0; Field < Fields.size (); Field ++) {
+    Output << "l";
+  }
+  Output << "}" << endl;
+  for (unsigned int Field = 0; Field < Fields.size (); Field ++) {
+    oss << Fields[Field] -> Name << " & ";
+  }
+  Output << oss.str().substr (0, oss.str().size() - 2) << "\\\\" << endl;
+  Output << "\\hline \\hline" << endl;
+
+  // Write the FAST results to file
+  Output << getLaTeXRows (Fields) << endl;
+
+  // Finish off the table
+  Output << "\\end{tabular}" << endl;
+  Output << "\\caption{Your caption goes here}" << endl;
+  Output << "\\label{table:fastresults}" << endl;
+  Output << "\\end{table}" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+// writeAASTeX (ostream &, vector <OutputField *> &) : Writes Fields as an
+// AASTeX deluxetable.
+//
+void ResultTable::writeAASTeX (ostream &Output, vector <OutputField *> &Fields) {
+  ostringstream oss;
+
+  // Generate the AASTeX deluxe table header
+  Output << "\\begin{deluxetable}{";
+  for (unsigned int Field = 0; Field < Fields.size (); Field ++) {
+    Output << "l";
+  }
+  Output << "}" << endl;
+  Output << "\\tablewidth{0pt}" << endl;
+  Output << "\\tabletypesize{\\scriptsize}" << endl;
+  Output << "\\tablecaption{Your caption goes here}" << endl;
+  Output << "\\tablehead{" << endl << "  ";
+  for (unsigned int Field = 0; Field < Fields.size (); Field ++) {
+    oss << "\\colhead{" << Fields[Field] -> Name << "} & ";
+  }
+  Output << oss.str().substr (0, oss.str().size() - 3) << endl << "}" << endl;
+
+  // Output the data to file.
+  Output << "\\startdata" << endl;
+  Output << getLaTeXRows (Fields) << endl;
+  Output << "\\enddata" << endl;
+
+  // Finish off the table
+  Output << "\\label{table:fastresults}" << endl;
+  Output << "\\end{deluxetable}" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+// getLaTeXRows (vector <OutputField *> &) : Construct a stringstream containing
+// the output data in LaTeX table format. Take care to use "\\" at the end of
+// all lines rather than a field delimiter. Return the stringstream string for
+// output in the calling function.
+//
+string ResultTable::getLaTeXRows (vector <OutputField *> &Fields) {
+  ostringstream oss;
+  for (unsigned int Level = 0; Level < Fields[0]->Value.size (); Level ++) {
+    for (unsigned int Line = 0; Line < Fields[0]->Value[Level].size (); Line ++) {
+      for (unsigned int Field = 0; Field < Fields.size (); Field ++) {
+        oss << "$" << Fields[Field] -> Value[Level][Line] << "$ & ";
+      }
+      oss.seekp ((long)oss.tellp () - 2);
+      oss << "\\\\\n";
+    }
+    oss << endl;
+  }
+  return oss.str().substr (0, oss.str().size() - 3);
+}
@@ -0,0 +1,86 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ResultTable class (resulttable.h)
+//==============================================================================
+// Formats the results of a branching fraction calculation as a set of output
+// fields, one for each quantity that can be written, and writes a selection of
+// those fields to a Text/CSV file, a LaTeX table or an AASTeX deluxetable.
+// Each field holds the formatted value of its quantity for every line of every
+// upper level. The fields come from three lists: the branching fraction data,
+// the parameters of the fitted XGremlin lines, and the target lines.
+//
+// ResultTable does not ask before overwriting a file. That is left to the
+// caller (see OutputWindow).
+//
+#ifndef RESULT_TABLE_H
+#define RESULT_TABLE_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include "ErrDefs.h"
+#include "xgline.h"
+#include "kzline.h"
+#include "bfengine.h"
+
+#define OUTPUT_BF_LIST 0x01
+#define OUTPUT_TARGET_LIST 0x02
+#define OUTPUT_FITTED_LIST 0x04
+
+// Output file types
+#define OUTPUT_CSV    0
+#define OUTPUT_LATEX  1
+#define OUTPUT_AASTEX 2
+
+using namespace::std;
+
+typedef struct output_field {
+  string Name;                        // Field name to be displayed
+  unsigned int ResultIndex;           // Index of this element in the 'Results' vector
+  bool Active;                        // Set to true when this field is included in move operations
+  bool Selected;                      // Set to true when this field is selected for output
+  vector < vector <string> > Value;   // A copy of the field value, obtained from AnalyserWindow
+  unsigned short int List;
+} OutputField;
+
+class ResultTable {
+
+  private:
+    static void writeCSV (ostream &Output, vector <OutputField *> &Fields,
+      string Delimiter);
+    static void writeLaTeX (ostream &Output, vector <OutputField *> &Fields);
+    static void writeAASTeX (ostream &Output, vector <OutputField *> &Fields);
+    static string getLaTeXRows (vector <OutputField *> &Fields);
+
+  public:
+    // Returns every output field. Results[l], Fits[l] and Targets[l] hold the
+    // branching fraction data, fitted lines and target lines of level l.
+    static vector <OutputField> fields (vector <vector <BfResult> > &Results,
+      vector <vector <XgLine> > &Fits, vector <vector <KzLine> > &Targets);
+
+    // Adds the extension expected for files of type Type to Filename, if it
+    // does not already have one
+    static string filename (string Filename, int Type);
+
+    // Writes Fields to Filename, which must already have the right extension.
+    // The Delimiter is only used for Text/CSV files.
+    static void write (string Filename, int Type, vector <OutputField *> &Fields,
+      string Delimiter = ",") throw (Error);
+};
+
+#endif // RESULT_TABLE_H
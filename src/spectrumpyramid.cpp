@@ -0,0 +1,130 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// SpectrumPyramid class (spectrumpyramid.cpp)
+//==============================================================================
+#include "spectrumpyramid.h"
+#include "trace.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// build (const vector <Coord> &) : Replaces the pyramid with one for Data. The
+// last block of each level may cover fewer points than the others.
+//
+void SpectrumPyramid::build (const vector <Coord> &Data) {
+  TRACE_SCOPE ("SpectrumPyramid::build");
+  clear ();
+  Points = Data.size ();
+  if (Points == 0) return;
+
+  // Level 0 is made from the data points themselves
+  unsigned int Blocks = (Points + PYRAMID_BLOCK - 1) / PYRAMID_BLOCK;
+  Low.push_back (vector <float> (Blocks));
+  High.push_back (vector <float> (Blocks));
+  for (unsigned int i = 0; i < Blocks; i ++) {
+    unsigned int Last = min ((i + 1) * PYRAMID_BLOCK, Points);
+    double Min = Data[i * PYRAMID_BLOCK].y, Max = Min;
+    for (unsigned int j = i * PYRAMID_BLOCK + 1; j < Last; j ++) {
+      if (Data[j].y < Min) Min = Data[j].y;
+      if (Data[j].y > Max) Max = Data[j].y;
+    }
+    Low[0][i] = Min;
+    High[0][i] = Max;
+  }
+
+  // Each level above combines pairs of blocks from the one below
+  while (Blocks > 1) {
+    unsigned int Below = Low.size () - 1;
+    Blocks = (Blocks + 1) / 2;
+    Low.push_back (vector <float> (Blocks));
+    High.push_back (vector <float> (Blocks));
+    for (unsigned int i = 0; i < Blocks; i ++) {
+      unsigned int Pair = min (2 * i + 1, (unsigned int) Low[Below].size () - 1);
+      Low.back ()[i] = min (Low[Below][2 * i], Low[Below][Pair]);
+      High.back ()[i] = max (High[Below][2 * i], High[Below][Pair]);
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// clear () : Empties the pyramid and frees its memory
+//
+void SpectrumPyramid::clear () {
+  vector < vector <float> > ().swap (Low);
+  vector < vector <float> > ().swap (High);
+  Points = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// range (const vector <Coord> &, unsigned int, unsigned int, double &,
+// double &) : Finds the lowest and highest intensity in Data[First, Last). The
+// points before the first whole block and after the last are read from Data.
+// The whole blocks in between are covered by walking up the pyramid, taking
+// a block from either end of the run whenever it cannot be paired with its
+// neighbour at the next level. At most two blocks are taken at each level.
+//
+bool SpectrumPyramid::range (const vector <Coord> &Data, unsigned int First,
+  unsigned int Last, double &Min, double &Max) const {
+  Last = min (Last, min (Points, (unsigned int) Data.size ()));
+  if (First >= Last) return false;
+  Min = Data[First].y;
+  Max = Min;
+
+  // Read the points that do not fill a block of level 0
+  while (First < Last && First % PYRAMID_BLOCK != 0) {
+    Min = min (Min, Data[First].y);
+    Max = max (Max, Data[First].y);
+    First ++;
+  }
+  while (Last > First && Last % PYRAMID_BLOCK != 0) {
+    Last --;
+    Min = min (Min, Data[Last].y);
+    Max = max (Max, Data[Last].y);
+  }
+
+  // Then take the largest blocks that lie within the run
+  unsigned int i = First / PYRAMID_BLOCK, j = Last / PYRAMID_BLOCK;
+  for (unsigned int k = 0; k < Low.size () && i < j; k ++) {
+    if (i & 1) {
+      Min = min (Min, double (Low[k][i]));
+      Max = max (Max, double (High[k][i]));
+      i ++;
+    }
+    if (j & 1) {
+      j --;
+      Min = min (Min, double (Low[k][j]));
+      Max = max (Max, double (High[k][j]));
+    }
+    i /= 2;
+    j /= 2;
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the memory used by the pyramid
+//
+uint64_t SpectrumPyramid::bytes () {
+  uint64_t Bytes = 0;
+  for (unsigned int k = 0; k < Low.size (); k ++) {
+    Bytes += (Low[k].capacity () + High[k].capacity ()) * sizeof (float);
+  }
+  return Bytes;
+}
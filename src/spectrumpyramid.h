@@ -0,0 +1,70 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// SpectrumPyramid class (spectrumpyramid.h)
+//==============================================================================
+// A SpectrumPyramid holds the minimum and maximum intensity of a spectrum over
+// blocks of points at a series of resolutions. Level 0 holds one minimum and
+// maximum for every PYRAMID_BLOCK points, and each level above it combines
+// pairs of blocks from the level below, until a single block covers the whole
+// spectrum.
+//
+// range () uses the pyramid to find the minimum and maximum over any run of
+// points in O(PYRAMID_BLOCK + log N) time, however many points it spans. This
+// lets a plot of the whole spectrum be drawn in time proportional to its
+// width in pixels. The pyramid uses about one byte per point.
+//
+// The pyramid does not keep the spectrum. The same data it was built from
+// must be passed to range (), which reads the points at either end of the
+// run that do not fill a block.
+//
+#ifndef SPECTRUM_PYRAMID_H
+#define SPECTRUM_PYRAMID_H
+
+#include <vector>
+#include <stdint.h>
+#include "CoreDefs.h"
+
+using namespace::std;
+
+#define PYRAMID_BLOCK 16  /* Data points in each block of level 0 */
+
+class SpectrumPyramid {
+
+  private:
+    vector < vector <float> > Low, High;  // Low[k][i] is the minimum of block i
+                                          // at level k
+    unsigned int Points;                  // Data points the pyramid covers
+
+  public:
+    SpectrumPyramid () { Points = 0; }
+    ~SpectrumPyramid () { }
+
+    void build (const vector <Coord> &Data);
+    void clear ();
+
+    // Set Min and Max to the lowest and highest intensity of Data[First] to
+    // Data[Last - 1]. Returns false if there are no such points.
+    bool range (const vector <Coord> &Data, unsigned int First,
+      unsigned int Last, double &Min, double &Max) const;
+
+    unsigned int size () { return Points; }
+    unsigned int levels () { return Low.size (); }
+    uint64_t bytes ();
+};
+
+#endif // SPECTRUM_PYRAMID_H
@@ -0,0 +1,322 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// Trace class (trace.cpp)
+//==============================================================================
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <glibmm/thread.h>
+#include <glibmm/timer.h>
+#include "trace.h"
+
+using namespace::std;
+
+// Events beyond this number are dropped, so that a long session cannot use up
+// all the available memory
+#define TRACE_MAX_EVENTS 4000000
+
+typedef struct trace_event {
+  const char *Name;
+  char Phase;              // 'X' for a scope, 'C' for a counter
+  double Start, Duration;  // In microseconds
+  unsigned int Thread;
+  long Value;              // The counter total after the event
+} TraceEvent;
+
+typedef struct trace_counter {
+  const char *Name;
+  long Total;
+} TraceCounter;
+
+// Everything recorded while tracing. This is created by the first call to
+// Trace::start () or Trace::monitor () and never deleted, so that a thread which
+// has just seen Trace::Enabled set can always reach it.
+typedef struct trace_log {
+  string Filename;
+  bool Recording;               // True while events are kept for Filename
+  bool Monitoring;              // True while Stats are kept
+  Glib::Timer Timer;            // Started when the log is created
+  double Origin;                // Timer reading when recording started, in us
+  Glib::Mutex Mutex;
+  vector <TraceEvent> Events;
+  vector <TraceCounter> Counters;
+  vector <TraceStat> Stats;
+  vector <GThread *> Threads;   // Thread n is the nth thread seen
+  unsigned long Dropped;
+} TraceLog;
+
+static TraceLog *Log = NULL;
+
+bool Trace::Enabled = false;
+
+
+//------------------------------------------------------------------------------
+// threadIndex () : Returns the index of the calling thread in Log -> Threads,
+// adding it if it has not been seen before. Log -> Mutex must be held.
+//
+static unsigned int threadIndex () {
+  GThread *Self = g_thread_self ();
+  for (unsigned int i = 0; i < Log -> Threads.size (); i ++) {
+    if (Log -> Threads[i] == Self) return i;
+  }
+  Log -> Threads.push_back (Self);
+  return Log -> Threads.size () - 1;
+}
+
+
+//------------------------------------------------------------------------------
+// createLog () : Creates the trace log if it does not already exist.
+//
+static void createLog () {
+  if (Log != NULL) return;
+  Log = new TraceLog;
+  Log -> Recording = false;
+  Log -> Monitoring = false;
+  Log -> Origin = 0.0;
+  Log -> Dropped = 0;
+  Log -> Timer.start ();
+}
+
+
+//------------------------------------------------------------------------------
+// addStat (const char *, bool, double) : Adds Value to the summary of the
+// scope or counter Name. Log -> Mutex must be held.
+//
+static void addStat (const char *Name, bool Counter, double Value) {
+  unsigned int i;
+  for (i = 0; i < Log -> Stats.size (); i ++) {
+    if (Log -> Stats[i].Name == Name) break;
+  }
+  if (i == Log -> Stats.size ()) {
+    TraceStat NewStat;
+    NewStat.Name = Name;
+    NewStat.Counter = Counter;
+    NewStat.Calls = 0;
+    NewStat.Last = NewStat.Total = NewStat.Max = 0.0;
+    Log -> Stats.push_back (NewStat);
+  }
+  TraceStat &Stat = Log -> Stats[i];
+  Stat.Calls ++;
+  Stat.Last = Value;
+  Stat.Total += Value;
+  if (Value > Stat.Max) Stat.Max = Value;
+}
+
+
+//------------------------------------------------------------------------------
+// addEvent (TraceEvent &) : Stores Event, unless TRACE_MAX_EVENTS have already
+// been stored. Log -> Mutex must be held.
+//
+static void addEvent (TraceEvent &Event) {
+  if (Log -> Events.size () < TRACE_MAX_EVENTS) {
+    Log -> Events.push_back (Event);
+  } else {
+    Log -> Dropped ++;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// parse (int &, char *) : Removes TRACE_ARG and the file name following it from
+// the command line, then starts tracing to that file. If TRACE_ARG is not
+// given, the file named in TRACE_ENV is used instead.
+//
+void Trace::parse (int &argc, char *argv[]) {
+  string Filename = "";
+  const char *Env = getenv (TRACE_ENV);
+
+  if (Env != NULL) Filename = Env;
+  for (int i = 1; i + 1 < argc; i ++) {
+    if (string (argv[i]) == TRACE_ARG) {
+      Filename = argv[i + 1];
+      for (int j = i; j + 2 <= argc; j ++) argv[j] = argv[j + 2];
+      argc -= 2;
+      break;
+    }
+  }
+  if (Filename != "") start (Filename);
+}
+
+
+//------------------------------------------------------------------------------
+// start (string) : Discards any events already recorded and starts recording
+// new ones. The thread calling start () is named the main thread.
+//
+void Trace::start (string Filename) {
+  createLog ();
+  Glib::Mutex::Lock lock (Log -> Mutex);
+  Log -> Filename = Filename;
+  Log -> Events.clear ();
+  Log -> Counters.clear ();
+  Log -> Threads.clear ();
+  Log -> Dropped = 0;
+  threadIndex ();
+  Log -> Origin = Log -> Timer.elapsed () * 1.0e6;
+  Log -> Recording = true;
+  Enabled = true;
+  cerr << "Tracing to " << Filename << endl;
+}
+
+
+//------------------------------------------------------------------------------
+// stop () : Stops recording and writes every event to the trace file in the
+// Chrome trace-event format.
+//
+void Trace::stop () throw (Error) {
+  char Buffer[256];
+
+  if (Log == NULL) return;
+  Glib::Mutex::Lock lock (Log -> Mutex);
+  if (!Log -> Recording) return;
+  Log -> Recording = false;
+  Enabled = Log -> Monitoring;
+  FILE *Out = fopen (Log -> Filename.c_str (), "w");
+  if (Out == NULL) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Unable to open " + Log -> Filename,
+      "The trace has not been saved."));
+  }
+
+  fprintf (Out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  for (unsigned int i = 0; i < Log -> Threads.size (); i ++) {
+    if (i == 0) sprintf (Buffer, "main");
+    else sprintf (Buffer, "worker %u", i);
+    fprintf (Out, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+      "\"tid\": %u, \"args\": {\"name\": \"%s\"}},\n", i, Buffer);
+  }
+  for (unsigned int i = 0; i < Log -> Events.size (); i ++) {
+    TraceEvent &Event = Log -> Events[i];
+    if (Event.Phase == 'X') {
+      fprintf (Out, "{\"name\": \"%s\", \"cat\": \"fast\", \"ph\": \"X\", "
+        "\"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+        Event.Name, Event.Start, Event.Duration, Event.Thread);
+    } else {
+      fprintf (Out, "{\"name\": \"%s\", \"cat\": \"fast\", \"ph\": \"C\", "
+        "\"ts\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"value\": %ld}}",
+        Event.Name, Event.Start, Event.Thread, Event.Value);
+    }
+    fprintf (Out, "%s\n", i + 1 < Log -> Events.size () ? "," : "");
+  }
+  fprintf (Out, "]}\n");
+  if (fclose (Out) != 0) {
+    throw (Error (FLT_FILE_WRITE_ERROR, "Error writing " + Log -> Filename,
+      "Check there is enough space on the disk."));
+  }
+
+  cerr << "Wrote " << Log -> Events.size () << " trace events to "
+    << Log -> Filename << endl;
+  if (Log -> Dropped > 0) {
+    cerr << "Warning: " << Log -> Dropped << " later events were dropped"
+      << endl;
+  }
+  Log -> Events.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// monitor (bool) : Starts or stops keeping a summary of every scope and
+// counter. The summary is kept until resetStats () is called.
+//
+void Trace::monitor (bool On) {
+  createLog ();
+  Glib::Mutex::Lock lock (Log -> Mutex);
+  Log -> Monitoring = On;
+  Enabled = Log -> Recording || Log -> Monitoring;
+}
+
+
+//------------------------------------------------------------------------------
+// stats () : Returns a copy of the summary of every scope and counter seen
+// while monitoring, in the order they were first seen.
+//
+vector <TraceStat> Trace::stats () {
+  if (Log == NULL) return vector <TraceStat> ();
+  Glib::Mutex::Lock lock (Log -> Mutex);
+  return Log -> Stats;
+}
+
+
+//------------------------------------------------------------------------------
+// resetStats () : Discards the summary of every scope and counter.
+//
+void Trace::resetStats () {
+  if (Log == NULL) return;
+  Glib::Mutex::Lock lock (Log -> Mutex);
+  Log -> Stats.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// now () : Returns the time since the trace log was created in microseconds.
+//
+double Trace::now () {
+  return Log -> Timer.elapsed () * 1.0e6;
+}
+
+
+//------------------------------------------------------------------------------
+// scope (const char *, double) : Records a scope named Name, which started at
+// Start and has just finished.
+//
+void Trace::scope (const char *Name, double Start) {
+  TraceEvent Event;
+  Event.Name = Name;
+  Event.Phase = 'X';
+  Event.Start = Start - Log -> Origin;
+  Event.Duration = now () - Start;
+  Event.Value = 0;
+
+  Glib::Mutex::Lock lock (Log -> Mutex);
+  if (Log -> Monitoring) addStat (Name, false, Event.Duration * 1.0e-6);
+  if (!Log -> Recording || Start < Log -> Origin) return;
+  Event.Thread = threadIndex ();
+  addEvent (Event);
+}
+
+
+//------------------------------------------------------------------------------
+// count (const char *, long) : Adds Delta to the counter named Name and records
+// its new total.
+//
+void Trace::count (const char *Name, long Delta) {
+  TraceEvent Event;
+  unsigned int i;
+  Event.Name = Name;
+  Event.Phase = 'C';
+  Event.Start = now ();
+  Event.Duration = 0.0;
+
+  Glib::Mutex::Lock lock (Log -> Mutex);
+  if (Log -> Monitoring) addStat (Name, true, Delta);
+  if (!Log -> Recording) return;
+  Event.Start -= Log -> Origin;
+  for (i = 0; i < Log -> Counters.size (); i ++) {
+    if (strcmp (Log -> Counters[i].Name, Name) == 0) break;
+  }
+  if (i == Log -> Counters.size ()) {
+    TraceCounter NewCounter;
+    NewCounter.Name = Name;
+    NewCounter.Total = 0;
+    Log -> Counters.push_back (NewCounter);
+  }
+  Log -> Counters[i].Total += Delta;
+  Event.Value = Log -> Counters[i].Total;
+  Event.Thread = threadIndex ();
+  addEvent (Event);
+}
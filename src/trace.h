@@ -0,0 +1,112 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// Trace class (trace.h)
+//==============================================================================
+// Records how long FAST spends in each of its slow paths, and how much work
+// they do, as a Chrome trace-event file. This can be opened in chrome://tracing
+// or https://ui.perfetto.dev to see which stage of a refresh took the time.
+//
+// Tracing is started by Trace::parse () if TRACE_ARG <file> is given on the
+// command line, or if the TRACE_ENV environment variable holds a file name.
+// The file is written by Trace::stop () when FAST exits.
+//
+// Code is traced with two macros:
+//
+//   TRACE_SCOPE ("name")         Times the rest of the enclosing block
+//   TRACE_COUNT ("name", Delta)  Adds Delta to a running total
+//
+// Names must be string literals. When tracing is off, each macro costs no more
+// than a test of Trace::Enabled. Both may be used from any thread.
+//
+// Trace::monitor () turns on a running summary of each scope and counter
+// without writing a file. This is what the performance window displays.
+//
+#ifndef FAST_TRACE_H
+#define FAST_TRACE_H
+
+#include <string>
+#include <vector>
+#include "ErrDefs.h"
+
+using namespace::std;
+
+#define TRACE_ARG "--trace"
+#define TRACE_ENV "FAST_TRACE"
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2 (a, b)
+#define TRACE_SCOPE(Name) \
+  TraceScope TRACE_CONCAT (TraceScope_, __LINE__) (Name)
+#define TRACE_COUNT(Name, Delta) \
+  do { if (Trace::Enabled) Trace::count (Name, Delta); } while (0)
+
+// The running summary of one scope or counter
+typedef struct trace_stat {
+  string Name;
+  bool Counter;          // False for a scope
+  unsigned long Calls;
+  double Last, Total, Max;   // Scope durations in seconds, or counter deltas
+} TraceStat;
+
+class Trace {
+
+  public:
+    static bool Enabled;    // True while recording to a file or monitoring
+
+    // Removes TRACE_ARG and its file name from the command line, then starts
+    // tracing if a file was given there or in TRACE_ENV. Threads must already
+    // have been initialised.
+    static void parse (int &argc, char *argv[]);
+
+    // Starts recording events, which are written to Filename by stop ()
+    static void start (string Filename);
+    static void stop () throw (Error);
+
+    // Starts or stops keeping a TraceStat for every scope and counter. The
+    // summary is kept whether or not a trace file is being recorded.
+    static void monitor (bool On);
+    static vector <TraceStat> stats ();
+    static void resetStats ();
+
+    // Microseconds since tracing was started
+    static double now ();
+
+    // Record the scope Name that began at Start, and add Delta to the counter
+    // Name. These are called by TraceScope and TRACE_COUNT.
+    static void scope (const char *Name, double Start);
+    static void count (const char *Name, long Delta);
+};
+
+// Times its own lifetime. Declared with TRACE_SCOPE.
+class TraceScope {
+
+  private:
+    const char *Name;
+    double Start;      // -1 if tracing was off when this was created
+
+  public:
+    TraceScope (const char *NameIn) {
+      Name = NameIn;
+      Start = Trace::Enabled ? Trace::now () : -1.0;
+    }
+    ~TraceScope () {
+      if (Trace::Enabled && Start >= 0.0) Trace::scope (Name, Start);
+    }
+};
+
+#endif // FAST_TRACE_H
@@ -0,0 +1,575 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// VoigtFit and VoigtRefitter classes (voigtfit.cpp)
+//==============================================================================
+// The fit parameters for each line are stored consecutively in a single vector
+// in the order peak, width (mK), damping, centre (cm^-1). A group of N lines
+// therefore has 4N parameters. Derivatives with respect to the width, damping
+// and centre are found numerically since the XGremlin Voigt kernel is built
+// from interpolation tables. The peak derivative is just the unit profile.
+//
+#include "voigtfit.h"
+#include <cmath>
+#if !defined (_WIN32)
+  #include <unistd.h>
+#endif
+
+using namespace::std;
+
+// Offsets of each parameter within the block belonging to a single line
+#define P_PEAK   0
+#define P_WIDTH  1
+#define P_DMP    2
+#define P_CENTRE 3
+
+// Step sizes used to calculate numerical derivatives
+#define DERIV_WIDTH_STEP  1.0e-3  /* Fraction of the line width */
+#define DERIV_DMP_STEP    1.0e-3
+#define DERIV_CENTRE_STEP 5.0e-2  /* Fraction of the point spacing */
+
+
+//------------------------------------------------------------------------------
+// solveLinear (vector <double>, vector <double>, int, vector <double> &) :
+// Solves the m x m system A.x = b by Gaussian elimination with partial
+// pivoting. A is stored row by row. Returns false if A is singular.
+//
+static bool solveLinear (vector <double> A, vector <double> b, int m,
+  vector <double> &x) {
+  for (int c = 0; c < m; c ++) {
+    int Pivot = c;
+    for (int r = c + 1; r < m; r ++) {
+      if (fabs (A[r * m + c]) > fabs (A[Pivot * m + c])) Pivot = r;
+    }
+    if (A[Pivot * m + c] == 0.0) return false;
+    if (Pivot != c) {
+      for (int k = 0; k < m; k ++) swap (A[c * m + k], A[Pivot * m + k]);
+      swap (b[c], b[Pivot]);
+    }
+    for (int r = c + 1; r < m; r ++) {
+      double f = A[r * m + c] / A[c * m + c];
+      for (int k = c; k < m; k ++) A[r * m + k] -= f * A[c * m + k];
+      b[r] -= f * b[c];
+    }
+  }
+  x.assign (m, 0.0);
+  for (int r = m - 1; r >= 0; r --) {
+    double Sum = b[r];
+    for (int k = r + 1; k < m; k ++) Sum -= A[r * m + k] * x[k];
+    x[r] = Sum / A[r * m + r];
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// invertMatrix (vector <double>, int, vector <double> &) : Inverts the m x m
+// matrix A by solving for each column of the identity matrix in turn.
+//
+static bool invertMatrix (vector <double> A, int m, vector <double> &Inverse) {
+  vector <double> Unit (m, 0.0), Column;
+  Inverse.assign (m * m, 0.0);
+  for (int c = 0; c < m; c ++) {
+    Unit.assign (m, 0.0);
+    Unit[c] = 1.0;
+    if (!solveLinear (A, Unit, m, Column)) return false;
+    for (int r = 0; r < m; r ++) Inverse[r * m + c] = Column[r];
+  }
+  return true;
+}
+
+
+//==============================================================================
+// VoigtFit : CONSTRUCTORS AND SET FUNCTIONS
+//==============================================================================
+
+VoigtFit::VoigtFit () {
+  Y = NULL;
+  NumPoints = 0;
+  Origin = 0.0;
+  Step = 0.0;
+  MaxIterations = FIT_MAX_ITERATIONS;
+  Tolerance = FIT_TOLERANCE;
+}
+
+
+//------------------------------------------------------------------------------
+// spectrum (const double *, int, double, double) : Sets the spectrum to which
+// lines will be fitted. YIn holds NumPointsIn intensities on a uniform grid
+// starting at OriginIn cm^-1 with a spacing of StepIn cm^-1.
+//
+void VoigtFit::spectrum (const double *YIn, int NumPointsIn, double OriginIn,
+  double StepIn) {
+  Y = YIn;
+  NumPoints = NumPointsIn;
+  Origin = OriginIn;
+  Step = StepIn;
+}
+
+
+//==============================================================================
+// VoigtFit : PRIVATE FUNCTIONS
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// lineProfile (const double *, int, int, double *) : Writes the Voigt profile
+// of the line described by the four parameters at P into Out, for the n grid
+// points starting at Start. VoigtLsqfit::voigt only uses the first two x values
+// to find the point spacing, so there is no need to fill a full x array here.
+//
+void VoigtFit::lineProfile (const double *P, int Start, int n, double *Out) {
+  double x[2];
+  x[0] = Origin + Start * Step;
+  x[1] = x[0] + Step;
+  voigtGen.voigt (n, x, Out, 0.0005 * P[P_WIDTH] / Step, P[P_PEAK], P[P_DMP],
+    P[P_CENTRE]);
+}
+
+
+//------------------------------------------------------------------------------
+// lineWindow (double, double, int &, int &) : Returns the grid indices of the
+// fit window for a line of the given centre and width. End is one past the
+// last point in the window.
+//
+void VoigtFit::lineWindow (double Centre, double Width, int &Start, int &End) {
+  double HalfWidth = Width * FIT_WIDTH_RANGE;
+  Start = int ((Centre - Origin - HalfWidth) / Step);
+  End = int ((Centre - Origin + HalfWidth) / Step) + 1;
+  if (Start < 0) Start = 0;
+  if (End > NumPoints) End = NumPoints;
+}
+
+
+//------------------------------------------------------------------------------
+// evaluate (...) : Calculates the residual between the data and the background
+// B plus the profiles of all the lines described by P. Returns the sum of the
+// squared residuals.
+//
+double VoigtFit::evaluate (const vector <double> &P, const vector <double> &B,
+  int Start, int n, vector <double> &Residual) {
+  vector <double> Profile (n);
+  double Chi2 = 0.0;
+
+  Residual.resize (n);
+  for (int k = 0; k < n; k ++) Residual[k] = Y[Start + k] - B[k];
+  for (unsigned int l = 0; l < P.size (); l += FIT_PARAMS_PER_LINE) {
+    lineProfile (&P[l], Start, n, &Profile[0]);
+    for (int k = 0; k < n; k ++) Residual[k] -= Profile[k];
+  }
+  for (int k = 0; k < n; k ++) Chi2 += Residual[k] * Residual[k];
+  return Chi2;
+}
+
+
+//------------------------------------------------------------------------------
+// jacobian (...) : Fills J with the derivative of the model at each of the n
+// grid points starting at Start with respect to each parameter. J is stored
+// one parameter (column) at a time.
+//
+void VoigtFit::jacobian (const vector <double> &P, int Start, int n,
+  vector <double> &J) {
+  vector <double> Lo (n), Hi (n);
+  double Q[FIT_PARAMS_PER_LINE], h;
+
+  J.assign (P.size () * n, 0.0);
+  for (unsigned int l = 0; l < P.size (); l += FIT_PARAMS_PER_LINE) {
+    double *dPeak = &J[(l + P_PEAK) * n];
+    double *dWidth = &J[(l + P_WIDTH) * n];
+    double *dDmp = &J[(l + P_DMP) * n];
+    double *dCentre = &J[(l + P_CENTRE) * n];
+
+    // The profile is proportional to the peak height
+    for (int i = 0; i < FIT_PARAMS_PER_LINE; i ++) Q[i] = P[l + i];
+    Q[P_PEAK] = 1.0;
+    lineProfile (Q, Start, n, dPeak);
+
+    // Central differences for the width and centre
+    Q[P_PEAK] = P[l + P_PEAK];
+    h = DERIV_WIDTH_STEP * P[l + P_WIDTH];
+    Q[P_WIDTH] = P[l + P_WIDTH] - h; lineProfile (Q, Start, n, &Lo[0]);
+    Q[P_WIDTH] = P[l + P_WIDTH] + h; lineProfile (Q, Start, n, &Hi[0]);
+    for (int k = 0; k < n; k ++) dWidth[k] = (Hi[k] - Lo[k]) / (2.0 * h);
+    Q[P_WIDTH] = P[l + P_WIDTH];
+
+    h = DERIV_CENTRE_STEP * Step;
+    Q[P_CENTRE] = P[l + P_CENTRE] - h; lineProfile (Q, Start, n, &Lo[0]);
+    Q[P_CENTRE] = P[l + P_CENTRE] + h; lineProfile (Q, Start, n, &Hi[0]);
+    for (int k = 0; k < n; k ++) dCentre[k] = (Hi[k] - Lo[k]) / (2.0 * h);
+    Q[P_CENTRE] = P[l + P_CENTRE];
+
+    // The damping is confined to [0,1], so keep the difference inside it
+    double DmpLo = P[l + P_DMP] - DERIV_DMP_STEP;
+    double DmpHi = P[l + P_DMP] + DERIV_DMP_STEP;
+    if (DmpLo < 0.0) DmpLo = 0.0;
+    if (DmpHi > 1.0) DmpHi = 1.0;
+    Q[P_DMP] = DmpLo; lineProfile (Q, Start, n, &Lo[0]);
+    Q[P_DMP] = DmpHi; lineProfile (Q, Start, n, &Hi[0]);
+    for (int k = 0; k < n; k ++) dDmp[k] = (Hi[k] - Lo[k]) / (DmpHi - DmpLo);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// constrain (vector <double> &, int, int) : Keeps the parameters of each line
+// physical. Peaks cannot be negative, widths must span at least half a grid
+// point, the damping lies in [0,1] and the centre must stay in the fit window.
+//
+void VoigtFit::constrain (vector <double> &P, int Start, int End) {
+  double MinWidth = 500.0 * Step;  /* Half a point spacing in mK */
+  double MinCentre = Origin + Start * Step;
+  double MaxCentre = Origin + (End - 1) * Step;
+  for (unsigned int l = 0; l < P.size (); l += FIT_PARAMS_PER_LINE) {
+    if (P[l + P_PEAK] < 0.0) P[l + P_PEAK] = 0.0;
+    if (P[l + P_WIDTH] < MinWidth) P[l + P_WIDTH] = MinWidth;
+    if (P[l + P_DMP] < 0.0) P[l + P_DMP] = 0.0;
+    if (P[l + P_DMP] > 1.0) P[l + P_DMP] = 1.0;
+    if (P[l + P_CENTRE] < MinCentre) P[l + P_CENTRE] = MinCentre;
+    if (P[l + P_CENTRE] > MaxCentre) P[l + P_CENTRE] = MaxCentre;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// profileArea (double, double, double, double) : Returns the integrated area of
+// a line profile over +/- Range cm^-1 about its centre. This is used to scale
+// the XGremlin equivalent width when a line is refitted, so that the result
+// retains whatever units and calibration XGremlin applied to it.
+//
+double VoigtFit::profileArea (double Peak, double Width, double Dmp,
+  double Range) {
+  int n = int (2.0 * Range / Step) + 1;
+  if (n < 2) n = 2;
+  vector <double> Profile (n);
+  double x[2], Area = 0.0;
+  x[0] = -Range;
+  x[1] = x[0] + Step;
+  voigtGen.voigt (n, x, &Profile[0], 0.0005 * Width / Step, Peak, Dmp, 0.0);
+  for (int k = 0; k < n; k ++) Area += Profile[k];
+  return Area * Step;
+}
+
+
+//------------------------------------------------------------------------------
+// residualStatistics (...) : Calculates the noise and XGremlin-style Eps values
+// of a fitted line from the residual in its own fit window. EpsTot is the RMS
+// residual, EpsEvn and EpsOdd the RMS of the parts of the residual that are
+// symmetric and antisymmetric about the line centre, and EpsRan the RMS point
+// to point scatter. All are expressed as a fraction of the peak height.
+//
+void VoigtFit::residualStatistics (const vector <double> &Residual, int Start,
+  double Centre, double Width, double Peak, VoigtFitResult &Result) {
+  int LineStart, LineEnd;
+  int End = Start + Residual.size ();
+  int CentreIndex = int (floor ((Centre - Origin) / Step + 0.5));
+  double Sum2 = 0.0, Even2 = 0.0, Odd2 = 0.0, Diff2 = 0.0;
+  unsigned int NumPairs = 0, NumDiffs = 0, NumPoints = 0;
+
+  lineWindow (Centre, Width, LineStart, LineEnd);
+  if (LineStart < Start) LineStart = Start;
+  if (LineEnd > End) LineEnd = End;
+  for (int i = LineStart; i < LineEnd; i ++) {
+    double r = Residual[i - Start];
+    int j = 2 * CentreIndex - i;
+    Sum2 += r * r;
+    NumPoints ++;
+    if (j >= LineStart && j < LineEnd) {
+      double e = 0.5 * (r + Residual[j - Start]);
+      double o = 0.5 * (r - Residual[j - Start]);
+      Even2 += e * e;
+      Odd2 += o * o;
+      NumPairs ++;
+    }
+    if (i + 1 < LineEnd) {
+      double d = Residual[i + 1 - Start] - r;
+      Diff2 += d * d;
+      NumDiffs ++;
+    }
+  }
+  if (NumPoints > 0) Result.Noise = sqrt (Sum2 / NumPoints);
+  if (Peak > 0.0) {
+    Result.EpsTot = Result.Noise / Peak;
+    if (NumPairs > 0) Result.EpsEvn = sqrt (Even2 / NumPairs) / Peak;
+    if (NumPairs > 0) Result.EpsOdd = sqrt (Odd2 / NumPairs) / Peak;
+    if (NumDiffs > 0) Result.EpsRan = sqrt (Diff2 / (2.0 * NumDiffs)) / Peak;
+  }
+}
+
+
+//==============================================================================
+// VoigtFit : FITTING
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// fit (vector <XgLine *>, ModelSpectrum *, vector <VoigtFitResult> &) : Fits
+// every line in Group simultaneously over the union of their fit windows. If
+// Model is not NULL, it must have been rendered from the list containing the
+// lines in Group. The initial profiles of the group are then removed from the
+// model, and what remains is held fixed as the contribution of all the other
+// lines in the list. One result is returned for each line in Group.
+//
+bool VoigtFit::fit (vector <XgLine *> Group, ModelSpectrum *Model,
+  vector <VoigtFitResult> &Results) {
+  int m = Group.size () * FIT_PARAMS_PER_LINE;
+  int Start = NumPoints, End = 0, LineStart, LineEnd;
+  vector <double> P (m), Initial, Trial, Residual, TrialResidual, B, J;
+  vector <double> A, Augmented, g, Delta, Covariance, Profile;
+
+  Results.assign (Group.size (), VoigtFitResult ());
+  if (Y == NULL || Group.size () == 0 || Step <= 0.0) return false;
+
+  // Set the initial parameters and find the extent of the fit window
+  for (unsigned int l = 0; l < Group.size (); l ++) {
+    P[l * FIT_PARAMS_PER_LINE + P_PEAK] = Group[l] -> peak ();
+    P[l * FIT_PARAMS_PER_LINE + P_WIDTH] = Group[l] -> width ();
+    P[l * FIT_PARAMS_PER_LINE + P_DMP] = Group[l] -> dmp ();
+    P[l * FIT_PARAMS_PER_LINE + P_CENTRE] = Group[l] -> wavenumber ();
+    lineWindow (Group[l] -> wavenumber (), Group[l] -> width (),
+      LineStart, LineEnd);
+    if (LineStart < Start) Start = LineStart;
+    if (LineEnd > End) End = LineEnd;
+  }
+  int n = End - Start;
+  if (n <= m) return false;
+  Initial = P;
+
+  // Build the fixed background from the model of the whole list, less the
+  // initial profiles of the lines being fitted. Each line only contributes to
+  // the model over the range it was rendered, so only subtract it there.
+  B.assign (n, 0.0);
+  if (Model != NULL) {
+    Profile.resize (n);
+    for (int k = 0; k < n; k ++) B[k] = Model -> value (Start + k);
+    for (unsigned int l = 0; l < Group.size (); l ++) {
+      lineProfile (&P[l * FIT_PARAMS_PER_LINE], Start, n, &Profile[0]);
+      Model -> lineRange (*Group[l], LineStart, LineEnd);
+      for (int k = 0; k < n; k ++) {
+        if (Start + k >= LineStart && Start + k < LineEnd) B[k] -= Profile[k];
+      }
+    }
+  }
+
+  // Levenberg-Marquardt iterations
+  double Chi2 = evaluate (P, B, Start, n, Residual);
+  double TrialChi2;
+  double Lambda = FIT_LAMBDA_START;
+  bool Converged = false, Stalled = false;
+  int Iteration;
+  for (Iteration = 0; Iteration < MaxIterations && !Converged && !Stalled;
+    Iteration ++) {
+    jacobian (P, Start, n, J);
+    A.assign (m * m, 0.0);
+    g.assign (m, 0.0);
+    for (int r = 0; r < m; r ++) {
+      for (int c = r; c < m; c ++) {
+        double Sum = 0.0;
+        for (int k = 0; k < n; k ++) Sum += J[r * n + k] * J[c * n + k];
+        A[r * m + c] = A[c * m + r] = Sum;
+      }
+      for (int k = 0; k < n; k ++) g[r] += J[r * n + k] * Residual[k];
+    }
+
+    // Increase the damping until a step is found that reduces chi-squared. If
+    // none can be found before FIT_LAMBDA_MAX, the fit has stalled. It may be
+    // at the minimum, but there is no way to tell, so it is not converged.
+    bool Improved = false;
+    while (!Improved && Lambda < FIT_LAMBDA_MAX) {
+      Augmented = A;
+      for (int j = 0; j < m; j ++) {
+        Augmented[j * m + j] += Lambda * (A[j * m + j] > 0.0 ? A[j * m + j] : 1.0);
+      }
+      if (!solveLinear (Augmented, g, m, Delta)) {
+        Lambda *= 10.0;
+        continue;
+      }
+      Trial = P;
+      for (int j = 0; j < m; j ++) Trial[j] += Delta[j];
+      constrain (Trial, Start, End);
+      TrialChi2 = evaluate (Trial, B, Start, n, TrialResidual);
+      if (TrialChi2 <= Chi2) {
+        Improved = true;
+        Converged = (Chi2 - TrialChi2) <= Tolerance * Chi2;
+        P = Trial;
+        Residual = TrialResidual;
+        Chi2 = TrialChi2;
+        Lambda *= 0.1;
+      } else {
+        Lambda *= 10.0;
+      }
+    }
+    if (!Improved) Stalled = true;
+  }
+
+  // Estimate the parameter uncertainties from the covariance matrix, scaled by
+  // the reduced chi-squared since the data point uncertainties are unknown.
+  jacobian (P, Start, n, J);
+  A.assign (m * m, 0.0);
+  for (int r = 0; r < m; r ++) {
+    for (int c = r; c < m; c ++) {
+      double Sum = 0.0;
+      for (int k = 0; k < n; k ++) Sum += J[r * n + k] * J[c * n + k];
+      A[r * m + c] = A[c * m + r] = Sum;
+    }
+  }
+  if (!invertMatrix (A, m, Covariance)) Converged = false;
+  double ReducedChi2 = Chi2 / (n - m);
+
+  for (unsigned int l = 0; l < Group.size (); l ++) {
+    int p = l * FIT_PARAMS_PER_LINE;
+    VoigtFitResult &Result = Results[l];
+    Result.Peak = P[p + P_PEAK];
+    Result.Width = P[p + P_WIDTH];
+    Result.Dmp = P[p + P_DMP];
+    Result.Centre = P[p + P_CENTRE];
+    Result.Iterations = Iteration;
+    Result.Converged = Converged;
+    Result.Stalled = Stalled;
+    if (Converged) {
+      Result.ErrPeak = sqrt (fabs (ReducedChi2 * Covariance[(p + P_PEAK) * (m + 1)]));
+      Result.ErrWidth = sqrt (fabs (ReducedChi2 * Covariance[(p + P_WIDTH) * (m + 1)]));
+      Result.ErrDmp = sqrt (fabs (ReducedChi2 * Covariance[(p + P_DMP) * (m + 1)]));
+      Result.ErrCentre = sqrt (fabs (ReducedChi2 * Covariance[(p + P_CENTRE) * (m + 1)]));
+    }
+    residualStatistics (Residual, Start, Result.Centre, Result.Width,
+      Result.Peak, Result);
+
+    double Range = 2.0 * FIT_WIDTH_RANGE * max (Initial[p + P_WIDTH], Result.Width);
+    double InitialArea = profileArea (Initial[p + P_PEAK], Initial[p + P_WIDTH],
+      Initial[p + P_DMP], Range);
+    if (InitialArea > 0.0) {
+      Result.AreaRatio = profileArea (Result.Peak, Result.Width, Result.Dmp,
+        Range) / InitialArea;
+    }
+  }
+  return Converged;
+}
+
+
+//==============================================================================
+// VoigtRefitter
+//==============================================================================
+
+VoigtRefitter::VoigtRefitter () {
+  Origin = 0.0;
+  Step = 0.0;
+  Model = NULL;
+  NextGroup = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// spectrum (vector <double>, double, double) : Sets the spectrum to be fitted.
+//
+void VoigtRefitter::spectrum (vector <double> YIn, double OriginIn,
+  double StepIn) {
+  Y = YIn;
+  Origin = OriginIn;
+  Step = StepIn;
+}
+
+
+//------------------------------------------------------------------------------
+// worker () : Repeatedly takes the next unfitted group from Groups and fits it
+// until none remain. Run concurrently by every thread in fit ().
+//
+void VoigtRefitter::worker () {
+  VoigtFit Fitter;
+  unsigned int Next;
+
+  if (Y.size () == 0) return;
+  Fitter.spectrum (&Y[0], Y.size (), Origin, Step);
+  while (true) {
+    {
+      Glib::Mutex::Lock lock (GroupMutex);
+      Next = NextGroup ++;
+    }
+    if (Next >= Groups.size ()) return;
+    Fitter.fit (Groups[Next], Model, Results[Next]);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// fit (vector < vector <XgLine *> >, ModelSpectrum *, unsigned int) : Fits each
+// group of lines in GroupsIn independently, sharing the work between NumThreads
+// threads (including the calling thread). The lines themselves are not changed;
+// use results () and apply () to retrieve and store the fitted parameters.
+//
+void VoigtRefitter::fit (vector < vector <XgLine *> > GroupsIn,
+  ModelSpectrum *ModelIn, unsigned int NumThreads) {
+  vector <Glib::Thread *> Workers;
+
+  Groups = GroupsIn;
+  Model = ModelIn;
+  Results.assign (Groups.size (), vector <VoigtFitResult> ());
+  NextGroup = 0;
+
+  if (NumThreads > Groups.size ()) NumThreads = Groups.size ();
+  for (unsigned int i = 1; i < NumThreads; i ++) {
+    try {
+      Workers.push_back (Glib::Thread::create
+        (sigc::mem_fun (*this, &VoigtRefitter::worker), true));
+    } catch (Glib::ThreadError &e) {
+      break;  // Carry on with however many threads were created
+    }
+  }
+  worker ();
+  for (unsigned int i = 0; i < Workers.size (); i ++) {
+    Workers[i] -> join ();
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// apply (XgLine &, VoigtFitResult &) : Writes a converged fit result into Line,
+// along with the uncertainties of the fitted parameters. The wavenumber
+// correction is removed from the centre and width, and from their errors,
+// since XgLine stores uncorrected values. The equivalent width is scaled by
+// the change in profile area. Returns false, leaving Line untouched, if the
+// fit failed or stalled.
+//
+bool VoigtRefitter::apply (XgLine &Line, VoigtFitResult &Result) {
+  if (!Result.Converged) return false;
+  double Correction = 1.0 + Line.wavCorr ();
+  Line.wavenumber (Result.Centre / Correction);
+  Line.width (Result.Width / Correction);
+  Line.peak (Result.Peak);
+  Line.dmp (Result.Dmp);
+  Line.fitErrors (Result.ErrPeak, Result.ErrWidth / Correction, Result.ErrDmp,
+    Result.ErrCentre / Correction);
+  Line.eqwidth (Line.eqwidth () * Result.AreaRatio);
+  Line.epstot (Result.EpsTot);
+  Line.epsevn (Result.EpsEvn);
+  Line.epsodd (Result.EpsOdd);
+  Line.epsran (Result.EpsRan);
+  Line.noise (Result.Noise);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// defaultThreads () : Returns the number of processors available, or
+// DEF_FIT_THREADS if this cannot be determined.
+//
+unsigned int VoigtRefitter::defaultThreads () {
+#if defined (_WIN32)
+  return DEF_FIT_THREADS;
+#else
+  long NumProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+  if (NumProcessors > 0) return (unsigned int) NumProcessors;
+  return DEF_FIT_THREADS;
+#endif
+}
@@ -0,0 +1,150 @@
+// The FTS Atomic Spectrum Tool (FAST)
+// Copyright (C) 2011-2014 M. P. Ruffoni
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// VoigtFit and VoigtRefitter classes (voigtfit.h)
+//==============================================================================
+// VoigtFit refits the peak, width, damping and centre of one or more XGremlin
+// lines to the experimental spectrum with a Levenberg-Marquardt least squares
+// algorithm. Profiles are generated with the XGremlin Voigt kernel wrapped in
+// VoigtLsqfit, so the fitted parameters have exactly the same meaning as those
+// in an XGremlin 'writelines' file. All the lines passed to fit () are fitted
+// simultaneously. If a ModelSpectrum is also given, the contribution of every
+// other line in the list is removed from the data before fitting.
+//
+// VoigtRefitter distributes a set of independent fits over a pool of worker
+// threads. Each worker owns its own VoigtFit (and hence VoigtLsqfit) object, as
+// the Voigt kernel is not re-entrant. Results are collected in the order the
+// line groups were given and can be written back with apply ().
+//
+#ifndef VOIGT_FIT_H
+#define VOIGT_FIT_H
+
+#include <vector>
+#include <glibmm/thread.h>
+#include "xgline.h"
+#include "voigtlsqfit.h"
+#include "modelspectrum.h"
+
+using namespace::std;
+
+// Half-width of the fit window around each line, as a multiple of the line
+// width in mK. This matches PLOT_WIDTH_RANGE, so a line is fitted over exactly
+// the region shown in its profile plot.
+#define FIT_WIDTH_RANGE     0.004
+
+// Levenberg-Marquardt control parameters
+#define FIT_MAX_ITERATIONS  50
+#define FIT_TOLERANCE       1.0e-6
+#define FIT_LAMBDA_START    1.0e-3
+#define FIT_LAMBDA_MAX      1.0e10
+#define FIT_PARAMS_PER_LINE 4
+
+// Number of worker threads to use if the number of processors is unknown
+#define DEF_FIT_THREADS     4
+
+// The outcome of fitting a single line. The width is in mK and the centre in
+// cm^-1, both with the line's wavenumber correction applied. The Eps values
+// follow the XGremlin convention of fit residuals normalised to the peak height.
+typedef struct voigt_fit_result {
+  double Peak, Width, Dmp, Centre;
+  double ErrPeak, ErrWidth, ErrDmp, ErrCentre;
+  double EpsTot, EpsEvn, EpsOdd, EpsRan;
+  double Noise;      // RMS of the fit residual
+  double AreaRatio;  // Ratio of the fitted to the original profile area
+  int Iterations;
+  bool Converged;
+  bool Stalled;      // No step could reduce chi-squared before FIT_LAMBDA_MAX
+
+  voigt_fit_result () {
+    Peak = Width = Dmp = Centre = 0.0;
+    ErrPeak = ErrWidth = ErrDmp = ErrCentre = 0.0;
+    EpsTot = EpsEvn = EpsOdd = EpsRan = 0.0;
+    Noise = 0.0; AreaRatio = 1.0; Iterations = 0;
+    Converged = false; Stalled = false;
+  }
+} VoigtFitResult;
+
+class VoigtFit {
+
+  private:
+    const double *Y;     // Experimental spectrum intensities
+    int NumPoints;
+    double Origin, Step;
+    int MaxIterations;
+    double Tolerance;
+    VoigtLsqfit voigtGen;
+
+    void lineProfile (const double *P, int Start, int n, double *Out);
+    void lineWindow (double Centre, double Width, int &Start, int &End);
+    void jacobian (const vector <double> &P, int Start, int n,
+      vector <double> &J);
+    double evaluate (const vector <double> &P, const vector <double> &B,
+      int Start, int n, vector <double> &Residual);
+    void constrain (vector <double> &P, int Start, int End);
+    double profileArea (double Peak, double Width, double Dmp, double Range);
+    void residualStatistics (const vector <double> &Residual, int Start,
+      double Centre, double Width, double Peak, VoigtFitResult &Result);
+
+  public:
+    VoigtFit ();
+    ~VoigtFit () { }
+
+    // Set the experimental spectrum to be fitted. The data is not copied, so
+    // YIn must remain valid for as long as fit () is being called.
+    void spectrum (const double *YIn, int NumPointsIn, double OriginIn,
+      double StepIn);
+    void maxIterations (int a) { MaxIterations = a; }
+    void tolerance (double a) { Tolerance = a; }
+
+    // Fit all the lines in Group simultaneously. Returns true on convergence.
+    // A fit that stalls or runs out of iterations has not converged.
+    bool fit (vector <XgLine *> Group, ModelSpectrum *Model,
+      vector <VoigtFitResult> &Results);
+};
+
+class VoigtRefitter {
+
+  private:
+    vector <double> Y;
+    double Origin, Step;
+    ModelSpectrum *Model;
+    vector < vector <XgLine *> > Groups;
+    vector < vector <VoigtFitResult> > Results;
+    unsigned int NextGroup;
+    Glib::Mutex GroupMutex;
+
+    void worker ();
+
+  public:
+    VoigtRefitter ();
+    ~VoigtRefitter () { }
+
+    // Set the experimental spectrum. The intensities are copied into the
+    // refitter so they may be shared safely between the worker threads.
+    void spectrum (vector <double> YIn, double OriginIn, double StepIn);
+
+    // Fit each group of lines independently using NumThreads workers.
+    void fit (vector < vector <XgLine *> > GroupsIn, ModelSpectrum *ModelIn,
+      unsigned int NumThreads);
+    vector < vector <VoigtFitResult> > results () { return Results; }
+
+    // Write a converged fit result back into an XGremlin line.
+    static bool apply (XgLine &Line, VoigtFitResult &Result);
+    static unsigned int defaultThreads ();
+};
+
+#endif // VOIGT_FIT_H
@@ -34,6 +34,7 @@ XgLine::XgLine () {
   EpsRan = 0.0; Wavelength = 0.0; Tags = ""; Identification = "";
   WavenumberCorrection = 0.0; AirCorrection = 0.0; IntensityCalibration = 0.0;
   Spare = 0.0;
+  ErrPeak = 0.0; ErrWidth = 0.0; ErrDmp = 0.0; ErrCentre = 0.0;
   SNR = 0.0;
   Noise = 1.0;
   SourceFilename = "";
@@ -51,6 +52,7 @@ XgLine::XgLine (string LineData, double NewWaveCorr, double NewAirCorr,
   WavenumberCorrection = NewWaveCorr;
   AirCorrection = NewAirCorr;
   IntensityCalibration = NewIntCal;
+  ErrPeak = 0.0; ErrWidth = 0.0; ErrDmp = 0.0; ErrCentre = 0.0;
   createLine (LineData);
 }
 
@@ -78,6 +80,10 @@ void XgLine::operator= (XgLine Operator) {
   AirCorrection = Operator.airCorrection ();
   IntensityCalibration = Operator.intensityCalibration ();
   SourceFilename = Operator.name ();
+  ErrPeak = Operator.ErrPeak;
+  ErrWidth = Operator.ErrWidth;
+  ErrDmp = Operator.ErrDmp;
+  ErrCentre = Operator.ErrCentre;
 }
 
 
@@ -302,58 +308,10 @@ double XgLine::snr () {
 
 
 //------------------------------------------------------------------------------
-// Line I/O functions for reading from or writing to a saved project file.
+// load (istream &) : Reads the line properties from a project file saved in a
+// version of the format older than 4.
 //
-void XgLine::save (ofstream &BinOut) 
-{
-  int Size;
-  
-  BinOut.write ((char*)&Index, sizeof (int));
-  BinOut.write ((char*)&Itn, sizeof (int));
-  BinOut.write ((char*)&H, sizeof (int));
-  
-  BinOut.write ((char*)&Wavenumber, sizeof (double));
-  BinOut.write ((char*)&Peak, sizeof (double));
-  BinOut.write ((char*)&Width, sizeof (double));
-  BinOut.write ((char*)&Dmp, sizeof (double));
-  BinOut.write ((char*)&EqWidth, sizeof (double));
-  BinOut.write ((char*)&EpsTot, sizeof (double));
-  BinOut.write ((char*)&EpsEvn, sizeof (double));
-  BinOut.write ((char*)&EpsOdd, sizeof (double));
-  BinOut.write ((char*)&EpsRan, sizeof (double));
-  BinOut.write ((char*)&Spare, sizeof (double));
-  BinOut.write ((char*)&Wavelength, sizeof (double));
-  BinOut.write ((char*)&WavenumberCorrection, sizeof (double));
-  BinOut.write ((char*)&AirCorrection, sizeof (double));
-  BinOut.write ((char*)&IntensityCalibration, sizeof (double));
-  
-  Size = Tags.size ();
-  char tags [Size];
-  for (int i = 0; i < Size; i ++) {
-    tags[i] = Tags[i];
-  }
-  BinOut.write ((char*)&Size, sizeof (int));
-  BinOut.write ((char*)&tags, sizeof (char) * Size);
-
-  Size = Identification.size ();
-  char id [Size];
-  for (int i = 0; i < Size; i ++) {
-    id[i] = Identification[i];
-  }
-  BinOut.write ((char*)&Size, sizeof (int));
-  BinOut.write ((char*)&id, sizeof (char) * Size);
-
-  Size = SourceFilename.size ();
-  char name [Size];
-  for (int i = 0; i < Size; i ++) {
-    name[i] = SourceFilename[i];
-  }
-  BinOut.write ((char*)&Size, sizeof (int));
-  BinOut.write ((char*)&name, sizeof (char) * Size);
-}
-
-
-void XgLine::load (ifstream &BinIn) 
+void XgLine::load (istream &BinIn) 
 {
   int Size;
   BinIn.read ((char*)&Index, sizeof (int));
@@ -393,6 +351,64 @@ void XgLine::load (ifstream &BinIn)
   name [Size] = '\0';
   SourceFilename = string (name);
   
+}
+
+
+//------------------------------------------------------------------------------
+// pack (XgLineRecord &, vector <string> &) : Copies the numeric properties of
+// the line into Record, and appends its strings to Strings, in the form used
+// by version 4 FAST project files.
+//
+void XgLine::pack (XgLineRecord &Record, vector <string> &Strings) {
+  Record.Wavenumber = Wavenumber;
+  Record.Peak = Peak;
+  Record.Width = Width;
+  Record.Dmp = Dmp;
+  Record.EqWidth = EqWidth;
+  Record.EpsTot = EpsTot;
+  Record.EpsEvn = EpsEvn;
+  Record.EpsOdd = EpsOdd;
+  Record.EpsRan = EpsRan;
+  Record.Spare = Spare;
+  Record.Wavelength = Wavelength;
+  Record.WavenumberCorrection = WavenumberCorrection;
+  Record.AirCorrection = AirCorrection;
+  Record.IntensityCalibration = IntensityCalibration;
+  Record.Index = Index;
+  Record.Itn = Itn;
+  Record.H = H;
+  Record.Reserved = 0;
+  Strings.push_back (Tags);
+  Strings.push_back (Identification);
+  Strings.push_back (SourceFilename);
+}
+
+
+//------------------------------------------------------------------------------
+// unpack (const XgLineRecord &, const string *) : The reverse of pack (). The
+// XGLINE_RECORD_STRINGS strings of the line start at Strings.
+//
+void XgLine::unpack (const XgLineRecord &Record, const string *Strings) {
+  Wavenumber = Record.Wavenumber;
+  Peak = Record.Peak;
+  Width = Record.Width;
+  Dmp = Record.Dmp;
+  EqWidth = Record.EqWidth;
+  EpsTot = Record.EpsTot;
+  EpsEvn = Record.EpsEvn;
+  EpsOdd = Record.EpsOdd;
+  EpsRan = Record.EpsRan;
+  Spare = Record.Spare;
+  Wavelength = Record.Wavelength;
+  WavenumberCorrection = Record.WavenumberCorrection;
+  AirCorrection = Record.AirCorrection;
+  IntensityCalibration = Record.IntensityCalibration;
+  Index = Record.Index;
+  Itn = Record.Itn;
+  H = Record.H;
+  Tags = Strings[0];
+  Identification = Strings[1];
+  SourceFilename = Strings[2];
 }    
   
   
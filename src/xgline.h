@@ -49,6 +49,10 @@
 // XGremlin, and so must be passed in at arg1. A default spacing is given by
 // DEF_POINT_SPACING.
 //
+// A line refitted by VoigtRefitter also holds the uncertainties of its fitted
+// peak, width, damping and wavenumber. These are zero for a line that has only
+// been read from XGremlin, which does not write them.
+//
 #ifndef XG_LINE_H
 #define XG_LINE_H
 
@@ -56,6 +60,7 @@
 #include <sstream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include "ErrDefs.h"
 
 // The default spacing between spectru data points, in cm^-1. This is used by
@@ -70,6 +75,17 @@
 
 using namespace::std;
 
+// The numeric properties of an XgLine as stored in a version 4 FAST project
+// file. Records for a whole line list are written as one contiguous array. The
+// XGLINE_RECORD_STRINGS strings of each line (tags, identification and source
+// file name) are stored separately.
+#define XGLINE_RECORD_STRINGS 3
+typedef struct xgline_record {
+  double Wavenumber, Peak, Width, Dmp, EqWidth, EpsTot, EpsEvn, EpsOdd, EpsRan,
+    Spare, Wavelength, WavenumberCorrection, AirCorrection, IntensityCalibration;
+  int Index, Itn, H, Reserved;
+} XgLineRecord;
+
 class XgLine {
   public:
   
@@ -96,6 +112,11 @@ class XgLine {
     double epsodd () { return EpsOdd; }
     double epsran () { return EpsRan; }
     double spare () { return Spare; }
+    double peakError () { return ErrPeak; }
+    double widthError () { return ErrWidth * (1.0 + WavenumberCorrection); }
+    double dmpError () { return ErrDmp; }
+    double wavenumberError () {
+      return ErrCentre * (1.0 + WavenumberCorrection); }
     double wavelength () { return 1.0e7 / wavenumber (); }
     double airWavelength ();
     string tags () { return Tags; }
@@ -121,6 +142,9 @@ class XgLine {
     void epsodd (double NewEpsodd) { EpsOdd = NewEpsodd; } 
     void epsran (double NewEpsran) { EpsRan = NewEpsran; }
     void spare (double NewSpare) { Spare = NewSpare; }
+    void fitErrors (double NewErrPeak, double NewErrWidth, double NewErrDmp,
+      double NewErrCentre) { ErrPeak = NewErrPeak; ErrWidth = NewErrWidth;
+      ErrDmp = NewErrDmp; ErrCentre = NewErrCentre; }
     void wavelength (double NewWavelength) throw (Error);
     void tags (string NewTags) { Tags = NewTags; }
     void id (string NewId) { Identification = NewId; }
@@ -143,8 +167,9 @@ class XgLine {
     void print (ostream& Output = std::cout);
     string getLineSynString ();
     string getLineString ();
-    void save (ofstream& BinOut);
-    void load (ifstream& BinIn);
+    void load (istream& BinIn);
+    void pack (XgLineRecord &Record, vector <string> &Strings);
+    void unpack (const XgLineRecord &Record, const string *Strings);
     
     // Calculates the error in the line centroid position using the Brault eqn.
     double getCentroidError (double PointsInFwhm = DEF_POINT_SPACING);
@@ -157,6 +182,10 @@ class XgLine {
       EpsEvn, EpsOdd, EpsRan, Wavelength, SNR, Noise;
     string Tags, Identification, SourceFilename;
     double Spare;
+    
+    // Uncertainties from the last refit. As with the width, the wavenumber
+    // correction is not applied to ErrWidth and ErrCentre.
+    double ErrPeak, ErrWidth, ErrDmp, ErrCentre;
     bool CustomSNR;
     
     // Header parameters from an XGremlin "writelines" file
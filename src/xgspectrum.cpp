@@ -19,6 +19,13 @@
 //==============================================================================
 
 #include "xgspectrum.h"
+#include "trace.h"
+#include <glibmm/thread.h>
+
+// Spectra are loaded on worker threads, so their revisions are all taken from
+// one locked counter
+static Glib::StaticMutex RevisionMutex = GLIBMM_STATIC_MUTEX_INIT;
+static unsigned long LastRevision = 0;
 
 //------------------------------------------------------------------------------
 // Default constructor : Initialises class variables and prepares the GSL spline
@@ -28,8 +35,12 @@ XgSpectrum::XgSpectrum () {
   Name = "";
   Index = "";
   Step = 0.0;
+  StoredMinX = 0.0;
+  DataStored = false;
   IsReference = false;
   RadianceSplineCreated = false;
+  DataRevision = nextRevision ();
+  LinesRevision = nextRevision ();
   B = 0; bw = 0; c = 0; r = 0; x = 0; y = 0; X = 0; cov = 0; mw = 0; w = 0;
   gsl_rng_env_setup();
 }
@@ -46,6 +57,15 @@ XgSpectrum::~XgSpectrum () {
 }
 
 
+//------------------------------------------------------------------------------
+// nextRevision () : Returns a revision that has not been given to any spectrum.
+//
+unsigned long XgSpectrum::nextRevision () {
+  Glib::StaticMutex::Lock lock (RevisionMutex);
+  return ++ LastRevision;
+}
+
+
 //------------------------------------------------------------------------------
 // linesVector () : Returns a copy of the all the lines stored in the Lines
 // vector. The individual sub-lists are merged into one long list.
@@ -61,12 +81,43 @@ vector <XgLine> XgSpectrum::linesVector () {
 }
 
 
+//------------------------------------------------------------------------------
+// dataBytes () : Returns the memory used by the spectrum and calibration data
+// points, not counting any that are still mapped from a project file.
+//
+uint64_t XgSpectrum::dataBytes () {
+  return (Data.capacity () + Response.capacity () + StdLampSpectrum.capacity ()
+    + Radiance.capacity ()) * sizeof (Coord)
+    + RadianceErrors.capacity () * sizeof (ErrRange)
+    + StoredData.bytes () + HeaderFile.capacity ();
+}
+
+
+//------------------------------------------------------------------------------
+// lineBytes (int) : Returns the memory used by line list ListIndex and the
+// profiles saved for it.
+//
+uint64_t XgSpectrum::lineBytes (int ListIndex) {
+  uint64_t Bytes = Lines[ListIndex].capacity () * sizeof (XgLine);
+  if (ListIndex < (int) LinHeaders.size ()) {
+    Bytes += LinHeaders[ListIndex].capacity ();
+  }
+  if (ListIndex < (int) Profiles.size ()) {
+    Bytes += Profiles[ListIndex].bytes ();
+  }
+  return Bytes;
+}
+
+
 //------------------------------------------------------------------------------
 // data (vector <Coord>) : Sets the spectrum's data using the input Coords
 //
 void XgSpectrum::data (vector <Coord> NewData) {
+  StoredData.clear ();
+  DataStored = false;
   Data = NewData;
   Step = (Data [Data.size () - 1].x - Data[0].x) / (Data.size () - 1);
+  DataRevision = nextRevision ();
 }
 
 
@@ -74,14 +125,78 @@ void XgSpectrum::data (vector <Coord> NewData) {
 // data (vector <Coord>) : Adds a new data point to the end of the spectrum
 //
 void XgSpectrum::data_push_back (Coord a) { 
+  loadData ();
   Data.push_back (a);
   Step = (Data [Data.size () - 1].x - Data[0].x) / (Data.size () - 1);
+  DataRevision = nextRevision ();
+}
+
+//------------------------------------------------------------------------------
+// data (FtsFloatArray, double, double) : Sets the spectrum's data to the points
+// in Y, which start at MinX and are separated by Spacing. The points are not
+// read from Y until they are needed.
+//
+void XgSpectrum::data (FtsFloatArray Y, double MinX, double Spacing) {
+  Data.clear ();
+  StoredData = Y;
+  StoredMinX = MinX;
+  Step = Spacing;
+  DataStored = true;
+  DataRevision = nextRevision ();
 }
 
+
+//------------------------------------------------------------------------------
+// intensities (FtsFloatArray &) : Sets Y to the intensity of every data point.
+// Points that are still in the project file are not read; Y shares the file
+// mapping instead, so this is safe to call on the main loop for any size of
+// spectrum.
+//
+void XgSpectrum::intensities (FtsFloatArray &Y) {
+  Y.clear ();
+  if (DataStored) {
+    Y = StoredData;
+  } else {
+    vector <float> &Values = Y.values ();
+    Values.resize (Data.size ());
+    for (unsigned int i = 0; i < Data.size (); i ++) {
+      Values[i] = Data[i].y;
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// firstWavenumber () : Returns the wavenumber of the first data point, without
+// reading any points left in the project file.
+//
+double XgSpectrum::firstWavenumber () {
+  if (DataStored) return StoredMinX;
+  return Data.size () > 0 ? Data[0].x : 0.0;
+}
+
+
+//------------------------------------------------------------------------------
+// readStoredData () : Converts the points held in StoredData into Data and
+// releases StoredData.
+//
+void XgSpectrum::readStoredData () {
+  vector <float> Y;
+  StoredData.read (Y);
+  Data.resize (Y.size ());
+  for (unsigned int i = 0; i < Y.size (); i ++) {
+    Data[i] = Coord (double (i) * Step + StoredMinX, Y[i]);
+  }
+  StoredData.clear ();
+  DataStored = false;
+}
+
+
 //------------------------------------------------------------------------------
 // Coord data () : 
 //
 Coord XgSpectrum::data (int Index) throw (Error) {
+  loadData ();
   if (Index >= 0 && Index < (int)Data.size ()) {
     return Data [Index];
   } else {
@@ -96,8 +211,11 @@ Coord XgSpectrum::data (int Index) throw (Error) {
 //
 void XgSpectrum::clear () {
   Data.clear(); 
+  StoredData.clear ();
+  DataStored = false;
   Lines.clear ();
-  Plots.clear (); 
+  Clusters.clear ();
+  Profiles.clear ();
   LinHeaders.clear ();
   Response.clear ();
   StdLampSpectrum.clear ();
@@ -109,6 +227,8 @@ void XgSpectrum::clear () {
   IsReference = false;
   RadianceFile = "";
   StandardLampFile = "";
+  DataRevision = nextRevision ();
+  LinesRevision = nextRevision ();
 }
 
 
@@ -118,6 +238,7 @@ void XgSpectrum::clear () {
 vector <Coord> XgSpectrum::data (int a, int b) throw (Error){
   vector <Coord> RtnPoints;
 
+  loadData ();
   if (a < 0 || a >= (int)Data.size ()) {
     throw (Error (XGSPEC_OUT_OF_BOUNDS, "At least one line is outside the spectrum range",
       "Check the contents of this LIN file in XGremlin and remove these invalid lines")); 
@@ -140,6 +261,7 @@ vector <Coord> XgSpectrum::data (int a, int b) throw (Error){
 // the vicinity of a line.
 //
 vector <Coord> XgSpectrum::data (double Centre, double Width) {
+  loadData ();
   if (Data.size () != 0) {
     int XStart, XEnd;
     XStart = int((Centre - Data[0].x - Width) / Step);
@@ -538,28 +660,29 @@ void XgSpectrum::calculateResponseFunction () {
   
 
 //------------------------------------------------------------------------------
-// remove_linelist (int) : Removes the line list and plots at the given Index in
-// the Lines and Plots vectors.
+// remove_linelist (int) : Removes the line list at the given Index in the Lines
+// vector, along with its clusters and profiles.
 //
 void XgSpectrum::remove_linelist (int Index) {
   Lines.erase (Lines.begin () + Index); 
-  for (unsigned int i = 0; i < Plots[Index].size (); i ++) {
-    delete (Plots[Index][i]);
-  }
-  Plots.erase (Plots.begin () + Index);
+  if (Index < (int)Clusters.size ()) Clusters.erase (Clusters.begin () + Index);
+  if (Index < (int)Profiles.size ()) Profiles.erase (Profiles.begin () + Index);
+  linesChanged ();
 }
 
 
 //------------------------------------------------------------------------------
-// remove_line (int, int) : Removes the line and plot at the given index (arg2)
-// in the list specified at arg1.
+// remove_line (int, int) : Removes the line at the given index (arg2) in the
+// list specified at arg1.
 //
 void XgSpectrum::remove_line (int ListIndex, int LineIndex) {
   if (ListIndex >= 0 && ListIndex < (int)Lines.size ()) {
     if (LineIndex >= 0 && LineIndex < (int)Lines[ListIndex].size ()) {
       Lines[ListIndex].erase (Lines[ListIndex].begin () + LineIndex);
-      delete (Plots[ListIndex][LineIndex]);
-      Plots[ListIndex].erase (Plots[ListIndex].begin () + LineIndex);
+      if (ListIndex < (int)Clusters.size ()) {
+        Clusters[ListIndex].remove (Lines[ListIndex], LineIndex);
+      }
+      linesChanged ();
     } else {
       cout << "ERROR: XgSpectrum::remove_line LineIndex out of bounds. No line removed." << endl;
     }
@@ -592,12 +715,39 @@ vector < vector <XgLine *> > XgSpectrum::linesPtr () {
 }
 
 
+//------------------------------------------------------------------------------
+// clusters (int) : Returns the blend clusters of line list ListIndex, or NULL
+// if there is no such list. The clusters are built the first time they are
+// requested and are then kept up to date as lines are refitted or removed.
+//
+LineClusters *XgSpectrum::clusters (int ListIndex) {
+  if (ListIndex < 0 || ListIndex >= (int)Lines.size ()) return NULL;
+  if (Clusters.size () < Lines.size ()) Clusters.resize (Lines.size ());
+  if (!Clusters[ListIndex].built ()) Clusters[ListIndex].build (Lines[ListIndex]);
+  return &Clusters[ListIndex];
+}
+
+
+//------------------------------------------------------------------------------
+// profiles (int) : Returns the saved plot profiles of list ListIndex, or NULL
+// if there is no such list. Entries for lines that have since been changed or
+// removed are simply never matched, so the store does not need to follow every
+// edit to the list.
+//
+ProfileStore *XgSpectrum::profiles (int ListIndex) {
+  if (ListIndex < 0 || ListIndex >= (int)Lines.size ()) return NULL;
+  if (Profiles.size () < Lines.size ()) Profiles.resize (Lines.size ());
+  return &Profiles[ListIndex];
+}
+
+
 //------------------------------------------------------------------------------
 // loadAscii (string) : Loads an XGremlin spectrum ASCII file that has
 // previously been saved with the "writeasc" command. The contents of this file
 // is returned a vector <Coord>.
 //
 void XgSpectrum::loadAscii (string Filename) throw (Error) {
+  TRACE_SCOPE ("XgSpectrum::loadAscii");
   ostringstream oss, osssub;
   string LineString;
   Coord NewPoint;
@@ -650,6 +800,7 @@ void XgSpectrum::loadAscii (string Filename) throw (Error) {
 // to which is given at arg1, and returns a vector<Coord> containing the data points contained within i
 //
 void XgSpectrum::loadDat (string Filename) throw (Error) {
+  TRACE_SCOPE ("XgSpectrum::loadDat");
   ostringstream oss, osssub;
   ifstream DataIn;
   float NextPoint;
@@ -765,44 +916,68 @@ void XgSpectrum::storeHeader (string Filename) throw (Error) {
 
 
 //------------------------------------------------------------------------------
-//
+// save (string) : Writes the spectrum to Filename, reading any points still
+// held in the project file first.
 //
 void XgSpectrum::save (string Filename) throw (int) {
-  ofstream BinOut;
-  float NextPoint;
+  loadData ();
+  save (Filename, Data);
+}
+
+
+//------------------------------------------------------------------------------
+// save (string, const vector <Coord> &) : Writes Points to Filename in the
+// format the spectrum was loaded from. Points is normally a copy of the data
+// taken on the main loop. The spectrum itself is only read, so this may be
+// called from a background job while the spectrum is in use elsewhere.
+//
+void XgSpectrum::save (string Filename, const vector <Coord> &Points)
+  throw (int) {
   ostringstream oss;
-  FILE *AscOut;
-  
+  FILE *Out;
+
   // If an XGremlin HDR file has previously been saved, the data must have been
   // loaded from XGremlin DAT and HDR files. Save them back to file in this 
-  // format
+  // format. Each file is written in a single call.
   if (HeaderFile.size () > 0) {
-    BinOut.open (Filename.c_str(), ios::out|ios::binary);
-    if (!BinOut.is_open ()) throw (FLT_FILE_WRITE_ERROR);
-    for (unsigned int i = 0; i < Data.size (); i ++) {
-      NextPoint = Data [i].y;
-      BinOut.write ((char*)&NextPoint, sizeof (float));
+    vector <float> Y (Points.size ());
+    for (unsigned int i = 0; i < Points.size (); i ++) {
+      Y[i] = Points[i].y;
+    }
+    Out = fopen (Filename.c_str(), "wb");
+    if (Out == NULL) throw (FLT_FILE_WRITE_ERROR);
+    size_t Written = Y.size () == 0 ? 0
+      : fwrite (&Y[0], sizeof (float), Y.size (), Out);
+    if (fclose (Out) != 0 || Written != Y.size ()) {
+      throw (FLT_FILE_WRITE_ERROR);
     }
-    BinOut.close ();
     
     oss << Filename.substr (0, Filename.size () - 4) << ".hdr";
-    BinOut.open (oss.str().c_str(), ios::out|ios::binary);
-    if (!BinOut.is_open ()) throw (FLT_FILE_WRITE_ERROR);
-    for (unsigned int i = 0; i < HeaderFile.size (); i ++) {
-      BinOut.write ((char*)&HeaderFile[i], sizeof (char));
+    Out = fopen (oss.str().c_str(), "wb");
+    if (Out == NULL) throw (FLT_FILE_WRITE_ERROR);
+    Written = fwrite (&HeaderFile[0], sizeof (char), HeaderFile.size (), Out);
+    if (fclose (Out) != 0 || Written != HeaderFile.size ()) {
+      throw (FLT_FILE_WRITE_ERROR);
     }
-    BinOut.close ();
   
   // If no XGremlin HDR file is present, the data must have been loaded from an
-  // ASCII file. Therefore, output the data to file in ASCII format.
+  // ASCII file. Therefore, output the data to file in ASCII format. The points
+  // are formatted into a buffer first so that the file is written in one go.
   } else {
-    AscOut = fopen (Filename.c_str(), "w");
-    if (AscOut == 0) throw (FLT_FILE_WRITE_ERROR);
-    fprintf (AscOut, "# %s saved by FAST\n", Name.c_str ());
-    for (unsigned int i = 0; i < Data.size (); i ++) {
-      fprintf (AscOut, "%13.5f  %13.6e\n", Data[i].x, Data[i].y);
+    string Buffer;
+    char NextPoint [XGSPECTRUM_ASCII_POINT_SIZE];
+    Buffer.reserve ((Points.size () + 1) * 30 + Name.size ());
+    Buffer += "# " + Name + " saved by FAST\n";
+    for (unsigned int i = 0; i < Points.size (); i ++) {
+      Buffer.append (NextPoint, sprintf (NextPoint, "%13.5f  %13.6e\n",
+        Points[i].x, Points[i].y));
+    }
+    Out = fopen (Filename.c_str(), "w");
+    if (Out == NULL) throw (FLT_FILE_WRITE_ERROR);
+    size_t Written = fwrite (Buffer.data (), 1, Buffer.size (), Out);
+    if (fclose (Out) != 0 || Written != Buffer.size ()) {
+      throw (FLT_FILE_WRITE_ERROR);
     }
-    fclose (AscOut);
   }
 }
 
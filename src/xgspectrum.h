@@ -21,8 +21,8 @@
 // XGremlin .dat/.hdr file pair using the loadDat (string) function, or from an
 // ASCII created with the writeasc command using loadAscii (string). Lists of
 // lines may be added to the spectrum using the lines () and lines_push_back ()
-// functions. Plot widgets for use in the FAST interface may also be stored 
-// using the plots () and plots_push_back () functions.
+// functions. The plots of the lines shown in the FAST interface are kept by the
+// interface itself, so XgSpectrum does not depend on GTK+.
 //
 // A Standard lamp spectrum and set of radiance data may also be attached to the
 // XgSpectrum object in preparation for the calculation of the spectrometer
@@ -38,8 +38,11 @@
 #include <fstream>
 #include <sstream>
 #include <cstdio>
+#include "CoreDefs.h"
 #include "xgline.h"
-#include "linedata.h"
+#include "lineclusters.h"
+#include "ftsfile.h"
+#include "profilestore.h"
 
 // Include the GSL headers required for spline fitting
 #include <gsl/gsl_bspline.h>
@@ -59,6 +62,9 @@
 #define DELTAX_TAG "delw"
 #define NUM_PTS_TAG "npo"
 
+// Enough characters for any two doubles written in the ASCII spectrum format
+#define XGSPECTRUM_ASCII_POINT_SIZE 720
+
 using namespace::std;
 
 // Define an error range structure for use with spectral radiance uncertainties.
@@ -71,9 +77,13 @@ class XgSpectrum {
 
   private:
     vector <Coord> Data;                  // Experimental spectrum data points
+    FtsFloatArray StoredData;             // Data points not yet read from file
+    double StoredMinX;                    // Wavenumber of StoredData[0]
+    bool DataStored;                      // True until StoredData is read
     vector < vector <XgLine> > Lines;     // XGremlin lines for this spectrum
     vector < vector <char> > LinHeaders;
-    vector < vector <LineData *> > Plots; // Plot objects; one for each line
+    vector <LineClusters> Clusters;       // Cached blend clusters for each list
+    vector <ProfileStore> Profiles;       // Saved plot profiles for each list
     vector <Coord> Response;              // The spectrometer response function
     vector <Coord> StdLampSpectrum;       // Measured standard lamp spectrum
     vector <Coord> Radiance;              // Standard lamp radiance data  
@@ -82,6 +92,11 @@ class XgSpectrum {
     string Name, Index, RadianceFile, StandardLampFile;
     bool IsReference;    // True if this spectrum is the FAST reference spectrum
     double Step;
+    unsigned long DataRevision;           // Changed whenever Data is replaced
+    unsigned long LinesRevision;          // Changed whenever Lines is edited
+
+    // Returns a revision that no other spectrum has been given
+    static unsigned long nextRevision ();
     
     // Spline fitting environment variables that are used to interpolate the
     // standard lamp spectral radiance data
@@ -100,6 +115,9 @@ class XgSpectrum {
     void freeSplineEnvironment ();
     vector <Coord> matchStandardLampResolution ();
     
+    // Copies StoredData into Data
+    void readStoredData ();
+
     // Internal function reading data from an XGremlin HDR file
     double getXGremlinHeaderField(string Filename, string FieldName) throw(Error);
     
@@ -116,6 +134,7 @@ class XgSpectrum {
     
     // Save functions for stored data
     void save (string Filename) throw (int);
+    void save (string Filename, const vector <Coord> &Points) throw (int);
 //    void saveStdLamp (string Filename = StandardLampFile) throw (int);
 //    void saveRadiance (string Filename = RadianceFile) throw (int);
     void storeHeader (string Filename) throw (Error);
@@ -123,23 +142,37 @@ class XgSpectrum {
     // GET functions for spectrum data. The linesPtr and linesPtr2 functions
     // provide direct access to the class Lines vector, and so should be used
     // with care. They are present simply to allow fast access to the spectrum's
-    // lines that isn't possible when passing the Lines vector by value.
+    // lines that isn't possible when passing the Lines vector by value. The
+    // dataPtr function does the same for the Data vector.
     Coord data (int Index) throw (Error);
-    vector <Coord> data () { return Data; }
+    vector <Coord> data () { loadData (); return Data; }
+    vector <Coord>* dataPtr () { loadData (); return &Data; }
     vector <Coord> data (int Min, int Max) throw (Error);
     vector <Coord> data (double Centre, double Width);
     vector < vector <XgLine> > lines () { return Lines; }
     vector <XgLine> linesVector ();
     vector < vector <XgLine *> > linesPtr ();
     vector < vector <XgLine> >* linesPtr2 () { return &Lines; }
-    vector < vector <LineData *> > plots () { return Plots; }
-    LineData* plots (int i, int j) { return Plots[i][j]; }
+    LineClusters *clusters (int ListIndex);
+    ProfileStore *profiles (int ListIndex);
     vector < vector <char> > linHeaders () { return LinHeaders; }
     vector <char> headerFile () { return HeaderFile; }
     string name () { return Name; }
     string index () { return Index; }
     bool isReference () { return IsReference; }
-    unsigned int numDataPoints () { return Data.size (); }
+    unsigned int numDataPoints () { return DataStored ? StoredData.size () : Data.size (); }
+    void intensities (FtsFloatArray &Y);
+    double firstWavenumber ();
+    uint64_t dataBytes ();
+    uint64_t lineBytes (int ListIndex);
+
+    // The revisions change whenever the data points or line lists are changed.
+    // A copy of a spectrum keeps its revisions, but no other spectrum ever has
+    // the same ones. linesChanged () must be called after any line has been
+    // edited through linesPtr2 ().
+    unsigned long dataRevision () { return DataRevision; }
+    unsigned long linesRevision () { return LinesRevision; }
+    void linesChanged () { LinesRevision = nextRevision (); }
     double get_point_spacing () { return Step; }
 
     // Functions for accessing response function related data
@@ -154,13 +187,17 @@ class XgSpectrum {
     string radiance_file () { return RadianceFile; }
     string standard_lamp_file () { return StandardLampFile; }
     
+    // Reads data points that were left in a project file. This is called by
+    // every data function, but is not thread-safe, so it must be called before
+    // the spectrum is used by more than one thread.
+    void loadData () { if (DataStored) readStoredData (); }
+
     // SET functions
     void data (vector <Coord> a);
+    void data (FtsFloatArray Y, double MinX, double Spacing);
     void data_push_back (Coord a);
-    void lines (vector < vector <XgLine> > a ) { Lines = a; }
-    void lines_push_back (vector <XgLine> a) { Lines.push_back (a); }
-    void plots (vector < vector <LineData *> > a) { Plots = a; }
-    void plots_push_back (vector <LineData *> a) { Plots.push_back (a); }
+    void lines (vector < vector <XgLine> > a ) { Lines = a; Clusters.clear (); Profiles.clear (); linesChanged (); }
+    void lines_push_back (vector <XgLine> a) { Lines.push_back (a); linesChanged (); }
     void lin_headers_push_back (vector <char> a) { LinHeaders.push_back (a); }
     void headerFile (vector <char> a) { HeaderFile = a; }
     void radiance (vector <Coord> a) { Radiance = a; }